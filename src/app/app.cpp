@@ -23,6 +23,7 @@
 #include "app/app.h"
 
 #include "app/app_options.h"
+#include "app/batch.h"
 #include "app/check_update.h"
 #include "app/color_utils.h"
 #include "app/commands/commands.h"
@@ -46,6 +47,7 @@
 #include "app/modules/palettes.h"
 #include "app/recent_files.h"
 #include "app/shell.h"
+#include "app/startup_profiler.h"
 #include "app/tools/tool_box.h"
 #include "app/ui/color_bar.h"
 #include "app/ui/editor/editor.h"
@@ -89,7 +91,7 @@ class App::Modules {
 public:
   ConfigModule m_configModule;
   LoggerModule m_loggerModule;
-  FileSystemModule m_file_system_module;
+  base::UniquePtr<FileSystemModule> m_file_system_module; // Created on first use
   tools::ToolBox m_toolbox;
   CommandsModule m_commands_modules;
   UIContext m_ui_context;
@@ -103,6 +105,42 @@ public:
   }
 };
 
+// Services which are started after the main window is displayed
+// (from the first timer tick in the GUI message loop) and stopped
+// when the message loop finishes.
+class BackgroundServices {
+public:
+  BackgroundServices() : m_timer(1) {
+    m_timer.Tick.connect(&BackgroundServices::onStart, this);
+    m_timer.start();
+  }
+
+private:
+  void onStart() {
+    m_timer.stop();
+
+#ifdef ENABLE_UPDATER
+    // Launch the thread to check for updates.
+    m_checkUpdate.reset(new CheckUpdateThreadLauncher);
+    m_checkUpdate->launch();
+#endif
+
+#ifdef ENABLE_WEBSERVER
+    // Launch the webserver.
+    m_webServer.reset(new WebServer);
+    m_webServer->start();
+#endif
+  }
+
+  ui::Timer m_timer;
+#ifdef ENABLE_UPDATER
+  base::UniquePtr<CheckUpdateThreadLauncher> m_checkUpdate;
+#endif
+#ifdef ENABLE_WEBSERVER
+  base::UniquePtr<WebServer> m_webServer;
+#endif
+};
+
 App* App::m_instance = NULL;
 
 // Initializes the application loading the modules, setting the
@@ -112,20 +150,34 @@ App::App(int argc, const char* argv[])
   , m_legacy(NULL)
   , m_isGui(false)
   , m_isShell(false)
+  , m_invalidOptions(false)
 {
   ASSERT(m_instance == NULL);
   m_instance = this;
 
   AppOptions options(argc, argv);
 
-  m_modules = new Modules(!options.startUI(), options.verbose());
+  startup_profiler_set_trace_file(options.startupTraceFileName());
+
+  {
+    StartupMarker marker("App modules");
+    m_modules = new Modules(!options.startUI(), options.verbose());
+  }
   m_isGui = options.startUI();
   m_isShell = options.startShell();
-  m_legacy = new LegacyModules(isGui() ? REQUIRE_INTERFACE: 0);
+  m_invalidOptions = options.hasErrors();
+  m_batchOptions = options.batchOptions();
+  {
+    StartupMarker marker("Legacy modules");
+    m_legacy = new LegacyModules(isGui() ? REQUIRE_INTERFACE: 0);
+  }
   m_files = options.files();
 
   // Register well-known image file types.
-  FileFormatsManager::instance().registerAllFormats();
+  {
+    StartupMarker marker("File formats");
+    FileFormatsManager::instance().registerAllFormats();
+  }
 
   // init editor cursor
   Editor::editor_cursor_init();
@@ -135,6 +187,7 @@ App::App(int argc, const char* argv[])
 
   // Default palette.
   if (!options.paletteFileName().empty()) {
+    StartupMarker marker("Custom palette");
     const char* palFile = options.paletteFileName().c_str();
     PRINTF("Loading custom palette file: %s\n", palFile);
 
@@ -151,6 +204,9 @@ App::App(int argc, const char* argv[])
 
 int App::run()
 {
+  if (m_invalidOptions)
+    return 1;
+
   // Initialize GUI interface
   if (isGui()) {
     PRINTF("GUI mode\n");
@@ -160,13 +216,19 @@ int App::run()
     ui::Manager::getDefault()->invalidate();
 
     // Create the main window and show it.
-    m_mainWindow.reset(new MainWindow);
+    {
+      StartupMarker marker("Main window");
+      m_mainWindow.reset(new MainWindow);
+    }
 
     // Default status of the main window.
     app_rebuild_documents_tabs();
     app_default_statusbar_message();
 
-    m_mainWindow->openWindow();
+    {
+      StartupMarker marker("Open main window");
+      m_mainWindow->openWindow();
+    }
 
     // Redraw the whole screen.
     ui::Manager::getDefault()->invalidate();
@@ -178,7 +240,16 @@ int App::run()
   // Procress options
   PRINTF("Processing options...\n");
 
-  {
+  int exitCode = 0;
+
+  // Convert/export files directly (without adding them to the
+  // context), useful for asset pipelines.
+  if (m_batchOptions.hasCommands()) {
+    BatchProcessor batch(m_batchOptions);
+    exitCode = batch.run(m_files);
+  }
+  else {
+    StartupMarker marker("Load files");
     Console console;
     for (FileList::iterator
            it  = m_files.begin(),
@@ -203,22 +274,16 @@ int App::run()
     }
   }
 
+  startup_profiler_dump();
+
   // Run the GUI
   if (isGui()) {
     // Support to drop files from Windows explorer
     install_drop_files();
 
-#ifdef ENABLE_UPDATER
-    // Launch the thread to check for updates.
-    app::CheckUpdateThreadLauncher checkUpdate;
-    checkUpdate.launch();
-#endif
-
-#ifdef ENABLE_WEBSERVER
-    // Launch the webserver.
-    app::WebServer webServer;
-    webServer.start();
-#endif
+    // The update checker and the webserver are not needed to show the
+    // first frame, so they are started from the message loop.
+    BackgroundServices backgroundServices;
 
     // Run the GUI main message loop
     gui_run();
@@ -247,7 +312,7 @@ int App::run()
     }
   }
 
-  return 0;
+  return exitCode;
 }
 
 // Finishes the Aseprite application.
@@ -293,6 +358,15 @@ RecentFiles* App::getRecentFiles() const
   return &m_modules->m_recent_files;
 }
 
+FileSystemModule* App::getFileSystemModule() const
+{
+  ASSERT(m_modules != NULL);
+  if (!m_modules->m_file_system_module)
+    m_modules->m_file_system_module.reset(new FileSystemModule);
+
+  return m_modules->m_file_system_module;
+}
+
 // Updates palette and redraw the screen.
 void app_refresh_screen()
 {
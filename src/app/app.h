@@ -19,6 +19,7 @@
 #ifndef APP_APP_H_INCLUDED
 #define APP_APP_H_INCLUDED
 
+#include "app/batch.h"
 #include "base/signal.h"
 #include "base/string.h"
 #include "base/system_console.h"
@@ -39,6 +40,7 @@ namespace raster {
 
 namespace app {
   class Document;
+  class FileSystemModule;
   class LegacyModules;
   class LoggerModule;
   class MainWindow;
@@ -61,11 +63,17 @@ namespace app {
     bool isGui() const { return m_isGui; }
 
     // Runs the Aseprite application. In GUI mode it's the top-level
-    // window, in console/scripting it just runs the specified scripts.
+    // window, in console/scripting it just runs the specified scripts,
+    // and in batch mode it processes the given files. Returns the exit
+    // code of the program.
     int run();
 
     tools::ToolBox* getToolBox() const;
     RecentFiles* getRecentFiles() const;
+
+    // The file system module is created the first time it's needed
+    // (e.g. when the file selector is opened).
+    FileSystemModule* getFileSystemModule() const;
     MainWindow* getMainWindow() const { return m_mainWindow; }
 
     // App Signals
@@ -88,6 +96,8 @@ namespace app {
     LegacyModules* m_legacy;
     bool m_isGui;
     bool m_isShell;
+    bool m_invalidOptions;
+    BatchOptions m_batchOptions;
     base::UniquePtr<MainWindow> m_mainWindow;
     FileList m_files;
   };
@@ -30,6 +30,7 @@
 #include "app/gui_xml.h"
 #include "app/modules/gui.h"
 #include "app/recent_files.h"
+#include "app/startup_profiler.h"
 #include "app/tools/tool_box.h"
 #include "app/ui/app_menuitem.h"
 #include "app/ui/main_window.h"
@@ -70,6 +71,7 @@ AppMenus::AppMenus()
 
 void AppMenus::reload()
 {
+  StartupMarker marker("Menus");
   XmlDocumentRef doc(GuiXml::instance()->doc());
   TiXmlHandle handle(doc);
   const char* path = GuiXml::instance()->filename();
@@ -24,6 +24,7 @@
 
 #include "base/path.h"
 
+#include <cstdlib>
 #include <iostream>
 
 namespace app {
@@ -35,11 +36,21 @@ AppOptions::AppOptions(int argc, const char* argv[])
   , m_startUI(true)
   , m_startShell(false)
   , m_verbose(false)
+  , m_hasErrors(false)
 {
   Option& palette = m_po.add("palette").requiresValue("GFXFILE").description("Use a specific palette by default");
   Option& shell = m_po.add("shell").description("Start an interactive console to execute scripts");
   Option& batch = m_po.add("batch").description("Do not start the UI");
+  Option& saveAs = m_po.add("save-as").requiresValue("FILE").description("Save each file with a new name/format ({path}, {title} and {layer} are replaced)");
+  Option& scale = m_po.add("scale").requiresValue("FACTOR").description("Resize each file by the given factor");
+  Option& sheet = m_po.add("sheet").requiresValue("FILE").description("Export all frames of each file as a horizontal strip");
+  Option& sheetPack = m_po.add("sheet-pack").description("Pack the --sheet as a texture atlas (trimmed frames, no duplicates) with a .json file");
+  Option& colorMode = m_po.add("color-mode").requiresValue("MODE").description("Change the color mode to rgb, grayscale or indexed");
+  Option& splitLayers = m_po.add("split-layers").description("Save/export each visible layer in a separate file");
+  Option& listFrames = m_po.add("list-frames").description("Print the frames of each file and their durations");
+  Option& jobs = m_po.add("jobs").requiresValue("N").description("Process N files in parallel (0 = one per CPU)");
   Option& verbose = m_po.add("verbose").description("Explain what is being done (in stderr or a log file)");
+  Option& startupTrace = m_po.add("startup-trace").requiresValue("FILE").description("Save the time spent in each startup step as a Chrome trace (JSON)");
   Option& help = m_po.add("help").mnemonic('?').description("Display this help and exits");
   Option& version = m_po.add("version").description("Output version information and exit");
 
@@ -48,8 +59,41 @@ AppOptions::AppOptions(int argc, const char* argv[])
 
     m_verbose = verbose.enabled();
     m_paletteFileName = palette.value();
+    m_startupTraceFileName = startupTrace.value();
     m_startShell = shell.enabled();
 
+    m_batchOptions.saveAs = saveAs.value();
+    m_batchOptions.sheet = sheet.value();
+    m_batchOptions.sheetPack = sheetPack.enabled();
+    m_batchOptions.splitLayers = splitLayers.enabled();
+    m_batchOptions.listFrames = listFrames.enabled();
+
+    if (scale.enabled()) {
+      m_batchOptions.scale = std::strtod(scale.value().c_str(), NULL);
+      if (m_batchOptions.scale <= 0.0)
+        throw std::runtime_error("Invalid scale factor: " + scale.value());
+    }
+
+    if (colorMode.enabled()) {
+      m_batchOptions.changeColorMode = true;
+      if (colorMode.value() == "rgb") m_batchOptions.colorMode = raster::IMAGE_RGB;
+      else if (colorMode.value() == "grayscale") m_batchOptions.colorMode = raster::IMAGE_GRAYSCALE;
+      else if (colorMode.value() == "indexed") m_batchOptions.colorMode = raster::IMAGE_INDEXED;
+      else
+        throw std::runtime_error("Invalid color mode: " + colorMode.value());
+    }
+
+    if (jobs.enabled()) {
+      // Only digits (a non-numeric value would be converted to 0,
+      // which means "one job per CPU").
+      const std::string& value = jobs.value();
+      if (value.empty() ||
+          value.find_first_not_of("0123456789") != std::string::npos)
+        throw std::runtime_error("Invalid number of jobs: " + value);
+
+      m_batchOptions.jobs = std::atoi(value.c_str());
+    }
+
     if (help.enabled()) {
       showHelp();
       m_startUI = false;
@@ -59,7 +103,7 @@ AppOptions::AppOptions(int argc, const char* argv[])
       m_startUI = false;
     }
 
-    if (shell.enabled() || batch.enabled()) {
+    if (shell.enabled() || batch.enabled() || m_batchOptions.hasCommands()) {
       m_startUI = false;
     }
   }
@@ -67,6 +111,7 @@ AppOptions::AppOptions(int argc, const char* argv[])
     std::cerr << m_exeName << ": " << parseError.what() << '\n'
               << "Try \"" << m_exeName << " --help\" for more information.\n";
     m_startUI = false;
+    m_hasErrors = true;
   }
 }
 
@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 
+#include "app/batch.h"
 #include "base/program_options.h"
 
 namespace app {
@@ -36,6 +37,14 @@ public:
   bool verbose() const { return m_verbose; }
 
   const std::string& paletteFileName() const { return m_paletteFileName; }
+  const std::string& startupTraceFileName() const { return m_startupTraceFileName; }
+
+  // Commands to process files without UI (--save-as, --scale, etc.).
+  const BatchOptions& batchOptions() const { return m_batchOptions; }
+
+  // True if the command line was invalid (the program should exit
+  // with an error code).
+  bool hasErrors() const { return m_hasErrors; }
 
   const base::ProgramOptions::ValueList& files() const {
     return m_po.values();
@@ -51,6 +60,9 @@ private:
   bool m_startShell;
   bool m_verbose;
   std::string m_paletteFileName;
+  std::string m_startupTraceFileName;
+  BatchOptions m_batchOptions;
+  bool m_hasErrors;
 };
 
 } // namespace app
@@ -0,0 +1,87 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tests/test.h"
+
+#include "app/app_options.h"
+
+using namespace app;
+
+// Parses the given options (after the program name).
+#define PARSE_OPTIONS(...)                                      \
+  const char* argv[] = { "aseprite", __VA_ARGS__ };             \
+  AppOptions options(sizeof(argv) / sizeof(argv[0]), argv);
+
+TEST(AppOptions, Jobs)
+{
+  {
+    PARSE_OPTIONS("--jobs", "4", "--list-frames", "a.ase");
+    EXPECT_FALSE(options.hasErrors());
+    EXPECT_EQ(4, options.batchOptions().jobs);
+  }
+  {
+    PARSE_OPTIONS("--jobs", "0", "--list-frames", "a.ase");
+    EXPECT_FALSE(options.hasErrors());
+    EXPECT_EQ(0, options.batchOptions().jobs);
+  }
+
+  const char* invalid[] = { "abc", "2x", "-1", "" };
+  for (size_t i=0; i<sizeof(invalid)/sizeof(invalid[0]); ++i) {
+    PARSE_OPTIONS("--jobs", invalid[i], "--list-frames", "a.ase");
+    EXPECT_TRUE(options.hasErrors()) << "--jobs " << invalid[i];
+    EXPECT_FALSE(options.startUI());
+  }
+}
+
+TEST(AppOptions, ColorMode)
+{
+  {
+    PARSE_OPTIONS("--color-mode", "grayscale", "a.ase");
+    EXPECT_FALSE(options.hasErrors());
+    EXPECT_FALSE(options.startUI());
+    EXPECT_TRUE(options.batchOptions().changeColorMode);
+    EXPECT_EQ(raster::IMAGE_GRAYSCALE, options.batchOptions().colorMode);
+  }
+  {
+    PARSE_OPTIONS("--color-mode", "indexed", "a.ase");
+    EXPECT_FALSE(options.hasErrors());
+    EXPECT_EQ(raster::IMAGE_INDEXED, options.batchOptions().colorMode);
+  }
+  {
+    PARSE_OPTIONS("--color-mode", "cmyk", "a.ase");
+    EXPECT_TRUE(options.hasErrors());
+  }
+}
+
+TEST(AppOptions, ListFrames)
+{
+  {
+    PARSE_OPTIONS("--list-frames", "a.ase", "b.ase");
+    EXPECT_FALSE(options.hasErrors());
+    EXPECT_FALSE(options.startUI());
+    EXPECT_TRUE(options.batchOptions().listFrames);
+    ASSERT_EQ(2, (int)options.files().size());
+    EXPECT_EQ("a.ase", options.files()[0]);
+  }
+  {
+    PARSE_OPTIONS("a.ase");
+    EXPECT_FALSE(options.batchOptions().listFrames);
+    EXPECT_FALSE(options.batchOptions().hasCommands());
+    EXPECT_TRUE(options.startUI());
+  }
+}
@@ -22,15 +22,170 @@
 
 #include "app/backup.h"
 
+#include "app/document.h"
+#include "app/document_snapshot.h"
+#include "base/convert_to.h"
+#include "base/file_handle.h"
+#include "base/fs.h"
+#include "base/path.h"
+#include "base/sha1.h"
+#include "base/unique_ptr.h"
+#include "raster/cel.h"
+#include "raster/image.h"
+#include "raster/layer.h"
+#include "raster/palette.h"
+#include "raster/sprite.h"
+#include "raster/stock.h"
+
+#include <cstdio>
+
+// Increase this version if the format of backup files changes.
+#define BACKUP_VERSION          1
+
 namespace app {
 
-Backup::Backup(const base::string& path)
+using namespace base;
+using namespace raster;
+
+namespace {
+
+  void write32(FILE* f, uint32_t value) {
+    std::fputc(value & 0xff, f);
+    std::fputc((value >> 8) & 0xff, f);
+    std::fputc((value >> 16) & 0xff, f);
+    std::fputc((value >> 24) & 0xff, f);
+  }
+
+  // Writes the file with a temporary name, and replaces the final
+  // file when the writer has finished without errors.
+  template<class Writer>
+  void write_file(const string& filename, const Writer& writer) {
+    string tmp = filename + ".tmp";
+    {
+      FileHandle f(open_file_with_exception(tmp, "wb"));
+      writer(f);
+      if (std::ferror(f))
+        throw std::runtime_error("Error writing backup file");
+    }
+    move_file(tmp, filename);
+  }
+
+  class ImageWriter {
+  public:
+    ImageWriter(const Image* image) : m_image(image) { }
+    void operator()(FILE* f) const {
+      write32(f, m_image->getPixelFormat());
+      write32(f, m_image->getWidth());
+      write32(f, m_image->getHeight());
+
+      int rowBytes = m_image->getRowStrideSize();
+      for (int y=0; y<m_image->getHeight(); ++y)
+        std::fwrite(m_image->getPixelAddress(0, y), 1, rowBytes, f);
+    }
+  private:
+    const Image* m_image;
+  };
+
+  class PaletteWriter {
+  public:
+    PaletteWriter(const Palette* palette) : m_palette(palette) { }
+    void operator()(FILE* f) const {
+      write32(f, m_palette->size());
+      for (int i=0; i<m_palette->size(); ++i)
+        write32(f, m_palette->getEntry(i));
+    }
+  private:
+    const Palette* m_palette;
+  };
+
+  // Structure of the document (it references images and palettes by
+  // their file names).
+  class DocumentWriter {
+  public:
+    DocumentWriter(const std::string& text) : m_text(text) { }
+    void operator()(FILE* f) const {
+      std::fwrite(m_text.c_str(), 1, m_text.size(), f);
+    }
+  private:
+    const std::string& m_text;
+  };
+
+  string get_image_object_name(const Image* image) {
+    Sha1Builder sha1;
+    uint32_t header[3] = { (uint32_t)image->getPixelFormat(),
+                           (uint32_t)image->getWidth(),
+                           (uint32_t)image->getHeight() };
+    sha1.add(header, sizeof(header));
+
+    int rowBytes = image->getRowStrideSize();
+    for (int y=0; y<image->getHeight(); ++y)
+      sha1.add(image->getPixelAddress(0, y), rowBytes);
+
+    return convert_to<string>(sha1.getSha1()) + ".img";
+  }
+
+  string get_palette_object_name(const Palette* palette) {
+    Sha1Builder sha1;
+    for (int i=0; i<palette->size(); ++i) {
+      uint32_t color = palette->getEntry(i);
+      sha1.add(&color, sizeof(color));
+    }
+
+    return convert_to<string>(sha1.getSha1()) + ".pal";
+  }
+
+  void write_layers(const LayerFolder* folder, int depth,
+                    const std::map<int, string>& images,
+                    string& text)
+  {
+    char buf[256];
+
+    for (LayerConstIterator it=folder->getLayerBegin(),
+           end=folder->getLayerEnd(); it != end; ++it) {
+      const Layer* layer = *it;
+
+      std::sprintf(buf, "layer %d %s %u ", depth,
+                   (layer->isFolder() ? "folder": "image"),
+                   (unsigned int)layer->getFlags());
+      text += buf;
+      text += layer->getName();
+      text += "\n";
+
+      if (layer->isImage()) {
+        const LayerImage* layerImage = static_cast<const LayerImage*>(layer);
+
+        for (CelConstIterator it2=layerImage->getCelBegin(),
+               end2=layerImage->getCelEnd(); it2 != end2; ++it2) {
+          const Cel* cel = *it2;
+          std::map<int, string>::const_iterator img = images.find(cel->getImage());
+          if (img == images.end())
+            continue;
+
+          std::sprintf(buf, "cel %d %d %d %d ",
+                       (int)cel->getFrame(), cel->getX(), cel->getY(),
+                       cel->getOpacity());
+          text += buf;
+          text += img->second;
+          text += "\n";
+        }
+      }
+      else if (layer->isFolder())
+        write_layers(static_cast<const LayerFolder*>(layer), depth+1, images, text);
+    }
+  }
+
+}
+
+Backup::Backup(const string& path)
   : m_path(path)
 {
 }
 
 Backup::~Backup()
 {
+  for (std::map<DocumentId, DocumentData*>::iterator
+         it=m_documents.begin(), end=m_documents.end(); it != end; ++it)
+    delete it->second;
 }
 
 bool Backup::hasDataToRestore()
@@ -38,4 +193,202 @@ bool Backup::hasDataToRestore()
   return false;
 }
 
+void Backup::writeDocument(DocumentId id, DocumentSnapshot* snapshot)
+{
+  DocumentData* oldData = NULL;
+  std::map<DocumentId, DocumentData*>::iterator it = m_documents.find(id);
+  if (it != m_documents.end())
+    oldData = it->second;
+
+  base::UniquePtr<DocumentSnapshot> snapshotPtr(snapshot);
+  DocumentData* data = new DocumentData;
+
+  try {
+    const Sprite* sprite = snapshot->getSprite();
+    const Stock* stock = sprite->getStock();
+    std::map<int, string> images;
+
+    // Write modified images (if an image of the snapshot has the
+    // same modification stamp of an image of the previous snapshot,
+    // its pixels weren't modified, so we don't need to calculate its
+    // SHA1 again).
+    for (int i=1; i<stock->size(); ++i) {
+      const Image* image = stock->getImage(i);
+      if (!image)
+        continue;
+
+      string name;
+      if (oldData) {
+        ImageObjects::iterator old = oldData->images.find(image->getModificationStamp());
+        if (old != oldData->images.end())
+          name = old->second;
+      }
+      if (name.empty())
+        name = writeImage(image);
+
+      data->images[image->getModificationStamp()] = name;
+      addObject(name, data->objects);
+      images[i] = name;
+    }
+
+    // Document structure
+    char buf[256];
+    string text;
+
+    std::sprintf(buf, "aseprite-backup %d\n", BACKUP_VERSION);
+    text += buf;
+    text += "filename " + snapshot->getDocument()->getFilename() + "\n";
+
+    std::sprintf(buf, "sprite %d %d %d %u\n",
+                 (int)sprite->getPixelFormat(),
+                 sprite->getWidth(), sprite->getHeight(),
+                 (unsigned int)sprite->getTransparentColor());
+    text += buf;
+
+    std::sprintf(buf, "frames %d\n", (int)sprite->getTotalFrames());
+    text += buf;
+    for (FrameNumber frame(0); frame<sprite->getTotalFrames(); ++frame) {
+      std::sprintf(buf, "duration %d %d\n", (int)frame,
+                   sprite->getFrameDuration(frame));
+      text += buf;
+    }
+
+    const PalettesList& palettes = sprite->getPalettes();
+    for (PalettesList::const_iterator it=palettes.begin(),
+           end=palettes.end(); it != end; ++it) {
+      const Palette* palette = *it;
+      string name = writePalette(palette);
+      addObject(name, data->objects);
+
+      std::sprintf(buf, "palette %d ", (int)palette->getFrame());
+      text += buf;
+      text += name;
+      text += "\n";
+    }
+
+    write_layers(sprite->getFolder(), 0, images, text);
+
+    write_file(getDocumentFilename(id), DocumentWriter(text));
+  }
+  catch (...) {
+    // Keep the previous backup of the document.
+    releaseObjects(data->objects);
+    delete data;
+    throw;
+  }
+
+  // Now the data of the previous snapshot can be released (and files
+  // that aren't used anymore deleted).
+  if (oldData) {
+    releaseObjects(oldData->objects);
+    delete oldData;
+  }
+  m_documents[id] = data;
+}
+
+void Backup::removeDocument(DocumentId id)
+{
+  std::map<DocumentId, DocumentData*>::iterator it = m_documents.find(id);
+  if (it == m_documents.end())
+    return;
+
+  DocumentData* data = it->second;
+  m_documents.erase(it);
+
+  string filename = getDocumentFilename(id);
+  if (file_exists(filename))
+    delete_file(filename);
+
+  releaseObjects(data->objects);
+  delete data;
+}
+
+void Backup::removeAllDocuments()
+{
+  while (!m_documents.empty())
+    removeDocument(m_documents.begin()->first);
+}
+
+string Backup::writeImage(const Image* image)
+{
+  string name = get_image_object_name(image);
+
+  // Other document (or a previous snapshot) could be using the same
+  // image.
+  if (m_objects.find(name) == m_objects.end())
+    writeObject(name, ImageWriter(image));
+
+  return name;
+}
+
+string Backup::writePalette(const Palette* palette)
+{
+  string name = get_palette_object_name(palette);
+
+  if (m_objects.find(name) == m_objects.end())
+    writeObject(name, PaletteWriter(palette));
+
+  return name;
+}
+
+// Writes the file of an image/palette if it doesn't exist. A file
+// with the same name has the same content, and if it wasn't created
+// by this Backup (e.g. it is from a crashed session) it must be kept.
+template<class Writer>
+void Backup::writeObject(const string& name, const Writer& writer)
+{
+  string filename = join_path(m_path, name);
+  if (file_exists(filename))
+    return;
+
+  write_file(filename, writer);
+  m_createdObjects.insert(name);
+}
+
+string Backup::getDocumentFilename(DocumentId id) const
+{
+  return join_path(m_path, "document" + convert_to<string>((int)id) + ".txt");
+}
+
+string Backup::getImageFilename(const Image* image) const
+{
+  return join_path(m_path, get_image_object_name(image));
+}
+
+string Backup::getPaletteFilename(const Palette* palette) const
+{
+  return join_path(m_path, get_palette_object_name(palette));
+}
+
+void Backup::addObject(const string& name, Objects& objects)
+{
+  ++m_objects[name];
+  objects.push_back(name);
+}
+
+void Backup::releaseObjects(const Objects& objects)
+{
+  for (Objects::const_iterator it=objects.begin(),
+         end=objects.end(); it != end; ++it) {
+    std::map<string, int>::iterator obj = m_objects.find(*it);
+    if (obj == m_objects.end())
+      continue;
+
+    if (--obj->second == 0) {
+      m_objects.erase(obj);
+
+      // Files that weren't created by this Backup are kept.
+      std::set<string>::iterator created = m_createdObjects.find(*it);
+      if (created == m_createdObjects.end())
+        continue;
+
+      m_createdObjects.erase(created);
+
+      string filename = join_path(m_path, *it);
+      if (file_exists(filename))
+        delete_file(filename);
+    }
+  }
+}
+
 } // namespace app
@@ -19,12 +19,32 @@
 #ifndef APP_BACKUP_H_INCLUDED
 #define APP_BACKUP_H_INCLUDED
 
+#include "app/document_id.h"
 #include "base/disable_copying.h"
 #include "base/string.h"
 
+#include <map>
+#include <set>
+#include <vector>
+
+namespace raster {
+  class Image;
+  class Palette;
+}
+
 namespace app {
+  class DocumentSnapshot;
 
   // A class to record/restore backup information.
+  //
+  // Documents are recorded as a small text file (the layers, frames
+  // and cels structure), which references images and palettes saved
+  // in other files named with the SHA1 of their content. So each
+  // snapshot writes only the images/palettes that changed, and equal
+  // images are stored once. All files are written with a temporary
+  // name and then renamed, and the document file is replaced at the
+  // end, so the backup is consistent even if the program crashes in
+  // the middle of a snapshot.
   class Backup {
   public:
     Backup(const base::string& path);
@@ -33,10 +53,56 @@ namespace app {
     // Returns true if there are items that can be restored.
     bool hasDataToRestore();
 
+    // Records the snapshot of the given document and deletes it. The
+    // modification stamp of each image is kept to know which images
+    // didn't change in the next snapshot. It can be called
+    // from a background thread, but all functions to record data
+    // must be called from the same thread.
+    void writeDocument(DocumentId id, DocumentSnapshot* snapshot);
+
+    // Removes the recorded data of the given document.
+    void removeDocument(DocumentId id);
+
+    // Removes all the data recorded by this Backup (files from other
+    // sessions in the same directory are kept).
+    void removeAllDocuments();
+
+    // Returns the file names where the document structure, and the
+    // images and palettes (named with the SHA1 of their content) are
+    // recorded.
+    base::string getDocumentFilename(DocumentId id) const;
+    base::string getImageFilename(const raster::Image* image) const;
+    base::string getPaletteFilename(const raster::Palette* palette) const;
+
   private:
+    typedef std::vector<base::string> Objects;
+    typedef std::map<uint32_t, base::string> ImageObjects;
+
+    struct DocumentData {
+      ImageObjects images;
+      Objects objects;
+    };
+
+    base::string writeImage(const raster::Image* image);
+    base::string writePalette(const raster::Palette* palette);
+    template<class Writer>
+    void writeObject(const base::string& name, const Writer& writer);
+    void addObject(const base::string& name, Objects& objects);
+    void releaseObjects(const Objects& objects);
+
     DISABLE_COPYING(Backup);
 
     base::string m_path;
+
+    // Recorded documents.
+    std::map<DocumentId, DocumentData*> m_documents;
+
+    // Number of documents that use each image/palette file.
+    std::map<base::string, int> m_objects;
+
+    // Image/palette files created by this Backup (the only ones that
+    // can be deleted).
+    std::set<base::string> m_createdObjects;
   };
 
 } // namespace app
@@ -0,0 +1,155 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "app/backup.h"
+#include "app/document.h"
+#include "app/document_snapshot.h"
+#include "base/fs.h"
+#include "base/path.h"
+#include "base/unique_ptr.h"
+#include "raster/raster.h"
+
+#include <vector>
+
+using namespace app;
+using namespace base;
+using namespace raster;
+
+// Deletes the files that a test could leave in the backup directory
+// (if some expectation failed) and the directory itself.
+static void remove_backup_directory(const string& path, const std::vector<string>& files)
+{
+  for (std::vector<string>::const_iterator it=files.begin(), end=files.end(); it != end; ++it)
+    if (file_exists(*it))
+      delete_file(*it);
+
+  EXPECT_NO_THROW(remove_directory(path));
+}
+
+TEST(Backup, WriteAndRemoveDocuments)
+{
+  string path = join_path(get_temp_path(), "aseprite_backup_unittest");
+  if (!directory_exists(path))
+    make_directory(path);
+
+  UniquePtr<Document> doc1(Document::createBasicDocument(IMAGE_RGB, 8, 8, 256));
+  UniquePtr<Document> doc2(Document::createBasicDocument(IMAGE_RGB, 8, 8, 256));
+  doc1->setId(1);
+  doc2->setId(2);
+
+  Sprite* sprite = doc1->getSprite();
+  LayerImage* layer = static_cast<LayerImage*>(sprite->getFolder()->getFirstLayer());
+  Image* image = sprite->getStock()->getImage(layer->getCel(FrameNumber(0))->getImage());
+  std::vector<string> files;
+
+  {
+    Backup backup(path);
+    string filename1 = backup.getDocumentFilename(1);
+    string filename2 = backup.getDocumentFilename(2);
+    string imageFile = backup.getImageFilename(image);
+    string paletteFile = backup.getPaletteFilename(sprite->getPalette(FrameNumber(0)));
+    files.push_back(filename1);
+    files.push_back(filename2);
+    files.push_back(imageFile);
+    files.push_back(paletteFile);
+
+    backup.writeDocument(1, doc1->createSnapshot());
+    backup.writeDocument(2, doc2->createSnapshot());
+    EXPECT_TRUE(file_exists(filename1));
+    EXPECT_TRUE(file_exists(filename2));
+    EXPECT_TRUE(file_exists(imageFile));
+    EXPECT_TRUE(file_exists(paletteFile));
+
+    // Modify the document and write it again
+    put_pixel(image, 0, 0, rgba(255, 0, 0, 255));
+    image->markAsModified();
+    string modifiedImageFile = backup.getImageFilename(image);
+    files.push_back(modifiedImageFile);
+
+    backup.writeDocument(1, doc1->createSnapshot());
+    EXPECT_TRUE(file_exists(modifiedImageFile));
+    EXPECT_TRUE(file_exists(imageFile)); // Used by doc2
+
+    backup.removeDocument(1);
+    EXPECT_FALSE(file_exists(filename1));
+    EXPECT_FALSE(file_exists(modifiedImageFile));
+    EXPECT_TRUE(file_exists(filename2));
+    EXPECT_TRUE(file_exists(imageFile));
+    EXPECT_TRUE(file_exists(paletteFile));
+
+    backup.removeAllDocuments();
+    EXPECT_FALSE(file_exists(filename2));
+
+    // All images and palettes were removed too.
+    EXPECT_FALSE(file_exists(imageFile));
+    EXPECT_FALSE(file_exists(paletteFile));
+  }
+
+  remove_backup_directory(path, files);
+}
+
+TEST(Backup, KeepFilesFromOtherSessions)
+{
+  string path = join_path(get_temp_path(), "aseprite_backup_unittest2");
+  if (!directory_exists(path))
+    make_directory(path);
+
+  UniquePtr<Document> doc(Document::createBasicDocument(IMAGE_RGB, 8, 8, 256));
+  doc->setId(1);
+
+  Sprite* sprite = doc->getSprite();
+  LayerImage* layer = static_cast<LayerImage*>(sprite->getFolder()->getFirstLayer());
+  Image* image = sprite->getStock()->getImage(layer->getCel(FrameNumber(0))->getImage());
+  std::vector<string> files;
+
+  // Files of a previous session (e.g. a crash).
+  {
+    Backup backup(path);
+    files.push_back(backup.getDocumentFilename(1));
+    files.push_back(backup.getImageFilename(image));
+    files.push_back(backup.getPaletteFilename(sprite->getPalette(FrameNumber(0))));
+
+    backup.writeDocument(1, doc->createSnapshot());
+  }
+  for (size_t i=0; i<files.size(); ++i)
+    EXPECT_TRUE(file_exists(files[i]));
+
+  // A new session in the same directory with the same image and
+  // palette doesn't delete them.
+  {
+    Backup backup(path);
+    backup.writeDocument(1, doc->createSnapshot());
+    backup.removeAllDocuments();
+  }
+  EXPECT_TRUE(file_exists(files[1]));
+  EXPECT_TRUE(file_exists(files[2]));
+
+  remove_backup_directory(path, files);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
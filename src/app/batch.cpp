@@ -0,0 +1,479 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/batch.h"
+
+#include "app/document.h"
+#include "app/document_api.h"
+#include "app/document_undo.h"
+#include "app/file/file.h"
+#include "app/util/packed_sprite_sheet.h"
+#include "base/path.h"
+#include "base/scoped_lock.h"
+#include "base/task_scheduler.h"
+#include "base/unique_ptr.h"
+#include "raster/algorithm/resize_image.h"
+#include "raster/cel.h"
+#include "raster/image.h"
+#include "raster/layer.h"
+#include "raster/palette.h"
+#include "raster/quantization.h"
+#include "raster/sprite.h"
+#include "raster/stock.h"
+
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+namespace app {
+
+using namespace raster;
+
+BatchOptions::BatchOptions()
+  : sheetPack(false)
+  , scale(1.0)
+  , changeColorMode(false)
+  , colorMode(IMAGE_RGB)
+  , splitLayers(false)
+  , listFrames(false)
+  , jobs(1)
+{
+}
+
+bool BatchOptions::hasCommands() const
+{
+  return (!saveAs.empty() ||
+          !sheet.empty() ||
+          scale != 1.0 ||
+          changeColorMode ||
+          splitLayers ||
+          listFrames);
+}
+
+static void replace_all(base::string& str, const base::string& from, const base::string& to)
+{
+  base::string::size_type pos = 0;
+  while ((pos = str.find(from, pos)) != base::string::npos) {
+    str.replace(pos, from.size(), to);
+    pos += to.size();
+  }
+}
+
+static base::string output_filename(const base::string& pattern,
+                                    const base::string& input,
+                                    const base::string& layerName)
+{
+  base::string path = base::get_file_path(input);
+  if (path.empty())
+    path = ".";
+
+  base::string result = pattern;
+  replace_all(result, "{path}", path);
+  replace_all(result, "{title}", base::get_file_title(input));
+  replace_all(result, "{layer}", layerName);
+  return result;
+}
+
+static void add_error(base::string& errors, const base::string& error)
+{
+  errors += error;
+  if (!error.empty() && error[error.size()-1] != '\n')
+    errors += '\n';
+}
+
+static bool save_file(Document* document, const base::string& filename, base::string& errors)
+{
+  document->setFilename(filename);
+
+  FileOp* fop = fop_to_save_document(document);
+  if (!fop) {
+    add_error(errors, "Error saving \"" + filename + "\"");
+    return false;
+  }
+
+  // fop_to_save_document() returns a FileOp with an error if the
+  // format cannot save the document.
+  if (!fop->has_error()) {
+    fop_operate(fop, NULL);
+    fop_done(fop);
+  }
+
+  bool ok = !fop->has_error();
+  if (!ok)
+    add_error(errors, fop->error);
+
+  fop_free(fop);
+  return ok;
+}
+
+static void change_color_mode(Document* document, PixelFormat format)
+{
+  Sprite* sprite = document->getSprite();
+  if (sprite->getPixelFormat() == format)
+    return;
+
+  // Quantize RGB images using an optimized palette (instead of the
+  // current one, which can be the default palette).
+  if (format == IMAGE_INDEXED && sprite->getPixelFormat() == IMAGE_RGB) {
+    base::UniquePtr<Palette> palette(quantization::create_palette_from_rgb(sprite, FrameNumber(0)));
+    sprite->resetPalettes();
+    sprite->setPalette(palette, false);
+  }
+
+  document->getApi().setPixelFormat(sprite, format, DITHERING_NONE);
+}
+
+static int scale_value(int value, double scale)
+{
+  return (int)std::floor(value * scale);
+}
+
+static void scale_sprite(Document* document, double scale)
+{
+  Sprite* sprite = document->getSprite();
+  DocumentApi api = document->getApi();
+  Stock* stock = sprite->getStock();
+
+  // Resize each image of the stock once (even if it's used by several
+  // cels).
+  for (int i=0; i<stock->size(); ++i) {
+    Image* image = stock->getImage(i);
+    if (!image)
+      continue;
+
+    Image* newImage = Image::create(image->getPixelFormat(),
+                                    MAX(1, scale_value(image->getWidth(), scale)),
+                                    MAX(1, scale_value(image->getHeight(), scale)));
+
+    algorithm::resize_image(image, newImage,
+                            algorithm::RESIZE_METHOD_NEAREST_NEIGHBOR,
+                            sprite->getPalette(FrameNumber(0)),
+                            sprite->getRgbMap(FrameNumber(0)));
+
+    api.replaceStockImage(sprite, i, newImage);
+  }
+
+  CelList cels;
+  sprite->getCels(cels);
+  for (CelIterator it = cels.begin(); it != cels.end(); ++it) {
+    Cel* cel = *it;
+    api.setCelPosition(sprite, cel,
+                       scale_value(cel->getX(), scale),
+                       scale_value(cel->getY(), scale));
+  }
+
+  api.setSpriteSize(sprite,
+                    MAX(1, scale_value(sprite->getWidth(), scale)),
+                    MAX(1, scale_value(sprite->getHeight(), scale)));
+}
+
+// Creates a document with one layer and the given number of frames,
+// with the same color mode, palettes and durations of "sprite".
+// Returns the image of each frame in "images".
+static Document* create_flat_document(const Sprite* sprite, int width, int height,
+                                      FrameNumber frames, std::vector<Image*>& images)
+{
+  base::UniquePtr<Sprite> flat(new Sprite(sprite->getPixelFormat(), width, height,
+                                          sprite->getPalette(FrameNumber(0))->size()));
+  flat->setTotalFrames(frames);
+  flat->setTransparentColor(sprite->getTransparentColor());
+
+  const PalettesList& palettes = sprite->getPalettes();
+  for (PalettesList::const_iterator it = palettes.begin(); it != palettes.end(); ++it)
+    flat->setPalette(*it, true);
+
+  LayerImage* layer = new LayerImage(flat);
+  layer->setName("Layer 1");
+  flat->getFolder()->addLayer(layer);
+
+  for (FrameNumber frame(0); frame<frames; ++frame) {
+    base::UniquePtr<Image> image(Image::create(sprite->getPixelFormat(), width, height));
+    int indexInStock = flat->getStock()->addImage(image);
+    images.push_back(image.release());
+
+    layer->addCel(new Cel(frame, indexInStock));
+    flat->setFrameDuration(frame, sprite->getFrameDuration(frame));
+  }
+
+  base::UniquePtr<Document> document(new Document(flat));
+  flat.release();
+  return document.release();
+}
+
+// Renders the visible layers of each frame in a one-layer document.
+static Document* create_rendered_document(const Sprite* sprite)
+{
+  std::vector<Image*> images;
+  Document* document = create_flat_document(sprite,
+                                            sprite->getWidth(), sprite->getHeight(),
+                                            sprite->getTotalFrames(), images);
+
+  for (FrameNumber frame(0); frame<sprite->getTotalFrames(); ++frame)
+    sprite->render(images[frame], 0, 0, frame);
+
+  return document;
+}
+
+// Renders all frames in a horizontal strip (one-frame document).
+static Document* create_sheet_document(const Sprite* sprite)
+{
+  std::vector<Image*> images;
+  FrameNumber frames = sprite->getTotalFrames();
+  Document* document = create_flat_document(sprite,
+                                            sprite->getWidth()*frames, sprite->getHeight(),
+                                            FrameNumber(1), images);
+
+  for (FrameNumber frame(0); frame<frames; ++frame) {
+    gfx::Rect cell(sprite->getWidth()*frame, 0, sprite->getWidth(), sprite->getHeight());
+    sprite->render(images[0], cell.x, cell.y, frame, cell);
+  }
+
+  return document;
+}
+
+// Saves the sprite sheet (a horizontal strip, or a packed atlas with
+// a .json file to locate each frame).
+static bool save_sheet(const Sprite* sprite, bool pack, const base::string& filename, base::string& errors)
+{
+  if (!pack) {
+    base::UniquePtr<Document> sheetDoc(create_sheet_document(sprite));
+    return save_file(sheetDoc, filename, errors);
+  }
+
+  PackedSpriteSheet sheet(sprite);
+  base::UniquePtr<Document> sheetDoc(sheet.createDocument());
+  if (!save_file(sheetDoc, filename, errors))
+    return false;
+
+  if (!sheet.saveJson(filename)) {
+    add_error(errors, "Error saving \"" + PackedSpriteSheet::getJsonFilename(filename) + "\"");
+    return false;
+  }
+  return true;
+}
+
+static void collect_visible_image_layers(LayerFolder* folder, LayerList& layers)
+{
+  for (LayerIterator it = folder->getLayerBegin(); it != folder->getLayerEnd(); ++it) {
+    Layer* layer = *it;
+    if (!layer->isReadable())
+      continue;
+
+    if (layer->isImage())
+      layers.push_back(layer);
+    else if (layer->isFolder())
+      collect_visible_image_layers(static_cast<LayerFolder*>(layer), layers);
+  }
+}
+
+// Hides all layers except one (and its parents) while it is alive, so
+// Sprite::render() draws only that layer.
+class ScopedSoloLayer {
+public:
+  ScopedSoloLayer(Sprite* sprite, Layer* solo) {
+    hideLayers(sprite->getFolder());
+
+    for (Layer* layer=solo; layer != sprite->getFolder(); layer=layer->getParent())
+      layer->setReadable(true);
+  }
+
+  ~ScopedSoloLayer() {
+    for (size_t i=0; i<m_flags.size(); ++i)
+      m_flags[i].first->setFlags(m_flags[i].second);
+  }
+
+private:
+  void hideLayers(LayerFolder* folder) {
+    for (LayerIterator it = folder->getLayerBegin(); it != folder->getLayerEnd(); ++it) {
+      Layer* layer = *it;
+      m_flags.push_back(std::make_pair(layer, layer->getFlags()));
+      layer->setReadable(false);
+
+      if (layer->isFolder())
+        hideLayers(static_cast<LayerFolder*>(layer));
+    }
+  }
+
+  std::vector<std::pair<Layer*, uint32_t> > m_flags;
+};
+
+//////////////////////////////////////////////////////////////////////
+// BatchProcessor
+
+class BatchProcessor::FileTask {
+public:
+  FileTask(BatchProcessor* processor, const base::string& filename)
+    : m_processor(processor)
+    , m_filename(filename) {
+  }
+
+  // Called from a thread of the TaskScheduler (it must not throw).
+  void operator()() const {
+    base::string output, errors;
+    bool ok;
+
+    try {
+      ok = m_processor->processFile(m_filename, output, errors);
+    }
+    catch (const std::exception& e) {
+      add_error(errors, e.what());
+      ok = false;
+    }
+    catch (...) {
+      add_error(errors, "Unknown error");
+      ok = false;
+    }
+
+    m_processor->reportFile(m_filename, ok, output, errors);
+  }
+
+private:
+  BatchProcessor* m_processor;
+  base::string m_filename;
+};
+
+BatchProcessor::BatchProcessor(const BatchOptions& options)
+  : m_options(options)
+  , m_failures(0)
+{
+}
+
+int BatchProcessor::run(const std::vector<base::string>& files)
+{
+  const char* error = NULL;
+
+  if (files.empty())
+    error = "No files to process";
+  else if (m_options.splitLayers &&
+           ((!m_options.saveAs.empty() && m_options.saveAs.find("{layer}") == base::string::npos) ||
+            (!m_options.sheet.empty() && m_options.sheet.find("{layer}") == base::string::npos)))
+    error = "--split-layers needs {layer} in output file names";
+  else if (files.size() > 1 &&
+           ((!m_options.saveAs.empty() && m_options.saveAs.find("{title}") == base::string::npos) ||
+            (!m_options.sheet.empty() && m_options.sheet.find("{title}") == base::string::npos)))
+    error = "Several files need {title} in output file names";
+
+  if (error) {
+    std::cerr << error << '\n';
+    return 1;
+  }
+
+  m_failures = 0;
+
+  if (m_options.jobs == 1 || files.size() == 1) {
+    for (size_t i=0; i<files.size(); ++i)
+      FileTask(this, files[i])();
+  }
+  else {
+    // The thread that waits the group runs tasks too, so "jobs-1"
+    // threads are needed.
+    base::UniquePtr<base::TaskScheduler> scheduler;
+    if (m_options.jobs > 1)
+      scheduler.reset(new base::TaskScheduler(m_options.jobs-1));
+
+    base::TaskGroup group(scheduler ? *scheduler: base::TaskScheduler::getDefault());
+    for (size_t i=0; i<files.size(); ++i)
+      group.run(FileTask(this, files[i]));
+    group.wait();
+  }
+
+  return (m_failures == 0 ? 0: 1);
+}
+
+bool BatchProcessor::processFile(const base::string& filename, base::string& output, base::string& errors)
+{
+  base::string loadError;
+  base::UniquePtr<Document> document(load_document_noninteractive(filename.c_str(), loadError));
+  add_error(errors, loadError);
+  if (!document) {
+    if (errors.empty())
+      add_error(errors, "Error loading file");
+    return false;
+  }
+
+  // Batch changes don't need to be undone.
+  document->getUndo()->setEnabled(false);
+
+  Sprite* sprite = document->getSprite();
+
+  if (m_options.changeColorMode)
+    change_color_mode(document, m_options.colorMode);
+
+  if (m_options.scale != 1.0)
+    scale_sprite(document, m_options.scale);
+
+  if (m_options.listFrames) {
+    std::ostringstream frames;
+    for (FrameNumber frame(0); frame<sprite->getTotalFrames(); ++frame)
+      frames << filename << '\t' << (int)frame << '\t' << sprite->getFrameDuration(frame) << '\n';
+    output += frames.str();
+  }
+
+  bool ok = true;
+
+  if (m_options.splitLayers) {
+    LayerList layers;
+    collect_visible_image_layers(sprite->getFolder(), layers);
+
+    for (LayerIterator it = layers.begin(); it != layers.end(); ++it) {
+      ScopedSoloLayer solo(sprite, *it);
+
+      if (!m_options.saveAs.empty()) {
+        base::UniquePtr<Document> layerDoc(create_rendered_document(sprite));
+        ok = save_file(layerDoc, output_filename(m_options.saveAs, filename, (*it)->getName()), errors) && ok;
+      }
+
+      if (!m_options.sheet.empty())
+        ok = save_sheet(sprite, m_options.sheetPack,
+                        output_filename(m_options.sheet, filename, (*it)->getName()), errors) && ok;
+    }
+  }
+  else {
+    if (!m_options.saveAs.empty())
+      ok = save_file(document, output_filename(m_options.saveAs, filename, ""), errors) && ok;
+
+    if (!m_options.sheet.empty())
+      ok = save_sheet(sprite, m_options.sheetPack,
+                      output_filename(m_options.sheet, filename, ""), errors) && ok;
+  }
+
+  return ok;
+}
+
+void BatchProcessor::reportFile(const base::string& filename, bool ok,
+                                const base::string& output, const base::string& errors)
+{
+  base::scoped_lock hold(m_mutex);
+
+  if (!ok)
+    ++m_failures;
+
+  if (!output.empty())
+    std::cout << output << std::flush;
+
+  if (!errors.empty())
+    std::cerr << filename << ": " << errors << std::flush;
+}
+
+} // namespace app
@@ -0,0 +1,87 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef APP_BATCH_H_INCLUDED
+#define APP_BATCH_H_INCLUDED
+
+#include "base/disable_copying.h"
+#include "base/mutex.h"
+#include "base/string.h"
+#include "raster/pixel_format.h"
+
+#include <vector>
+
+namespace app {
+
+  // Commands to be applied to each file given in the command line
+  // (without starting the UI).
+  struct BatchOptions {
+    base::string saveAs;        // --save-as FILE
+    base::string sheet;         // --sheet FILE
+    bool sheetPack;             // --sheet-pack
+    double scale;               // --scale FACTOR (1.0 = no change)
+    bool changeColorMode;       // --color-mode MODE
+    raster::PixelFormat colorMode;
+    bool splitLayers;           // --split-layers
+    bool listFrames;            // --list-frames
+    int jobs;                   // --jobs N (0 = one per CPU)
+
+    BatchOptions();
+
+    // Returns true if some command was specified, so the files must
+    // be processed by the BatchProcessor.
+    bool hasCommands() const;
+  };
+
+  // Loads each file in its own Document (not added to any context),
+  // applies the commands of BatchOptions in the following order:
+  // color mode, scale, list frames, save as, and sprite sheet, and
+  // then destroys the document. Several files are processed in
+  // parallel when "jobs" is not 1.
+  //
+  // In output file names "{path}" and "{title}" are replaced with
+  // the directory and the title of the input file, and "{layer}"
+  // with the name of the layer (for --split-layers).
+  class BatchProcessor {
+  public:
+    BatchProcessor(const BatchOptions& options);
+
+    // Returns the exit code for the program: 0 if all files were
+    // processed successfully, 1 if some file failed.
+    int run(const std::vector<base::string>& files);
+
+  private:
+    class FileTask;
+
+    bool processFile(const base::string& filename, base::string& output, base::string& errors);
+    void reportFile(const base::string& filename, bool ok,
+                    const base::string& output, const base::string& errors);
+
+    const BatchOptions& m_options;
+
+    // Protects m_failures and the standard output/error (so the
+    // output of each file is not mixed with the output of others).
+    base::mutex m_mutex;
+    int m_failures;
+
+    DISABLE_COPYING(BatchProcessor);
+  };
+
+} // namespace app
+
+#endif
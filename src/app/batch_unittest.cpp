@@ -0,0 +1,251 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tests/test.h"
+
+#include "app/batch.h"
+#include "app/document.h"
+#include "app/document_api.h"
+#include "app/document_undo.h"
+#include "app/file/file.h"
+#include "app/file/file_formats_manager.h"
+#include "app/util/packed_sprite_sheet.h"
+#include "base/fs.h"
+#include "base/path.h"
+#include "base/unique_ptr.h"
+#include "raster/raster.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace app;
+using namespace base;
+using namespace raster;
+
+// Creates a test file with two frames and two layers.
+static string create_test_file(const string& path)
+{
+  UniquePtr<Document> doc(Document::createBasicDocument(IMAGE_RGB, 8, 4, 256));
+  Sprite* sprite = doc->getSprite();
+  doc->getUndo()->setEnabled(false);
+
+  DocumentApi api = doc->getApi();
+  api.addFrame(sprite, FrameNumber(1));
+  api.setFrameDuration(sprite, FrameNumber(1), 50);
+
+  LayerImage* layer = api.newLayer(sprite);
+  layer->setName("b");
+  sprite->getFolder()->getFirstLayer()->setName("a");
+
+  string filename = join_path(path, "test.ase");
+  doc->setFilename(filename);
+  EXPECT_EQ(0, save_document(doc));
+  return filename;
+}
+
+static Document* load_test_file(const string& filename)
+{
+  EXPECT_TRUE(file_exists(filename));
+  return load_document(filename.c_str());
+}
+
+class BatchTest : public ::testing::Test {
+protected:
+  static void SetUpTestCase() {
+    FileFormatsManager::instance().registerAllFormats();
+  }
+
+  void SetUp() {
+    m_path = join_path(get_temp_path(), "aseprite_batch_unittest");
+    if (!directory_exists(m_path))
+      make_directory(m_path);
+
+    m_files.push_back(create_test_file(m_path));
+  }
+
+  // Deletes the files created by the test and the directory.
+  void TearDown() {
+    m_outputs.insert(m_outputs.end(), m_files.begin(), m_files.end());
+    for (size_t i=0; i<m_outputs.size(); ++i)
+      if (file_exists(m_outputs[i]))
+        delete_file(m_outputs[i]);
+
+    EXPECT_NO_THROW(remove_directory(m_path));
+  }
+
+  // Returns the full path of a file that the test creates (so it's
+  // deleted at the end of the test).
+  string outputFile(const string& name) {
+    string filename = join_path(m_path, name);
+    m_outputs.push_back(filename);
+    return filename;
+  }
+
+  string m_path;
+  std::vector<string> m_files;
+  std::vector<string> m_outputs;
+};
+
+TEST_F(BatchTest, ScaleAndSaveAs)
+{
+  BatchOptions options;
+  options.scale = 2.0;
+  options.saveAs = "{path}/{title}-x2.ase";
+  EXPECT_TRUE(options.hasCommands());
+  EXPECT_EQ(0, BatchProcessor(options).run(m_files));
+
+  UniquePtr<Document> doc(load_test_file(outputFile("test-x2.ase")));
+  ASSERT_TRUE(doc != NULL);
+  EXPECT_EQ(16, doc->getSprite()->getWidth());
+  EXPECT_EQ(8, doc->getSprite()->getHeight());
+  EXPECT_EQ(2, doc->getSprite()->getTotalFrames());
+  EXPECT_EQ(50, doc->getSprite()->getFrameDuration(FrameNumber(1)));
+}
+
+TEST_F(BatchTest, ChangeColorMode)
+{
+  BatchOptions options;
+  options.changeColorMode = true;
+  options.colorMode = IMAGE_GRAYSCALE;
+  options.saveAs = "{path}/{title}-gray.ase";
+  EXPECT_TRUE(options.hasCommands());
+  EXPECT_EQ(0, BatchProcessor(options).run(m_files));
+
+  UniquePtr<Document> doc(load_test_file(outputFile("test-gray.ase")));
+  ASSERT_TRUE(doc != NULL);
+  EXPECT_EQ(IMAGE_GRAYSCALE, doc->getSprite()->getPixelFormat());
+  EXPECT_EQ(8, doc->getSprite()->getWidth());
+  EXPECT_EQ(2, doc->getSprite()->getTotalFrames());
+}
+
+TEST_F(BatchTest, ListFrames)
+{
+  UniquePtr<Document> doc(load_test_file(m_files[0]));
+  ASSERT_TRUE(doc != NULL);
+
+  std::ostringstream expected;
+  expected << m_files[0] << "\t0\t" << doc->getSprite()->getFrameDuration(FrameNumber(0)) << "\n"
+           << m_files[0] << "\t1\t50\n";
+
+  BatchOptions options;
+  options.listFrames = true;
+  EXPECT_TRUE(options.hasCommands());
+
+  // Capture the standard output.
+  std::ostringstream output;
+  std::streambuf* oldBuf = std::cout.rdbuf(output.rdbuf());
+  int result = BatchProcessor(options).run(m_files);
+  std::cout.rdbuf(oldBuf);
+
+  EXPECT_EQ(0, result);
+  EXPECT_EQ(expected.str(), output.str());
+}
+
+TEST_F(BatchTest, SplitLayersInSheets)
+{
+  BatchOptions options;
+  options.sheet = "{path}/{title}-{layer}.ase";
+  options.splitLayers = true;
+  options.jobs = 2;
+  EXPECT_EQ(0, BatchProcessor(options).run(m_files));
+
+  const char* layers[] = { "a", "b" };
+  for (int i=0; i<2; ++i) {
+    UniquePtr<Document> doc(load_test_file(outputFile(string("test-") + layers[i] + ".ase")));
+    ASSERT_TRUE(doc != NULL);
+    EXPECT_EQ(16, doc->getSprite()->getWidth());
+    EXPECT_EQ(1, doc->getSprite()->getTotalFrames());
+  }
+}
+
+TEST_F(BatchTest, PackedSheet)
+{
+  // Three frames, the first two ones are equal.
+  UniquePtr<Document> doc(Document::createBasicDocument(IMAGE_RGB, 8, 4, 256));
+  Sprite* sprite = doc->getSprite();
+  LayerImage* layer = static_cast<LayerImage*>(sprite->getFolder()->getFirstLayer());
+  doc->getUndo()->setEnabled(false);
+
+  Image* image = sprite->getStock()->getImage(layer->getCel(FrameNumber(0))->getImage());
+  put_pixel(image, 2, 1, rgba(255, 0, 0, 255));
+  put_pixel(image, 3, 2, rgba(255, 0, 0, 255));
+
+  DocumentApi api = doc->getApi();
+  api.addFrame(sprite, FrameNumber(1));
+  api.addFrame(sprite, FrameNumber(2));
+
+  image = sprite->getStock()->getImage(layer->getCel(FrameNumber(2))->getImage());
+  put_pixel(image, 7, 3, rgba(0, 0, 255, 128));
+
+  {
+    PackedSpriteSheet sheet(sprite);
+    const std::vector<PackedFrame>& frames = sheet.getFrames();
+    ASSERT_EQ(3, (int)frames.size());
+    EXPECT_EQ(2, sheet.getUniqueFrames());
+
+    EXPECT_EQ(-1, frames[0].sameAs);
+    EXPECT_EQ(0, frames[1].sameAs);
+    EXPECT_EQ(-1, frames[2].sameAs);
+    EXPECT_TRUE(frames[0].trimBounds == gfx::Rect(2, 1, 2, 2));
+    EXPECT_TRUE(frames[1].sheetBounds == frames[0].sheetBounds);
+    EXPECT_TRUE(frames[2].trimBounds == gfx::Rect(2, 1, 6, 3));
+
+    // Trimmed frames are copied in the sheet.
+    const gfx::Rect& rc = frames[2].sheetBounds;
+    EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(sheet.getImage(), rc.x, rc.y));
+    EXPECT_EQ(rgba(0, 0, 255, 128), get_pixel(sheet.getImage(), rc.x+5, rc.y+2));
+
+    // Less than half of the horizontal strip.
+    EXPECT_LT(sheet.getImage()->getWidth() * sheet.getImage()->getHeight(), 8*4*3 / 2);
+  }
+
+  string filename = outputFile("packed.ase");
+  doc->setFilename(filename);
+  EXPECT_EQ(0, save_document(doc));
+
+  BatchOptions options;
+  options.sheet = "{path}/{title}-atlas.png";
+  options.sheetPack = true;
+  EXPECT_EQ(0, BatchProcessor(options).run(std::vector<string>(1, filename)));
+  EXPECT_TRUE(file_exists(outputFile("packed-atlas.json")));
+
+  UniquePtr<Document> atlas(load_test_file(outputFile("packed-atlas.png")));
+  ASSERT_TRUE(atlas != NULL);
+  EXPECT_EQ(1, atlas->getSprite()->getTotalFrames());
+  EXPECT_GE(8, atlas->getSprite()->getWidth());
+}
+
+TEST_F(BatchTest, Errors)
+{
+  BatchOptions options;
+  options.saveAs = "{path}/{title}.unknown";
+  outputFile("test.unknown");
+  EXPECT_EQ(1, BatchProcessor(options).run(m_files));
+
+  // {layer} is needed to split layers.
+  options.saveAs = "{path}/{title}-copy.ase";
+  options.splitLayers = true;
+  EXPECT_EQ(1, BatchProcessor(options).run(m_files));
+
+  // Missing files.
+  options.splitLayers = false;
+  m_files.push_back(join_path(m_path, "missing.ase"));
+  options.saveAs = "{path}/{title}-copy.ase";
+  outputFile("test-copy.ase");
+  EXPECT_EQ(1, BatchProcessor(options).run(m_files));
+}
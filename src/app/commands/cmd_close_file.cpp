@@ -21,6 +21,7 @@
 #endif
 
 #include "app/app.h"
+#include "app/commands/cmd_save_file.h"
 #include "app/commands/command.h"
 #include "app/commands/commands.h"
 #include "app/context_access.h"
@@ -167,6 +168,13 @@ static bool close_active_document(Context* context)
         CommandsModule::instance()->getCommandByName(CommandId::SaveFile);
       context->executeCommand(save_command);
 
+      // The document is saved in background, so we wait the save to
+      // know if the document is still modified (e.g. the save failed).
+      {
+        DocumentWriter document(closedDocument);
+        wait_document_saves(document);
+      }
+
       try_again = true;
     }
     else
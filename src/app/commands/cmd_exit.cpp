@@ -21,9 +21,11 @@
 #endif
 
 #include "app/app.h"
+#include "app/commands/cmd_save_file.h"
 #include "app/commands/command.h"
 #include "app/context.h"
 #include "app/document.h"
+#include "app/document_access.h"
 #include "app/ui/main_window.h"
 #include "ui/alert.h"
 
@@ -51,7 +53,15 @@ void ExitCommand::onExecute(Context* context)
   bool modifiedFiles = false;
 
   for (Documents::const_iterator it=docs.begin(), end=docs.end(); it!=end; ++it) {
-    const Document* document = *it;
+    Document* document = *it;
+
+    // Documents being saved in background are modified until their
+    // saves finish.
+    {
+      DocumentWriter writer(document);
+      wait_document_saves(document);
+    }
+
     if (document->isModified()) {
       modifiedFiles = true;
       break;
@@ -27,13 +27,19 @@
 #include "app/document.h"
 #include "app/document_api.h"
 #include "app/document_undo.h"
+#include "app/file/file.h"
+#include "app/file_selector.h"
 #include "app/ini_file.h"
 #include "app/modules/editors.h"
 #include "app/modules/gui.h"
 #include "app/modules/palettes.h"
 #include "app/ui/editor/editor.h"
+#include "app/ui/status_bar.h"
 #include "app/undo_transaction.h"
+#include "app/util/packed_sprite_sheet.h"
 #include "base/bind.h"
+#include "base/fs.h"
+#include "base/path.h"
 #include "raster/cel.h"
 #include "raster/image.h"
 #include "raster/layer.h"
@@ -50,7 +56,7 @@ namespace app {
 using namespace ui;
 
 class ExportSpriteSheetWindow : public Window {
-  enum SpriteSheetType { HorizontalStrip, VerticalStrip, Matrix };
+  enum SpriteSheetType { HorizontalStrip, VerticalStrip, Matrix, PackedAtlas };
   enum ExportAction { SaveCopyAs, SaveAs, Save, DoNotSave };
 
 public:
@@ -68,6 +74,7 @@ public:
     m_sheetType.addItem("Horizontal Strip");
     m_sheetType.addItem("Vertical Strip");
     m_sheetType.addItem("Matrix");
+    m_sheetType.addItem("Packed Atlas");
 
     m_exportAction.addItem("Save Copy As...");
     m_exportAction.addItem("Save As...");
@@ -117,6 +124,11 @@ protected:
     m_columnsLabel.setVisible(state);
     m_columns.setVisible(state);
 
+    // The packed atlas is always saved in new files.
+    state = (m_sheetType.getSelectedItemIndex() != PackedAtlas);
+    m_exportActionLabel.setVisible(state);
+    m_exportAction.setVisible(state);
+
     gfx::Size reqSize = getPreferredSize();
     moveWindow(gfx::Rect(getOrigin(), reqSize));
 
@@ -125,6 +137,12 @@ protected:
 
   void onExport()
   {
+    if (m_sheetType.getSelectedItemIndex() == PackedAtlas) {
+      exportPackedAtlas();
+      closeWindow(NULL);
+      return;
+    }
+
     Sprite* sprite = m_document->getSprite();
     FrameNumber nframes = sprite->getTotalFrames();
     int columns;
@@ -146,16 +164,15 @@ protected:
     int sheet_w = sprite->getWidth()*columns;
     int sheet_h = sprite->getHeight()*((nframes/columns)+((nframes%columns)>0?1:0));
     base::UniquePtr<Image> resultImage(Image::create(sprite->getPixelFormat(), sheet_w, sheet_h));
-    base::UniquePtr<Image> tempImage(Image::create(sprite->getPixelFormat(), sprite->getWidth(), sprite->getHeight()));
     raster::clear_image(resultImage, 0);
 
     int column = 0, row = 0;
     for (FrameNumber frame(0); frame<nframes; ++frame) {
-      // TODO "tempImage" could not be necessary if we could specify
-      // destination clipping bounds in Sprite::render() function.
-      tempImage->clear(0);
-      sprite->render(tempImage, 0, 0, frame);
-      resultImage->copy(tempImage, column*sprite->getWidth(), row*sprite->getHeight());
+      // Render the frame directly in its cell (the clipping avoids
+      // drawing cels outside the sprite bounds in other cells).
+      gfx::Rect cell(column*sprite->getWidth(), row*sprite->getHeight(),
+                     sprite->getWidth(), sprite->getHeight());
+      sprite->render(resultImage, cell.x, cell.y, frame, cell);
 
       if (++column >= columns) {
         column = 0;
@@ -297,6 +314,47 @@ protected:
     closeWindow(NULL);
   }
 
+  // Saves the packed atlas and a .json file with the position of each
+  // frame. The document is not modified.
+  void exportPackedAtlas()
+  {
+    char exts[4096];
+    get_writable_extensions(exts, sizeof(exts));
+
+    base::string docFilename = m_document->getFilename();
+    base::string filename =
+      app::show_file_selector("Export Packed Atlas",
+                              base::join_path(base::get_file_path(docFilename),
+                                              base::get_file_title(docFilename) + "-sheet.png"),
+                              exts);
+    if (filename.empty())
+      return;
+
+    if (base::file_exists(filename) &&
+        Alert::show("Warning<<File exists, overwrite it?<<%s||&Yes||&No",
+                    base::get_file_name(filename).c_str()) != 1)
+      return;
+
+    ContextReader reader(m_context);
+    PackedSpriteSheet sheet(reader.document()->getSprite());
+
+    base::UniquePtr<Document> sheetDoc(sheet.createDocument());
+    sheetDoc->setFilename(filename);
+    if (save_document(sheetDoc.get()) != 0)
+      return;
+
+    if (!sheet.saveJson(filename)) {
+      Alert::show("Error<<Saving sprite sheet data<<%s||&Close",
+                  base::get_file_name(PackedSpriteSheet::getJsonFilename(filename)).c_str());
+      return;
+    }
+
+    StatusBar::instance()->setStatusText
+      (2000, "Packed atlas %dx%d (%d unique frames of %d)",
+       sheet.getImage()->getWidth(), sheet.getImage()->getHeight(),
+       sheet.getUniqueFrames(), (int)sheet.getFrames().size());
+  }
+
 private:
   Context* m_context;
   Document* m_document;
@@ -33,6 +33,7 @@
 #include "app/settings/document_settings.h"
 #include "app/settings/settings.h"
 #include "app/ui/editor/editor.h"
+#include "app/util/frame_render_cache.h"
 #include "raster/conversion_alleg.h"
 #include "raster/image.h"
 #include "raster/palette.h"
@@ -104,6 +105,19 @@ void PlayAnimationCommand::onExecute(Context* context)
   // Clear extras (e.g. pen preview)
   document->destroyExtraCel();
 
+  // Render the visible part of the sprite in background (the
+  // document is locked for writing, so nobody else can modify the
+  // sprite while we are playing the animation).
+  int zoom = current_editor->getZoom();
+  gfx::Rect bounds = current_editor->getVisibleSpriteBounds()
+    .createIntersect(gfx::Rect(0, 0, sprite->getWidth(), sprite->getHeight()));
+  FrameRenderCache renderCache(document, sprite, current_editor->getLayer(),
+                               gfx::Rect(bounds.x << zoom, bounds.y << zoom,
+                                         bounds.w << zoom, bounds.h << zoom),
+                               zoom, true);
+  renderCache.prefetch(current_editor->getFrame());
+  current_editor->setFrameRenderCache(&renderCache);
+
   // Do animation
   oldpal = NULL;
   speed_timer = 0;
@@ -136,13 +150,29 @@ void PlayAnimationCommand::onExecute(Context* context)
       FrameNumber frame = current_editor->getFrame().next();
       if (frame > sprite->getLastFrame())
         frame = FrameNumber(0);
-      current_editor->setFrame(frame);
 
       speed_timer--;
+
+      // If we are late, skip the frames that are not rendered yet.
+      for (int skipped=0;
+           speed_timer > 0 && !renderCache.isFrameReady(frame) &&
+             skipped < sprite->getTotalFrames()-1;
+           ++skipped) {
+        frame = frame.next();
+        if (frame > sprite->getLastFrame())
+          frame = FrameNumber(0);
+
+        speed_timer--;
+      }
+
+      renderCache.prefetch(frame);
+      current_editor->setFrame(frame);
     }
     gui_feedback();
   }
 
+  current_editor->setFrameRenderCache(NULL);
+
   // Restore onionskin flag
   docSettings->setUseOnionskin(onionskin_state);
 
@@ -36,6 +36,7 @@
 #include "app/settings/settings.h"
 #include "app/ui/editor/editor.h"
 #include "app/ui/status_bar.h"
+#include "app/util/frame_render_cache.h"
 #include "app/util/render.h"
 #include "raster/conversion_alleg.h"
 #include "raster/image.h"
@@ -126,6 +127,13 @@ void PreviewCommand::onExecute(Context* context)
   base::UniquePtr<Image> render;
   base::UniquePtr<Image> doublebuf(Image::create(IMAGE_RGB, JI_SCREEN_W, JI_SCREEN_H));
 
+  // Pre-render the next frames in background so we can move through
+  // frames without waiting the render of each one.
+  gfx::Rect spriteBounds(0, 0, sprite->getWidth(), sprite->getHeight());
+  FrameRenderCache renderCache(document, sprite, editor->getLayer(),
+                               spriteBounds, 0, false);
+  renderCache.prefetch(editor->getFrame());
+
   do {
     // Update scroll
     if (jmouse_poll()) {
@@ -139,11 +147,17 @@ void PreviewCommand::onExecute(Context* context)
 
     // Render sprite and leave the result in 'render' variable
     if (render == NULL) {
-      RenderEngine renderEngine(document, sprite,
-                                editor->getLayer(),
-                                editor->getFrame());
-      render.reset(renderEngine.renderSprite(0, 0, sprite->getWidth(), sprite->getHeight(),
-                                             editor->getFrame(), 0, false));
+      renderCache.prefetch(editor->getFrame());
+      render.reset(renderCache.getFrameImage(editor->getFrame(), spriteBounds));
+
+      // The frame is not ready yet, render it now
+      if (render == NULL) {
+        RenderEngine renderEngine(document, sprite,
+                                  editor->getLayer(),
+                                  editor->getFrame());
+        render.reset(renderEngine.renderSprite(0, 0, sprite->getWidth(), sprite->getHeight(),
+                                               editor->getFrame(), 0, false));
+      }
     }
 
     // Redraw the screen
@@ -29,6 +29,9 @@
 #include "app/modules/gui.h"
 #include "app/ui/color_bar.h"
 #include "app/undo_transaction.h"
+#include "base/mutex.h"
+#include "base/parallel_for.h"
+#include "base/scoped_lock.h"
 #include "raster/cel.h"
 #include "raster/image.h"
 #include "raster/mask.h"
@@ -38,6 +41,8 @@
 
 #include <allegro/unicode.h>
 
+#include <vector>
+
 namespace app {
 
 class RotateCanvasCommand : public Command {
@@ -60,6 +65,43 @@ class RotateCanvasJob : public Job
   Sprite* m_sprite;
   int m_angle;
 
+  // Rotation of one image of the stock.
+  struct StockRotation {
+    int index;
+    const Image* image;
+    Image* new_image;
+  };
+
+  // Functor used in base::parallel_for() to rotate each image from
+  // worker threads.
+  class RotateImageFunc {
+  public:
+    RotateImageFunc(RotateCanvasJob* job,
+                    const std::vector<StockRotation>& rotations,
+                    base::mutex& mutex, int& done)
+      : m_job(job), m_rotations(rotations)
+      , m_mutex(mutex), m_done(done) {
+    }
+
+    void operator()(int i) const {
+      if (m_job->isCanceled())
+        return;
+
+      const StockRotation& rotation = m_rotations[i];
+      raster::rotate_image(rotation.image, rotation.new_image, m_job->m_angle);
+
+      base::scoped_lock hold(m_mutex);
+      ++m_done;
+      m_job->jobProgress((float)m_done / m_rotations.size());
+    }
+
+  private:
+    RotateCanvasJob* m_job;
+    const std::vector<StockRotation>& m_rotations;
+    base::mutex& m_mutex;
+    int& m_done;
+  };
+
 public:
 
   RotateCanvasJob(const ContextReader& reader, int angle)
@@ -110,27 +152,42 @@ protected:
       }
     }
 
-    // for each stock's image
+    // Create the new images for each stock's image.
+    std::vector<StockRotation> rotations;
     for (int i=0; i<m_sprite->getStock()->size(); ++i) {
       Image* image = m_sprite->getStock()->getImage(i);
       if (!image)
         continue;
 
-      // rotate the image
-      Image* new_image = Image::create(image->getPixelFormat(),
-                                       m_angle == 180 ? image->getWidth(): image->getHeight(),
-                                       m_angle == 180 ? image->getHeight(): image->getWidth());
-      raster::rotate_image(image, new_image, m_angle);
-
-      api.replaceStockImage(m_sprite, i, new_image);
+      StockRotation rotation;
+      rotation.index = i;
+      rotation.image = image;
+      rotation.new_image = Image::create(image->getPixelFormat(),
+                                         m_angle == 180 ? image->getWidth(): image->getHeight(),
+                                         m_angle == 180 ? image->getHeight(): image->getWidth());
+      rotations.push_back(rotation);
+    }
 
-      jobProgress((float)i / m_sprite->getStock()->size());
+    // Rotate all images in parallel.
+    {
+      base::mutex mutex;
+      int done = 0;
+      base::parallel_for(0, rotations.size(),
+                         RotateImageFunc(this, rotations, mutex, done));
+    }
 
-      // cancel all the operation?
-      if (isCanceled())
-        return;        // UndoTransaction destructor will undo all operations
+    // cancel all the operation?
+    if (isCanceled()) {
+      for (size_t i=0; i<rotations.size(); ++i)
+        delete rotations[i].new_image;
+      return;        // UndoTransaction destructor will undo all operations
     }
 
+    // Replace the images (undoable operations are done in this thread
+    // only).
+    for (size_t i=0; i<rotations.size(); ++i)
+      api.replaceStockImage(m_sprite, rotations[i].index, rotations[i].new_image);
+
     // rotate mask
     if (m_document->isMaskVisible()) {
       Mask* origMask = m_document->getMask();
@@ -20,16 +20,20 @@
 #include "config.h"
 #endif
 
+#include "app/commands/cmd_save_file.h"
+
 #include "app/app.h"
 #include "app/commands/command.h"
 #include "app/console.h"
 #include "app/context_access.h"
+#include "app/context_observer.h"
+#include "app/document_snapshot.h"
 #include "app/file/file.h"
 #include "app/file_selector.h"
-#include "app/job.h"
 #include "app/modules/gui.h"
 #include "app/recent_files.h"
 #include "app/ui/status_bar.h"
+#include "app/ui_context.h"
 #include "base/bind.h"
 #include "base/fs.h"
 #include "base/path.h"
@@ -38,65 +42,283 @@
 #include "raster/sprite.h"
 #include "ui/ui.h"
 
+#include <vector>
+
 static const int kMonitoringPeriod = 100;
 
 namespace app {
 
-class SaveFileJob : public Job, public IFileOpProgress {
+// Saves a snapshot of a document from a background thread, so the
+// user can continue editing the document meanwhile. Files are written
+// with a temporary name, and then they are renamed to replace the
+// original files, so a failed save doesn't destroy the previous file.
+class BackgroundSave {
 public:
-  SaveFileJob(FileOp* fop)
-    : Job("Saving file")
+  BackgroundSave(Document* document, DocumentSnapshot* snapshot, FileOp* fop,
+                 bool markAsSaved, ui::Timer* timer)
+    : m_document(document)
+    , m_snapshot(snapshot)
     , m_fop(fop)
+    , m_markAsSaved(markAsSaved)
+    , m_timer(timer)
+    , m_thread(NULL)
   {
+    if (m_fop->is_sequence()) {
+      for (size_t i=0; i<m_fop->seq.filename_list.size(); ++i)
+        useTempFile(m_fop->seq.filename_list[i]);
+      m_fop->filename = m_fop->seq.filename_list[0];
+    }
+    else
+      useTempFile(m_fop->filename);
+
+    m_thread = new base::thread(Bind<void>(&BackgroundSave::saveProc, this));
   }
 
-  void showProgressWindow() {
-    startJob();
-    fop_stop(m_fop);
+  ~BackgroundSave() {
+    wait();
+    fop_free(m_fop);
+    delete m_snapshot;
+  }
+
+  Document* getDocument() const { return m_document; }
+
+  // The document was closed.
+  void detachDocument() { m_document = NULL; }
+
+  bool isDone() const { return fop_is_done(m_fop); }
+
+  void wait() {
+    if (m_thread) {
+      m_thread->join();
+      delete m_thread;
+      m_thread = NULL;
+    }
+  }
+
+  // Reports the result of the save. The document (if it wasn't
+  // closed) must be locked to write.
+  void finish() {
+    wait();
+
+    if (m_fop->has_error()) {
+      Console console;
+      console.printf(m_fop->error.c_str());
+      return;
+    }
+
+    const base::string& filename = m_snapshot->getDocument()->getFilename();
+    App::instance()->getRecentFiles()->addRecentFile(filename.c_str());
+
+    if (m_document) {
+      if (m_markAsSaved)
+        m_document->markSavingAsSaved();
+
+      update_screen_for_document(m_document);
+    }
+
+    StatusBar::instance()
+      ->setStatusText(2000, "File %s, saved.",
+                      base::get_file_name(filename).c_str());
   }
 
 private:
+  void useTempFile(std::string& filename) {
+    m_targets.push_back(filename);
+    filename += ".tmp";
+  }
 
   // Thread to do the hard work: save the file to the disk.
-  virtual void onJob() OVERRIDE {
+  void saveProc() {
     try {
-      fop_operate(m_fop, this);
+      fop_operate(m_fop, NULL);
+
+      if (!m_fop->has_error())
+        replaceTargets();
     }
     catch (const std::exception& e) {
       fop_error(m_fop, "Error saving file:\n%s", e.what());
     }
+
+    // Remove temporary files of a failed save.
+    if (m_fop->has_error())
+      removeTempFiles();
+
     fop_done(m_fop);
+
+    if (m_timer)
+      m_timer->tickFromThread();
   }
 
-  virtual void ackFileOpProgress(double progress) OVERRIDE {
-    jobProgress(progress);
+  void replaceTargets() {
+    for (size_t i=0; i<m_targets.size(); ++i)
+      base::move_file(m_targets[i] + ".tmp", m_targets[i]);
+  }
+
+  void removeTempFiles() {
+    for (size_t i=0; i<m_targets.size(); ++i) {
+      std::string tmp = m_targets[i] + ".tmp";
+      try {
+        if (base::file_exists(tmp))
+          base::delete_file(tmp);
+      }
+      catch (const std::exception&) {
+        // Ignore errors, the error of the save is more important.
+      }
+    }
   }
 
+  Document* m_document;
+  DocumentSnapshot* m_snapshot;
   FileOp* m_fop;
+  bool m_markAsSaved;
+  ui::Timer* m_timer;
+  base::thread* m_thread;
+  std::vector<std::string> m_targets;
+};
+
+// Saves in progress. Finished saves are reported from the UI thread
+// (from a timer), and the saves of a document are waited before
+// closing it.
+class BackgroundSaves : public ContextObserver {
+public:
+  static BackgroundSaves* instance() {
+    static BackgroundSaves saves;
+    return &saves;
+  }
+
+  ui::Timer* getTimer() {
+    if (!m_timer) {
+      m_timer.reset(new ui::Timer(kMonitoringPeriod));
+      m_timer->Tick.connect(&BackgroundSaves::onTick, this);
+    }
+    return m_timer;
+  }
+
+  void add(BackgroundSave* save) {
+    m_saves.push_back(save);
+    getTimer()->start();
+  }
+
+  // Waits the saves of the given document. The document must be
+  // locked to write.
+  void waitDocument(Document* document) {
+    BackgroundSave* save;
+    while ((save = takeSave(document, false)) != NULL) {
+      save->finish();
+      delete save;
+    }
+  }
+
+private:
+  BackgroundSaves() {
+    UIContext::instance()->addObserver(this);
+  }
+
+  // Removes a save from the list (a finished one, or any save of the
+  // given document).
+  BackgroundSave* takeSave(Document* document, bool onlyDone) {
+    for (std::vector<BackgroundSave*>::iterator
+           it=m_saves.begin(), end=m_saves.end(); it != end; ++it) {
+      BackgroundSave* save = *it;
+      if ((!document || save->getDocument() == document) &&
+          (!onlyDone || save->isDone())) {
+        m_saves.erase(it);
+        return save;
+      }
+    }
+    return NULL;
+  }
+
+  void onTick() {
+    std::vector<BackgroundSave*> locked;
+    BackgroundSave* save;
+
+    while ((save = takeSave(NULL, true)) != NULL) {
+      Document* document = save->getDocument();
+
+      // If the document is being used, we try again in the next tick.
+      if (document && !document->lock(Document::WriteLock)) {
+        locked.push_back(save);
+        continue;
+      }
+
+      save->finish();
+      delete save;
+
+      if (document)
+        document->unlock();
+    }
+
+    m_saves.insert(m_saves.end(), locked.begin(), locked.end());
+    if (m_saves.empty())
+      m_timer->stop();
+  }
+
+  void onRemoveDocument(Context* context, Document* document) OVERRIDE {
+    BackgroundSave* save;
+    while ((save = takeSave(document, false)) != NULL) {
+      save->detachDocument();
+      save->finish();
+      delete save;
+    }
+
+    // We cannot destroy the timer from its own tick, so we destroy it
+    // here (all documents are closed before the UI is shut down).
+    if (m_saves.empty())
+      m_timer.reset(NULL);
+  }
+
+  std::vector<BackgroundSave*> m_saves;
+  base::UniquePtr<ui::Timer> m_timer;
 };
 
-static void save_document_in_background(Document* document, bool mark_as_saved)
+// Saves a snapshot of the document with the given file name. If
+// "mark_as_saved" is true, the document is renamed and it will be
+// marked as saved when the snapshot is written (if it wasn't undone
+// to a previous state meanwhile), in other case it's a copy.
+static void save_document_in_background(Document* document,
+                                        const base::string& filename,
+                                        bool mark_as_saved)
 {
-  base::UniquePtr<FileOp> fop(fop_to_save_document(document));
+  BackgroundSaves* saves = BackgroundSaves::instance();
+
+  // Only one save of the same document at the same time (they share
+  // the format options and the saving state).
+  saves->waitDocument(document);
+
+  base::UniquePtr<DocumentSnapshot> snapshot(document->createSnapshot());
+  snapshot->getDocument()->setFilename(filename);
+
+  FileOp* fop = fop_to_save_document(snapshot->getDocument());
   if (!fop)
     return;
 
-  SaveFileJob job(fop);
-  job.showProgressWindow();
-
   if (fop->has_error()) {
     Console console;
     console.printf(fop->error.c_str());
+    fop_free(fop);
+    return;
   }
-  else {
-    App::instance()->getRecentFiles()->addRecentFile(document->getFilename().c_str());
-    if (mark_as_saved)
-      document->markAsSaved();
 
-    StatusBar::instance()
-      ->setStatusText(2000, "File %s, saved.",
-                      base::get_file_name(document->getFilename()));
+  if (fop->seq.format_options != NULL)
+    document->setFormatOptions(fop->seq.format_options);
+
+  if (mark_as_saved) {
+    document->setFilename(filename);
+    document->markAsSaving();
   }
+
+  StatusBar::instance()
+    ->setStatusText(0, "Saving file %s...",
+                    base::get_file_name(filename).c_str());
+
+  saves->add(new BackgroundSave(document, snapshot.release(), fop,
+                                mark_as_saved, saves->getTimer()));
+}
+
+void wait_document_saves(Document* document)
+{
+  BackgroundSaves::instance()->waitDocument(document);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -141,11 +363,8 @@ static void save_as_dialog(const ContextReader& reader, const char* dlg_title, b
     ContextWriter writer(reader);
     Document* documentWriter = writer.document();
 
-    // Change the document file name
-    documentWriter->setFilename(filename.c_str());
-
-    // Save the document
-    save_document_in_background(documentWriter, mark_as_saved);
+    // Save the document (with the new file name)
+    save_document_in_background(documentWriter, filename, mark_as_saved);
 
     update_screen_for_document(documentWriter);
   }
@@ -188,7 +407,7 @@ void SaveFileCommand::onExecute(Context* context)
     ContextWriter writer(reader);
     Document* documentWriter = writer.document();
 
-    save_document_in_background(documentWriter, true);
+    save_document_in_background(documentWriter, documentWriter->getFilename(), true);
     update_screen_for_document(documentWriter);
   }
   // If the document isn't associated to a file, we must to show the
@@ -252,18 +471,10 @@ bool SaveFileCopyAsCommand::onEnabled(Context* context)
 void SaveFileCopyAsCommand::onExecute(Context* context)
 {
   const ContextReader reader(context);
-  const Document* document(reader.document());
-  base::string old_filename = document->getFilename();
 
-  // show "Save As" dialog
+  // show "Save As" dialog (the copy doesn't change the file name of
+  // the document)
   save_as_dialog(reader, "Save Copy As", false);
-
-  // Restore the file name.
-  {
-    ContextWriter writer(reader);
-    writer.document()->setFilename(old_filename.c_str());
-    update_screen_for_document(writer.document());
-  }
 }
 
 Command* CommandFactory::createSaveFileCommand()
@@ -32,18 +32,24 @@
 #include "app/ui_context.h"
 #include "app/undo_transaction.h"
 #include "base/bind.h"
+#include "base/task_scheduler.h"
 #include "base/unique_ptr.h"
 #include "raster/algorithm/resize_image.h"
 #include "raster/cel.h"
 #include "raster/image.h"
 #include "raster/mask.h"
+#include "raster/palette.h"
 #include "raster/primitives.h"
+#include "raster/rgbmap.h"
 #include "raster/sprite.h"
 #include "raster/stock.h"
 #include "ui/ui.h"
 
 #include <allegro/unicode.h>
 
+#include <map>
+#include <vector>
+
 #define PERC_FORMAT     "%.1f"
 
 namespace app {
@@ -51,6 +57,10 @@ namespace app {
 using namespace ui;
 using raster::algorithm::ResizeMethod;
 
+// Number of rows of each piece of work when cel images are resized in
+// parallel (so big images are split between several threads too).
+static const int kRowsPerResizeBand = 64;
+
 class SpriteSizeJob : public Job {
   ContextWriter m_writer;
   Document* m_document;
@@ -62,6 +72,46 @@ class SpriteSizeJob : public Job {
   inline int scale_x(int x) const { return x * m_new_width / m_sprite->getWidth(); }
   inline int scale_y(int y) const { return y * m_new_height / m_sprite->getHeight(); }
 
+  // Resize of one cel image.
+  struct CelResize {
+    Cel* cel;
+    const Image* image;
+    Image* new_image;
+    const Palette* palette;
+    const RgbMap* rgbmap;
+  };
+
+  // A band of rows of a cel image to be resized.
+  struct ResizeBand {
+    int cel_resize;
+    int y1, y2;
+  };
+
+  // Task to resize a band of rows from a thread of the task
+  // scheduler. Each finished band is one unit of work of the group
+  // (which is reported as the job progress).
+  class ResizeBandTask : public base::Task {
+  public:
+    ResizeBandTask(base::TaskGroup& group, const CelResize& resize,
+                   ResizeMethod method, const ResizeBand& band)
+      : m_group(group), m_resize(resize), m_method(method), m_band(band) {
+    }
+
+    void run() {
+      raster::algorithm::resize_image(m_resize.image, m_resize.new_image,
+                                      m_method,
+                                      m_resize.palette, m_resize.rgbmap,
+                                      m_band.y1, m_band.y2);
+      m_group.addDoneWork(1);
+    }
+
+  private:
+    base::TaskGroup& m_group;
+    CelResize m_resize;
+    ResizeMethod m_method;
+    ResizeBand m_band;
+  };
+
 public:
 
   SpriteSizeJob(const ContextReader& reader, int new_width, int new_height, ResizeMethod resize_method)
@@ -89,37 +139,83 @@ protected:
     CelList cels;
     m_sprite->getCels(cels);
 
-    // For each cel...
-    int progress = 0;
-    for (CelIterator it = cels.begin(); it != cels.end(); ++it, ++progress) {
-      Cel* cel = *it;
+    // The RgbMap of the sprite is regenerated each time a different
+    // palette is requested, so we need one RgbMap for each palette to
+    // use them from several threads.
+    std::map<const Palette*, RgbMap*> rgbmaps;
 
-      // Change its location
-      api.setCelPosition(m_sprite, cel, scale_x(cel->getX()), scale_y(cel->getY()));
+    // Create the new images and split them in bands of rows.
+    std::vector<CelResize> resizes;
+    std::vector<ResizeBand> bands;
 
-      // Get cel's image
+    for (CelIterator it = cels.begin(); it != cels.end(); ++it) {
+      Cel* cel = *it;
       Image* image = m_sprite->getStock()->getImage(cel->getImage());
       if (!image)
         continue;
 
-      // Resize the image
       int w = scale_x(image->getWidth());
       int h = scale_y(image->getHeight());
-      Image* new_image = Image::create(image->getPixelFormat(), MAX(1, w), MAX(1, h));
 
-      raster::algorithm::fixup_image_transparent_colors(image);
-      raster::algorithm::resize_image(image, new_image,
-                                      m_resize_method,
-                                      m_sprite->getPalette(cel->getFrame()),
-                                      m_sprite->getRgbMap(cel->getFrame()));
+      CelResize resize;
+      resize.cel = cel;
+      resize.image = image;
+      resize.new_image = Image::create(image->getPixelFormat(), MAX(1, w), MAX(1, h));
+      resize.palette = m_sprite->getPalette(cel->getFrame());
+
+      RgbMap*& rgbmap = rgbmaps[resize.palette];
+      if (!rgbmap) {
+        rgbmap = new RgbMap;
+        rgbmap->regenerate(resize.palette);
+      }
+      resize.rgbmap = rgbmap;
+      resizes.push_back(resize);
+
+      for (int y=0; y<resize.new_image->getHeight(); y+=kRowsPerResizeBand) {
+        ResizeBand band;
+        band.cel_resize = resizes.size()-1;
+        band.y1 = y;
+        band.y2 = MIN(y+kRowsPerResizeBand, resize.new_image->getHeight());
+        bands.push_back(band);
+      }
+    }
+
+    // Resize all images in parallel (bands that weren't started are
+    // skipped if the job is canceled).
+    {
+      base::TaskGroup group;
+      group.addTotalWork(bands.size());
+      for (size_t i=0; i<bands.size(); ++i)
+        group.add(new ResizeBandTask(group, resizes[bands[i].cel_resize],
+                                     m_resize_method, bands[i]));
 
-      api.replaceStockImage(m_sprite, cel->getImage(), new_image);
+      waitTaskGroup(group);
+    }
+
+    for (std::map<const Palette*, RgbMap*>::iterator
+           it = rgbmaps.begin(), end = rgbmaps.end(); it != end; ++it)
+      delete it->second;
 
-      jobProgress((float)progress / cels.size());
+    // Cancel all the operation?
+    if (isCanceled()) {
+      for (size_t i=0; i<resizes.size(); ++i)
+        delete resizes[i].new_image;
+      return;        // UndoTransaction destructor will undo all operations
+    }
+
+    // Replace the images and change the cels location (undoable
+    // operations are done in this thread only).
+    size_t i = 0;
+    for (CelIterator it = cels.begin(); it != cels.end(); ++it) {
+      Cel* cel = *it;
+
+      // Change its location
+      api.setCelPosition(m_sprite, cel, scale_x(cel->getX()), scale_y(cel->getY()));
 
-      // cancel all the operation?
-      if (isCanceled())
-        return;        // UndoTransaction destructor will undo all operations
+      if (i < resizes.size() && resizes[i].cel == cel) {
+        api.replaceStockImage(m_sprite, cel->getImage(), resizes[i].new_image);
+        ++i;
+      }
     }
 
     // Resize mask
@@ -30,6 +30,7 @@
 #include "app/commands/command.h"
 #include "app/commands/commands.h"
 #include "app/console.h"
+#include "app/startup_profiler.h"
 
 namespace app {
 
@@ -43,6 +44,8 @@ CommandsModule* CommandsModule::m_instance = NULL;
 
 CommandsModule::CommandsModule()
 {
+  StartupMarker marker("Commands module");
+
   ASSERT(m_instance == NULL);
   m_instance = this;
 
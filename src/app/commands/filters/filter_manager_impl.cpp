@@ -47,7 +47,29 @@ namespace app {
 
 using namespace std;
 using namespace ui;
-  
+
+namespace {
+
+// Interlaced passes used to preview the visible area of the editor.
+// Each filtered row is replicated in the next "fill" rows, so the user
+// sees a coarse version of the whole visible area after the first
+// pass, and the result is refined in the following passes.
+struct InterlacedPass {
+  int start, step, fill;
+};
+
+const InterlacedPass interlaced_passes[] = {
+  { 0, 8, 8 },
+  { 4, 8, 4 },
+  { 2, 4, 2 },
+  { 1, 2, 1 }
+};
+
+const int interlaced_passes_count =
+  sizeof(interlaced_passes) / sizeof(interlaced_passes[0]);
+
+} // anonymous namespace
+
 FilterManagerImpl::FilterManagerImpl(Context* context, Filter* filter)
   : m_context(context)
   , m_location(context->getActiveLocation())
@@ -55,6 +77,9 @@ FilterManagerImpl::FilterManagerImpl(Context* context, Filter* filter)
   , m_progressDelegate(NULL)
   , m_dst(NULL)
   , m_preview_mask(NULL)
+  , m_previewArea(0)
+  , m_previewCoarse(false)
+  , m_previewPass(0)
 {
   int offset_x, offset_y;
 
@@ -109,9 +134,22 @@ void FilterManagerImpl::begin()
 }
 
 void FilterManagerImpl::beginForPreview()
+{
+  beginForPreview(getVisibleBounds());
+}
+
+void FilterManagerImpl::beginForPreview(const gfx::Rect& visibleBounds)
 {
   Document* document = m_location.document();
 
+  // Cancel the preview in progress (if any).
+  m_maskBits.unlock();
+  m_previewAreas.clear();
+  m_previewArea = 0;
+  m_previewCoarse = false;
+  m_previewPass = 0;
+  m_previewDirty = gfx::Rect();
+
   if (document->isMaskVisible())
     m_preview_mask.reset(new Mask(*document->getMask()));
   else {
@@ -124,40 +162,36 @@ void FilterManagerImpl::beginForPreview()
   m_row = 0;
   m_mask = m_preview_mask;
 
-  {
-    Editor* editor = current_editor;
-    Sprite* sprite = m_location.sprite();
-    gfx::Rect vp = View::getView(editor)->getViewportBounds();
-    int x1, y1, x2, y2;
-    int x, y, w, h;
-
-    editor->screenToEditor(vp.x, vp.y, &x1, &y1);
-    editor->screenToEditor(vp.x+vp.w-1, vp.y+vp.h-1, &x2, &y2);
-
-    if (x1 < 0) x1 = 0;
-    if (y1 < 0) y1 = 0;
-    if (x2 >= sprite->getWidth()) x2 = sprite->getWidth()-1;
-    if (y2 >= sprite->getHeight()) y2 = sprite->getHeight()-1;
-
-    x = x1;
-    y = y1;
-    w = x2 - x1 + 1;
-    h = y2 - y1 + 1;
-
-    if ((w < 1) || (h < 1)) {
-      m_preview_mask.reset(NULL);
-      m_row = -1;
-      return;
-    }
-
-    m_preview_mask->intersect(x, y, w, h);
-  }
-
   if (!updateMask(m_mask, m_src)) {
     m_preview_mask.reset(NULL);
     m_row = -1;
     return;
   }
+
+  // The visible area of the editor goes first, then the rest of the
+  // image is filtered in bands around it (top, bottom, left, right).
+  gfx::Rect bounds(m_x, m_y, m_w, m_h);
+  gfx::Rect vis = visibleBounds.createIntersect(bounds);
+
+  if (!vis.isEmpty()) {
+    m_previewCoarse = true;
+    m_previewAreas.push_back(vis);
+
+    gfx::Rect bands[4] = {
+      gfx::Rect(bounds.x, bounds.y, bounds.w, vis.y - bounds.y),
+      gfx::Rect(bounds.x, vis.y2(), bounds.w, bounds.y2() - vis.y2()),
+      gfx::Rect(bounds.x, vis.y, vis.x - bounds.x, vis.h),
+      gfx::Rect(vis.x2(), vis.y, bounds.x2() - vis.x2(), vis.h)
+    };
+
+    for (int i=0; i<4; ++i)
+      if (!bands[i].isEmpty())
+        m_previewAreas.push_back(bands[i]);
+  }
+  else
+    m_previewAreas.push_back(bounds);
+
+  startPreviewArea(0);
 }
 
 void FilterManagerImpl::end()
@@ -168,22 +202,7 @@ void FilterManagerImpl::end()
 bool FilterManagerImpl::applyStep()
 {
   if ((m_row >= 0) && (m_row < m_h)) {
-    if ((m_mask) && (m_mask->getBitmap())) {
-      int x = m_x - m_mask->getBounds().x + m_offset_x;
-      int y = m_row + m_y - m_mask->getBounds().y + m_offset_y;
-
-      m_maskBits = m_mask->getBitmap()
-        ->lockBits<BitmapTraits>(Image::ReadLock,
-                                 gfx::Rect(x, y, m_w - x, m_h - y));
-
-      m_maskIterator = m_maskBits.begin();
-    }
-
-    switch (m_location.sprite()->getPixelFormat()) {
-      case IMAGE_RGB:       m_filter->applyToRgba(this); break;
-      case IMAGE_GRAYSCALE: m_filter->applyToGrayscale(this); break;
-      case IMAGE_INDEXED:   m_filter->applyToIndexed(this); break;
-    }
+    applyRow();
     ++m_row;
 
     return true;
@@ -193,6 +212,107 @@ bool FilterManagerImpl::applyStep()
   }
 }
 
+bool FilterManagerImpl::applyPreviewStep()
+{
+  if (m_row < 0 || m_previewArea >= m_previewAreas.size())
+    return false;
+
+  bool coarse = (m_previewCoarse && m_previewArea == 0);
+  int step = (coarse ? interlaced_passes[m_previewPass].step: 1);
+  int fill = (coarse ? interlaced_passes[m_previewPass].fill: 1);
+  int bytes = m_src->getRowStrideSize(m_w);
+  int y = m_y + m_row;
+
+  // Restore the original row as filters don't touch non-selected
+  // pixels, and this row could be a replica of a previous pass.
+  memcpy(m_dst->getPixelAddress(m_x, y),
+         m_src->getPixelAddress(m_x, y), bytes);
+
+  applyRow();
+
+  if (fill > m_h - m_row)
+    fill = m_h - m_row;
+
+  for (int i=1; i<fill; ++i)
+    memcpy(m_dst->getPixelAddress(m_x, y+i),
+           m_dst->getPixelAddress(m_x, y), bytes);
+
+  m_previewDirty = m_previewDirty.createUnion(gfx::Rect(m_x, y, m_w, fill));
+
+  // Go to the next row/pass/area.
+  m_row += step;
+  if (m_row >= m_h) {
+    // Skip passes that start below the area (it could be too small
+    // for them).
+    if (coarse) {
+      while (++m_previewPass < interlaced_passes_count) {
+        m_row = interlaced_passes[m_previewPass].start;
+        if (m_row < m_h)
+          return true;
+      }
+    }
+
+    startPreviewArea(m_previewArea+1);
+  }
+
+  return true;
+}
+
+void FilterManagerImpl::applyRow()
+{
+  if ((m_mask) && (m_mask->getBitmap())) {
+    int x = m_x - m_mask->getBounds().x + m_offset_x;
+    int y = m_row + m_y - m_mask->getBounds().y + m_offset_y;
+
+    m_maskBits = m_mask->getBitmap()
+      ->lockBits<BitmapTraits>(Image::ReadLock,
+                               gfx::Rect(x, y, m_w, 1));
+
+    m_maskIterator = m_maskBits.begin();
+  }
+
+  switch (m_location.sprite()->getPixelFormat()) {
+    case IMAGE_RGB:       m_filter->applyToRgba(this); break;
+    case IMAGE_GRAYSCALE: m_filter->applyToGrayscale(this); break;
+    case IMAGE_INDEXED:   m_filter->applyToIndexed(this); break;
+  }
+}
+
+void FilterManagerImpl::startPreviewArea(size_t index)
+{
+  m_previewArea = index;
+  m_previewPass = 0;
+
+  if (index < m_previewAreas.size()) {
+    const gfx::Rect& area = m_previewAreas[index];
+    m_x = area.x;
+    m_y = area.y;
+    m_w = area.w;
+    m_h = area.h;
+    m_row = 0;
+  }
+  else
+    m_row = -1;
+}
+
+// Returns the bounds of the current editor viewport in "m_src"
+// coordinates.
+gfx::Rect FilterManagerImpl::getVisibleBounds() const
+{
+  Editor* editor = current_editor;
+  if (!editor)
+    return gfx::Rect();
+
+  gfx::Rect vp = View::getView(editor)->getViewportBounds();
+  int x1, y1, x2, y2;
+
+  editor->screenToEditor(vp.x, vp.y, &x1, &y1);
+  editor->screenToEditor(vp.x+vp.w-1, vp.y+vp.h-1, &x2, &y2);
+
+  return gfx::Rect(x1 - m_offset_x, y1 - m_offset_y,
+                   x2 - x1 + 1, y2 - y1 + 1);
+}
+
 void FilterManagerImpl::apply()
 {
   bool cancelled = false;
@@ -217,6 +337,7 @@ void FilterManagerImpl::apply()
 
     // Copy "dst" to "src"
     copy_image(m_src, m_dst, 0, 0);
+    m_src->markAsModified();
 
     undo.commit();
   }
@@ -262,15 +383,15 @@ void FilterManagerImpl::applyToTarget()
 
 void FilterManagerImpl::flush()
 {
-  if (m_row >= 0) {
+  if (!m_previewDirty.isEmpty()) {
     gfx::Rect rect;
 
     Editor* editor = current_editor;
-    editor->editorToScreen(m_x+m_offset_x,
-                           m_y+m_offset_y+m_row-1,
+    editor->editorToScreen(m_previewDirty.x+m_offset_x,
+                           m_previewDirty.y+m_offset_y,
                            &rect.x, &rect.y);
-    rect.w = (m_w << editor->getZoom());
-    rect.h = (1 << editor->getZoom());
+    rect.w = (m_previewDirty.w << editor->getZoom());
+    rect.h = (m_previewDirty.h << editor->getZoom());
 
     gfx::Region reg1(rect);
     gfx::Region reg2;
@@ -278,6 +399,8 @@ void FilterManagerImpl::flush()
     reg1.createIntersection(reg1, reg2);
 
     editor->invalidateRegion(reg1);
+
+    m_previewDirty = gfx::Rect();
   }
 }
 
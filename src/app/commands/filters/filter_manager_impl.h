@@ -24,11 +24,13 @@
 #include "base/unique_ptr.h"
 #include "filters/filter_indexed_data.h"
 #include "filters/filter_manager.h"
+#include "gfx/rect.h"
 #include "raster/image_bits.h"
 #include "raster/image_traits.h"
 #include "raster/pixel_format.h"
 
 #include <cstring>
+#include <vector>
 
 namespace raster {
   class Image;
@@ -87,16 +89,28 @@ namespace app {
 
     void begin();
     void beginForPreview();
+
+    // Starts the preview filtering first the given area (in
+    // coordinates of the source image) instead of the visible area
+    // of the current editor.
+    void beginForPreview(const gfx::Rect& visibleBounds);
     void end();
     bool applyStep();
     void applyToTarget();
 
+    // Filters the next row of the preview. The visible area of the
+    // current editor is filtered first (with coarse interlaced passes),
+    // and then the rest of the image. Returns false when the whole
+    // preview is complete (or there is nothing to preview).
+    bool applyPreviewStep();
+
     Document* getDocument() { return m_location.document(); }
     Sprite* getSprite() { return m_location.sprite(); }
     Layer* getLayer() { return m_location.layer(); }
     Image* getDestinationImage() const { return m_dst; }
 
-    // Updates the current editor to show the progress of the preview.
+    // Updates the current editor to show the progress of the preview
+    // (only the rows modified since the last call are invalidated).
     void flush();
 
     // FilterManager implementation
@@ -116,6 +130,9 @@ namespace app {
 
   private:
     void init(const Layer* layer, Image* image, int offset_x, int offset_y);
+    void applyRow();
+    void startPreviewArea(size_t index);
+    gfx::Rect getVisibleBounds() const;
     void apply();
     void applyToImage(Layer* layer, Image* image, int x, int y);
     bool updateMask(Mask* mask, const Image* image);
@@ -135,6 +152,13 @@ namespace app {
     Target m_targetOrig;          // Original targets
     Target m_target;              // Filtered targets
 
+    // Preview state
+    std::vector<gfx::Rect> m_previewAreas; // Areas to filter (the first one is the visible area)
+    size_t m_previewArea;         // Index of the area being filtered
+    bool m_previewCoarse;         // True if the first area is filtered with interlaced passes
+    int m_previewPass;            // Current interlaced pass
+    gfx::Rect m_previewDirty;     // Modified area since the last flush()
+
     // Hooks
     float m_progressBase;
     float m_progressWidth;
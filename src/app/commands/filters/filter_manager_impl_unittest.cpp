@@ -0,0 +1,113 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tests/test.h"
+
+#include "app/commands/filters/filter_manager_impl.h"
+#include "app/context.h"
+#include "app/document.h"
+#include "app/document_location.h"
+#include "base/unique_ptr.h"
+#include "filters/filter.h"
+#include "raster/raster.h"
+
+#include <vector>
+
+using namespace app;
+using namespace filters;
+using namespace raster;
+
+class TestContext : public Context {
+public:
+  TestContext(Document* document) : Context(NULL), m_document(document) { }
+
+protected:
+  void onGetActiveLocation(DocumentLocation* location) const {
+    location->document(m_document);
+    location->sprite(m_document->getSprite());
+    location->layer(m_document->getSprite()->getFolder()->getFirstLayer());
+    location->frame(FrameNumber(0));
+  }
+
+private:
+  Document* m_document;
+};
+
+// Fills each row with white and records the filtered rows.
+class TestFilter : public Filter {
+public:
+  std::vector<int> rows;
+
+  const char* getName() { return "Test"; }
+
+  void applyToRgba(FilterManager* filterMgr) {
+    uint32_t* dst = (uint32_t*)filterMgr->getDestinationAddress();
+    for (int x=0; x<filterMgr->getWidth(); ++x)
+      *(dst++) = rgba(255, 255, 255, 255);
+    rows.push_back(filterMgr->getY());
+  }
+
+  void applyToGrayscale(FilterManager* filterMgr) { }
+  void applyToIndexed(FilterManager* filterMgr) { }
+};
+
+static void test_preview(int height)
+{
+  base::UniquePtr<Document> doc(Document::createBasicDocument(IMAGE_RGB, 8, height, 256));
+  TestContext context(doc);
+  TestFilter filter;
+  FilterManagerImpl filterMgr(&context, &filter);
+
+  // Filter all the image with interlaced passes.
+  filterMgr.beginForPreview(gfx::Rect(0, 0, 8, height));
+  int steps = 0;
+  while (filterMgr.applyPreviewStep())
+    ASSERT_LT(++steps, 100);
+  filterMgr.end();
+
+  // Each row is filtered once.
+  ASSERT_EQ(height, (int)filter.rows.size());
+  std::vector<bool> filtered(height, false);
+  for (int i=0; i<(int)filter.rows.size(); ++i) {
+    int y = filter.rows[i];
+    ASSERT_GE(y, 0);
+    ASSERT_LT(y, height);
+    EXPECT_FALSE(filtered[y]);
+    filtered[y] = true;
+  }
+
+  Image* dst = filterMgr.getDestinationImage();
+  for (int y=0; y<height; ++y)
+    for (int x=0; x<8; ++x)
+      EXPECT_EQ(rgba(255, 255, 255, 255), get_pixel(dst, x, y));
+}
+
+TEST(FilterManagerImpl, PreviewOneRow)
+{
+  test_preview(1);
+}
+
+TEST(FilterManagerImpl, PreviewThreeRows)
+{
+  test_preview(3);
+}
+
+TEST(FilterManagerImpl, PreviewManyRows)
+{
+  test_preview(21);
+}
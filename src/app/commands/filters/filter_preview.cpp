@@ -23,6 +23,7 @@
 #include "app/commands/filters/filter_preview.h"
 
 #include "app/commands/filters/filter_manager_impl.h"
+#include "base/chrono.h"
 #include "raster/sprite.h"
 #include "ui/manager.h"
 #include "ui/message.h"
@@ -34,6 +35,11 @@ namespace app {
 using namespace ui;
 using namespace filters;
 
+// Maximum time (in seconds) to filter rows in each timer tick. The
+// rest of the preview continues in the next tick, so user input (e.g.
+// a slider change which restarts the preview) is processed quickly.
+static const double kPreviewTimeSlice = 0.010;
+
 FilterPreview::FilterPreview(FilterManagerImpl* filterMgr)
   : Widget(kGenericWidget)
   , m_filterMgr(filterMgr)
@@ -88,9 +94,16 @@ bool FilterPreview::onProcessMessage(Message* msg)
 
     case kTimerMessage:
       if (m_filterMgr) {
-        if (m_filterMgr->applyStep())
-          m_filterMgr->flush();
-        else
+        base::Chrono chrono;
+        bool running;
+
+        while ((running = m_filterMgr->applyPreviewStep()) &&
+               chrono.elapsed() < kPreviewTimeSlice)
+          ;
+
+        m_filterMgr->flush();
+
+        if (!running)
           m_timer.stop();
       }
       break;
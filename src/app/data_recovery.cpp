@@ -23,21 +23,36 @@
 #include "app/data_recovery.h"
 
 #include "app/backup.h"
+#include "app/document_snapshot.h"
+#include "base/bind.h"
+#include "base/convert_to.h"
 #include "base/fs.h"
 #include "base/path.h"
+#include "base/scoped_lock.h"
 #include "base/temp_dir.h"
+#include "base/thread.h"
 #include "app/document.h"
+#include "app/startup_profiler.h"
 #include "app/ui_context.h"
+#include "ui/manager.h"
+#include "ui/timer.h"
 
 #include <allegro.h>
 
 namespace app {
 
+using namespace base;
+
 DataRecovery::DataRecovery(Context* context)
   : m_tempDir(NULL)
   , m_backup(NULL)
+  , m_sessionBackup(NULL)
   , m_context(context)
+  , m_exit(false)
+  , m_thread(NULL)
 {
+  StartupMarker marker("Data recovery");
+
   // Check if there is already data to recover
   const base::string existent_data_path = get_config_string("DataRecovery", "Path", "");
   if (!existent_data_path.empty() &&
@@ -50,12 +65,22 @@ DataRecovery::DataRecovery(Context* context)
   else {
     // Create a new directory to save the backup information.
     m_tempDir = new base::TempDir(PACKAGE);
-    m_backup = new Backup(m_tempDir->path());
 
     set_config_string("DataRecovery", "Path", m_tempDir->path().c_str());
     flush_config_file();
   }
 
+  // Each session is recorded in its own subdirectory, so document
+  // ids of this session don't overwrite the data of a crash.
+  for (int i=1; ; ++i) {
+    m_sessionPath = join_path(m_tempDir->path(), "session" + convert_to<string>(i));
+    if (!directory_exists(m_sessionPath)) {
+      make_directory(m_sessionPath);
+      break;
+    }
+  }
+  m_sessionBackup = new Backup(m_sessionPath);
+
   m_context->addObserver(this);
 }
 
@@ -63,22 +88,161 @@ DataRecovery::~DataRecovery()
 {
   m_context->removeObserver(this);
 
+  if (m_thread) {
+    {
+      scoped_lock hold(m_mutex);
+      m_exit = true;
+      m_jobsAvailable.notify_one();
+    }
+    m_thread->join();
+    delete m_thread;
+  }
+
+  for (std::deque<Job>::iterator it=m_jobs.begin(), end=m_jobs.end(); it != end; ++it)
+    delete it->snapshot;
+
+  // The program is closed normally, we don't need the backup data of
+  // this session.
+  try {
+    m_sessionBackup->removeAllDocuments();
+    delete m_sessionBackup;
+    m_sessionBackup = NULL;
+
+    remove_directory(m_sessionPath);
+  }
+  catch (const std::exception& e) {
+    PRINTF("Error removing backup data: %s\n", e.what());
+  }
+
+  delete m_sessionBackup;
   delete m_backup;
 
   if (m_tempDir) {
-    delete m_tempDir;
-    set_config_string("DataRecovery", "Path", "");
+    try {
+      delete m_tempDir;
+      set_config_string("DataRecovery", "Path", "");
+    }
+    catch (const std::exception&) {
+      // The directory isn't empty (it contains data from a previous
+      // crash that wasn't restored), so we keep it.
+    }
   }
 }
 
 void DataRecovery::onAddDocument(Context* context, Document* document)
 {
-  document->addObserver(this);
+  // We don't need a backup until the document is modified.
+  m_versions[document] = document->getVersion();
+
+  // Backups are taken from a timer, so the UI must be running.
+  if (!m_timer && ui::Manager::getDefault()) {
+    int period = get_config_int("DataRecovery", "Period", 60);
+
+    m_timer.reset(new ui::Timer(MAX(1, period) * 1000));
+    m_timer->Tick.connect(&DataRecovery::onBackupTick, this);
+    m_timer->start();
+
+    if (!m_thread)
+      m_thread = new base::thread(Bind<void>(&DataRecovery::backupThread, this));
+  }
 }
 
 void DataRecovery::onRemoveDocument(Context* context, Document* document)
 {
-  document->removeObserver(this);
+  // The document was closed by the user, we don't need its data.
+  m_versions.erase(document);
+  addJob(document->getId(), NULL);
+
+  // Destroy the timer when there are no documents (all documents are
+  // closed before the UI is shut down).
+  if (m_versions.empty())
+    m_timer.reset(NULL);
+}
+
+// Takes a snapshot of each modified document. [main thread]
+void DataRecovery::onBackupTick()
+{
+  for (std::map<Document*, int>::iterator
+         it=m_versions.begin(), end=m_versions.end(); it != end; ++it) {
+    Document* document = it->first;
+    int version = document->getVersion();
+    if (version == it->second)
+      continue;
+
+    // Saved documents (or documents that were undone to the saved
+    // state) don't need a backup.
+    if (!document->isModified()) {
+      it->second = version;
+      addJob(document->getId(), NULL);
+      continue;
+    }
+
+    // Try again in the next tick if the document is being modified.
+    if (!document->lock(Document::ReadLock))
+      continue;
+
+    DocumentSnapshot* snapshot = NULL;
+    try {
+      snapshot = document->createSnapshot();
+    }
+    catch (const std::exception& e) {
+      PRINTF("Error creating backup snapshot: %s\n", e.what());
+    }
+    document->unlock();
+
+    if (snapshot) {
+      it->second = snapshot->getVersion();
+      addJob(document->getId(), snapshot);
+    }
+  }
+}
+
+void DataRecovery::addJob(DocumentId id, DocumentSnapshot* snapshot)
+{
+  scoped_lock hold(m_mutex);
+
+  // Replace a pending job of the same document (we need only the
+  // last snapshot).
+  for (std::deque<Job>::iterator it=m_jobs.begin(), end=m_jobs.end(); it != end; ++it) {
+    if (it->id == id) {
+      delete it->snapshot;
+      it->snapshot = snapshot;
+      return;
+    }
+  }
+
+  Job job = { id, snapshot };
+  m_jobs.push_back(job);
+  m_jobsAvailable.notify_one();
+}
+
+// Writes snapshots in the backup directory. [backup thread]
+void DataRecovery::backupThread()
+{
+  for (;;) {
+    Job job;
+    {
+      scoped_lock hold(m_mutex);
+      while (!m_exit && m_jobs.empty())
+        m_jobsAvailable.wait(hold);
+
+      if (m_exit)
+        return;
+
+      job = m_jobs.front();
+      m_jobs.pop_front();
+    }
+
+    try {
+      if (job.snapshot)
+        m_sessionBackup->writeDocument(job.id, job.snapshot);
+      else
+        m_sessionBackup->removeDocument(job.id);
+    }
+    catch (const std::exception& e) {
+      PRINTF("Error writing backup data: %s\n", e.what());
+    }
+  }
 }
 
 } // namespace app
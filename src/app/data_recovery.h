@@ -20,36 +20,83 @@
 #define APP_DATA_RECOVERY_H_INCLUDED
 
 #include "app/context_observer.h"
-#include "app/document_observer.h"
+#include "app/document_id.h"
 #include "app/documents.h"
 #include "base/compiler_specific.h"
+#include "base/condition_variable.h"
 #include "base/disable_copying.h"
+#include "base/mutex.h"
 #include "base/slot.h"
+#include "base/string.h"
+#include "base/unique_ptr.h"
 
-namespace base { class TempDir; }
+#include <deque>
+#include <map>
+
+namespace base {
+  class TempDir;
+  class thread;
+}
+
+namespace ui { class Timer; }
 
 namespace app {
   class Backup;
+  class DocumentSnapshot;
+
+  // Records periodic snapshots of modified documents in a temporary
+  // directory, so they can be restored if the program crashes.
+  // Snapshots are taken from the UI thread (a DocumentSnapshot only
+  // copies images that were modified), and they are written to disk
+  // from a background thread.
 
-  class DataRecovery : public ContextObserver
-                     , public DocumentObserver {
+  class DataRecovery : public ContextObserver {
   public:
     DataRecovery(Context* context);
     ~DataRecovery();
 
     // Returns a backup if there are data to be restored from a
     // crash. Or null if the program didn't crash in its previous
-    // execution.
+    // execution. Each crashed session is in its own subdirectory.
     Backup* getBackup() { return m_backup; }
 
   private:
     void onAddDocument(Context* context, Document* document) OVERRIDE;
     void onRemoveDocument(Context* context, Document* document) OVERRIDE;
 
+    void onBackupTick();
+    void backupThread();
+
+    // Adds a snapshot to be written in the background thread (a NULL
+    // snapshot means that the document data must be removed).
+    void addJob(DocumentId id, DocumentSnapshot* snapshot);
+
+    struct Job {
+      DocumentId id;
+      DocumentSnapshot* snapshot;
+    };
+
     base::TempDir* m_tempDir;
     Backup* m_backup;
+
+    // Backup of the documents of this session.
+    base::string m_sessionPath;
+    Backup* m_sessionBackup;
     Context* m_context;
 
+    // Version of each document in the last snapshot (or the version
+    // when it was added, as we don't need a backup of a document that
+    // wasn't modified).
+    std::map<Document*, int> m_versions;
+    base::UniquePtr<ui::Timer> m_timer;
+
+    // Jobs for the background thread.
+    base::mutex m_mutex;
+    base::condition_variable m_jobsAvailable;
+    std::deque<Job> m_jobs;
+    bool m_exit;
+    base::thread* m_thread;
+
     DISABLE_COPYING(DataRecovery);
   };
 
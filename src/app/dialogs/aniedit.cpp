@@ -148,6 +148,9 @@ protected:
   void onAddFrame(DocumentEvent& ev) OVERRIDE;
   void onRemoveFrame(DocumentEvent& ev) OVERRIDE;
   void onTotalFramesChanged(DocumentEvent& ev) OVERRIDE;
+  void onAddCel(DocumentEvent& ev) OVERRIDE;
+  void onRemoveCel(DocumentEvent& ev) OVERRIDE;
+  void onCelFrameChanged(DocumentEvent& ev) OVERRIDE;
 
 private:
   void setCursor(int x, int y);
@@ -260,6 +263,7 @@ AnimationEditor::AnimationEditor(Context* context)
   m_space_pressed = false;
 
   this->setFocusStop(true);
+  this->setRetainedBuffer(true);
 
   regenerateLayers();
 
@@ -282,6 +286,10 @@ bool AnimationEditor::onProcessMessage(Message* msg)
       int layer, first_layer, last_layer;
       FrameNumber frame, first_frame, last_frame;
 
+      // Exposed area (e.g. a menu was closed), the cels didn't change.
+      if (restoreRetainedArea(clip))
+        return true;
+
       getDrawableLayers(clip, &first_layer, &last_layer);
       getDrawableFrames(clip, &first_frame, &last_frame);
 
@@ -322,6 +330,7 @@ bool AnimationEditor::onProcessMessage(Message* msg)
 
       drawLayerPadding();
 
+      retainArea(gfx::Region(clip));
       return true;
     }
 
@@ -901,6 +910,24 @@ void AnimationEditor::onTotalFramesChanged(DocumentEvent& ev)
   }
 }
 
+// A cel pointer can be reused for a new cel (or the frame of a cel
+// can change its palette), so we discard only the thumbnail of the
+// affected cel.
+void AnimationEditor::onAddCel(DocumentEvent& ev)
+{
+  destroy_thumbnail(ev.cel());
+}
+
+void AnimationEditor::onRemoveCel(DocumentEvent& ev)
+{
+  destroy_thumbnail(ev.cel());
+}
+
+void AnimationEditor::onCelFrameChanged(DocumentEvent& ev)
+{
+  destroy_thumbnail(ev.cel());
+}
+
 void AnimationEditor::setCursor(int x, int y)
 {
   int mx = x - getBounds().x;
@@ -946,16 +973,25 @@ void AnimationEditor::setCursor(int x, int y)
   }
 }
 
+// Returns the range of layers that intersect the given clipping
+// rectangle, so we don't paint (or generate thumbnails for) layers
+// that are outside the visible area. If there are no visible layers,
+// first_layer will be greater than last_layer.
 void AnimationEditor::getDrawableLayers(const gfx::Rect& clip, int* first_layer, int* last_layer)
 {
-  *first_layer = 0;
-  *last_layer = m_layers.size()-1;
+  int y = getBounds().y + HDRSIZE - m_scroll_y;
+
+  *first_layer = MAX(0, (clip.y - y) / LAYSIZE);
+  *last_layer = MIN((int)m_layers.size()-1, (clip.y + clip.h - 1 - y) / LAYSIZE);
 }
 
+// Same as getDrawableLayers() but for the frames (columns).
 void AnimationEditor::getDrawableFrames(const gfx::Rect& clip, FrameNumber* first_frame, FrameNumber* last_frame)
 {
-  *first_frame = FrameNumber(0);
-  *last_frame = m_sprite->getLastFrame();
+  int x = getBounds().x + m_separator_x + m_separator_w - m_scroll_x;
+
+  *first_frame = FrameNumber(MAX(0, (clip.x - x) / FRMSIZE));
+  *last_frame = FrameNumber(MIN((int)m_sprite->getLastFrame(), (clip.x + clip.w - 1 - x) / FRMSIZE));
 }
 
 void AnimationEditor::drawHeader(const gfx::Rect& clip)
@@ -1313,6 +1349,10 @@ void AnimationEditor::drawCel(const gfx::Rect& clip, int layer_index, FrameNumbe
 
 bool AnimationEditor::drawPart(int part, int layer, FrameNumber frame)
 {
+  // The part is drawn directly on the screen (without a paint
+  // message), so the retained copy is not valid anymore.
+  discardRetainedArea(gfx::Region(getBounds()));
+
   switch (part) {
     case A_PART_NOTHING:
       // Do nothing.
@@ -24,6 +24,7 @@
 
 #include "app/document_api.h"
 #include "app/document_event.h"
+#include "app/document_snapshot.h"
 #include "app/document_observer.h"
 #include "app/document_undo.h"
 #include "app/file/format_options.h"
@@ -57,6 +58,7 @@ Document::Document(Sprite* sprite)
   , m_mutex(new mutex)
   , m_write_lock(false)
   , m_read_locks(0)
+  , m_version(0)
     // Information about the file format used to load/save this document
   , m_format_options(NULL)
     // Extra cel
@@ -210,6 +212,17 @@ void Document::markAsSaved()
   m_associated_to_file = true;
 }
 
+void Document::markAsSaving()
+{
+  m_undo->markSavingState();
+}
+
+void Document::markSavingAsSaved()
+{
+  m_undo->markSavingStateAsSaved();
+  m_associated_to_file = true;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Loaded options from file
 
@@ -500,6 +513,14 @@ Document* Document::duplicate(DuplicateType type) const
   return documentCopy.release();
 }
 
+DocumentSnapshot* Document::createSnapshot() const
+{
+  if (!m_snapshotImages)
+    m_snapshotImages.reset(new DocumentSnapshotImages);
+
+  return new DocumentSnapshot(this, m_snapshotImages);
+}
+
 //////////////////////////////////////////////////////////////////////
 // Multi-threading ("sprite wrappers" use this)
 
@@ -556,6 +577,13 @@ void Document::unlockToRead()
 
   m_write_lock = false;
   m_read_locks = 1;
+  ++m_version;
+}
+
+int Document::getVersion() const
+{
+  scoped_lock lock(*m_mutex);
+  return m_version;
 }
 
 void Document::unlock()
@@ -564,6 +592,7 @@ void Document::unlock()
 
   if (m_write_lock) {
     m_write_lock = false;
+    ++m_version;
   }
   else if (m_read_locks > 0) {
     --m_read_locks;
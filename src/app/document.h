@@ -52,6 +52,8 @@ namespace undo {
 namespace app {
   class DocumentApi;
   class DocumentObserver;
+  class DocumentSnapshot;
+  class DocumentSnapshotImages;
   class DocumentUndo;
   class FormatOptions;
   struct BoundSeg;
@@ -116,6 +118,13 @@ namespace app {
     bool isAssociatedToFile() const;
     void markAsSaved();
 
+    // Used to save a snapshot of the document in background:
+    // markAsSaving() is called when the snapshot is taken, and
+    // markSavingAsSaved() when the snapshot was saved successfully
+    // (the document remains modified if it was changed meanwhile).
+    void markAsSaving();
+    void markSavingAsSaved();
+
     //////////////////////////////////////////////////////////////////////
     // Loaded options from file
 
@@ -172,6 +181,12 @@ namespace app {
     void copyLayerContent(const Layer* sourceLayer, Document* destDoc, Layer* destLayer) const;
     Document* duplicate(DuplicateType type) const;
 
+    // Creates a read-only copy of the current state of the document
+    // that can be used from other thread without locking this document
+    // (see DocumentSnapshot). The document must be locked (at least
+    // for reading) by the caller.
+    DocumentSnapshot* createSnapshot() const;
+
     //////////////////////////////////////////////////////////////////////
     // Multi-threading ("sprite wrappers" use this)
 
@@ -189,6 +204,10 @@ namespace app {
 
     void unlock();
 
+    // Returns a number that is incremented each time the document is
+    // unlocked after being locked to write it.
+    int getVersion() const;
+
   private:
     // Unique identifier for this document (it is assigned by Documents class).
     DocumentId m_id;
@@ -220,6 +239,12 @@ namespace app {
     // Greater than zero when one or more threads are reading the sprite.
     int m_read_locks;
 
+    // Modifications counter (see getVersion()).
+    int m_version;
+
+    // Images shared by snapshots of this document.
+    mutable base::UniquePtr<DocumentSnapshotImages> m_snapshotImages;
+
     // Data to save the file in the same format that it was loaded
     SharedPtr<FormatOptions> m_format_options;
 
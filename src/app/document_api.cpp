@@ -768,6 +768,7 @@ void DocumentApi::backgroundFromLayer(LayerImage* layer, int bgcolor)
           cel_image, 0, 0, cel_image->getWidth(), cel_image->getHeight()));
 
       copy_image(cel_image, bg_image, 0, 0);
+      cel_image->markAsModified();
     }
     else {
       replaceStockImage(sprite, cel->getImage(), Image::createCopy(bg_image));
@@ -872,6 +873,7 @@ void DocumentApi::flattenLayers(Sprite* sprite, int bgcolor)
     }
 
     copy_image(cel_image, image, 0, 0);
+    cel_image->markAsModified();
   }
 
   // Delete old layers.
@@ -963,6 +965,7 @@ void DocumentApi::clearMask(Layer* layer, Cel* cel, int bgcolor)
 
       // clear all
       clear_image(image, bgcolor);
+      image->markAsModified();
     }
     // If the layer is transparent we can remove the cel (and its
     // associated image).
@@ -1004,6 +1007,7 @@ void DocumentApi::clearMask(Layer* layer, Cel* cel, int bgcolor)
     }
 
     ASSERT(it == maskBits.end());
+    image->markAsModified();
   }
 }
 
@@ -1021,6 +1025,7 @@ void DocumentApi::flipImage(Image* image,
 
   // Flip the portion of the bitmap.
   raster::algorithm::flip_image(image, bounds, flipType);
+  image->markAsModified();
 }
 
 void DocumentApi::flipImageWithMask(Image* image, const Mask* mask, raster::algorithm::FlipType flipType, int bgcolor)
@@ -1041,6 +1046,7 @@ void DocumentApi::flipImageWithMask(Image* image, const Mask* mask, raster::algo
 
   // Copy the flipped image into the image specified as argument.
   copy_image(image, flippedImage, 0, 0);
+  image->markAsModified();
 }
 
 void DocumentApi::pasteImage(Sprite* sprite, Cel* cel, const Image* src_image, int x, int y, int opacity)
@@ -0,0 +1,259 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/document_snapshot.h"
+
+#include "app/document.h"
+#include "app/document_undo.h"
+#include "base/mutex.h"
+#include "base/scoped_lock.h"
+#include "raster/cel.h"
+#include "raster/image.h"
+#include "raster/layer.h"
+#include "raster/mask.h"
+#include "raster/palette.h"
+#include "raster/sprite.h"
+#include "raster/stock.h"
+
+namespace app {
+
+using namespace raster;
+
+// Copy of an image of the document. Its pixels are never modified,
+// and it keeps the modification stamp of the original image.
+class SnapshotImage {
+public:
+  SnapshotImage(DocumentSnapshotImages* owner, const Image* source)
+    : m_owner(owner)
+    , m_source(source)
+    , m_image(Image::createCopy(source))
+    , m_refs(1) {
+    m_image->setModificationStamp(source->getModificationStamp());
+  }
+
+  Image* getImage() const { return m_image; }
+
+  // Returns true if the copy has the same pixels of the given image
+  // of the document.
+  bool isCopyOf(const Image* image) const {
+    return (m_image->getModificationStamp() == image->getModificationStamp());
+  }
+
+  // These functions are called from different threads (a snapshot can
+  // be destroyed in a background thread).
+  SnapshotImage* ref() {
+    base::scoped_lock hold(m_mutex);
+    ++m_refs;
+    return this;
+  }
+
+  void unref() {
+    {
+      base::scoped_lock hold(m_mutex);
+      if (--m_refs > 0)
+        return;
+
+      // No snapshot uses this copy, it's removed from the copies of
+      // the document.
+      if (m_owner)
+        m_owner->m_images.erase(m_source);
+    }
+    delete m_image;
+    delete this;
+  }
+
+  // Protects reference counters and the copies of each
+  // DocumentSnapshotImages.
+  static base::mutex m_mutex;
+
+private:
+  friend class DocumentSnapshotImages;
+
+  DocumentSnapshotImages* m_owner;
+  const Image* m_source;
+  Image* m_image;
+  int m_refs;
+};
+
+base::mutex SnapshotImage::m_mutex;
+
+static void copy_layer(const Layer* srcLayer, Layer* dstLayer)
+{
+  dstLayer->setName(srcLayer->getName());
+  dstLayer->setFlags(srcLayer->getFlags());
+
+  if (srcLayer->isImage()) {
+    const LayerImage* src = static_cast<const LayerImage*>(srcLayer);
+    LayerImage* dst = static_cast<LayerImage*>(dstLayer);
+
+    // Cels reference images by index, and the snapshot's stock uses
+    // the same indexes of the original stock.
+    for (CelConstIterator it=src->getCelBegin(), end=src->getCelEnd(); it != end; ++it)
+      dst->addCel(new Cel(**it));
+  }
+  else if (srcLayer->isFolder()) {
+    const LayerFolder* src = static_cast<const LayerFolder*>(srcLayer);
+    LayerFolder* dst = static_cast<LayerFolder*>(dstLayer);
+
+    for (LayerConstIterator it=src->getLayerBegin(), end=src->getLayerEnd(); it != end; ++it) {
+      Layer* child;
+      if ((*it)->isImage())
+        child = new LayerImage(dst->getSprite());
+      else
+        child = new LayerFolder(dst->getSprite());
+
+      dst->addLayer(child);
+      copy_layer(*it, child);
+    }
+  }
+}
+
+// Destroys the cels of the layer without destroying their images
+// (the images of a snapshot are shared with other snapshots).
+static void destroy_cels(Layer* layer)
+{
+  if (layer->isImage()) {
+    LayerImage* layerImage = static_cast<LayerImage*>(layer);
+    CelList cels;
+    layerImage->getCels(cels);
+
+    for (CelIterator it=cels.begin(), end=cels.end(); it != end; ++it) {
+      layerImage->removeCel(*it);
+      delete *it;
+    }
+  }
+  else if (layer->isFolder()) {
+    LayerFolder* folder = static_cast<LayerFolder*>(layer);
+
+    for (LayerIterator it=folder->getLayerBegin(), end=folder->getLayerEnd(); it != end; ++it)
+      destroy_cels(*it);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+// DocumentSnapshotImages
+
+DocumentSnapshotImages::DocumentSnapshotImages()
+{
+}
+
+DocumentSnapshotImages::~DocumentSnapshotImages()
+{
+  // Copies can be still used by snapshots.
+  base::scoped_lock hold(SnapshotImage::m_mutex);
+  for (Map::iterator it=m_images.begin(), end=m_images.end(); it != end; ++it)
+    it->second->m_owner = NULL;
+}
+
+void DocumentSnapshotImages::getImages(const Stock* stock, std::vector<SnapshotImage*>& images)
+{
+  base::scoped_lock hold(SnapshotImage::m_mutex);
+
+  images.resize(stock->size(), (SnapshotImage*)NULL);
+
+  for (int i=0; i<stock->size(); ++i) {
+    const Image* image = stock->getImage(i);
+    if (!image)
+      continue;
+
+    // Reuse the copy used by other snapshots if the image wasn't
+    // modified (or if the image is twice in the stock).
+    Map::iterator it = m_images.find(image);
+    if (it != m_images.end()) {
+      SnapshotImage* copy = it->second;
+      if (copy->isCopyOf(image)) {
+        ++copy->m_refs;
+        images[i] = copy;
+        continue;
+      }
+
+      // The old copy is destroyed with its snapshots.
+      copy->m_owner = NULL;
+      m_images.erase(it);
+    }
+
+    SnapshotImage* copy = new SnapshotImage(this, image);
+    m_images[image] = copy;
+    images[i] = copy;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+// DocumentSnapshot
+
+DocumentSnapshot::DocumentSnapshot(const Document* document, DocumentSnapshotImages* images)
+  : m_version(document->getVersion())
+{
+  const Sprite* srcSprite = document->getSprite();
+  base::UniquePtr<Sprite> spritePtr(new Sprite(srcSprite->getPixelFormat(),
+                                               srcSprite->getWidth(),
+                                               srcSprite->getHeight(),
+                                               srcSprite->getPalette(FrameNumber(0))->size()));
+  m_document.reset(new Document(spritePtr));
+  Sprite* sprite = spritePtr.release();
+
+  m_document->getUndo()->setEnabled(false);
+  m_document->setFilename(document->getFilename());
+
+  sprite->setTransparentColor(srcSprite->getTransparentColor());
+  sprite->setTotalFrames(srcSprite->getTotalFrames());
+  for (FrameNumber i(0); i < srcSprite->getTotalFrames(); ++i)
+    sprite->setFrameDuration(i, srcSprite->getFrameDuration(i));
+
+  for (PalettesList::const_iterator it = srcSprite->getPalettes().begin(),
+         end = srcSprite->getPalettes().end(); it != end; ++it)
+    sprite->setPalette(*it, true);
+
+  // Share the images (the index 0 is always NULL in the stock)
+  images->getImages(srcSprite->getStock(), m_images);
+  for (size_t i=1; i<m_images.size(); ++i)
+    sprite->getStock()->addImage(m_images[i] ? m_images[i]->getImage(): NULL);
+
+  copy_layer(srcSprite->getFolder(), sprite->getFolder());
+
+  m_document->setMask(document->getMask());
+  m_document->setMaskVisible(document->isMaskVisible());
+}
+
+DocumentSnapshot::~DocumentSnapshot()
+{
+  // Shared images are not owned by the sprite's stock, so the cels
+  // are destroyed here (layers destroy their cels with their images).
+  destroy_cels(getSprite()->getFolder());
+
+  Stock* stock = getSprite()->getStock();
+  for (int i=1; i<stock->size(); ++i)
+    stock->replaceImage(i, NULL);
+
+  m_document.reset(NULL);
+
+  for (size_t i=0; i<m_images.size(); ++i)
+    if (m_images[i])
+      m_images[i]->unref();
+}
+
+Sprite* DocumentSnapshot::getSprite() const
+{
+  return m_document->getSprite();
+}
+
+} // namespace app
@@ -0,0 +1,95 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef APP_DOCUMENT_SNAPSHOT_H_INCLUDED
+#define APP_DOCUMENT_SNAPSHOT_H_INCLUDED
+
+#include "base/disable_copying.h"
+#include "base/unique_ptr.h"
+
+#include <map>
+#include <vector>
+
+namespace raster {
+  class Image;
+  class Sprite;
+  class Stock;
+}
+
+namespace app {
+  class Document;
+
+  using namespace raster;
+
+  // Image shared between snapshots. Its pixels are never modified.
+  class SnapshotImage;
+
+  // Copies of the images of a document used by its snapshots (to
+  // share the pixels of images that weren't modified between
+  // snapshots). Copies are destroyed with the last snapshot that uses
+  // them, so they don't use memory when there are no snapshots.
+  class DocumentSnapshotImages {
+  public:
+    DocumentSnapshotImages();
+    ~DocumentSnapshotImages();
+
+    // Returns references to immutable copies of the images of the
+    // stock, reusing the copies of other snapshots for images with
+    // the same modification stamp (see Image::markAsModified()).
+    void getImages(const Stock* stock, std::vector<SnapshotImage*>& images);
+
+  private:
+    friend class SnapshotImage;
+
+    typedef std::map<const Image*, SnapshotImage*> Map;
+    Map m_images;
+
+    DISABLE_COPYING(DocumentSnapshotImages);
+  };
+
+  // Read-only copy of a document (sprite, layers, cels, palettes,
+  // frames and mask) at some version (see Document::getVersion()).
+  //
+  // Snapshots are created with Document::createSnapshot() from a
+  // thread that has the document locked (e.g. the UI thread), and then
+  // they can be used from any other thread without locking the
+  // original document (e.g. to save or render it while the user
+  // continues editing). A snapshot can be used/destroyed even after
+  // the original document is closed.
+  class DocumentSnapshot {
+  public:
+    DocumentSnapshot(const Document* document, DocumentSnapshotImages* images);
+    ~DocumentSnapshot();
+
+    int getVersion() const { return m_version; }
+
+    // The document must not be modified.
+    Document* getDocument() const { return m_document.get(); }
+    Sprite* getSprite() const;
+
+  private:
+    base::UniquePtr<Document> m_document;
+    std::vector<SnapshotImage*> m_images;
+    int m_version;
+
+    DISABLE_COPYING(DocumentSnapshot);
+  };
+
+} // namespace app
+
+#endif
@@ -0,0 +1,127 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <gtest/gtest.h>
+
+#include "app/document.h"
+#include "app/document_snapshot.h"
+#include "base/unique_ptr.h"
+#include "raster/raster.h"
+
+using namespace app;
+using namespace raster;
+
+static Image* get_first_image(Document* doc)
+{
+  Sprite* sprite = doc->getSprite();
+  LayerImage* layer = static_cast<LayerImage*>(sprite->getFolder()->getFirstLayer());
+  return sprite->getStock()->getImage(layer->getCel(FrameNumber(0))->getImage());
+}
+
+TEST(DocumentSnapshot, Version)
+{
+  base::UniquePtr<Document> doc(Document::createBasicDocument(IMAGE_RGB, 8, 8, 256));
+  int version = doc->getVersion();
+
+  ASSERT_TRUE(doc->lock(Document::ReadLock));
+  doc->unlock();
+  EXPECT_EQ(version, doc->getVersion());
+
+  ASSERT_TRUE(doc->lock(Document::WriteLock));
+  doc->unlock();
+  EXPECT_EQ(version+1, doc->getVersion());
+}
+
+TEST(DocumentSnapshot, SnapshotIsNotModified)
+{
+  base::UniquePtr<Document> doc(Document::createBasicDocument(IMAGE_RGB, 8, 8, 256));
+  Image* image = get_first_image(doc);
+  put_pixel(image, 0, 0, rgba(255, 0, 0, 255));
+
+  base::UniquePtr<DocumentSnapshot> snapshot(doc->createSnapshot());
+  EXPECT_EQ(doc->getVersion(), snapshot->getVersion());
+  EXPECT_EQ(8, snapshot->getSprite()->getWidth());
+  EXPECT_EQ(1, snapshot->getSprite()->getFolder()->getLayersCount());
+
+  Image* copy = get_first_image(snapshot->getDocument());
+  EXPECT_NE(image, copy);
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(copy, 0, 0));
+
+  // Modify the document
+  put_pixel(image, 0, 0, rgba(0, 0, 255, 255));
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(copy, 0, 0));
+
+  // The snapshot can be used after the document is destroyed
+  doc.reset(NULL);
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(copy, 0, 0));
+}
+
+TEST(DocumentSnapshot, ShareUnmodifiedImages)
+{
+  base::UniquePtr<Document> doc(Document::createBasicDocument(IMAGE_INDEXED, 8, 8, 256));
+  Image* image = get_first_image(doc);
+
+  base::UniquePtr<DocumentSnapshot> snapshot1(doc->createSnapshot());
+  base::UniquePtr<DocumentSnapshot> snapshot2(doc->createSnapshot());
+  EXPECT_EQ(get_first_image(snapshot1->getDocument()),
+            get_first_image(snapshot2->getDocument()));
+
+  put_pixel(image, 1, 1, 4);
+  image->markAsModified();
+  base::UniquePtr<DocumentSnapshot> snapshot3(doc->createSnapshot());
+  EXPECT_NE(get_first_image(snapshot2->getDocument()),
+            get_first_image(snapshot3->getDocument()));
+  EXPECT_EQ(0, get_pixel(get_first_image(snapshot2->getDocument()), 1, 1));
+  EXPECT_EQ(4, get_pixel(get_first_image(snapshot3->getDocument()), 1, 1));
+
+  // Destroy snapshots in a different order
+  snapshot1.reset(NULL);
+  snapshot3.reset(NULL);
+  EXPECT_EQ(0, get_pixel(get_first_image(snapshot2->getDocument()), 1, 1));
+}
+
+TEST(DocumentSnapshot, ReleaseCopiesWithLastSnapshot)
+{
+  base::UniquePtr<Document> doc(Document::createBasicDocument(IMAGE_INDEXED, 8, 8, 256));
+  Image* image = get_first_image(doc);
+
+  base::UniquePtr<DocumentSnapshot> snapshot(doc->createSnapshot());
+  EXPECT_EQ(0, get_pixel(get_first_image(snapshot->getDocument()), 1, 1));
+  snapshot.reset(NULL);
+
+  // There is no copy to reuse (even if the image wasn't marked as
+  // modified).
+  put_pixel(image, 1, 1, 4);
+  snapshot.reset(doc->createSnapshot());
+  EXPECT_EQ(4, get_pixel(get_first_image(snapshot->getDocument()), 1, 1));
+
+  // The document can be destroyed before its snapshots.
+  doc.reset(NULL);
+  snapshot.reset(NULL);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
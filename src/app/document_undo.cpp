@@ -74,6 +74,16 @@ void DocumentUndo::markSavedState()
   return m_undoHistory->markSavedState();
 }
 
+void DocumentUndo::markSavingState()
+{
+  return m_undoHistory->markSavingState();
+}
+
+void DocumentUndo::markSavingStateAsSaved()
+{
+  return m_undoHistory->markSavingStateAsSaved();
+}
+
 void DocumentUndo::pushUndoer(undo::Undoer* undoer)
 {
   return m_undoHistory->pushUndoer(undoer);
@@ -54,6 +54,8 @@ namespace app {
 
     bool isSavedState() const;
     void markSavedState();
+    void markSavingState();
+    void markSavingStateAsSaved();
 
     // UndoHistoryDelegate implementation.
     undo::ObjectsContainer* getObjects() const OVERRIDE { return m_objects; }
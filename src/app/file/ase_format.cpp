@@ -75,10 +75,12 @@ struct ASE_FrameHeader {
   uint16_t duration;
 };
 
-// TODO Warning: the writing routines aren't thread-safe
-static ASE_FrameHeader *current_frame_header = NULL;
-static int chunk_type;
-static int chunk_start;
+// Chunk being written, the state is kept in the stack of the saving
+// thread so several files can be saved at the same time.
+struct ASE_Chunk {
+  int type;
+  int start;
+};
 
 static bool ase_file_read_header(FILE* f, ASE_Header* header);
 static void ase_file_prepare_header(FILE* f, ASE_Header* header, const Sprite* sprite);
@@ -88,26 +90,26 @@ static void ase_file_read_frame_header(FILE *f, ASE_FrameHeader *frame_header);
 static void ase_file_prepare_frame_header(FILE *f, ASE_FrameHeader *frame_header);
 static void ase_file_write_frame_header(FILE *f, ASE_FrameHeader *frame_header);
 
-static void ase_file_write_layers(FILE *f, Layer *layer);
-static void ase_file_write_cels(FILE *f, Sprite *sprite, Layer *layer, FrameNumber frame);
+static void ase_file_write_layers(FILE *f, ASE_FrameHeader *frame_header, Layer *layer);
+static void ase_file_write_cels(FILE *f, ASE_FrameHeader *frame_header, Sprite *sprite, Layer *layer, FrameNumber frame);
 
 static void ase_file_read_padding(FILE *f, int bytes);
 static void ase_file_write_padding(FILE *f, int bytes);
 static std::string ase_file_read_string(FILE *f);
 static void ase_file_write_string(FILE *f, const std::string& string);
 
-static void ase_file_write_start_chunk(FILE *f, int type);
-static void ase_file_write_close_chunk(FILE *f);
+static void ase_file_write_start_chunk(FILE *f, ASE_FrameHeader *frame_header, int type, ASE_Chunk *chunk);
+static void ase_file_write_close_chunk(FILE *f, ASE_Chunk *chunk);
 
 static Palette *ase_file_read_color_chunk(FILE *f, Sprite *sprite, FrameNumber frame);
 static Palette *ase_file_read_color2_chunk(FILE *f, Sprite *sprite, FrameNumber frame);
-static void ase_file_write_color2_chunk(FILE *f, Palette *pal);
+static void ase_file_write_color2_chunk(FILE *f, ASE_FrameHeader *frame_header, Palette *pal);
 static Layer *ase_file_read_layer_chunk(FILE *f, Sprite *sprite, Layer **previous_layer, int *current_level);
-static void ase_file_write_layer_chunk(FILE *f, Layer *layer);
+static void ase_file_write_layer_chunk(FILE *f, ASE_FrameHeader *frame_header, Layer *layer);
 static Cel *ase_file_read_cel_chunk(FILE *f, Sprite *sprite, FrameNumber frame, PixelFormat pixelFormat, FileOp *fop, ASE_Header *header, size_t chunk_end);
-static void ase_file_write_cel_chunk(FILE *f, Cel *cel, LayerImage *layer, Sprite *sprite);
+static void ase_file_write_cel_chunk(FILE *f, ASE_FrameHeader *frame_header, Cel *cel, LayerImage *layer, Sprite *sprite);
 static Mask *ase_file_read_mask_chunk(FILE *f);
-static void ase_file_write_mask_chunk(FILE *f, Mask *mask);
+static void ase_file_write_mask_chunk(FILE *f, ASE_FrameHeader *frame_header, Mask *mask);
 
 class AseFormat : public FileFormat {
   const char* onGetName() const { return "ase"; }
@@ -307,7 +309,7 @@ bool AseFormat::onSave(FileOp *fop)
         (frame == 0 ||
          sprite->getPalette(frame.previous())->countDiff(sprite->getPalette(frame), NULL, NULL) > 0)) {
       /* write the color chunk */
-      ase_file_write_color2_chunk(f, sprite->getPalette(frame));
+      ase_file_write_color2_chunk(f, &frame_header, sprite->getPalette(frame));
     }
 
     /* write extra chunks in the first frame */
@@ -317,11 +319,11 @@ bool AseFormat::onSave(FileOp *fop)
 
       /* write layer chunks */
       for (; it != end; ++it)
-        ase_file_write_layers(f, *it);
+        ase_file_write_layers(f, &frame_header, *it);
     }
 
     /* write cel chunks */
-    ase_file_write_cels(f, sprite, sprite->getFolder(), frame);
+    ase_file_write_cels(f, &frame_header, sprite, sprite->getFolder(), frame);
 
     /* write the frame header */
     ase_file_write_frame_header(f, &frame_header);
@@ -440,8 +442,6 @@ static void ase_file_prepare_frame_header(FILE *f, ASE_FrameHeader *frame_header
   frame_header->chunks = 0;
   frame_header->duration = 0;
 
-  current_frame_header = frame_header;
-
   fseek(f, pos+16, SEEK_SET);
 }
 
@@ -461,24 +461,22 @@ static void ase_file_write_frame_header(FILE *f, ASE_FrameHeader *frame_header)
   ase_file_write_padding(f, 6);
 
   fseek(f, end, SEEK_SET);
-
-  current_frame_header = NULL;
 }
 
-static void ase_file_write_layers(FILE *f, Layer *layer)
+static void ase_file_write_layers(FILE *f, ASE_FrameHeader *frame_header, Layer *layer)
 {
-  ase_file_write_layer_chunk(f, layer);
+  ase_file_write_layer_chunk(f, frame_header, layer);
 
   if (layer->isFolder()) {
     LayerIterator it = static_cast<LayerFolder*>(layer)->getLayerBegin();
     LayerIterator end = static_cast<LayerFolder*>(layer)->getLayerEnd();
 
     for (; it != end; ++it)
-      ase_file_write_layers(f, *it);
+      ase_file_write_layers(f, frame_header, *it);
   }
 }
 
-static void ase_file_write_cels(FILE *f, Sprite *sprite, Layer *layer, FrameNumber frame)
+static void ase_file_write_cels(FILE *f, ASE_FrameHeader *frame_header, Sprite *sprite, Layer *layer, FrameNumber frame)
 {
   if (layer->isImage()) {
     Cel* cel = static_cast<LayerImage*>(layer)->getCel(frame);
@@ -486,7 +484,7 @@ static void ase_file_write_cels(FILE *f, Sprite *sprite, Layer *layer, FrameNumb
 /*       fop_error(fop, "New cel in frame %d, in layer %d\n", */
 /*                   frame, sprite_layer2index(sprite, layer)); */
 
-      ase_file_write_cel_chunk(f, cel, static_cast<LayerImage*>(layer), sprite);
+      ase_file_write_cel_chunk(f, frame_header, cel, static_cast<LayerImage*>(layer), sprite);
     }
   }
 
@@ -495,7 +493,7 @@ static void ase_file_write_cels(FILE *f, Sprite *sprite, Layer *layer, FrameNumb
     LayerIterator end = static_cast<LayerFolder*>(layer)->getLayerEnd();
 
     for (; it != end; ++it)
-      ase_file_write_cels(f, sprite, *it, frame);
+      ase_file_write_cels(f, frame_header, sprite, *it, frame);
   }
 }
 
@@ -534,24 +532,24 @@ static void ase_file_write_string(FILE *f, const std::string& string)
     fputc(string[c], f);
 }
 
-static void ase_file_write_start_chunk(FILE *f, int type)
+static void ase_file_write_start_chunk(FILE *f, ASE_FrameHeader *frame_header, int type, ASE_Chunk *chunk)
 {
-  current_frame_header->chunks++;
+  frame_header->chunks++;
 
-  chunk_type = type;
-  chunk_start = ftell(f);
+  chunk->type = type;
+  chunk->start = ftell(f);
 
-  fseek(f, chunk_start+6, SEEK_SET);
+  fseek(f, chunk->start+6, SEEK_SET);
 }
 
-static void ase_file_write_close_chunk(FILE *f)
+static void ase_file_write_close_chunk(FILE *f, ASE_Chunk *chunk)
 {
   int chunk_end = ftell(f);
-  int chunk_size = chunk_end - chunk_start;
+  int chunk_size = chunk_end - chunk->start;
 
-  fseek(f, chunk_start, SEEK_SET);
+  fseek(f, chunk->start, SEEK_SET);
   fputl(chunk_size, f);
-  fputw(chunk_type, f);
+  fputw(chunk->type, f);
   fseek(f, chunk_end, SEEK_SET);
 }
 
@@ -610,11 +608,12 @@ static Palette *ase_file_read_color2_chunk(FILE *f, Sprite *sprite, FrameNumber
 }
 
 /* writes the original color chunk in FLI files for the entire palette "pal" */
-static void ase_file_write_color2_chunk(FILE *f, Palette *pal)
+static void ase_file_write_color2_chunk(FILE *f, ASE_FrameHeader *frame_header, Palette *pal)
 {
   int c, color;
 
-  ase_file_write_start_chunk(f, ASE_FILE_CHUNK_FLI_COLOR2);
+  ASE_Chunk chunk;
+  ase_file_write_start_chunk(f, frame_header, ASE_FILE_CHUNK_FLI_COLOR2, &chunk);
 
   fputw(1, f);                  // number of packets
 
@@ -629,7 +628,7 @@ static void ase_file_write_color2_chunk(FILE *f, Palette *pal)
     fputc(rgba_getb(color), f);
   }
 
-  ase_file_write_close_chunk(f);
+  ase_file_write_close_chunk(f, &chunk);
 }
 
 static Layer *ase_file_read_layer_chunk(FILE *f, Sprite *sprite, Layer **previous_layer, int *current_level)
@@ -682,9 +681,10 @@ static Layer *ase_file_read_layer_chunk(FILE *f, Sprite *sprite, Layer **previou
   return layer;
 }
 
-static void ase_file_write_layer_chunk(FILE *f, Layer *layer)
+static void ase_file_write_layer_chunk(FILE *f, ASE_FrameHeader *frame_header, Layer *layer)
 {
-  ase_file_write_start_chunk(f, ASE_FILE_CHUNK_LAYER);
+  ASE_Chunk chunk;
+  ase_file_write_start_chunk(f, frame_header, ASE_FILE_CHUNK_LAYER, &chunk);
 
   // Flags
   fputw(layer->getFlags(), f);
@@ -712,7 +712,7 @@ static void ase_file_write_layer_chunk(FILE *f, Layer *layer)
   /* layer name */
   ase_file_write_string(f, layer->getName());
 
-  ase_file_write_close_chunk(f);
+  ase_file_write_close_chunk(f, &chunk);
 
   /* fop_error(fop, "Layer name \"%s\" child level: %d\n", layer->name, child_level); */
 }
@@ -1103,12 +1103,13 @@ static Cel *ase_file_read_cel_chunk(FILE *f, Sprite *sprite, FrameNumber frame,
   return newCel;
 }
 
-static void ase_file_write_cel_chunk(FILE *f, Cel *cel, LayerImage *layer, Sprite *sprite)
+static void ase_file_write_cel_chunk(FILE *f, ASE_FrameHeader *frame_header, Cel *cel, LayerImage *layer, Sprite *sprite)
 {
   int layer_index = sprite->layerToIndex(layer);
   int cel_type = ASE_FILE_COMPRESSED_CEL;
 
-  ase_file_write_start_chunk(f, ASE_FILE_CHUNK_CEL);
+  ASE_Chunk chunk;
+  ase_file_write_start_chunk(f, frame_header, ASE_FILE_CHUNK_CEL, &chunk);
 
   fputw(layer_index, f);
   fputw(cel->getX(), f);
@@ -1190,7 +1191,7 @@ static void ase_file_write_cel_chunk(FILE *f, Cel *cel, LayerImage *layer, Sprit
     }
   }
 
-  ase_file_write_close_chunk(f);
+  ase_file_write_close_chunk(f, &chunk);
 }
 
 static Mask *ase_file_read_mask_chunk(FILE *f)
@@ -1221,12 +1222,13 @@ static Mask *ase_file_read_mask_chunk(FILE *f)
   return mask;
 }
 
-static void ase_file_write_mask_chunk(FILE *f, Mask *mask)
+static void ase_file_write_mask_chunk(FILE *f, ASE_FrameHeader *frame_header, Mask *mask)
 {
   int c, u, v, byte;
   const gfx::Rect& bounds(mask->getBounds());
 
-  ase_file_write_start_chunk(f, ASE_FILE_CHUNK_MASK);
+  ASE_Chunk chunk;
+  ase_file_write_start_chunk(f, frame_header, ASE_FILE_CHUNK_MASK, &chunk);
 
   fputw(bounds.x, f);
   fputw(bounds.y, f);
@@ -1247,7 +1249,7 @@ static void ase_file_write_mask_chunk(FILE *f, Mask *mask)
       fputc(byte, f);
     }
 
-  ase_file_write_close_chunk(f);
+  ase_file_write_close_chunk(f, &chunk);
 }
 
 } // namespace app
@@ -116,6 +116,27 @@ Document* load_document(const char* filename)
   return document;
 }
 
+Document* load_document_noninteractive(const char* filename, std::string& error)
+{
+  FileOp* fop = fop_to_load_document(filename,
+                                     FILE_LOAD_SEQUENCE_NONE |
+                                     FILE_LOAD_NOT_INTERACTIVE);
+  if (!fop)
+    return NULL;
+
+  fop_operate(fop, NULL);
+  fop_done(fop);
+  fop_post_load(fop);
+
+  if (fop->has_error())
+    error = fop->error;
+
+  Document* document = fop->document;
+  fop_free(fop);
+
+  return document;
+}
+
 int save_document(Document* document)
 {
   int ret;
@@ -227,6 +248,9 @@ FileOp* fop_to_load_document(const char* filename, int flags)
   if (flags & FILE_LOAD_ONE_FRAME)
     fop->oneframe = true;
 
+  if (flags & FILE_LOAD_NOT_INTERACTIVE)
+    fop->interactive = false;
+
 done:;
   return fop;
 }
@@ -246,13 +270,13 @@ FileOp* fop_to_save_document(Document* document)
   // Get the extension of the filename (in lower case)
   base::string extension = base::string_to_lower(base::get_file_extension(fop->document->getFilename()));
 
-  PRINTF("Saving document \"%s\" (%s)\n", fop->document->getFilename(), extension.c_str());
+  PRINTF("Saving document \"%s\" (%s)\n", fop->document->getFilename().c_str(), extension.c_str());
 
   /* get the format through the extension of the filename */
   fop->format = get_fileformat(extension.c_str());
   if (!fop->format ||
       !fop->format->support(FILE_SUPPORT_SAVE)) {
-    fop_error(fop, "ASEPRITE can't save \"%s\" files\n", extension);
+    fop_error(fop, "ASEPRITE can't save \"%s\" files\n", extension.c_str());
     return fop;
   }
 
@@ -810,6 +834,7 @@ static FileOp* fop_new(FileOpType type)
   fop->done = false;
   fop->stop = false;
   fop->oneframe = false;
+  fop->interactive = true;
 
   fop->seq.palette = NULL;
   fop->seq.image = NULL;
@@ -31,6 +31,7 @@
 #define FILE_LOAD_SEQUENCE_ASK          0x00000002
 #define FILE_LOAD_SEQUENCE_YES          0x00000004
 #define FILE_LOAD_ONE_FRAME             0x00000008
+#define FILE_LOAD_NOT_INTERACTIVE       0x00000010
 
 namespace base {
   class mutex;
@@ -82,6 +83,9 @@ namespace app {
     bool oneframe : 1;            // Load just one frame (in formats
     // that support animation like
     // GIF/FLI/ASE).
+    bool interactive : 1;         // The user can be asked for options
+    // (false if the file is loaded from
+    // a worker thread or without UI).
 
     // Data for sequences.
     struct {
@@ -119,6 +123,11 @@ namespace app {
   // High-level routines to load/save documents.
 
   Document* load_document(const char* filename);
+
+  // Loads a document from any thread: the user is not asked anything
+  // and errors are returned in "error" (instead of showing them in
+  // the console).
+  Document* load_document_noninteractive(const char* filename, std::string& error);
   int save_document(Document* document);
 
   // Low-level routines to load/save documents.
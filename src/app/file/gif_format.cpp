@@ -21,6 +21,7 @@
 #endif
 
 #include "base/unique_ptr.h"
+#include "app/app.h"
 #include "app/document.h"
 #include "app/file/file.h"
 #include "app/file/file_format.h"
@@ -317,7 +318,11 @@ bool GifFormat::onPostLoad(FileOp* fop)
   done:;
   }
 
-  if (askForConversion) {
+  // Without UI (e.g. batch mode) the safest option is used.
+  if (askForConversion && (!fop->interactive || !App::instance()->isGui())) {
+    pixelFormat = IMAGE_RGB;
+  }
+  else if (askForConversion) {
     int result =
       ui::Alert::show("GIF Conversion"
                       "<<The selected file: %s"
@@ -27,8 +27,14 @@
 
 #include "app/file_system.h"
 
+#include "app/app.h"
+#include "base/bind.h"
+#include "base/fs.h"
+#include "base/mutex.h"
 #include "base/path.h"
+#include "base/scoped_lock.h"
 #include "base/string.h"
+#include "base/thread.h"
 
 #include <algorithm>
 #include <cstdio>
@@ -38,11 +44,6 @@
 
 #include <allegro.h>
 
-// define this macro to solve the problem of for_each_file Allegro
-// routine which does not support to wrap 64-bits pointers in its
-// user-data parameter
-#define WORKAROUND_64BITS_SUPPORT
-
 // in Windows we can use PIDLS
 #if defined ALLEGRO_WINDOWS
   // uncomment this if you don't want to use PIDLs in windows
@@ -102,6 +103,97 @@
 
 namespace app {
 
+#ifndef USE_PIDLS
+
+// Reads the entries of a folder in a background thread.
+class ChildrenLoader {
+public:
+  struct Entry {
+    base::string filename;
+    int attrib;
+  };
+  typedef std::vector<Entry> Entries;
+
+  ChildrenLoader(const base::string& path)
+    : m_path(path)
+    , m_done(false)
+    , m_stop(false)
+    , m_thread(Bind<void>(&ChildrenLoader::readEntries, this)) {
+  }
+
+  ~ChildrenLoader() {
+    m_stop = true;
+    m_thread.join();
+  }
+
+  // Waits until all the folder is read.
+  void wait() {
+    m_thread.join();
+  }
+
+  // Moves the entries read until now to the given vector. Returns
+  // true if all the entries were read.
+  bool takeEntries(Entries& entries) {
+    base::scoped_lock hold(m_mutex);
+    entries.insert(entries.end(), m_entries.begin(), m_entries.end());
+    m_entries.clear();
+    return m_done;
+  }
+
+private:
+  void readEntries() {
+    char buf[MAX_PATH], path[MAX_PATH], tmp[32];
+
+    ustrcpy(path, m_path.c_str());
+    put_backslash(path);
+
+    replace_filename(buf,
+                     path,
+                     uconvert_ascii("*.*", tmp),
+                     sizeof(buf));
+
+    struct al_ffblk info;
+    if (al_findfirst(buf, &info, FA_TO_SHOW) == 0) {
+      Entries batch;
+      do {
+        if (*info.name == '.' &&
+            (ustrcmp(info.name, ".") == 0 ||
+             ustrcmp(info.name, "..") == 0))
+          continue;
+
+        Entry entry;
+        entry.filename = base::join_path(m_path, info.name);
+        entry.attrib = info.attrib;
+        batch.push_back(entry);
+
+        // Publish the entries in groups to avoid locking the mutex
+        // for each file.
+        if (batch.size() == 256) {
+          base::scoped_lock hold(m_mutex);
+          m_entries.insert(m_entries.end(), batch.begin(), batch.end());
+          batch.clear();
+        }
+      } while (!m_stop && al_findnext(&info) == 0);
+      al_findclose(&info);
+
+      base::scoped_lock hold(m_mutex);
+      m_entries.insert(m_entries.end(), batch.begin(), batch.end());
+    }
+
+    base::scoped_lock hold(m_mutex);
+    m_done = true;
+  }
+
+  base::string m_path;
+  base::mutex m_mutex;
+  Entries m_entries;
+  bool m_done;
+  volatile bool m_stop;
+  base::thread m_thread;
+};
+
+#endif
+
 // a position in the file-system
 class FileItem : public IFileItem {
 public:
@@ -110,6 +202,7 @@ public:
   base::string displayname;
   FileItem* parent;
   FileItemList children;
+  FileItemList oldChildren;     // Children before the current read
   unsigned int version;
   bool removed;
 #ifdef USE_PIDLS
@@ -120,12 +213,18 @@ public:
   SFGAOF attrib;
 #else
   int attrib;
+  time_t mtime;                 // Modification time of the folder
+                                // when its children were read
+  ChildrenLoader* loader;       // Reading children in background
 #endif
 
   FileItem(FileItem* parent);
   ~FileItem();
 
-  void insertChildSorted(FileItem* child);
+  bool isChildrenListOutdated();
+  void startLoadingChildren();
+  void addChild(FileItem* child);
+  void finishLoadingChildren();
   int compare(const FileItem& that) const;
 
   bool operator<(const FileItem& that) const { return compare(that) < 0; }
@@ -144,6 +243,8 @@ public:
 
   IFileItem* getParent() const;
   const FileItemList& getChildren();
+  void loadChildrenInBackground();
+  const FileItemList& getLoadedChildren(bool& loading);
 
   bool hasExtension(const base::string& csv_extensions);
 
@@ -164,10 +265,6 @@ static unsigned int current_file_system_version = 0;
 #ifdef USE_PIDLS
   static IMalloc* shl_imalloc = NULL;
   static IShellFolder* shl_idesktop = NULL;
-#else
-  #ifdef WORKAROUND_64BITS_SUPPORT
-  static FileItem* for_each_child_callback_param;
-  #endif
 #endif
 
 /* a more easy PIDLs interface (without using the SH* & IL* routines of W2K) */
@@ -186,7 +283,6 @@ static unsigned int current_file_system_version = 0;
   static void put_fileitem(FileItem* fileitem);
 #else
   static FileItem* get_fileitem_by_path(const base::string& path, bool create_if_not);
-  static void for_each_child_callback(const char *filename, int attrib, int param);
   static base::string remove_backslash_if_needed(const base::string& filename);
   static base::string get_key_for_filename(const base::string& filename);
   static void put_fileitem(FileItem* fileitem);
@@ -255,6 +351,9 @@ FileSystemModule::~FileSystemModule()
 
 FileSystemModule* FileSystemModule::instance()
 {
+  if (!m_instance)
+    App::instance()->getFileSystemModule();
+
   return m_instance;
 }
 
@@ -422,133 +521,219 @@ IFileItem* FileItem::getParent() const
 
 const FileItemList& FileItem::getChildren()
 {
-  // Is the file-item a folder?
-  if (IS_FOLDER(this) &&
-      // if the children list is empty, or the file-system version
-      // change (it's like to say: the current this->children list
-      // is outdated)...
-      (this->children.empty() ||
-       current_file_system_version > this->version)) {
-    FileItemList::iterator it;
-    FileItem* child;
+  loadChildrenInBackground();
 
-    // we have to mark current items as deprecated
-    for (it=this->children.begin();
-         it!=this->children.end(); ++it) {
-      child = static_cast<FileItem*>(*it);
-      child->removed = true;
-    }
+#ifndef USE_PIDLS
+  if (this->loader)
+    this->loader->wait();
+#endif
+
+  bool loading;
+  return getLoadedChildren(loading);
+}
+
+void FileItem::loadChildrenInBackground()
+{
+#ifndef USE_PIDLS
+  if (this->loader)
+    return;
+#endif
+
+  if (!isChildrenListOutdated())
+    return;
+
+  //PRINTF("FS: Loading files for %p (%s)\n", fileitem, fileitem->displayname);
+  startLoadingChildren();
 
-    //PRINTF("FS: Loading files for %p (%s)\n", fileitem, fileitem->displayname);
 #ifdef USE_PIDLS
-    {
-      IShellFolder* pFolder = NULL;
+  {
+    IShellFolder* pFolder = NULL;
+    FileItem* child;
 
-      if (this == rootitem)
-        pFolder = shl_idesktop;
-      else
-        shl_idesktop->BindToObject(this->fullpidl,
-                                   NULL,
-                                   IID_IShellFolder,
-                                   (LPVOID *)&pFolder);
-
-      if (pFolder != NULL) {
-        IEnumIDList *pEnum = NULL;
-        ULONG c, fetched;
-
-        /* get the interface to enumerate subitems */
-        pFolder->EnumObjects(win_get_window(),
-                             SHCONTF_FOLDERS | SHCONTF_NONFOLDERS, &pEnum);
-
-        if (pEnum != NULL) {
-          LPITEMIDLIST itempidl[256];
-          SFGAOF attribs[256];
-
-          /* enumerate the items in the folder */
-          while (pEnum->Next(256, itempidl, &fetched) == S_OK && fetched > 0) {
-            /* request the SFGAO_FOLDER attribute to know what of the
-               item is a folder */
-            for (c=0; c<fetched; ++c) {
-              attribs[c] = SFGAO_FOLDER;
-              pFolder->GetAttributesOf(1, (LPCITEMIDLIST *)itempidl, attribs+c);
-            }
+    if (this == rootitem)
+      pFolder = shl_idesktop;
+    else
+      shl_idesktop->BindToObject(this->fullpidl,
+                                 NULL,
+                                 IID_IShellFolder,
+                                 (LPVOID *)&pFolder);
+
+    if (pFolder != NULL) {
+      IEnumIDList *pEnum = NULL;
+      ULONG c, fetched;
+
+      /* get the interface to enumerate subitems */
+      pFolder->EnumObjects(win_get_window(),
+                           SHCONTF_FOLDERS | SHCONTF_NONFOLDERS, &pEnum);
+
+      if (pEnum != NULL) {
+        LPITEMIDLIST itempidl[256];
+        SFGAOF attribs[256];
+
+        /* enumerate the items in the folder */
+        while (pEnum->Next(256, itempidl, &fetched) == S_OK && fetched > 0) {
+          /* request the SFGAO_FOLDER attribute to know what of the
+             item is a folder */
+          for (c=0; c<fetched; ++c) {
+            attribs[c] = SFGAO_FOLDER;
+            pFolder->GetAttributesOf(1, (LPCITEMIDLIST *)itempidl, attribs+c);
+          }
+
+          /* generate the FileItems */
+          for (c=0; c<fetched; ++c) {
+            LPITEMIDLIST fullpidl = concat_pidl(this->fullpidl,
+                                                itempidl[c]);
+
+            child = get_fileitem_by_fullpidl(fullpidl, false);
+            if (!child) {
+              child = new FileItem(this);
+
+              child->pidl = itempidl[c];
+              child->fullpidl = fullpidl;
+              child->attrib = attribs[c];
 
-            /* generate the FileItems */
-            for (c=0; c<fetched; ++c) {
-              LPITEMIDLIST fullpidl = concat_pidl(this->fullpidl,
-                                                  itempidl[c]);
-
-              child = get_fileitem_by_fullpidl(fullpidl, false);
-              if (!child) {
-                child = new FileItem(this);
-
-                child->pidl = itempidl[c];
-                child->fullpidl = fullpidl;
-                child->attrib = attribs[c];
-
-                update_by_pidl(child);
-                put_fileitem(child);
-              }
-              else {
-                ASSERT(child->parent == this);
-                free_pidl(fullpidl);
-                free_pidl(itempidl[c]);
-              }
-
-              this->insertChildSorted(child);
+              update_by_pidl(child);
+              put_fileitem(child);
+            }
+            else {
+              ASSERT(child->parent == this);
+              free_pidl(fullpidl);
+              free_pidl(itempidl[c]);
             }
-          }
 
-          pEnum->Release();
+            this->addChild(child);
+          }
         }
 
-        if (pFolder != shl_idesktop)
-          pFolder->Release();
+        pEnum->Release();
       }
+
+      if (pFolder != shl_idesktop)
+        pFolder->Release();
     }
+  }
+
+  finishLoadingChildren();
 #else
-    {
-      char buf[MAX_PATH], path[MAX_PATH], tmp[32];
+  this->mtime = base::get_file_mtime(this->filename);
+  this->loader = new ChildrenLoader(this->filename);
+#endif
+}
 
-      ustrcpy(path, this->filename.c_str());
-      put_backslash(path);
+const FileItemList& FileItem::getLoadedChildren(bool& loading)
+{
+#ifndef USE_PIDLS
+  if (this->loader) {
+    ChildrenLoader::Entries entries;
+    bool done = this->loader->takeEntries(entries);
+
+    for (ChildrenLoader::Entries::iterator
+           it=entries.begin(), end=entries.end(); it!=end; ++it) {
+      FileItem* child = get_fileitem_by_path(it->filename, false);
+      if (!child) {
+        child = new FileItem(this);
+
+        child->filename = it->filename;
+        child->displayname = base::get_file_name(it->filename);
+        child->attrib = it->attrib;
+
+        put_fileitem(child);
+      }
+      else {
+        ASSERT(child->parent == this);
+      }
 
-      replace_filename(buf,
-                       path,
-                       uconvert_ascii("*.*", tmp),
-                       sizeof(buf));
+      addChild(child);
+    }
+
+    if (done) {
+      delete this->loader;
+      this->loader = NULL;
+
+      finishLoadingChildren();
+    }
+  }
 
-#ifdef WORKAROUND_64BITS_SUPPORT
-      // we cannot use the for_each_file's 'param' to wrap a 64-bits pointer
-      for_each_child_callback_param = this;
-      for_each_file(buf, FA_TO_SHOW, for_each_child_callback, 0);
+  loading = (this->loader != NULL);
 #else
-      for_each_file(buf, FA_TO_SHOW,
-                    for_each_child_callback,
-                    (int)this);
+  loading = false;
 #endif
+
+  return this->children;
+}
+
+// Returns true if the children of the folder must be read again.
+bool FileItem::isChildrenListOutdated()
+{
+  // Is the file-item a folder?
+  if (!IS_FOLDER(this))
+    return false;
+
+  // if the children list is empty, or the file-system version
+  // change (it's like to say: the current this->children list
+  // is outdated)...
+  if (!this->children.empty() &&
+      current_file_system_version <= this->version)
+    return false;
+
+#ifndef USE_PIDLS
+  // Files can be added, removed or renamed in a folder only if its
+  // modification time changes, so we can avoid reading and sorting
+  // the whole folder again.
+  if (!this->children.empty() &&
+      base::get_file_mtime(this->filename) == this->mtime) {
+    this->version = current_file_system_version;
+    return false;
   }
 #endif
 
-    // check old file-items (maybe removed directories or file-items)
-    for (it=this->children.begin();
-         it!=this->children.end(); ) {
-      child = static_cast<FileItem*>(*it);
-      if (child->removed) {
-        it = this->children.erase(it);
+  return true;
+}
 
-        fileitems_map->erase(fileitems_map->find(child->keyname));
-        delete child;
-      }
-      else
-        ++it;
-    }
+void FileItem::startLoadingChildren()
+{
+  // we have to mark current items as deprecated (the ones that are
+  // not found again will be removed)
+  for (FileItemList::iterator
+         it=this->children.begin(); it!=this->children.end(); ++it) {
+    FileItem* child = static_cast<FileItem*>(*it);
+    child->removed = true;
+  }
 
-    // now this file-item is updated
-    this->version = current_file_system_version;
+  this->oldChildren.swap(this->children);
+  this->children.clear();
+}
+
+void FileItem::addChild(FileItem* child)
+{
+  // this file-item wasn't removed from the last lookup
+  child->removed = false;
+  this->children.push_back(child);
+}
+
+static bool fileitem_less_than(IFileItem* a, IFileItem* b)
+{
+  return static_cast<FileItem*>(a)->compare(*static_cast<FileItem*>(b)) < 0;
+}
+
+void FileItem::finishLoadingChildren()
+{
+  // check old file-items (maybe removed directories or file-items)
+  for (FileItemList::iterator
+         it=this->oldChildren.begin(); it!=this->oldChildren.end(); ++it) {
+    FileItem* child = static_cast<FileItem*>(*it);
+    if (child->removed) {
+      fileitems_map->erase(fileitems_map->find(child->keyname));
+      delete child;
+    }
   }
+  this->oldChildren.clear();
 
-  return this->children;
+  // Sort all the children at once (instead of sorted insertions).
+  std::sort(this->children.begin(), this->children.end(), fileitem_less_than);
+
+  // now this file-item is updated
+  this->version = current_file_system_version;
 }
 
 bool FileItem::hasExtension(const base::string& csv_extensions)
@@ -596,6 +781,8 @@ FileItem::FileItem(FileItem* parent)
   this->attrib = 0;
 #else
   this->attrib = 0;
+  this->mtime = 0;
+  this->loader = NULL;
 #endif
 }
 
@@ -613,33 +800,11 @@ FileItem::~FileItem()
     free_pidl(this->pidl);
     this->pidl = NULL;
   }
+#else
+  delete this->loader;
 #endif
 }
 
-void FileItem::insertChildSorted(FileItem* child)
-{
-  // this file-item wasn't removed from the last lookup
-  child->removed = false;
-
-  // if the fileitem is already in the list we can go back
-  if (std::find(children.begin(), children.end(), child) != children.end())
-    return;
-
-  bool inserted = false;
-
-  for (FileItemList::iterator
-         it=children.begin(); it!=children.end(); ++it) {
-    if (*static_cast<FileItem*>(*it) > *child) {
-      children.insert(it, child);
-      inserted = true;
-      break;
-    }
-  }
-
-  if (!inserted)
-    children.push_back(child);
-}
-
 /**
  * Compares two FileItems.
  *
@@ -1022,39 +1187,6 @@ static FileItem* get_fileitem_by_path(const base::string& path, bool create_if_n
   return fileitem;
 }
 
-static void for_each_child_callback(const char *filename, int attrib, int param)
-{
-#ifdef WORKAROUND_64BITS_SUPPORT
-  FileItem* fileitem = for_each_child_callback_param;
-#else
-  FileItem* fileitem = (FileItem*)param;
-#endif
-  FileItem* child;
-  const char *filename_without_path = get_filename(filename);
-
-  if (*filename_without_path == '.' &&
-      (ustrcmp(filename_without_path, ".") == 0 ||
-       ustrcmp(filename_without_path, "..") == 0))
-    return;
-
-  child = get_fileitem_by_path(filename, false);
-  if (!child) {
-    ASSERT(fileitem != NULL);
-    child = new FileItem(fileitem);
-
-    child->filename = filename;
-    child->displayname = filename_without_path;
-    child->attrib = attrib;
-
-    put_fileitem(child);
-  }
-  else {
-    ASSERT(child->parent == fileitem);
-  }
-
-  fileitem->insertChildSorted(child);
-}
-
 static base::string remove_backslash_if_needed(const base::string& filename)
 {
   if (!filename.empty() && base::is_path_separator(*(filename.end()-1))) {
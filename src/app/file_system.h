@@ -66,8 +66,22 @@ namespace app {
     virtual base::string getDisplayName() const = 0;
 
     virtual IFileItem* getParent() const = 0;
+
+    // Returns the children of the folder, they are read again if the
+    // list is outdated. If the children were being read in background
+    // (see loadChildrenInBackground()), it waits the read to finish.
     virtual const FileItemList& getChildren() = 0;
 
+    // Starts reading the children of the folder in a background
+    // thread (only if the current list is outdated).
+    virtual void loadChildrenInBackground() = 0;
+
+    // Adds to the list of children the ones read in background until
+    // now and returns the list. "loading" is set to true if the read
+    // is still in progress (the list is sorted when the read
+    // finishes). It must be called from the GUI thread.
+    virtual const FileItemList& getLoadedChildren(bool& loading) = 0;
+
     virtual bool hasExtension(const base::string& csv_extensions) = 0;
 
     virtual BITMAP* getThumbnail() = 0;
@@ -23,6 +23,7 @@
 #include "app/ini_file.h"
 
 #include "app/resource_finder.h"
+#include "app/startup_profiler.h"
 #include "base/fs.h"
 
 #include <allegro/config.h>
@@ -37,6 +38,8 @@ static std::string config_filename;
 
 ConfigModule::ConfigModule()
 {
+  StartupMarker marker("Config module");
+
   ResourceFinder rf;
   rf.findConfigurationFile();
 
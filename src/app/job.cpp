@@ -25,6 +25,7 @@
 #include "app/ui/status_bar.h"
 #include "base/mutex.h"
 #include "base/scoped_lock.h"
+#include "base/task_scheduler.h"
 #include "base/thread.h"
 #include "ui/alert.h"
 #include "ui/widget.h"
@@ -97,6 +98,17 @@ bool Job::isCanceled()
   return m_canceled_flag;
 }
 
+void Job::waitTaskGroup(base::TaskGroup& group)
+{
+  while (!group.wait_for(0.1)) {
+    jobProgress(group.getProgress());
+
+    if (isCanceled())
+      group.cancel();
+  }
+  jobProgress(group.getProgress());
+}
+
 void Job::onMonitoringTick()
 {
   base::scoped_lock hold(*m_mutex);
@@ -113,8 +125,13 @@ void Job::onMonitoringTick()
 
 void Job::done()
 {
-  base::scoped_lock hold(*m_mutex);
-  m_done_flag = true;
+  {
+    base::scoped_lock hold(*m_mutex);
+    m_done_flag = true;
+  }
+
+  // Close the monitor as soon as possible.
+  m_timer->tickFromThread();
 }
 
 // Called to start the worker thread.
@@ -26,6 +26,7 @@
 namespace base {
   class thread;
   class mutex;
+  class TaskGroup;
 }
 
 namespace app {
@@ -49,6 +50,11 @@ namespace app {
     // check this variable periodically to stop working.
     bool isCanceled();
 
+    // Waits the tasks of the given group from onJob(), reporting the
+    // progress of the group as the job progress, and canceling the
+    // group if the job is canceled.
+    void waitTaskGroup(base::TaskGroup& group);
+
   protected:
 
     // This member function is called from another dedicated thread
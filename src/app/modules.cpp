@@ -24,6 +24,7 @@
 
 #include "app/modules/gui.h"
 #include "app/modules/palettes.h"
+#include "app/startup_profiler.h"
 
 namespace app {
 
@@ -54,6 +55,7 @@ LegacyModules::LegacyModules(int requirements)
   for (int c=0; c<modules; c++)
     if ((module[c].reqs & requirements) == module[c].reqs) {
       PRINTF("Installing module: %s\n", module[c].name);
+      StartupMarker marker(std::string("Module ") + module[c].name);
 
       if ((*module[c].init)() < 0)
         throw base::Exception("Error initializing module: %s",
@@ -32,6 +32,7 @@
 #include "app/modules/gui.h"
 #include "app/modules/palettes.h"
 #include "app/settings/settings.h"
+#include "app/startup_profiler.h"
 #include "app/tools/ink.h"
 #include "app/tools/tool_box.h"
 #include "app/ui/editor/editor.h"
@@ -197,13 +198,19 @@ int init_module_gui()
   manager->setDisplay(main_display);
 
   // Setup the GUI theme for all widgets
-  CurrentTheme::set(ase_theme = new SkinTheme());
+  {
+    StartupMarker marker("Skin theme");
+    CurrentTheme::set(ase_theme = new SkinTheme());
+  }
 
   if (maximized)
     main_display->maximize();
 
   // Configure ji_screen
-  gui_setup_screen(true);
+  {
+    StartupMarker marker("Setup screen");
+    gui_setup_screen(true);
+  }
 
   // Set graphics options for next time
   save_gui_config();
@@ -24,6 +24,7 @@
 
 #include "app/app_menus.h"
 #include "app/ini_file.h"
+#include "app/startup_profiler.h"
 #include "base/fs.h"
 #include "base/path.h"
 
@@ -37,6 +38,8 @@ RecentFiles::RecentFiles()
   : m_files(16)
   , m_paths(16)
 {
+  StartupMarker marker("Recent files");
+
   char buf[512];
 
   for (int c=m_files.limit()-1; c>=0; c--) {
@@ -0,0 +1,138 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/startup_profiler.h"
+
+#include "base/chrono.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace app {
+
+namespace {
+
+  struct Mark {
+    std::string name;
+    int depth;
+    double begin;               // In seconds from the program start
+    double end;
+  };
+
+  // The chrono is created with the static objects, so it's the
+  // closest thing we have to the process start time.
+  base::Chrono startup_chrono;
+  std::vector<Mark> marks;
+  std::string trace_filename;
+  int current_depth = 0;
+  bool enabled = true;
+
+  std::string escape_json(const std::string& s) {
+    std::string result;
+    for (size_t i=0; i<s.size(); ++i) {
+      if (s[i] == '"' || s[i] == '\\')
+        result.push_back('\\');
+      result.push_back(s[i]);
+    }
+    return result;
+  }
+
+  bool start_order(const Mark* a, const Mark* b) {
+    if (a->begin != b->begin)
+      return a->begin < b->begin;
+    else
+      return a->depth < b->depth;
+  }
+
+}
+
+StartupMarker::StartupMarker(const std::string& name)
+  : m_name(name)
+  , m_begin(startup_chrono.elapsed())
+{
+  ++current_depth;
+}
+
+StartupMarker::~StartupMarker()
+{
+  --current_depth;
+
+  if (enabled) {
+    Mark mark;
+    mark.name = m_name;
+    mark.depth = current_depth;
+    mark.begin = m_begin;
+    mark.end = startup_chrono.elapsed();
+    marks.push_back(mark);
+  }
+}
+
+void startup_profiler_set_trace_file(const std::string& filename)
+{
+  trace_filename = filename;
+}
+
+void startup_profiler_dump()
+{
+  if (!enabled)
+    return;
+
+  enabled = false;
+
+  // Markers are recorded when they finish, so the outer ones are
+  // after their children. Print them in the order they started.
+  std::vector<const Mark*> sorted;
+  for (size_t i=0; i<marks.size(); ++i)
+    sorted.push_back(&marks[i]);
+  std::sort(sorted.begin(), sorted.end(), start_order);
+
+  PRINTF("Startup times (%.3f ms until now):\n", startup_chrono.elapsed() * 1000.0);
+  for (size_t i=0; i<sorted.size(); ++i)
+    PRINTF("  %*s%-*s %9.3f ms\n",
+           sorted[i]->depth*2, "",
+           40 - sorted[i]->depth*2, sorted[i]->name.c_str(),
+           (sorted[i]->end - sorted[i]->begin) * 1000.0);
+
+  if (!trace_filename.empty()) {
+    FILE* f = std::fopen(trace_filename.c_str(), "w");
+    if (f) {
+      std::fprintf(f, "{ \"traceEvents\": [\n");
+      for (size_t i=0; i<sorted.size(); ++i) {
+        std::fprintf(f, "  { \"name\": \"%s\", \"cat\": \"startup\", \"ph\": \"X\", "
+                     "\"ts\": %.0f, \"dur\": %.0f, \"pid\": 1, \"tid\": 1 }%s\n",
+                     escape_json(sorted[i]->name).c_str(),
+                     sorted[i]->begin * 1000000.0,
+                     (sorted[i]->end - sorted[i]->begin) * 1000000.0,
+                     (i+1 < sorted.size() ? ",": ""));
+      }
+      std::fprintf(f, "] }\n");
+      std::fclose(f);
+    }
+    else
+      PRINTF("Error saving startup trace to \"%s\"\n", trace_filename.c_str());
+  }
+
+  marks.clear();
+}
+
+} // namespace app
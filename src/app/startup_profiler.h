@@ -0,0 +1,50 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef APP_STARTUP_PROFILER_H_INCLUDED
+#define APP_STARTUP_PROFILER_H_INCLUDED
+
+#include <string>
+
+namespace app {
+
+  // Measures the time spent in a part of the program initialization
+  // (from its construction to its destruction). Markers can be
+  // nested, and they must be used from the main thread only.
+  class StartupMarker {
+  public:
+    StartupMarker(const std::string& name);
+    ~StartupMarker();
+
+  private:
+    std::string m_name;
+    double m_begin;
+  };
+
+  // Sets the file where the Chrome trace (chrome://tracing JSON
+  // format) of the startup markers will be saved.
+  void startup_profiler_set_trace_file(const std::string& filename);
+
+  // Prints the time spent in each startup marker (with --verbose) and
+  // saves the trace file (if it was specified). Next markers are not
+  // recorded.
+  void startup_profiler_dump();
+
+} // namespace app
+
+#endif
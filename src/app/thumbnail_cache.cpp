@@ -0,0 +1,302 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/thumbnail_cache.h"
+
+#include "app/resource_finder.h"
+#include "base/convert_to.h"
+#include "base/file_handle.h"
+#include "base/fs.h"
+#include "base/mutex.h"
+#include "base/path.h"
+#include "base/scoped_lock.h"
+
+#include <algorithm>
+#include <allegro.h>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+// Increase this version if the format of thumbnail files changes.
+#define THUMBNAIL_MAGIC         "ASETHUMB"
+#define THUMBNAIL_VERSION       1
+#define MAX_THUMBNAIL_SIZE      512
+
+// Limits of the cache directory. The oldest thumbnails are deleted
+// when the directory is bigger than this size, and thumbnails (e.g.
+// of deleted files) older than this number of days are deleted too.
+#define MAX_CACHE_SIZE          (64*1024*1024)
+#define MAX_THUMBNAIL_AGE       30
+
+namespace app {
+
+using namespace base;
+
+namespace {
+
+  mutex cache_dir_mutex;
+  string cache_dir;
+  bool cache_dir_initialized = false;
+  size_t cache_size = 0;          // Size of the cache directory (approximated between prunes)
+  int tmp_counter = 0;            // To create unique temporary files
+
+  struct CacheFile {
+    string filename;
+    size_t size;
+    time_t time;
+
+    // The oldest files go first.
+    bool operator<(const CacheFile& other) const {
+      return time < other.time;
+    }
+  };
+
+  // Deletes old thumbnails, and the oldest ones until the directory
+  // size is below the limit. It must be called with the
+  // "cache_dir_mutex" locked.
+  void prune_cache_dir() {
+    std::vector<CacheFile> files;
+    string pattern = join_path(cache_dir, "*.*");
+    struct al_ffblk info;
+
+    if (al_findfirst(pattern.c_str(), &info,
+                     FA_RDONLY | FA_HIDDEN | FA_SYSTEM | FA_ARCH) == 0) {
+      do {
+        CacheFile file;
+        file.filename = join_path(cache_dir, info.name);
+        file.size = (size_t)al_ffblk_get_size(&info);
+        file.time = info.time;
+        files.push_back(file);
+      } while (al_findnext(&info) == 0);
+      al_findclose(&info);
+    }
+
+    std::sort(files.begin(), files.end());
+
+    time_t limit = std::time(NULL) - MAX_THUMBNAIL_AGE*24*60*60;
+    cache_size = 0;
+    for (size_t i=0; i<files.size(); ++i)
+      cache_size += files[i].size;
+
+    for (size_t i=0; i<files.size(); ++i) {
+      if (files[i].time >= limit && cache_size <= MAX_CACHE_SIZE)
+        break;
+
+      try {
+        delete_file(files[i].filename);
+        cache_size -= files[i].size;
+      }
+      catch (const std::exception&) {
+        // The file could be used by other process.
+      }
+    }
+  }
+
+  // Returns the directory where thumbnails are saved (it's created
+  // the first time), or an empty string if it cannot be used.
+  string get_cache_dir() {
+    scoped_lock lock(cache_dir_mutex);
+
+    if (!cache_dir_initialized) {
+      cache_dir_initialized = true;
+
+      ResourceFinder rf;
+#if defined ALLEGRO_UNIX || defined ALLEGRO_MACOSX
+      rf.findInHomeDir(".aseprite-thumbnails");
+#endif
+      rf.findInBinDir("thumbnails");
+
+      if (const char* path = rf.first()) {
+        try {
+          if (!directory_exists(path))
+            make_directory(path);
+          cache_dir = path;
+
+          prune_cache_dir();
+        }
+        catch (const std::exception&) {
+          PRINTF("Thumbnail cache disabled, cannot create \"%s\"\n", path);
+        }
+      }
+    }
+
+    return cache_dir;
+  }
+
+  // Each file is saved in a file named with two 32-bit hashes
+  // (FNV-1a and djb2) of its path. The full path is saved inside the
+  // file too, to detect collisions.
+  string get_thumbnail_filename(const string& filename) {
+    string dir = get_cache_dir();
+    if (dir.empty())
+      return dir;
+
+    unsigned int fnv = 2166136261u;
+    unsigned int djb = 5381;
+    for (size_t i=0; i<filename.size(); ++i) {
+      unsigned char c = filename[i];
+      fnv = (fnv ^ c) * 16777619u;
+      djb = djb*33 + c;
+    }
+
+    char buf[32];
+    std::sprintf(buf, "%08x%08x.thumb", fnv, djb);
+    return join_path(dir, buf);
+  }
+
+  void write32(FILE* f, unsigned int value) {
+    std::fputc(value & 0xff, f);
+    std::fputc((value >> 8) & 0xff, f);
+    std::fputc((value >> 16) & 0xff, f);
+    std::fputc((value >> 24) & 0xff, f);
+  }
+
+  bool read32(FILE* f, unsigned int& value) {
+    unsigned char buf[4];
+    if (std::fread(buf, 1, 4, f) != 4)
+      return false;
+    value = buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((unsigned int)buf[3] << 24);
+    return true;
+  }
+
+  void write_thumbnail(FILE* f, const string& filename, BITMAP* thumbnail) {
+    std::fwrite(THUMBNAIL_MAGIC, 1, 8, f);
+    write32(f, THUMBNAIL_VERSION);
+    write32(f, (unsigned int)get_file_size(filename));
+    write32(f, (unsigned int)get_file_mtime(filename));
+    write32(f, filename.size());
+    std::fwrite(filename.c_str(), 1, filename.size(), f);
+    write32(f, thumbnail->w);
+    write32(f, thumbnail->h);
+
+    for (int y=0; y<thumbnail->h; ++y) {
+      for (int x=0; x<thumbnail->w; ++x) {
+        int c = _getpixel16(thumbnail, x, y);
+        std::fputc(getr16(c), f);
+        std::fputc(getg16(c), f);
+        std::fputc(getb16(c), f);
+      }
+    }
+  }
+
+}
+
+BITMAP* load_cached_thumbnail(const string& filename)
+{
+  string thumbFilename = get_thumbnail_filename(filename);
+  if (thumbFilename.empty())
+    return NULL;
+
+  FileHandle f(open_file(thumbFilename, "rb"));
+  if (!f)
+    return NULL;
+
+  char magic[8];
+  unsigned int version, size, mtime, pathLength, w, h;
+  if (std::fread(magic, 1, 8, f) != 8 ||
+      std::memcmp(magic, THUMBNAIL_MAGIC, 8) != 0 ||
+      !read32(f, version) || version != THUMBNAIL_VERSION ||
+      !read32(f, size) || size != (unsigned int)get_file_size(filename) ||
+      !read32(f, mtime) || mtime != (unsigned int)get_file_mtime(filename) ||
+      !read32(f, pathLength) || pathLength != filename.size())
+    return NULL;
+
+  std::vector<char> path(pathLength);
+  if (pathLength > 0 &&
+      (std::fread(&path[0], 1, pathLength, f) != pathLength ||
+       std::memcmp(&path[0], filename.c_str(), pathLength) != 0))
+    return NULL;
+
+  if (!read32(f, w) || !read32(f, h) ||
+      w < 1 || w > MAX_THUMBNAIL_SIZE ||
+      h < 1 || h > MAX_THUMBNAIL_SIZE)
+    return NULL;
+
+  std::vector<unsigned char> rgb(w*h*3);
+  if (std::fread(&rgb[0], 1, rgb.size(), f) != rgb.size())
+    return NULL;
+
+  BITMAP* bmp = create_bitmap_ex(16, w, h);
+  if (!bmp)
+    return NULL;
+
+  const unsigned char* src = &rgb[0];
+  for (unsigned int y=0; y<h; ++y) {
+    for (unsigned int x=0; x<w; ++x, src+=3)
+      _putpixel16(bmp, x, y, makecol16(src[0], src[1], src[2]));
+  }
+
+  return bmp;
+}
+
+void save_cached_thumbnail(const string& filename, BITMAP* thumbnail)
+{
+  ASSERT(bitmap_color_depth(thumbnail) == 16);
+  if (thumbnail->w > MAX_THUMBNAIL_SIZE ||
+      thumbnail->h > MAX_THUMBNAIL_SIZE)
+    return;
+
+  string thumbFilename = get_thumbnail_filename(filename);
+  if (thumbFilename.empty())
+    return;
+
+  // The thumbnail is written in a temporary file (unique for each
+  // call) which replaces the final file when it is complete, so a
+  // partial thumbnail is never read.
+  string tmpFilename;
+  {
+    scoped_lock lock(cache_dir_mutex);
+    tmpFilename = thumbFilename + "." + convert_to<string>(++tmp_counter) + ".tmp";
+  }
+
+  size_t size;
+  {
+    FileHandle f(open_file(tmpFilename, "wb"));
+    if (!f)
+      return;
+
+    write_thumbnail(f, filename, thumbnail);
+
+    size = (size_t)std::ftell(f);
+    if (std::ferror(f))
+      size = 0;
+  }
+
+  try {
+    if (size == 0) {
+      delete_file(tmpFilename);
+      return;
+    }
+    move_file(tmpFilename, thumbFilename);
+  }
+  catch (const std::exception&) {
+    return;
+  }
+
+  scoped_lock lock(cache_dir_mutex);
+  cache_size += size;
+  if (cache_size > MAX_CACHE_SIZE)
+    prune_cache_dir();
+}
+
+} // namespace app
@@ -0,0 +1,45 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef APP_THUMBNAIL_CACHE_H_INCLUDED
+#define APP_THUMBNAIL_CACHE_H_INCLUDED
+
+#include "base/string.h"
+
+struct BITMAP;
+
+namespace app {
+
+  // Persistent store of file thumbnails (used by the file selector)
+  // so they don't have to be generated again each time a folder is
+  // visited. Thumbnails are saved in the user directory and they are
+  // keyed by file path, size and modification time, so a thumbnail of
+  // a modified file is never used. The oldest thumbnails are deleted
+  // when the cache is too big or too old. These functions can be
+  // called from any thread.
+
+  // Returns a new 16 bpp bitmap with the thumbnail of the given file,
+  // or NULL if there is no valid thumbnail for it.
+  BITMAP* load_cached_thumbnail(const base::string& filename);
+
+  // Saves the given 16 bpp bitmap as the thumbnail of the file.
+  void save_cached_thumbnail(const base::string& filename, BITMAP* thumbnail);
+
+} // namespace app
+
+#endif
@@ -26,6 +26,7 @@
 #include "app/document.h"
 #include "app/file/file.h"
 #include "app/file_system.h"
+#include "app/thumbnail_cache.h"
 #include "base/bind.h"
 #include "base/scoped_lock.h"
 #include "base/thread.h"
@@ -39,33 +40,43 @@
 #include <allegro.h>
 
 #define MAX_THUMBNAIL_SIZE              128
+#define MAX_THUMBNAIL_THREADS           4
 
 namespace app {
 
 class ThumbnailGenerator::Worker {
 public:
+  enum State { Pending, Running, Done };
+
   Worker(FileOp* fop, IFileItem* fileitem)
     : m_fop(fop)
     , m_fileitem(fileitem)
+    , m_state(Pending)
     , m_thumbnail(NULL)
-    , m_palette(NULL)
-    , m_thread(Bind<void>(&Worker::loadBgThread, this)) {
+    , m_palette(NULL) {
   }
 
   ~Worker() {
-    fop_stop(m_fop);
-    m_thread.join();
-
     fop_free(m_fop);
   }
 
   IFileItem* getFileItem() { return m_fileitem; }
-  bool isDone() const { return fop_is_done(m_fop); }
+  State getState() const { return m_state; }
+  void setState(State state) { m_state = state; }
+  void stop() { fop_stop(m_fop); }
   double getProgress() const { return fop_get_progress(m_fop); }
 
-private:
-  void loadBgThread() {
+  // Called from a thread of the pool.
+  void run() {
     try {
+      // Try to use the thumbnail generated in other session.
+      BITMAP* bmp = load_cached_thumbnail(m_fileitem->getFileName());
+      if (bmp) {
+        m_fileitem->setThumbnail(bmp);
+        fop_done(m_fop);
+        return;
+      }
+
       fop_operate(m_fop, NULL);
 
       // Post load
@@ -106,6 +117,7 @@ private:
       if (m_thumbnail) {
         BITMAP* bmp = create_bitmap_ex(16, m_thumbnail->getWidth(), m_thumbnail->getHeight());
         convert_image_to_allegro(m_thumbnail, bmp, 0, 0, m_palette);
+        save_cached_thumbnail(m_fileitem->getFileName(), bmp);
         m_fileitem->setThumbnail(bmp);
       }
     }
@@ -115,11 +127,12 @@ private:
     fop_done(m_fop);
   }
 
+private:
   FileOp* m_fop;
   IFileItem* m_fileitem;
+  State m_state;                // Protected by m_workersAccess
   base::UniquePtr<Image> m_thumbnail;
   base::UniquePtr<Palette> m_palette;
-  base::thread m_thread;
 };
 
 static void delete_singleton(ThumbnailGenerator* singleton)
@@ -137,6 +150,34 @@ ThumbnailGenerator* ThumbnailGenerator::instance()
   return singleton;
 }
 
+ThumbnailGenerator::ThumbnailGenerator()
+  : m_exit(false)
+{
+}
+
+ThumbnailGenerator::~ThumbnailGenerator()
+{
+  {
+    base::scoped_lock hold(m_workersAccess);
+    m_exit = true;
+
+    for (WorkerList::iterator
+           it=m_workers.begin(), end=m_workers.end(); it!=end; ++it)
+      (*it)->stop();
+
+    m_workersChanged.notify_all();
+  }
+
+  for (size_t i=0; i<m_threads.size(); ++i) {
+    m_threads[i]->join();
+    delete m_threads[i];
+  }
+
+  for (WorkerList::iterator
+         it=m_workers.begin(), end=m_workers.end(); it!=end; ++it)
+    delete *it;
+}
+
 ThumbnailGenerator::WorkerStatus ThumbnailGenerator::getWorkerStatus(IFileItem* fileitem, double& progress)
 {
   base::scoped_lock hold(m_workersAccess);
@@ -145,7 +186,7 @@ ThumbnailGenerator::WorkerStatus ThumbnailGenerator::getWorkerStatus(IFileItem*
          it=m_workers.begin(), end=m_workers.end(); it!=end; ++it) {
     Worker* worker = *it;
     if (worker->getFileItem() == fileitem) {
-      if (worker->isDone())
+      if (worker->getState() == Worker::Done)
         return ThumbnailIsDone;
       else {
         progress = worker->getProgress();
@@ -163,7 +204,7 @@ bool ThumbnailGenerator::checkWorkers()
 
   for (WorkerList::iterator
          it=m_workers.begin(); it != m_workers.end(); ) {
-    if ((*it)->isDone()) {
+    if ((*it)->getState() == Worker::Done) {
       delete *it;
       it = m_workers.erase(it);
     }
@@ -175,15 +216,29 @@ bool ThumbnailGenerator::checkWorkers()
   return doingWork;
 }
 
-void ThumbnailGenerator::addWorkerToGenerateThumbnail(IFileItem* fileitem)
+void ThumbnailGenerator::addWorkerToGenerateThumbnail(IFileItem* fileitem, Priority priority)
 {
-  double progress;
-
   if (fileitem->isBrowsable() ||
-      fileitem->getThumbnail() != NULL ||
-      getWorkerStatus(fileitem, progress) != WithoutWorker)
+      fileitem->getThumbnail() != NULL)
     return;
 
+  {
+    base::scoped_lock hold(m_workersAccess);
+
+    for (WorkerList::iterator
+           it=m_workers.begin(), end=m_workers.end(); it!=end; ++it) {
+      Worker* worker = *it;
+      if (worker->getFileItem() == fileitem) {
+        // Promote a pending request to the front of the queue.
+        if (priority == HighPriority && worker->getState() == Worker::Pending) {
+          m_workers.erase(it);
+          m_workers.push_front(worker);
+        }
+        return;
+      }
+    }
+  }
+
   FileOp* fop = fop_to_load_document(fileitem->getFileName().c_str(),
                                      FILE_LOAD_SEQUENCE_NONE |
                                      FILE_LOAD_ONE_FRAME);
@@ -192,38 +247,92 @@ void ThumbnailGenerator::addWorkerToGenerateThumbnail(IFileItem* fileitem)
 
   if (fop->has_error()) {
     fop_free(fop);
+    return;
   }
-  else {
-    Worker* worker = new Worker(fop, fileitem);
-    try {
-      base::scoped_lock hold(m_workersAccess);
+
+  Worker* worker = new Worker(fop, fileitem);
+  try {
+    base::scoped_lock hold(m_workersAccess);
+
+    if (priority == HighPriority)
+      m_workers.push_front(worker);
+    else
       m_workers.push_back(worker);
-    }
-    catch (...) {
-      delete worker;
-      throw;
-    }
+
+    // Create a new thread for the pool if all threads are busy.
+    int busy = 0;
+    for (WorkerList::iterator
+           it=m_workers.begin(), end=m_workers.end(); it!=end; ++it)
+      if ((*it)->getState() == Worker::Running)
+        ++busy;
+
+    int maxThreads = MID(1, (int)base::thread::hardware_concurrency()-1, MAX_THUMBNAIL_THREADS);
+    if (busy == (int)m_threads.size() && (int)m_threads.size() < maxThreads)
+      m_threads.push_back(new base::thread(Bind<void>(&ThumbnailGenerator::threadProc, this)));
+
+    m_workersChanged.notify_one();
+  }
+  catch (...) {
+    delete worker;
+    throw;
   }
 }
 
 void ThumbnailGenerator::stopAllWorkers()
 {
-  base::thread* ptr = new base::thread(Bind<void>(&ThumbnailGenerator::stopAllWorkersBackground, this));
-  m_stopThread.reset(ptr);
+  base::scoped_lock hold(m_workersAccess);
+
+  for (WorkerList::iterator
+         it=m_workers.begin(); it != m_workers.end(); ) {
+    Worker* worker = *it;
+
+    // Running workers are stopped, and they will be deleted when they
+    // are done (in checkWorkers() or in the destructor).
+    if (worker->getState() == Worker::Running) {
+      worker->stop();
+      ++it;
+    }
+    else {
+      delete worker;
+      it = m_workers.erase(it);
+    }
+  }
 }
 
-void ThumbnailGenerator::stopAllWorkersBackground()
+void ThumbnailGenerator::threadProc()
 {
-  WorkerList workersCopy;
-  {
-    base::scoped_lock hold(m_workersAccess);
-    workersCopy = m_workers;
-    m_workers.clear();
-  }
+  for (;;) {
+    Worker* worker = NULL;
+    {
+      base::scoped_lock hold(m_workersAccess);
 
-  for (WorkerList::iterator
-         it=workersCopy.begin(), end=workersCopy.end(); it!=end; ++it) {
-    delete *it;
+      while (!m_exit) {
+        // Get the first pending worker (the one with more priority).
+        for (WorkerList::iterator
+               it=m_workers.begin(), end=m_workers.end(); it!=end; ++it) {
+          if ((*it)->getState() == Worker::Pending) {
+            worker = *it;
+            break;
+          }
+        }
+        if (worker)
+          break;
+
+        m_workersChanged.wait(hold);
+      }
+
+      if (m_exit)
+        return;
+
+      worker->setState(Worker::Running);
+    }
+
+    worker->run();
+
+    {
+      base::scoped_lock hold(m_workersAccess);
+      worker->setState(Worker::Done);
+    }
   }
 }
 
@@ -19,9 +19,10 @@
 #ifndef APP_THUMBNAIL_GENERATOR_H_INCLUDED
 #define APP_THUMBNAIL_GENERATOR_H_INCLUDED
 
+#include "base/condition_variable.h"
 #include "base/mutex.h"
-#include "base/unique_ptr.h"
 
+#include <list>
 #include <vector>
 
 namespace base {
@@ -31,15 +32,27 @@ namespace base {
 namespace app {
   class IFileItem;
 
+  // Generates thumbnails of files in a small pool of background
+  // threads. Requests are processed by priority (e.g. the selected
+  // file first, then visible files) and thumbnails are saved in a
+  // persistent cache (see thumbnail_cache.h).
   class ThumbnailGenerator {
   public:
     enum WorkerStatus { WithoutWorker, WorkingOnThumbnail, ThumbnailIsDone };
+    enum Priority { HighPriority, LowPriority };
+
+    ThumbnailGenerator();
+    ~ThumbnailGenerator();
 
     static ThumbnailGenerator* instance();
 
     // Generate a thumbnail for the given file-item.  It must be called
-    // from the GUI thread.
-    void addWorkerToGenerateThumbnail(IFileItem* fileitem);
+    // from the GUI thread. High priority requests are processed
+    // before any other pending request (the last one first), and a
+    // pending low priority request can be promoted calling this
+    // function again with HighPriority.
+    void addWorkerToGenerateThumbnail(IFileItem* fileitem,
+                                      Priority priority = HighPriority);
 
     // Returns the status of the worker that is generating the thumbnail
     // for the given file.
@@ -47,24 +60,29 @@ namespace app {
 
     // Checks the status of workers. If there are workers that already
     // done its job, we've to destroy them. This function must be called
-    // from the GUI thread (because a thread is joint to it).
+    // from the GUI thread.
     // Returns true if there are workers generating thumbnails.
     bool checkWorkers();
 
     // Stops all workers generating thumbnails. This is an non-blocking
-    // operation. The cancelation of all workers is done in a background
-    // thread.
+    // operation: pending requests are discarded, and the running ones
+    // are canceled (and destroyed in a next checkWorkers() call).
     void stopAllWorkers();
 
   private:
-    void stopAllWorkersBackground();
-
     class Worker;
-    typedef std::vector<Worker*> WorkerList;
+    typedef std::list<Worker*> WorkerList;
+
+    void threadProc();
 
+    // All the workers (pending, running, and done). Pending workers
+    // are processed in the list order, so high priority ones are
+    // added at the beginning, and low priority ones at the end.
     WorkerList m_workers;
     base::mutex m_workersAccess;
-    base::UniquePtr<base::thread> m_stopThread;
+    base::condition_variable m_workersChanged;
+    std::vector<base::thread*> m_threads;
+    bool m_exit;
   };
 } // namespace app
 
@@ -23,6 +23,7 @@
 #include "app/tools/tool_box.h"
 
 #include "app/gui_xml.h"
+#include "app/startup_profiler.h"
 #include "app/tools/controller.h"
 #include "app/tools/ink.h"
 #include "app/tools/intertwine.h"
@@ -71,6 +72,8 @@ const char* WellKnownInks::Jumble = "jumble";
 
 ToolBox::ToolBox()
 {
+  StartupMarker marker("Tool box");
+
   PRINTF("Toolbox module: installing\n");
 
   m_inks[WellKnownInks::Selection]       = new SelectionInk();
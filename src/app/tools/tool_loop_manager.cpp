@@ -129,26 +129,39 @@ bool ToolLoopManager::releaseButton(const Pointer& pointer)
 
 void ToolLoopManager::movement(const Pointer& pointer)
 {
-  if (isCanceled())
+  movement(std::vector<Pointer>(1, pointer));
+}
+
+void ToolLoopManager::movement(const std::vector<Pointer>& pointers)
+{
+  if (isCanceled() || pointers.empty())
     return;
 
-  // Convert the screen point to a sprite point
-  Point spritePoint = m_toolLoop->screenToSprite(Point(pointer.getX(), pointer.getY()));
-  // Calculate the speed (new sprite point - old sprite point)
-  m_toolLoop->setSpeed(spritePoint - m_oldPoint);
-  m_oldPoint = spritePoint;
-  snapToGrid(true, spritePoint);
+  for (size_t i=0; i<pointers.size(); ++i) {
+    const Pointer& pointer = pointers[i];
+    bool last = (i == pointers.size()-1);
+
+    // Convert the screen point to a sprite point
+    Point spritePoint = m_toolLoop->screenToSprite(Point(pointer.getX(), pointer.getY()));
+    // Calculate the speed (new sprite point - old sprite point)
+    m_toolLoop->setSpeed(spritePoint - m_oldPoint);
+    m_oldPoint = spritePoint;
+    snapToGrid(true, spritePoint);
 
-  m_toolLoop->getController()->movement(m_toolLoop, m_points, spritePoint);
+    m_toolLoop->getController()->movement(m_toolLoop, m_points, spritePoint);
+
+    // With TracePolicyLast only the trace of the last point is kept,
+    // so intermediate points don't need to be drawn.
+    if (last || m_toolLoop->getTracePolicy() != TracePolicyLast)
+      doLoopStep(false, last);
+  }
 
   std::string statusText;
   m_toolLoop->getController()->getStatusBarText(m_points, statusText);
   m_toolLoop->updateStatusBar(statusText.c_str());
-
-  doLoopStep(false);
 }
 
-void ToolLoopManager::doLoopStep(bool last_step)
+void ToolLoopManager::doLoopStep(bool last_step, bool notify)
 {
   Points points_to_interwine;
   if (!last_step)
@@ -196,6 +209,18 @@ void ToolLoopManager::doLoopStep(bool last_step)
     m_oldDirtyArea = prev_dirty_area;
   }
 
+  // Accumulate the dirty area of intermediate steps to notify it
+  // with the next step.
+  if (!notify) {
+    m_pendingDirtyArea.createUnion(m_pendingDirtyArea, dirty_area);
+    return;
+  }
+
+  if (!m_pendingDirtyArea.isEmpty()) {
+    dirty_area.createUnion(dirty_area, m_pendingDirtyArea);
+    m_pendingDirtyArea.clear();
+  }
+
   if (!dirty_area.isEmpty())
     m_toolLoop->updateDirtyArea();
 }
@@ -93,10 +93,15 @@ namespace app {
       // Should be called each time the user moves the mouse inside the editor.
       void movement(const Pointer& pointer);
 
+      // Same as movement() but for several positions of the mouse
+      // (e.g. coalesced mouse movements). The trace is drawn for each
+      // point, but the document observers are notified just one time.
+      void movement(const std::vector<Pointer>& pointers);
+
     private:
       typedef std::vector<gfx::Point> Points;
 
-      void doLoopStep(bool last_step);
+      void doLoopStep(bool last_step, bool notify = true);
       void snapToGrid(bool flexible, gfx::Point& point);
 
       static void calculateDirtyArea(ToolLoop* loop,
@@ -111,6 +116,7 @@ namespace app {
       Points m_points;
       gfx::Point m_oldPoint;
       gfx::Region m_oldDirtyArea;
+      gfx::Region m_pendingDirtyArea; // Dirty area not yet notified
     };
 
   } // namespace tools
@@ -29,6 +29,7 @@
 #include "app/ui/editor/editor.h"
 #include "ui/message.h"
 #include "ui/system.h"
+#include "ui/view.h"
 
 #include <allegro.h>
 
@@ -119,16 +120,28 @@ bool DrawingState::onMouseMove(Editor* editor, MouseMessage* msg)
   editor->hideDrawingCursor();
 
   // Infinite scroll
+  View* view = View::getView(editor);
+  gfx::Point oldScroll = view->getViewScroll();
   gfx::Point mousePos = editor->controlInfiniteScroll(msg);
 
   // Hide the cursor again
   editor->hideDrawingCursor();
 
-  // notify mouse movement to the tool
+  // Notify mouse movement to the tool (including the intermediate
+  // positions of coalesced mouse messages). Those positions were
+  // recorded before the infinite scroll, so they are moved with the
+  // sprite to point to the same sprite pixels.
   ASSERT(m_toolLoopManager != NULL);
-  m_toolLoopManager
-    ->movement(tools::ToolLoopManager::Pointer(mousePos.x, mousePos.y,
-                                               button_from_msg(msg)));
+  gfx::Point delta = oldScroll - view->getViewScroll();
+  std::vector<tools::ToolLoopManager::Pointer> pointers;
+  const std::vector<gfx::Point>& positions = msg->coalescedPositions();
+  for (size_t i=0; i<positions.size(); ++i)
+    pointers.push_back(tools::ToolLoopManager::Pointer(positions[i].x + delta.x,
+                                                       positions[i].y + delta.y,
+                                                       button_from_msg(msg)));
+  pointers.push_back(tools::ToolLoopManager::Pointer(mousePos.x, mousePos.y,
+                                                     button_from_msg(msg)));
+  m_toolLoopManager->movement(pointers);
 
   // draw the cursor again
   editor->showDrawingCursor();
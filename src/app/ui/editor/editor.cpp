@@ -50,6 +50,7 @@
 #include "app/ui/toolbar.h"
 #include "app/ui_context.h"
 #include "app/util/boundary.h"
+#include "app/util/frame_render_cache.h"
 #include "app/util/misc.h"
 #include "app/util/render.h"
 #include "base/bind.h"
@@ -131,6 +132,7 @@ Editor::Editor(Document* document)
   : Widget(editor_type())
   , m_state(new StandbyState())
   , m_decorator(NULL)
+  , m_renderCache(NULL)
   , m_document(document)
   , m_sprite(m_document->getSprite())
   , m_layer(m_sprite->getFolder()->getFirstLayer())
@@ -157,6 +159,10 @@ Editor::Editor(Document* document)
 
   this->setFocusStop(true);
 
+  // Re-rendering the sprite is expensive, so exposed areas are
+  // copied from a retained buffer.
+  setRetainedBuffer(true);
+
   m_currentToolChangeSlot =
     App::instance()->CurrentToolChange.connect(&Editor::onCurrentToolChange, this);
 
@@ -406,12 +412,19 @@ void Editor::drawSpriteUnclippedRect(const gfx::Rect& rc)
   // Draw the sprite
 
   if ((width > 0) && (height > 0)) {
-    RenderEngine renderEngine(m_document, m_sprite, m_layer, m_frame);
+    base::UniquePtr<Image> rendered;
+
+    // Use the frame rendered in background if it's ready
+    if (m_renderCache && m_renderCache->getZoom() == m_zoom)
+      rendered.reset(m_renderCache->getFrameImage(m_frame,
+                                                  Rect(source_x, source_y, width, height)));
 
     // Generate the rendered image
-    base::UniquePtr<Image> rendered
-      (renderEngine.renderSprite(source_x, source_y, width, height,
-                                 m_frame, m_zoom, true));
+    if (!rendered) {
+      RenderEngine renderEngine(m_document, m_sprite, m_layer, m_frame);
+      rendered.reset(renderEngine.renderSprite(source_x, source_y, width, height,
+                                               m_frame, m_zoom, true));
+    }
 
     if (rendered) {
       // Pre-render decorator.
@@ -485,6 +498,18 @@ void Editor::drawSpriteClipped(const gfx::Region& updateRegion)
 
     set_clip_rect(ji_screen, cx1, cy1, cx2, cy2);
   }
+
+  // Update the retained buffer with the new sprite pixels
+  if (hasRetainedBuffer()) {
+    Region screenRegion;
+    for (Region::const_iterator
+           it=updateRegion.begin(), end=updateRegion.end(); it != end; ++it) {
+      Rect rc;
+      editorToScreen(*it, &rc);
+      screenRegion.createUnion(screenRegion, Region(rc));
+    }
+    retainArea(screenRegion);
+  }
 }
 
 /**
@@ -872,18 +897,27 @@ bool Editor::onProcessMessage(Message* msg)
 
     case kPaintMessage: {
       SkinTheme* theme = static_cast<SkinTheme*>(this->getTheme());
+      const gfx::Rect& paintRect = static_cast<PaintMessage*>(msg)->rect();
 
       int old_cursor_thick = m_cursor_thick;
       if (m_cursor_thick)
         editor_clean_cursor();
 
+      // The area was just exposed (the sprite didn't change), so we
+      // can copy it from the retained buffer.
+      if (restoreRetainedArea(paintRect)) {
+        if (old_cursor_thick != 0)
+          editor_draw_cursor(jmouse_x(0), jmouse_y(0));
+      }
       // Editor without sprite
-      if (!m_sprite) {
+      else if (!m_sprite) {
         View* view = View::getView(this);
         Rect vp = view->getViewportBounds();
 
         jdraw_rectfill(vp, theme->getColor(ThemeColor::EditorFace));
         draw_emptyset_symbol(ji_screen, vp, ui::rgba(64, 64, 64));
+
+        retainArea(gfx::Region(paintRect));
       }
       // Editor with sprite
       else {
@@ -919,6 +953,9 @@ bool Editor::onProcessMessage(Message* msg)
             m_mask_timer.stop();
           }
 
+          // Keep a copy of the rendered sprite (without the cursor)
+          retainArea(gfx::Region(paintRect));
+
           // Draw the cursor again
           if (old_cursor_thick != 0) {
             editor_draw_cursor(jmouse_x(0), jmouse_y(0));
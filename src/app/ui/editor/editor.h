@@ -51,6 +51,7 @@ namespace app {
   class DocumentLocation;
   class DocumentView;
   class EditorCustomizationDelegate;
+  class FrameRenderCache;
   class PixelsMovement;
 
   namespace tools {
@@ -79,6 +80,11 @@ namespace app {
     EditorDecorator* getDecorator() { return m_decorator; }
     void setDecorator(EditorDecorator* decorator) { m_decorator = decorator; }
 
+    // Sets a cache of pre-rendered frames to be used instead of
+    // rendering the sprite (e.g. for the animation playback). The
+    // cache is not owned by the Editor.
+    void setFrameRenderCache(FrameRenderCache* cache) { m_renderCache = cache; }
+
     Document* getDocument() { return m_document; }
     Sprite* getSprite() { return m_sprite; }
     Layer* getLayer() { return m_layer; }
@@ -202,6 +208,9 @@ namespace app {
     // Current decorator (to draw extra UI elements).
     EditorDecorator* m_decorator;
 
+    // Frames rendered in background (can be NULL).
+    FrameRenderCache* m_renderCache;
+
     Document* m_document;         // Active document in the editor
     Sprite* m_sprite;             // Active sprite in the editor
     Layer* m_layer;               // Active layer in the editor
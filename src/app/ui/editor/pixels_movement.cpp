@@ -41,6 +41,12 @@
 
 namespace app {
 
+// Number of pixels of the transformed image from which it is
+// previewed with less quality while the user scales/rotates it. The
+// full quality image is drawn when the mouse button is released.
+static const int kPreviewMaxPixels = 512*512;
+static const int kPreviewMaxStep = 8;
+
 template<typename T>
 static inline const base::Vector2d<double> point2Vector(const gfx::PointT<T>& pt) {
   return base::Vector2d<double>(pt.x, pt.y);
@@ -58,6 +64,7 @@ PixelsMovement::PixelsMovement(Context* context,
   , m_firstDrop(true)
   , m_isDragging(false)
   , m_adjustPivot(false)
+  , m_isPreview(false)
   , m_handle(NoHandle)
   , m_originalImage(Image::createCopy(moveThis))
 {
@@ -393,7 +400,7 @@ void PixelsMovement::moveImage(int x, int y, MoveModifier moveModifier)
     m_adjustPivot = true;
   }
 
-  redrawExtraImage();
+  redrawExtraImage(getPreviewStep());
   redrawCurrentMask();
 
   if (m_firstDrop)
@@ -460,6 +467,11 @@ void PixelsMovement::stampImage()
 
   {
     ContextWriter writer(m_reader);
+
+    // Stamp the full quality image.
+    if (m_isPreview)
+      redrawExtraImage();
+
     {
       // Expand the canvas to paste the image in the fully visible
       // portion of sprite.
@@ -513,6 +525,10 @@ void PixelsMovement::dropImageTemporarily()
       m_currentData.displacePivotTo(gfx::Point(newPivot.x, newPivot.y));
     }
 
+    // Replace the low quality preview with the final image.
+    if (m_isPreview)
+      redrawExtraImage();
+
     m_document->generateMaskBoundaries(m_currentMask);
     update_screen_for_document(m_document);
   }
@@ -585,7 +601,7 @@ void PixelsMovement::setMaskColor(uint32_t mask_color)
 }
 
 
-void PixelsMovement::redrawExtraImage()
+void PixelsMovement::redrawExtraImage(int step)
 {
   gfx::Transformation::Corners corners;
   m_currentData.transformBox(corners);
@@ -597,7 +613,10 @@ void PixelsMovement::redrawExtraImage()
                       corners.leftTop().x, corners.leftTop().y,
                       corners.rightTop().x, corners.rightTop().y,
                       corners.rightBottom().x, corners.rightBottom().y,
-                      corners.leftBottom().x, corners.leftBottom().y);
+                      corners.leftBottom().x, corners.leftBottom().y,
+                      step);
+
+  m_isPreview = (step > 1);
 }
 
 void PixelsMovement::redrawCurrentMask()
@@ -619,4 +638,17 @@ void PixelsMovement::redrawCurrentMask()
   m_currentMask->unfreeze();
 }
 
+int PixelsMovement::getPreviewStep() const
+{
+  // Simple movements are always drawn with full quality.
+  if (!m_isDragging || m_handle == MoveHandle)
+    return 1;
+
+  double pixels = (double)m_currentData.bounds().w * m_currentData.bounds().h;
+  int step = 1;
+  while (step < kPreviewMaxStep && pixels / (step*step) > kPreviewMaxPixels)
+    step *= 2;
+  return step;
+}
+
 } // namespace app
@@ -95,9 +95,16 @@ namespace app {
     const gfx::Transformation& getTransformation() const { return m_currentData; }
 
   private:
-    void redrawExtraImage();
+    // Redraws the transformed image in the extra cel. If "step" is
+    // greater than 1 a low quality preview is drawn (see
+    // raster::image_parallelogram).
+    void redrawExtraImage(int step = 1);
     void redrawCurrentMask();
 
+    // Returns the "step" to preview the current transformation while
+    // the user is dragging a handle.
+    int getPreviewStep() const;
+
     const ContextReader m_reader;
     Document* m_document;
     Sprite* m_sprite;
@@ -106,6 +113,7 @@ namespace app {
     bool m_firstDrop;
     bool m_isDragging;
     bool m_adjustPivot;
+    bool m_isPreview;           // True if the extra cel has a low quality preview
     HandleType m_handle;
     Image* m_originalImage;
     int m_catchX, m_catchY;
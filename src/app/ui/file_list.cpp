@@ -49,8 +49,10 @@ FileList::FileList()
   m_req_valid = false;
   m_selected = NULL;
   m_isearchClock = 0;
+  m_loadingList = false;
 
   m_itemToGenerateThumbnail = NULL;
+  m_firstVisibleItem = m_lastVisibleItem = -1;
 
   m_generateThumbnailTimer.Tick.connect(&FileList::onGenerateThumbnailTick, this);
   m_monitoringTimer.Tick.connect(&FileList::onMonitoringTick, this);
@@ -82,6 +84,10 @@ void FileList::setCurrentFolder(IFileItem* folder)
   m_currentFolder = folder;
   m_req_valid = false;
   m_selected = NULL;
+  m_firstVisibleItem = m_lastVisibleItem = -1;
+
+  // Discard thumbnails requested for the previous folder.
+  ThumbnailGenerator::instance()->stopAllWorkers();
 
   regenerateList();
 
@@ -124,6 +130,8 @@ bool FileList::onProcessMessage(Message* msg)
       ui::Color fgcolor;
       BITMAP *thumbnail = NULL;
       int thumbnail_y = 0;
+      int firstVisibleItem = -1;
+      int lastVisibleItem = -1;
 
       // rows
       for (FileItemList::iterator
@@ -131,6 +139,13 @@ bool FileList::onProcessMessage(Message* msg)
         IFileItem* fi = *it;
         gfx::Size itemSize = getFileItemSize(fi);
 
+        if (y+itemSize.h > vp.y && y < vp.y+vp.h) {
+          int index = it - m_list.begin();
+          if (firstVisibleItem < 0)
+            firstVisibleItem = index;
+          lastVisibleItem = index;
+        }
+
         if (fi == m_selected) {
           fgcolor = theme->getColor(ThemeColor::FileListSelectedRowText);
           bgcolor = theme->getColor(ThemeColor::FileListSelectedRowFace);
@@ -224,6 +239,14 @@ bool FileList::onProcessMessage(Message* msg)
                  getBounds().x2()-1, getBounds().y2()-1,
                  to_system(theme->getColor(ThemeColor::Background)));
 
+      // Generate thumbnails of the new visible items.
+      if (firstVisibleItem != m_firstVisibleItem ||
+          lastVisibleItem != m_lastVisibleItem) {
+        m_firstVisibleItem = firstVisibleItem;
+        m_lastVisibleItem = lastVisibleItem;
+        m_generateThumbnailTimer.start();
+      }
+
       // Draw the thumbnail
       if (thumbnail) {
         x = vp.x+vp.w-2-thumbnail->w;
@@ -462,6 +485,18 @@ void FileList::onCurrentFolderChanged()
 
 void FileList::onMonitoringTick()
 {
+  if (m_loadingList) {
+    regenerateList();
+    m_req_valid = false;
+    invalidate();
+    View::getView(this)->updateView();
+
+    // The selected item (e.g. the folder where we come from in goUp())
+    // can be in the list now.
+    if (!m_loadingList && m_selected)
+      makeSelectedFileitemVisible();
+  }
+
   if (ThumbnailGenerator::instance()->checkWorkers())
     invalidate();
 }
@@ -473,6 +508,15 @@ void FileList::onGenerateThumbnailTick()
   IFileItem* fileitem = m_itemToGenerateThumbnail;
   if (fileitem)
     ThumbnailGenerator::instance()->addWorkerToGenerateThumbnail(fileitem);
+
+  // Visible items are queued after the selected one, so their
+  // thumbnails are ready when the user selects them.
+  for (int i=MAX(0, m_firstVisibleItem);
+       i<=m_lastVisibleItem && i<(int)m_list.size(); ++i) {
+    if (!m_list[i]->isFolder())
+      ThumbnailGenerator::instance()
+        ->addWorkerToGenerateThumbnail(m_list[i], ThumbnailGenerator::LowPriority);
+  }
 }
 
 gfx::Size FileList::getFileItemSize(IFileItem* fi) const
@@ -518,10 +562,20 @@ void FileList::makeSelectedFileitemVisible()
   }
 }
 
+void FileList::waitForFileList()
+{
+  if (m_loadingList) {
+    m_currentFolder->getChildren();
+    onMonitoringTick();
+  }
+}
+
 void FileList::regenerateList()
 {
-  // get the children of the current folder
-  m_list = m_currentFolder->getChildren();
+  // get the children of the current folder, big folders are read in
+  // background (the list is updated from onMonitoringTick())
+  m_currentFolder->loadChildrenInBackground();
+  m_list = m_currentFolder->getLoadedChildren(m_loadingList);
 
   // filter the list by the available extensions
   if (!m_exts.empty()) {
@@ -537,6 +591,16 @@ void FileList::regenerateList()
         ++it;
     }
   }
+
+  // Items that were not found again in the folder are deleted when
+  // the read finishes.
+  if (!m_loadingList) {
+    if (m_selected && getSelectedIndex() < 0)
+      m_selected = NULL;
+    if (m_itemToGenerateThumbnail &&
+        std::find(m_list.begin(), m_list.end(), m_itemToGenerateThumbnail) == m_list.end())
+      m_itemToGenerateThumbnail = NULL;
+  }
 }
 
 int FileList::getSelectedIndex()
@@ -39,8 +39,15 @@ namespace app {
     void setCurrentFolder(IFileItem* folder);
 
     IFileItem* getSelectedFileItem() const { return m_selected; }
+
+    // Returns the items of the current folder. The list can be
+    // incomplete if the folder is still being read in background
+    // (see waitForFileList()).
     const FileItemList& getFileList() const { return m_list; }
 
+    // Waits until the whole current folder is read.
+    void waitForFileList();
+
     void goUp();
 
     Signal0<void> FileSelected;
@@ -66,6 +73,7 @@ namespace app {
 
     IFileItem* m_currentFolder;
     FileItemList m_list;
+    bool m_loadingList;
     bool m_req_valid;
     int m_req_w, m_req_h;
     IFileItem* m_selected;
@@ -76,7 +84,7 @@ namespace app {
     int m_isearchClock;
 
     // Timer to start generating the thumbnail after an item is
-    // selected.
+    // selected (or the visible items change).
     ui::Timer m_generateThumbnailTimer;
 
     // Monitoring the progress of each thumbnail.
@@ -86,6 +94,11 @@ namespace app {
     // thumbnail to generate when the m_generateThumbnailTimer ticks.
     IFileItem* m_itemToGenerateThumbnail;
 
+    // Range of items visible in the viewport (the last time the list
+    // was painted), their thumbnails are generated with low priority.
+    int m_firstVisibleItem;
+    int m_lastVisibleItem;
+
   };
 
 } // namespace app
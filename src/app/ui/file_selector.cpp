@@ -363,6 +363,7 @@ again:
     }
     else if (!fn.empty()) {
       // check if the user specified in "fn" a item of "fileview"
+      m_fileList->waitForFileList();
       const FileItemList& children = m_fileList->getFileList();
 
       base::string fn2 = fn;
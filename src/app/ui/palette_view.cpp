@@ -66,6 +66,7 @@ PaletteView::PaletteView(bool editable)
   m_boxsize = 6;
 
   this->setFocusStop(true);
+  this->setRetainedBuffer(true);
 
   this->border_width.l = this->border_width.r = 1 * jguiscale();
   this->border_width.t = this->border_width.b = 1 * jguiscale();
@@ -205,6 +206,10 @@ bool PaletteView::onProcessMessage(Message* msg)
   switch (msg->type()) {
 
     case kPaintMessage: {
+      const gfx::Rect& paintRect = static_cast<PaintMessage*>(msg)->rect();
+      if (restoreRetainedArea(paintRect))
+        return true;
+
       div_t d = div(Palette::MaxColors, m_columns);
       int cols = m_columns;
       int rows = d.quot + ((d.rem)? 1: 0);
@@ -261,6 +266,8 @@ bool PaletteView::onProcessMessage(Message* msg)
       blit(bmp, ji_screen,
            0, 0, getBounds().x, getBounds().y, bmp->w, bmp->h);
       destroy_bitmap(bmp);
+
+      retainArea(gfx::Region(paintRect));
       return true;
     }
 
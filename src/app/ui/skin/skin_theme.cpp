@@ -361,7 +361,7 @@ SkinTheme::~SkinTheme()
 
   // Destroy the minifont
   if (m_minifont && m_minifont != font)
-    destroy_font(m_minifont);
+    ji_font_destroy(m_minifont);
 }
 
 // Call ji_regen_theme after this
@@ -398,10 +398,10 @@ void SkinTheme::reload_skin()
 void SkinTheme::reload_fonts()
 {
   if (default_font && default_font != font)
-    destroy_font(default_font);
+    ji_font_destroy(default_font);
 
   if (m_minifont && m_minifont != font)
-    destroy_font(m_minifont);
+    ji_font_destroy(m_minifont);
 
   default_font = loadFont("UserFont", "skins/" + m_selected_skin + "/font.png");
   m_minifont = loadFont("UserMiniFont", "skins/" + m_selected_skin + "/minifont.png");
@@ -528,9 +528,9 @@ bool StatusBar::onProcessMessage(Message* msg)
           str += buf;
         }
 
-        textout_ex(doublebuffer, this->getFont(), str.c_str(),
-                   x, rc.y + rc.h/2 - text_height(this->getFont())/2,
-                   to_system(text_color), -1);
+        ji_font_render_text(doublebuffer, this->getFont(), str.c_str(),
+                            x, rc.y + rc.h/2 - text_height(this->getFont())/2,
+                            to_system(text_color), -1);
 
         x += ji_font_text_len(this->getFont(), str.c_str()) + 4*jguiscale();
       }
@@ -548,10 +548,10 @@ bool StatusBar::onProcessMessage(Message* msg)
 
       // Status bar text
       if (getTextSize() > 0) {
-        textout_ex(doublebuffer, getFont(), getText().c_str(),
-                   x,
-                   rc.y + rc.h/2 - text_height(getFont())/2,
-                   to_system(text_color), -1);
+        ji_font_render_text(doublebuffer, getFont(), getText().c_str(),
+                            x,
+                            rc.y + rc.h/2 - text_height(getFont())/2,
+                            to_system(text_color), -1);
 
         x += ji_font_text_len(getFont(), getText().c_str()) + 4*jguiscale();
       }
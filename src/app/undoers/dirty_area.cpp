@@ -38,6 +38,7 @@ DirtyArea::DirtyArea(ObjectsContainer* objects, Image* image, Dirty* dirty)
   : m_imageId(objects->addObject(image))
 {
   raster::write_dirty(m_stream, dirty);
+  image->markAsModified();
 }
 
 void DirtyArea::dispose()
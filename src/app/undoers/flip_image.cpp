@@ -49,6 +49,8 @@ FlipImage::FlipImage(ObjectsContainer* objects, Image* image,
 {
   ASSERT(m_w >= 1 && m_h >= 1);
   ASSERT(m_x >= 0 && m_y >= 0 && m_x+m_w <= image->getWidth() && m_y+m_h <= image->getHeight());
+
+  image->markAsModified();
 }
 
 void FlipImage::dispose()
@@ -44,6 +44,9 @@ ImageArea::ImageArea(ObjectsContainer* objects, Image* image, int x, int y, int
 
   for (int v=0; v<h; ++v)
     memcpy(&m_data[m_lineSize*v], image->getPixelAddress(x, y+v), m_lineSize);
+
+  // This area of the image is going to be modified.
+  image->markAsModified();
 }
 
 void ImageArea::dispose()
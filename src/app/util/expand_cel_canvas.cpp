@@ -207,6 +207,7 @@ void ExpandCelCanvas::commit(const gfx::Rect& bounds)
 
       // Copy the destination to the cel image.
       copy_image(m_celImage, m_dstImage, 0, 0);
+      m_celImage->markAsModified();
     }
   }
   // If the size of both images are different, we have to
@@ -0,0 +1,166 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/util/frame_render_cache.h"
+
+#include "base/bind.h"
+#include "base/scoped_lock.h"
+#include "base/thread.h"
+#include "raster/image.h"
+#include "raster/primitives.h"
+#include "raster/sprite.h"
+
+#include <algorithm>
+
+namespace app {
+
+FrameRenderCache::FrameRenderCache(const Document* document,
+                                   const Sprite* sprite,
+                                   const Layer* currentLayer,
+                                   const gfx::Rect& bounds, int zoom,
+                                   bool draw_tiled_bg,
+                                   int memoryLimit)
+  : m_sprite(sprite)
+  , m_renderEngine(document, sprite, currentLayer, FrameNumber(0))
+  , m_bounds(bounds)
+  , m_zoom(zoom)
+  , m_drawTiledBg(draw_tiled_bg)
+  , m_frames(sprite->getTotalFrames(), (Image*)NULL)
+  , m_maxFrames(1)
+  , m_exit(false)
+  , m_thread(NULL)
+{
+  int frameSize = std::max(1, bounds.w * bounds.h * 4);
+  m_maxFrames = std::max(1, std::min(memoryLimit / frameSize, (int)m_frames.size()));
+
+  if (!m_bounds.isEmpty())
+    m_thread = new base::thread(Bind<void>(&FrameRenderCache::threadProc, this));
+}
+
+FrameRenderCache::~FrameRenderCache()
+{
+  if (m_thread) {
+    {
+      base::scoped_lock hold(m_mutex);
+      m_exit = true;
+      m_playheadChanged.notify_all();
+    }
+    m_thread->join();
+    delete m_thread;
+  }
+
+  for (size_t i=0; i<m_frames.size(); ++i)
+    delete m_frames[i];
+}
+
+void FrameRenderCache::prefetch(FrameNumber frame)
+{
+  base::scoped_lock hold(m_mutex);
+  if (m_playhead != frame) {
+    m_playhead = frame;
+    m_playheadChanged.notify_one();
+  }
+}
+
+bool FrameRenderCache::isFrameReady(FrameNumber frame)
+{
+  base::scoped_lock hold(m_mutex);
+  return (frame >= 0 && frame < (int)m_frames.size() && m_frames[frame] != NULL);
+}
+
+Image* FrameRenderCache::getFrameImage(FrameNumber frame, const gfx::Rect& rc)
+{
+  base::scoped_lock hold(m_mutex);
+
+  if (frame < 0 || frame >= (int)m_frames.size() ||
+      !m_frames[frame] || !m_bounds.contains(rc))
+    return NULL;
+
+  return crop_image(m_frames[frame],
+                    rc.x - m_bounds.x,
+                    rc.y - m_bounds.y, rc.w, rc.h, 0);
+}
+
+// Returns the position of the frame in the playback order starting
+// from the current playhead.
+int FrameRenderCache::getWindowIndex(FrameNumber frame) const
+{
+  int total = m_frames.size();
+  return ((frame - m_playhead) % total + total) % total;
+}
+
+bool FrameRenderCache::isInWindow(FrameNumber frame) const
+{
+  return getWindowIndex(frame) < m_maxFrames;
+}
+
+void FrameRenderCache::threadProc()
+{
+  for (;;) {
+    FrameNumber frame;
+    {
+      base::scoped_lock hold(m_mutex);
+
+      while (!m_exit) {
+        // Get the next frame to be rendered in playback order.
+        int i;
+        for (i=0; i<m_maxFrames; ++i) {
+          frame = FrameNumber((m_playhead + i) % m_frames.size());
+          if (!m_frames[frame])
+            break;
+        }
+        if (i < m_maxFrames)
+          break;
+
+        m_playheadChanged.wait(hold);
+      }
+
+      if (m_exit)
+        return;
+
+      // Discard frames that will not be displayed soon to keep the
+      // memory limit.
+      for (size_t i=0; i<m_frames.size(); ++i) {
+        if (m_frames[i] && !isInWindow(FrameNumber(i))) {
+          delete m_frames[i];
+          m_frames[i] = NULL;
+        }
+      }
+    }
+
+    Image* image = m_renderEngine.renderSprite(m_bounds.x, m_bounds.y,
+                                               m_bounds.w, m_bounds.h,
+                                               frame, m_zoom, m_drawTiledBg);
+
+    {
+      base::scoped_lock hold(m_mutex);
+      if (!m_frames[frame] && isInWindow(frame)) {
+        m_frames[frame] = image;
+        image = NULL;
+      }
+    }
+
+    delete image;
+  }
+}
+
+} // namespace app
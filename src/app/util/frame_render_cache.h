@@ -0,0 +1,112 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef APP_UTIL_FRAME_RENDER_CACHE_H_INCLUDED
+#define APP_UTIL_FRAME_RENDER_CACHE_H_INCLUDED
+
+#include "app/util/render.h"
+#include "base/condition_variable.h"
+#include "base/disable_copying.h"
+#include "base/mutex.h"
+#include "gfx/rect.h"
+#include "raster/frame_number.h"
+
+#include <vector>
+
+namespace base {
+  class thread;
+}
+
+namespace raster {
+  class Image;
+  class Layer;
+  class Sprite;
+}
+
+namespace app {
+  class Document;
+
+  using namespace raster;
+
+  // Renders the frames of a sprite in a background thread so the
+  // animation playback (or the preview) just needs to copy the final
+  // image to the screen. Frames are rendered in playback order from
+  // the frame specified in prefetch(), and the cache keeps as many
+  // frames as they fit in the given memory limit.
+  //
+  // The sprite must not be modified while the cache exists (e.g. the
+  // document is locked for writing or the UI is in a modal loop).
+  class FrameRenderCache {
+  public:
+    enum { DefaultMemoryLimit = 64*1024*1024 };
+
+    // The "bounds" are in zoomed sprite coordinates (as the
+    // source_x/y/width/height arguments of RenderEngine::renderSprite()).
+    FrameRenderCache(const Document* document,
+                     const Sprite* sprite,
+                     const Layer* currentLayer,
+                     const gfx::Rect& bounds, int zoom,
+                     bool draw_tiled_bg,
+                     int memoryLimit = DefaultMemoryLimit);
+    ~FrameRenderCache();
+
+    const gfx::Rect& getBounds() const { return m_bounds; }
+    int getZoom() const { return m_zoom; }
+
+    // Moves the playback position so the frames after the given one
+    // are rendered first (and old frames can be discarded).
+    void prefetch(FrameNumber frame);
+
+    // Returns true if the given frame is already rendered.
+    bool isFrameReady(FrameNumber frame);
+
+    // Returns a copy of the given area (in zoomed sprite coordinates)
+    // of the frame, or NULL if the frame isn't rendered yet (or "rc"
+    // is not inside the cache bounds). The caller must delete the
+    // returned image.
+    Image* getFrameImage(FrameNumber frame, const gfx::Rect& rc);
+
+  private:
+    bool isInWindow(FrameNumber frame) const;
+    int getWindowIndex(FrameNumber frame) const;
+    void threadProc();
+
+    const Sprite* m_sprite;
+    RenderEngine m_renderEngine;
+    gfx::Rect m_bounds;
+    int m_zoom;
+    bool m_drawTiledBg;
+
+    // Rendered frames (NULL if the frame is not rendered yet).
+    std::vector<Image*> m_frames;
+
+    // Number of frames (from m_playhead) that fit in memory.
+    int m_maxFrames;
+    FrameNumber m_playhead;
+
+    base::mutex m_mutex;
+    base::condition_variable m_playheadChanged;
+    bool m_exit;
+    base::thread* m_thread;
+
+    DISABLE_COPYING(FrameRenderCache);
+  };
+
+} // namespace app
+
+#endif
@@ -0,0 +1,353 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "app/util/packed_sprite_sheet.h"
+
+#include "app/document.h"
+#include "base/parallel_for.h"
+#include "base/path.h"
+#include "gfx/rect_packer.h"
+#include "raster/cel.h"
+#include "raster/image.h"
+#include "raster/layer.h"
+#include "raster/palette.h"
+#include "raster/primitives.h"
+#include "raster/primitives_fast.h"
+#include "raster/sprite.h"
+#include "raster/stock.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <ostream>
+
+namespace app {
+
+namespace {
+
+  // A rendered frame trimmed to its non-transparent area.
+  struct TrimmedFrame {
+    Image* image;               // NULL if the frame is transparent
+    gfx::Rect bounds;
+    uint32_t hash;
+  };
+
+  template<class Traits>
+  inline bool is_transparent(typename Traits::pixel_t c, color_t maskColor) {
+    return (c == maskColor);
+  }
+
+  template<>
+  inline bool is_transparent<RgbTraits>(RgbTraits::pixel_t c, color_t maskColor) {
+    return (rgba_geta(c) == 0);
+  }
+
+  template<>
+  inline bool is_transparent<GrayscaleTraits>(GrayscaleTraits::pixel_t c, color_t maskColor) {
+    return (graya_geta(c) == 0);
+  }
+
+  // Returns the bounds of the non-transparent pixels of the image.
+  template<class Traits>
+  gfx::Rect get_trim_bounds(const Image* image, color_t maskColor)
+  {
+    int x1 = image->getWidth(), y1 = image->getHeight();
+    int x2 = -1, y2 = -1;
+
+    for (int y=0; y<image->getHeight(); ++y) {
+      for (int x=0; x<image->getWidth(); ++x) {
+        if (!is_transparent<Traits>(get_pixel_fast<Traits>(image, x, y), maskColor)) {
+          x1 = std::min(x1, x);
+          x2 = std::max(x2, x);
+          y1 = std::min(y1, y);
+          y2 = y;
+        }
+      }
+    }
+
+    if (x2 < 0)
+      return gfx::Rect();
+    else
+      return gfx::Rect(x1, y1, x2-x1+1, y2-y1+1);
+  }
+
+  // FNV-1a hash of the pixels of the image.
+  template<class Traits>
+  uint32_t hash_image(const Image* image)
+  {
+    uint32_t hash = 2166136261u;
+
+    for (int y=0; y<image->getHeight(); ++y) {
+      for (int x=0; x<image->getWidth(); ++x) {
+        typename Traits::pixel_t c = get_pixel_fast<Traits>(image, x, y);
+        for (size_t i=0; i<sizeof(c); ++i) {
+          hash ^= (c >> (8*i)) & 0xff;
+          hash *= 16777619u;
+        }
+      }
+    }
+
+    return hash;
+  }
+
+  // Functor used in base::parallel_for() to render and trim each
+  // frame from worker threads.
+  class RenderFrameFunc {
+  public:
+    RenderFrameFunc(const Sprite* sprite, std::vector<TrimmedFrame>& frames)
+      : m_sprite(sprite), m_frames(frames) {
+    }
+
+    void operator()(int i) const {
+      base::UniquePtr<Image> image(Image::create(m_sprite->getPixelFormat(),
+                                                 m_sprite->getWidth(),
+                                                 m_sprite->getHeight()));
+      m_sprite->render(image, 0, 0, FrameNumber(i));
+
+      TrimmedFrame& frame = m_frames[i];
+      color_t maskColor = m_sprite->getTransparentColor();
+
+      switch (image->getPixelFormat()) {
+        case IMAGE_RGB:       frame.bounds = get_trim_bounds<RgbTraits>(image, maskColor); break;
+        case IMAGE_GRAYSCALE: frame.bounds = get_trim_bounds<GrayscaleTraits>(image, maskColor); break;
+        case IMAGE_INDEXED:   frame.bounds = get_trim_bounds<IndexedTraits>(image, maskColor); break;
+      }
+
+      if (frame.bounds.isEmpty())
+        return;
+
+      frame.image = crop_image(image,
+                               frame.bounds.x, frame.bounds.y,
+                               frame.bounds.w, frame.bounds.h, maskColor);
+
+      switch (image->getPixelFormat()) {
+        case IMAGE_RGB:       frame.hash = hash_image<RgbTraits>(frame.image); break;
+        case IMAGE_GRAYSCALE: frame.hash = hash_image<GrayscaleTraits>(frame.image); break;
+        case IMAGE_INDEXED:   frame.hash = hash_image<IndexedTraits>(frame.image); break;
+      }
+    }
+
+  private:
+    const Sprite* m_sprite;
+    std::vector<TrimmedFrame>& m_frames;
+  };
+
+  // Functor used in base::parallel_for() to copy each unique frame in
+  // its place of the sheet (frames don't overlap, so they can be
+  // copied at the same time).
+  class CopyFrameFunc {
+  public:
+    CopyFrameFunc(Image* sheet,
+                  const std::vector<TrimmedFrame>& trimmed,
+                  const std::vector<PackedFrame>& frames)
+      : m_sheet(sheet), m_trimmed(trimmed), m_frames(frames) {
+    }
+
+    void operator()(int i) const {
+      if (m_frames[i].sameAs < 0 && m_trimmed[i].image)
+        copy_image(m_sheet, m_trimmed[i].image,
+                   m_frames[i].sheetBounds.x,
+                   m_frames[i].sheetBounds.y);
+    }
+
+  private:
+    Image* m_sheet;
+    const std::vector<TrimmedFrame>& m_trimmed;
+    const std::vector<PackedFrame>& m_frames;
+  };
+
+  bool same_pixels(const TrimmedFrame& a, const TrimmedFrame& b)
+  {
+    return (a.hash == b.hash &&
+            a.bounds.w == b.bounds.w &&
+            a.bounds.h == b.bounds.h &&
+            count_diff_between_images(a.image, b.image) == 0);
+  }
+
+  std::string json_escape(const std::string& str)
+  {
+    std::string result;
+    for (size_t i=0; i<str.size(); ++i) {
+      if (str[i] == '"' || str[i] == '\\')
+        result.push_back('\\');
+      result.push_back(str[i]);
+    }
+    return result;
+  }
+
+} // anonymous namespace
+
+PackedSpriteSheet::PackedSpriteSheet(const Sprite* sprite, int padding)
+  : m_sprite(sprite)
+{
+  int nframes = sprite->getTotalFrames();
+  TrimmedFrame empty = { NULL, gfx::Rect(), 0 };
+  std::vector<TrimmedFrame> trimmed(nframes, empty);
+
+  // Render and trim all frames in parallel.
+  base::parallel_for(0, nframes, RenderFrameFunc(sprite, trimmed));
+
+  // Find duplicated frames (frames with the same hash are compared
+  // pixel by pixel).
+  std::multimap<uint32_t, int> hashes;
+  std::vector<gfx::Size> sizes(nframes);
+
+  m_frames.resize(nframes);
+  for (int i=0; i<nframes; ++i) {
+    PackedFrame& frame = m_frames[i];
+    frame.frame = FrameNumber(i);
+    frame.trimBounds = trimmed[i].bounds;
+    frame.duration = sprite->getFrameDuration(FrameNumber(i));
+    frame.sameAs = -1;
+
+    if (!trimmed[i].image)
+      continue;
+
+    typedef std::multimap<uint32_t, int>::iterator iterator;
+    std::pair<iterator, iterator> range = hashes.equal_range(trimmed[i].hash);
+    for (iterator it=range.first; it!=range.second; ++it) {
+      if (same_pixels(trimmed[i], trimmed[it->second])) {
+        frame.sameAs = it->second;
+        break;
+      }
+    }
+
+    if (frame.sameAs < 0) {
+      hashes.insert(std::make_pair(trimmed[i].hash, i));
+      sizes[i] = gfx::Size(trimmed[i].bounds.w + padding,
+                           trimmed[i].bounds.h + padding);
+    }
+  }
+
+  // Pack unique frames (duplicated and transparent frames have an
+  // empty size, so they aren't packed).
+  std::vector<gfx::Rect> bounds;
+  gfx::Size sheetSize = gfx::pack_rects(sizes, bounds);
+
+  for (int i=0; i<nframes; ++i) {
+    PackedFrame& frame = m_frames[i];
+    if (frame.sameAs >= 0)
+      frame.sheetBounds = m_frames[frame.sameAs].sheetBounds;
+    else if (trimmed[i].image)
+      frame.sheetBounds = gfx::Rect(bounds[i].x, bounds[i].y,
+                                    trimmed[i].bounds.w, trimmed[i].bounds.h);
+  }
+
+  // The padding is not needed after the last column/row.
+  sheetSize.w = std::max(1, sheetSize.w - padding);
+  sheetSize.h = std::max(1, sheetSize.h - padding);
+
+  m_image.reset(Image::create(sprite->getPixelFormat(), sheetSize.w, sheetSize.h));
+  clear_image(m_image, (sprite->getPixelFormat() == IMAGE_INDEXED ?
+                        sprite->getTransparentColor(): 0));
+
+  base::parallel_for(0, nframes, CopyFrameFunc(m_image, trimmed, m_frames));
+
+  for (int i=0; i<nframes; ++i)
+    delete trimmed[i].image;
+}
+
+PackedSpriteSheet::~PackedSpriteSheet()
+{
+}
+
+int PackedSpriteSheet::getUniqueFrames() const
+{
+  int count = 0;
+  for (size_t i=0; i<m_frames.size(); ++i)
+    if (m_frames[i].sameAs < 0 && !m_frames[i].sheetBounds.isEmpty())
+      ++count;
+  return count;
+}
+
+Document* PackedSpriteSheet::createDocument() const
+{
+  base::UniquePtr<Sprite> sprite(new Sprite(m_sprite->getPixelFormat(),
+                                            m_image->getWidth(), m_image->getHeight(),
+                                            m_sprite->getPalette(FrameNumber(0))->size()));
+  sprite->setTransparentColor(m_sprite->getTransparentColor());
+  sprite->setPalette(m_sprite->getPalette(FrameNumber(0)), true);
+
+  LayerImage* layer = new LayerImage(sprite);
+  layer->setName("Sprite Sheet");
+  sprite->getFolder()->addLayer(layer);
+
+  base::UniquePtr<Image> image(Image::createCopy(m_image));
+  int indexInStock = sprite->getStock()->addImage(image);
+  image.release();
+  layer->addCel(new Cel(FrameNumber(0), indexInStock));
+
+  base::UniquePtr<Document> document(new Document(sprite));
+  sprite.release();
+  return document.release();
+}
+
+void PackedSpriteSheet::writeJson(std::ostream& os, const std::string& imageFilename) const
+{
+  os << "{ \"frames\": [\n";
+
+  for (size_t i=0; i<m_frames.size(); ++i) {
+    const PackedFrame& frame = m_frames[i];
+    const gfx::Rect& rc = frame.sheetBounds;
+    const gfx::Rect& trim = frame.trimBounds;
+
+    os << "  { \"filename\": \"" << json_escape(base::get_file_title(imageFilename)) << " " << i << "\",\n"
+       << "    \"frame\": { \"x\": " << rc.x << ", \"y\": " << rc.y
+       << ", \"w\": " << rc.w << ", \"h\": " << rc.h << " },\n"
+       << "    \"rotated\": false,\n"
+       << "    \"trimmed\": " << (trim.w != m_sprite->getWidth() ||
+                                  trim.h != m_sprite->getHeight() ? "true": "false") << ",\n"
+       << "    \"spriteSourceSize\": { \"x\": " << trim.x << ", \"y\": " << trim.y
+       << ", \"w\": " << trim.w << ", \"h\": " << trim.h << " },\n"
+       << "    \"sourceSize\": { \"w\": " << m_sprite->getWidth()
+       << ", \"h\": " << m_sprite->getHeight() << " },\n"
+       << "    \"duration\": " << frame.duration << " }"
+       << (i+1 < m_frames.size() ? ",": "") << "\n";
+  }
+
+  os << " ],\n"
+     << "  \"meta\": {\n"
+     << "    \"app\": \"" << WEBSITE << "\",\n"
+     << "    \"version\": \"" << VERSION << "\",\n"
+     << "    \"image\": \"" << json_escape(imageFilename) << "\",\n"
+     << "    \"size\": { \"w\": " << m_image->getWidth()
+     << ", \"h\": " << m_image->getHeight() << " },\n"
+     << "    \"scale\": \"1\"\n"
+     << "  }\n"
+     << "}\n";
+}
+
+bool PackedSpriteSheet::saveJson(const std::string& imageFilename) const
+{
+  std::ofstream json(getJsonFilename(imageFilename).c_str());
+  writeJson(json, base::get_file_name(imageFilename));
+  return json.good();
+}
+
+// static
+std::string PackedSpriteSheet::getJsonFilename(const std::string& imageFilename)
+{
+  std::string ext = base::get_file_extension(imageFilename);
+  return imageFilename.substr(0, imageFilename.size() - (ext.empty() ? 0: ext.size()+1)) + ".json";
+}
+
+} // namespace app
@@ -0,0 +1,95 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef APP_UTIL_PACKED_SPRITE_SHEET_H_INCLUDED
+#define APP_UTIL_PACKED_SPRITE_SHEET_H_INCLUDED
+
+#include "base/disable_copying.h"
+#include "base/unique_ptr.h"
+#include "gfx/rect.h"
+#include "raster/frame_number.h"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace raster {
+  class Image;
+  class Sprite;
+}
+
+namespace app {
+  class Document;
+
+  using namespace raster;
+
+  // A frame of a packed sprite sheet.
+  struct PackedFrame {
+    FrameNumber frame;
+    gfx::Rect sheetBounds;      // Area of the frame in the sheet (empty if it's transparent)
+    gfx::Rect trimBounds;       // Non-transparent area of the frame in sprite coordinates
+    int duration;
+    int sameAs;                 // Index of the first frame with the same pixels (or -1)
+  };
+
+  // Texture atlas with all frames of a sprite: each frame is trimmed
+  // to its non-transparent area, identical frames are stored once,
+  // and the trimmed frames are packed with the MaxRects algorithm.
+  // Frames are rendered from several threads, so the sprite must not
+  // be modified meanwhile.
+  class PackedSpriteSheet {
+  public:
+    PackedSpriteSheet(const Sprite* sprite, int padding = 0);
+    ~PackedSpriteSheet();
+
+    const Sprite* getSprite() const { return m_sprite; }
+    const Image* getImage() const { return m_image; }
+    const std::vector<PackedFrame>& getFrames() const { return m_frames; }
+
+    // Returns the number of different frames in the sheet.
+    int getUniqueFrames() const;
+
+    // Returns a new one-frame document with a copy of the sheet (to
+    // save it with the file formats), the caller must delete it.
+    Document* createDocument() const;
+
+    // Writes the position of each frame in JSON format (in the format
+    // of the TexturePacker "array" data files, with the duration of
+    // each frame).
+    void writeJson(std::ostream& os, const std::string& imageFilename) const;
+
+    // Saves the JSON data of the sheet saved in the given image file
+    // (see getJsonFilename()). Returns false if the file couldn't be
+    // written.
+    bool saveJson(const std::string& imageFilename) const;
+
+    // Returns the name of the JSON file of a sheet (the image file
+    // name with .json extension).
+    static std::string getJsonFilename(const std::string& imageFilename);
+
+  private:
+    const Sprite* m_sprite;
+    base::UniquePtr<Image> m_image;
+    std::vector<PackedFrame> m_frames;
+
+    DISABLE_COPYING(PackedSpriteSheet);
+  };
+
+} // namespace app
+
+#endif
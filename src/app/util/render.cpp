@@ -282,7 +282,6 @@ static bool checked_bg_zoom;
 static app::Color checked_bg_color1;
 static app::Color checked_bg_color2;
 
-static int global_opacity = 255;
 static const Layer* selected_layer = NULL;
 static Image* rastering_image = NULL;
 
@@ -358,7 +357,19 @@ RenderEngine::RenderEngine(const Document* document,
   , m_sprite(sprite)
   , m_currentLayer(currentLayer)
   , m_currentFrame(currentFrame)
+  , m_globalOpacity(255)
 {
+  // Onion-skin settings are read here (in the thread that creates the
+  // engine) so renderSprite() can be called from a background thread
+  // (e.g. to pre-render frames for the animation playback).
+  IDocumentSettings* docSettings = UIContext::instance()
+    ->getSettings()->getDocumentSettings(m_document);
+
+  m_onionskin = docSettings->getUseOnionskin();
+  m_onionskinPrevs = docSettings->getOnionskinPrevFrames();
+  m_onionskinNexts = docSettings->getOnionskinNextFrames();
+  m_onionskinOpacityBase = docSettings->getOnionskinOpacityBase();
+  m_onionskinOpacityStep = docSettings->getOnionskinOpacityStep();
 }
 
 // static
@@ -418,32 +429,29 @@ Image* RenderEngine::renderSprite(int source_x, int source_y,
     clear_image(image, bg_color);
 
   // Onion-skin feature: draw the previous frame
-  IDocumentSettings* docSettings = UIContext::instance()
-    ->getSettings()->getDocumentSettings(m_document);
-
-  if (docSettings->getUseOnionskin()) {
+  if (m_onionskin) {
     // Draw background layer of the current frame with opacity=255
-    global_opacity = 255;
+    m_globalOpacity = 255;
     renderLayer(m_sprite->getFolder(), image,
                 source_x, source_y, frame, zoom, zoomed_func,
                 true, false);
 
     // Draw transparent layers of the previous/next frames with different opacity (<255) (it is the onion-skinning)
     {
-      int prevs = docSettings->getOnionskinPrevFrames();
-      int nexts = docSettings->getOnionskinNextFrames();
-      int opacity_base = docSettings->getOnionskinOpacityBase();
-      int opacity_step = docSettings->getOnionskinOpacityStep();
+      int prevs = m_onionskinPrevs;
+      int nexts = m_onionskinNexts;
+      int opacity_base = m_onionskinOpacityBase;
+      int opacity_step = m_onionskinOpacityStep;
 
       for (FrameNumber f=frame.previous(prevs); f <= frame.next(nexts); ++f) {
         if (f == frame || f < 0 || f > m_sprite->getLastFrame())
           continue;
         else if (f < frame)
-          global_opacity = opacity_base - opacity_step * ((frame - f)-1);
+          m_globalOpacity = opacity_base - opacity_step * ((frame - f)-1);
         else
-          global_opacity = opacity_base - opacity_step * ((f - frame)-1);
+          m_globalOpacity = opacity_base - opacity_step * ((f - frame)-1);
 
-        if (global_opacity > 0)
+        if (m_globalOpacity > 0)
           renderLayer(m_sprite->getFolder(), image,
                       source_x, source_y, f, zoom, zoomed_func,
                       false, true);
@@ -451,7 +459,7 @@ Image* RenderEngine::renderSprite(int source_x, int source_y,
     }
 
     // Draw transparent layers of the current frame with opacity=255
-    global_opacity = 255;
+    m_globalOpacity = 255;
     renderLayer(m_sprite->getFolder(), image,
                 source_x, source_y, frame, zoom, zoomed_func,
                 false, true);
@@ -601,7 +609,7 @@ void RenderEngine::renderLayer(const Layer* layer,
           register int t;
 
           output_opacity = MID(0, cel->getOpacity(), 255);
-          output_opacity = INT_MULT(output_opacity, global_opacity, t);
+          output_opacity = INT_MULT(output_opacity, m_globalOpacity, t);
 
           src_image->setMaskColor(m_sprite->getTransparentColor());
 
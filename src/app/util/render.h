@@ -95,6 +95,12 @@ namespace app {
     const Sprite* m_sprite;
     const Layer* m_currentLayer;
     FrameNumber m_currentFrame;
+    int m_globalOpacity;
+    bool m_onionskin;
+    int m_onionskinPrevs;
+    int m_onionskinNexts;
+    int m_onionskinOpacityBase;
+    int m_onionskinOpacityStep;
   };
 
 } // namespace app
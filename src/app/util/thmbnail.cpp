@@ -35,27 +35,44 @@
 #include "raster/sprite.h"
 #include "raster/stock.h"
 
+#include <list>
+#include <map>
+
 #define THUMBNAIL_W     32
 #define THUMBNAIL_H     32
 
+// Maximum memory used by thumbnails (older thumbnails are destroyed
+// when this limit is reached).
+#define THUMBNAILS_MEMORY_LIMIT (16*1024*1024)
+
 namespace app {
 
 struct Thumbnail {
   const Cel *cel;
+  const Image* image;           // To know if the cel's image has changed
+  const Palette* palette;
   BITMAP* bmp;
 
-  Thumbnail(const Cel *cel, BITMAP* bmp)
-    : cel(cel), bmp(bmp) {
+  Thumbnail(const Cel *cel, const Image* image, const Palette* palette, BITMAP* bmp)
+    : cel(cel), image(image), palette(palette), bmp(bmp) {
   }
 
   ~Thumbnail() {
     destroy_bitmap(bmp);
   }
+
+  int getMemSize() const {
+    return bmp->w * bmp->h * ((bitmap_color_depth(bmp)+7) / 8);
+  }
 };
 
-typedef std::vector<Thumbnail*> ThumbnailsList;
+// Thumbnails sorted by use (the most recently used first).
+typedef std::list<Thumbnail*> ThumbnailsList;
+typedef std::map<const Cel*, ThumbnailsList::iterator> ThumbnailsMap;
 
 static ThumbnailsList* thumbnails = NULL;
+static ThumbnailsMap* thumbnails_map = NULL;
+static int thumbnails_memory = 0;
 
 static void thumbnail_render(BITMAP* bmp, const Image* image, bool has_alpha, const Palette* palette);
 
@@ -65,43 +82,71 @@ void destroy_thumbnails()
     for (ThumbnailsList::iterator it = thumbnails->begin(); it != thumbnails->end(); ++it)
       delete *it;
 
-    thumbnails->clear();
     delete thumbnails;
+    delete thumbnails_map;
     thumbnails = NULL;
+    thumbnails_map = NULL;
+    thumbnails_memory = 0;
+  }
+}
+
+void destroy_thumbnail(const Cel* cel)
+{
+  if (!thumbnails)
+    return;
+
+  ThumbnailsMap::iterator it = thumbnails_map->find(cel);
+  if (it != thumbnails_map->end()) {
+    Thumbnail* thumbnail = *it->second;
+    thumbnails_memory -= thumbnail->getMemSize();
+    thumbnails->erase(it->second);
+    thumbnails_map->erase(it);
+    delete thumbnail;
   }
 }
 
 BITMAP* generate_thumbnail(const Layer* layer, const Cel* cel, const Sprite *sprite)
 {
+  const Image* image = sprite->getStock()->getImage(cel->getImage());
+  const Palette* palette = sprite->getPalette(cel->getFrame());
   Thumbnail* thumbnail;
   BITMAP* bmp;
 
-  if (!thumbnails)
+  if (!thumbnails) {
     thumbnails = new ThumbnailsList();
+    thumbnails_map = new ThumbnailsMap();
+  }
 
   // Find the thumbnail
-  for (ThumbnailsList::iterator it = thumbnails->begin(); it != thumbnails->end(); ++it) {
-    thumbnail = *it;
-    if (thumbnail->cel == cel)
+  ThumbnailsMap::iterator it = thumbnails_map->find(cel);
+  if (it != thumbnails_map->end()) {
+    thumbnail = *it->second;
+    if (thumbnail->image == image &&
+        thumbnail->palette == palette) {
+      // Move it to the front of the LRU list
+      thumbnails->splice(thumbnails->begin(), *thumbnails, it->second);
       return thumbnail->bmp;
+    }
+
+    // The thumbnail is outdated
+    destroy_thumbnail(cel);
   }
 
   bmp = create_bitmap(THUMBNAIL_W, THUMBNAIL_H);
   if (!bmp)
     return NULL;
 
-  thumbnail_render(bmp,
-                   sprite->getStock()->getImage(cel->getImage()),
-                   !layer->isBackground(),
-                   sprite->getPalette(cel->getFrame()));
+  thumbnail_render(bmp, image, !layer->isBackground(), palette);
 
-  thumbnail = new Thumbnail(cel, bmp);
-  if (!thumbnail) {
-    destroy_bitmap(bmp);
-    return NULL;
-  }
+  thumbnail = new Thumbnail(cel, image, palette, bmp);
+  thumbnails->push_front(thumbnail);
+  thumbnails_map->insert(std::make_pair(cel, thumbnails->begin()));
+  thumbnails_memory += thumbnail->getMemSize();
+
+  // Destroy the least recently used thumbnails
+  while (thumbnails_memory > THUMBNAILS_MEMORY_LIMIT && thumbnails->size() > 1)
+    destroy_thumbnail(thumbnails->back()->cel);
 
-  thumbnails->push_back(thumbnail);
   return thumbnail->bmp;
 }
 
@@ -30,9 +30,13 @@ namespace raster {
 namespace app {
   using namespace raster;
 
+  // Cel thumbnails for the timeline. They are kept in a LRU cache
+  // with a memory limit, and they are generated again automatically
+  // if the image or the palette of the cel change.
   void destroy_thumbnails();
+  void destroy_thumbnail(const Cel* cel);
   BITMAP* generate_thumbnail(const Layer* layer, const Cel* cel, const Sprite* sprite);
-  
+
 } // namespace app
 
 #endif
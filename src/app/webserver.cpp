@@ -24,19 +24,415 @@
 
 #include "app/webserver.h"
 
+#include "app/document.h"
+#include "app/file/file.h"
+#include "app/resource_finder.h"
+#include "app/util/packed_sprite_sheet.h"
+#include "base/chrono.h"
+#include "base/convert_to.h"
 #include "base/fs.h"
+#include "base/mutex.h"
 #include "base/path.h"
-#include "app/resource_finder.h"
+#include "base/scoped_lock.h"
+#include "base/thread.h"
+#include "raster/raster.h"
+#include "raster/quantization.h"
 #include "webserver/webserver.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include <allegro/config.h>
+#include "png.h"
 
-#define API_VERSION 1
+#define API_VERSION 2
 
 namespace app {
 
+using namespace raster;
+
+//////////////////////////////////////////////////////////////////////
+// Cache of documents loaded from requests
+
+// Documents of the cache are never modified, so several requests can
+// read the same document at the same time. When a file is modified,
+// the new version replaces the old one in the cache, and the old
+// document is deleted when the last request using it finishes.
+class WebServer::DocumentCache {
+public:
+  struct Entry {
+    std::string filename;
+    time_t mtime;
+    size_t size;
+    Document* document;
+    int refs;                   // Number of requests using the document
+    bool removed;               // True if it was removed from the cache
+    unsigned int lastUse;
+  };
+
+  // Releases the document when the request finishes.
+  class ScopedDocument {
+  public:
+    ScopedDocument(DocumentCache* cache, const std::string& filename, std::string& error)
+      : m_cache(cache)
+      , m_entry(cache->acquire(filename, error)) {
+    }
+
+    ~ScopedDocument() {
+      if (m_entry)
+        m_cache->release(m_entry);
+    }
+
+    Document* document() const { return (m_entry ? m_entry->document: NULL); }
+
+  private:
+    DocumentCache* m_cache;
+    Entry* m_entry;
+  };
+
+  DocumentCache(int maxDocuments)
+    : m_maxDocuments(maxDocuments)
+    , m_useCounter(0) {
+  }
+
+  ~DocumentCache() {
+    for (Entries::iterator it=m_entries.begin(); it!=m_entries.end(); ++it) {
+      ASSERT(it->second->refs == 0);
+      deleteEntry(it->second);
+    }
+  }
+
+  // Returns the document of the given file (loading it if it is
+  // needed). The returned entry must be released.
+  Entry* acquire(const std::string& filename, std::string& error) {
+    // The modification time has a resolution of one second, so the
+    // size is compared too to detect a file rewritten in the same
+    // second.
+    time_t mtime = base::get_file_mtime(filename);
+    size_t size = base::get_file_size(filename);
+    {
+      base::scoped_lock hold(m_mutex);
+      Entries::iterator it = m_entries.find(filename);
+      if (it != m_entries.end() &&
+          it->second->mtime == mtime &&
+          it->second->size == size) {
+        Entry* entry = it->second;
+        ++entry->refs;
+        entry->lastUse = ++m_useCounter;
+        return entry;
+      }
+    }
+
+    // Load the file without locking the cache (so other requests are
+    // not blocked meanwhile).
+    Document* document = load_document_noninteractive(filename.c_str(), error);
+    if (!document)
+      return NULL;
+
+    Entry* entry = new Entry;
+    entry->filename = filename;
+    entry->mtime = mtime;
+    entry->size = size;
+    entry->document = document;
+    entry->refs = 1;
+    entry->removed = false;
+
+    base::scoped_lock hold(m_mutex);
+    entry->lastUse = ++m_useCounter;
+
+    Entries::iterator it = m_entries.find(filename);
+    if (it != m_entries.end())
+      removeEntry(it);
+    m_entries[filename] = entry;
+
+    // Remove the least recently used documents.
+    while ((int)m_entries.size() > m_maxDocuments) {
+      Entries::iterator lru = m_entries.begin();
+      for (it=m_entries.begin(); it!=m_entries.end(); ++it)
+        if (it->second->lastUse < lru->second->lastUse)
+          lru = it;
+      removeEntry(lru);
+    }
+
+    return entry;
+  }
+
+  void release(Entry* entry) {
+    base::scoped_lock hold(m_mutex);
+    if (--entry->refs == 0 && entry->removed)
+      deleteEntry(entry);
+  }
+
+  int size() {
+    base::scoped_lock hold(m_mutex);
+    return (int)m_entries.size();
+  }
+
+private:
+  typedef std::map<std::string, Entry*> Entries;
+
+  // m_mutex must be locked.
+  void removeEntry(Entries::iterator it) {
+    Entry* entry = it->second;
+    m_entries.erase(it);
+
+    if (entry->refs == 0)
+      deleteEntry(entry);
+    else
+      entry->removed = true;
+  }
+
+  void deleteEntry(Entry* entry) {
+    delete entry->document;
+    delete entry;
+  }
+
+  base::mutex m_mutex;
+  Entries m_entries;
+  int m_maxDocuments;
+  unsigned int m_useCounter;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Latency metrics
+
+class WebServer::Metrics {
+public:
+  void add(const std::string& endpoint, double seconds, bool error) {
+    base::scoped_lock hold(m_mutex);
+    Stats& stats = m_stats[endpoint];
+    ++stats.requests;
+    if (error)
+      ++stats.errors;
+    stats.totalTime += seconds;
+    stats.maxTime = std::max(stats.maxTime, seconds);
+
+    int i = 0;
+    while (i < kBuckets-1 && seconds*1000.0 > kBucketLimits[i])
+      ++i;
+    ++stats.histogram[i];
+  }
+
+  void write(std::ostream& os) {
+    base::scoped_lock hold(m_mutex);
+    bool first = true;
+
+    os << "{";
+    for (StatsMap::iterator it=m_stats.begin(); it!=m_stats.end(); ++it) {
+      const Stats& stats = it->second;
+      if (!first)
+        os << ",";
+      first = false;
+
+      os << "\"" << it->first << "\":{"
+         << "\"requests\":" << stats.requests << ","
+         << "\"errors\":" << stats.errors << ","
+         << "\"avg_ms\":" << 1000.0 * stats.totalTime / stats.requests << ","
+         << "\"p50_ms\":" << percentile(stats, 0.50) << ","
+         << "\"p95_ms\":" << percentile(stats, 0.95) << ","
+         << "\"max_ms\":" << 1000.0 * stats.maxTime << "}";
+    }
+    os << "}";
+  }
+
+private:
+  // Latencies are grouped in buckets (the limit of each bucket is
+  // in milliseconds).
+  static const int kBuckets = 12;
+  static const double kBucketLimits[kBuckets];
+
+  struct Stats {
+    int requests;
+    int errors;
+    double totalTime;
+    double maxTime;
+    int histogram[kBuckets];
+
+    Stats() : requests(0), errors(0), totalTime(0.0), maxTime(0.0) {
+      std::fill(histogram, histogram+kBuckets, 0);
+    }
+  };
+
+  // Returns the limit of the bucket where the given percentile is
+  // (or the max time for the last bucket).
+  static double percentile(const Stats& stats, double p) {
+    int count = 0;
+    for (int i=0; i<kBuckets-1; ++i) {
+      count += stats.histogram[i];
+      if (count >= p * stats.requests)
+        return std::min(kBucketLimits[i], 1000.0 * stats.maxTime);
+    }
+    return 1000.0 * stats.maxTime;
+  }
+
+  typedef std::map<std::string, Stats> StatsMap;
+
+  base::mutex m_mutex;
+  StatsMap m_stats;
+};
+
+const double WebServer::Metrics::kBucketLimits[kBuckets] = {
+  1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 5000, 0 // Last bucket: more than 5s
+};
+
+//////////////////////////////////////////////////////////////////////
+// Rendering
+
+// Returns a new RGB image with the given frame rendered (only the
+// given layer if it is not NULL).
+static Image* render_rgb_frame(const Sprite* sprite, const Layer* layer, FrameNumber frame)
+{
+  base::UniquePtr<Image> image(Image::create(sprite->getPixelFormat(),
+                                             sprite->getWidth(),
+                                             sprite->getHeight()));
+
+  clear_image(image, (sprite->getPixelFormat() == IMAGE_INDEXED ?
+                      sprite->getTransparentColor(): 0));
+
+  if (layer)
+    layer_render(layer, image, 0, 0, frame);
+  else
+    sprite->render(image, 0, 0, frame);
+
+  if (image->getPixelFormat() == IMAGE_RGB)
+    return image.release();
+
+  return quantization::convert_pixel_format(image, IMAGE_RGB, DITHERING_NONE, NULL,
+                                            sprite->getPalette(frame),
+                                            sprite->getBackgroundLayer() != NULL);
+}
+
+static void png_write_to_stream(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+  std::ostream* os = reinterpret_cast<std::ostream*>(png_get_io_ptr(png_ptr));
+  os->write((const char*)data, length);
+}
+
+static void png_flush_stream(png_structp png_ptr)
+{
+}
+
+// Writes the given RGB image as a PNG file in the stream.
+static bool write_png(const Image* image, std::ostream& os)
+{
+  ASSERT(image->getPixelFormat() == IMAGE_RGB);
+
+  png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (!png_ptr)
+    return false;
+
+  png_infop info_ptr = png_create_info_struct(png_ptr);
+  if (!info_ptr) {
+    png_destroy_write_struct(&png_ptr, NULL);
+    return false;
+  }
+
+  std::vector<png_byte> row(image->getWidth() * 4);
+
+  if (setjmp(png_jmpbuf(png_ptr))) {
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    return false;
+  }
+
+  png_set_write_fn(png_ptr, &os, png_write_to_stream, png_flush_stream);
+  png_set_IHDR(png_ptr, info_ptr, image->getWidth(), image->getHeight(), 8,
+               PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+               PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  png_write_info(png_ptr, info_ptr);
+
+  for (int y=0; y<image->getHeight(); ++y) {
+    for (int x=0; x<image->getWidth(); ++x) {
+      uint32_t c = get_pixel_fast<RgbTraits>(image, x, y);
+      row[x*4  ] = rgba_getr(c);
+      row[x*4+1] = rgba_getg(c);
+      row[x*4+2] = rgba_getb(c);
+      row[x*4+3] = rgba_geta(c);
+    }
+    png_write_row(png_ptr, &row[0]);
+  }
+
+  png_write_end(png_ptr, info_ptr);
+  png_destroy_write_struct(&png_ptr, &info_ptr);
+  return true;
+}
+
+static Layer* find_layer(LayerFolder* folder, const std::string& name)
+{
+  for (LayerIterator it=folder->getLayerBegin(); it!=folder->getLayerEnd(); ++it) {
+    if ((*it)->getName() == name)
+      return *it;
+
+    if ((*it)->isFolder()) {
+      if (Layer* layer = find_layer(static_cast<LayerFolder*>(*it), name))
+        return layer;
+    }
+  }
+  return NULL;
+}
+
+static std::string json_string(const std::string& str)
+{
+  std::string result = "\"";
+  for (size_t i=0; i<str.size(); ++i) {
+    unsigned char chr = str[i];
+    switch (chr) {
+      case '"': result += "\\\""; break;
+      case '\\': result += "\\\\"; break;
+      case '\n': result += "\\n"; break;
+      case '\r': result += "\\r"; break;
+      case '\t': result += "\\t"; break;
+      default:
+        if (chr < 32) {
+          char buf[8];
+          sprintf(buf, "\\u%04x", chr);
+          result += buf;
+        }
+        else
+          result += chr;
+        break;
+    }
+  }
+  result += "\"";
+  return result;
+}
+
+static void write_layers_json(LayerFolder* folder, std::ostream& os, bool& first)
+{
+  for (LayerIterator it=folder->getLayerBegin(); it!=folder->getLayerEnd(); ++it) {
+    Layer* layer = *it;
+    if (!first)
+      os << ",";
+    first = false;
+
+    os << "{\"name\":" << json_string(layer->getName()) << ","
+       << "\"type\":\"" << (layer->isFolder() ? "folder": "image") << "\","
+       << "\"visible\":" << (layer->isReadable() ? "true": "false") << "}";
+
+    if (layer->isFolder())
+      write_layers_json(static_cast<LayerFolder*>(layer), os, first);
+  }
+}
+
+static void send_error(webserver::IResponse* response, int code, const std::string& message)
+{
+  response->setStatusCode(code);
+  response->setContentType("application/json");
+  response->getStream() << "{\"error\":" << json_string(message) << "}";
+}
+
+//////////////////////////////////////////////////////////////////////
+// WebServer
+
 WebServer::WebServer()
   : m_webServer(NULL)
+  , m_cache(new DocumentCache(get_config_int("WebServer", "CachedDocuments", 32)))
+  , m_metrics(new Metrics)
+  , m_root(get_config_string("WebServer", "Root", ""))
 {
   ResourceFinder rf;
   rf.findInDataDir("www");
@@ -51,14 +447,67 @@ WebServer::WebServer()
 
 WebServer::~WebServer()
 {
+  // Stops the server (waiting the requests in progress).
   delete m_webServer;
 }
 
 void WebServer::start()
 {
-  m_webServer = new webserver::WebServer(this);
+  int threads = get_config_int("WebServer", "Threads",
+                               std::max<int>(2, base::thread::hardware_concurrency()));
+
+  m_webServer = new webserver::WebServer(this, threads);
 }
 
+// Returns true if the "Host" header (and the "Origin" header if it
+// is present) is the local server. It's used for the endpoints that
+// read files, so web pages of other sites cannot use them (even with
+// DNS rebinding) to read local files. /version and static files can
+// be used from any site.
+static bool is_local_request(webserver::IRequest* request)
+{
+  std::string port = base::convert_to<std::string>(webserver::WebServer::getPort());
+  std::string localhost = "localhost:" + port;
+  std::string localip = "127.0.0.1:" + port;
+
+  const char* host = request->getHeader("Host");
+  if (!host || (host != localhost && host != localip))
+    return false;
+
+  const char* origin = request->getHeader("Origin");
+  if (origin &&
+      origin != "http://" + localhost &&
+      origin != "http://" + localip)
+    return false;
+
+  return true;
+}
+
+// Returns true if the file is inside the root directory (or if there
+// is no root directory).
+static bool is_file_in_root(const std::string& filename, const std::string& root)
+{
+  if (root.empty())
+    return true;
+
+  std::string fn = base::fix_path_separators(filename);
+  std::string dir = base::fix_path_separators(base::join_path(root, ""));
+  if (fn.size() <= dir.size() || fn.compare(0, dir.size(), dir) != 0)
+    return false;
+
+  // Don't allow going outside with ".." components.
+  std::string rest = fn.substr(dir.size());
+  for (size_t i=0, j; i <= rest.size(); i=j+1) {
+    j = i;
+    while (j < rest.size() && !base::is_path_separator(rest[j]))
+      ++j;
+    if (rest.compare(i, j-i, "..") == 0)
+      return false;
+  }
+  return true;
+}
+
+// Called from the threads of the webserver (several at the same time).
 void WebServer::onProcessRequest(webserver::IRequest* request,
                                  webserver::IResponse* response)
 {
@@ -66,6 +515,9 @@ void WebServer::onProcessRequest(webserver::IRequest* request,
   if (!uri.empty() && uri[uri.size()-1] == '/')
     uri.erase(uri.size()-1);
 
+  if (processApiRequest(uri, request, response))
+    return;
+
   if (uri == "/version") {
     response->setContentType("text/plain");
     response->getStream() << "{\"package\":\"" << PACKAGE "\","
@@ -73,12 +525,26 @@ void WebServer::onProcessRequest(webserver::IRequest* request,
                           << "\"webserver\":\"" << m_webServer->getName() << "\","
                           << "\"api\":\"" << API_VERSION << "\"}";
   }
+  else if (uri == "/metrics") {
+    if (!is_local_request(request)) {
+      send_error(response, 403, "Forbidden");
+      return;
+    }
+
+    response->setContentType("application/json");
+    response->getStream() << "{\"documents\":" << m_cache->size() << ","
+                          << "\"endpoints\":";
+    m_metrics->write(response->getStream());
+    response->getStream() << "}";
+  }
   else {
     if (uri == "/" || uri.empty())
       uri = "/index.html";
 
+    base::Chrono chrono;
     std::string fn = base::join_path(m_wwwpath, uri);
-    if (base::file_exists(fn)) {
+    bool found = base::file_exists(fn);
+    if (found) {
       response->sendFile(fn.c_str());
     }
     else {
@@ -87,9 +553,160 @@ void WebServer::onProcessRequest(webserver::IRequest* request,
                             << "URI = " << uri << "\n"
                             << "Local file = " << fn;
     }
+    m_metrics->add("static", chrono.elapsed(), !found);
   }
 }
 
+// Processes the requests that use documents (/info, /render and
+// /sheet), returns false for other URIs. /sheet returns a horizontal
+// strip with all frames, or a packed sheet with "pack=1" (with
+// "format=json" both return the position of each frame).
+bool WebServer::processApiRequest(const std::string& uri,
+                                  webserver::IRequest* request,
+                                  webserver::IResponse* response)
+{
+  if (uri != "/info" && uri != "/render" && uri != "/sheet")
+    return false;
+
+  base::Chrono chrono;
+  bool ok = false;
+  std::string filename, layerName, value, error;
+
+  if (!is_local_request(request)) {
+    send_error(response, 403, "Forbidden");
+  }
+  else if (!request->getQueryVar("file", filename)) {
+    send_error(response, 400, "The \"file\" parameter is required");
+  }
+  else if (!is_file_in_root(filename, m_root)) {
+    send_error(response, 403, "The file is outside the root directory");
+  }
+  else {
+    DocumentCache::ScopedDocument cached(m_cache.get(), filename, error);
+    Document* document = cached.document();
+
+    if (!document) {
+      send_error(response, 404, error.empty() ? "Error loading file": error);
+    }
+    else {
+      Sprite* sprite = document->getSprite();
+      Layer* layer = NULL;
+      FrameNumber frame(0);
+      ok = true;
+
+      if (request->getQueryVar("layer", layerName)) {
+        layer = find_layer(sprite->getFolder(), layerName);
+        if (!layer) {
+          send_error(response, 404, "Layer not found: " + layerName);
+          ok = false;
+        }
+      }
+
+      if (ok && request->getQueryVar("frame", value)) {
+        frame = FrameNumber(std::atoi(value.c_str()));
+        if (frame < 0 || frame >= sprite->getTotalFrames()) {
+          send_error(response, 400, "Invalid frame: " + value);
+          ok = false;
+        }
+      }
+
+      if (!ok) {
+        // The error was already sent
+      }
+      else if (uri == "/info") {
+        std::ostream& os = response->getStream();
+        bool first = true;
+
+        response->setContentType("application/json");
+        os << "{\"file\":" << json_string(filename) << ","
+           << "\"width\":" << sprite->getWidth() << ","
+           << "\"height\":" << sprite->getHeight() << ","
+           << "\"colorMode\":\""
+           << (sprite->getPixelFormat() == IMAGE_RGB ? "rgb":
+               sprite->getPixelFormat() == IMAGE_GRAYSCALE ? "grayscale": "indexed") << "\","
+           << "\"frames\":[";
+        for (FrameNumber i(0); i<sprite->getTotalFrames(); ++i)
+          os << (i > 0 ? ",": "") << "{\"duration\":" << sprite->getFrameDuration(i) << "}";
+        os << "],\"layers\":[";
+        write_layers_json(sprite->getFolder(), os, first);
+        os << "]}";
+      }
+      else if (uri == "/render") {
+        base::UniquePtr<Image> image(render_rgb_frame(sprite, layer, frame));
+
+        response->setContentType("image/png");
+        ok = write_png(image, response->getStream());
+      }
+      // A packed sheet of the whole sprite (trimmed frames without
+      // duplicates, see PackedSpriteSheet).
+      else if (uri == "/sheet" &&
+               request->getQueryVar("pack", value) && value == "1") {
+        if (layer) {
+          send_error(response, 400, "The \"layer\" parameter cannot be used with \"pack\"");
+          ok = false;
+        }
+        else {
+          PackedSpriteSheet sheet(sprite);
+
+          if (request->getQueryVar("format", value) && value == "json") {
+            response->setContentType("application/json");
+            sheet.writeJson(response->getStream(),
+                            base::get_file_title(filename) + ".png");
+          }
+          else {
+            const Image* image = sheet.getImage();
+            base::UniquePtr<Image> rgbImage;
+            if (image->getPixelFormat() != IMAGE_RGB) {
+              rgbImage.reset(quantization::convert_pixel_format(image, IMAGE_RGB, DITHERING_NONE, NULL,
+                                                                sprite->getPalette(FrameNumber(0)),
+                                                                sprite->getBackgroundLayer() != NULL));
+              image = rgbImage;
+            }
+
+            response->setContentType("image/png");
+            ok = write_png(image, response->getStream());
+          }
+        }
+      }
+      // A horizontal strip with all frames.
+      else if (uri == "/sheet") {
+        int w = sprite->getWidth();
+        int h = sprite->getHeight();
+        FrameNumber frames = sprite->getTotalFrames();
+
+        if (request->getQueryVar("format", value) && value == "json") {
+          std::ostream& os = response->getStream();
+
+          response->setContentType("application/json");
+          os << "{\"width\":" << w*frames << ","
+             << "\"height\":" << h << ","
+             << "\"frames\":[";
+          for (FrameNumber i(0); i<frames; ++i) {
+            os << (i > 0 ? ",": "")
+               << "{\"x\":" << w*i << ",\"y\":0,"
+               << "\"w\":" << w << ",\"h\":" << h << ","
+               << "\"duration\":" << sprite->getFrameDuration(i) << "}";
+          }
+          os << "]}";
+        }
+        else {
+          base::UniquePtr<Image> sheet(Image::create(IMAGE_RGB, w*frames, h));
+          for (FrameNumber i(0); i<frames; ++i) {
+            base::UniquePtr<Image> image(render_rgb_frame(sprite, layer, i));
+            copy_image(sheet, image, w*i, 0);
+          }
+
+          response->setContentType("image/png");
+          ok = write_png(sheet, response->getStream());
+        }
+      }
+    }
+  }
+
+  m_metrics->add(uri, chrono.elapsed(), !ok);
+  return true;
 }
 
+} // namespace app
+
 #endif // ENABLE_WEBSERVER
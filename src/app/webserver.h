@@ -22,10 +22,26 @@
 #ifdef ENABLE_WEBSERVER
 
 #include "base/compiler_specific.h"
+#include "base/unique_ptr.h"
 #include "webserver/webserver.h"
 
+#include <string>
+
 namespace app {
 
+  // Serves the web page of data/www, and an API to render files from
+  // the local disk (for asset pipelines/tools that keep one process
+  // running):
+  //
+  //   /version
+  //   /info?file=PATH                  Size, frames and layers (JSON)
+  //   /render?file=PATH[&frame=N][&layer=NAME]
+  //                                    One frame as PNG
+  //   /sheet?file=PATH[&layer=NAME][&format=json]
+  //                                    All frames as a sheet (PNG or JSON)
+  //   /metrics                         Latency of each endpoint (JSON)
+  //
+  // Loaded files are cached (and loaded again if they are modified).
   class WebServer : public webserver::IDelegate {
   public:
     WebServer();
@@ -38,8 +54,21 @@ namespace app {
                                   webserver::IResponse* response) OVERRIDE;
 
   private:
+    class DocumentCache;
+    class Metrics;
+
+    bool processApiRequest(const std::string& uri,
+                           webserver::IRequest* request,
+                           webserver::IResponse* response);
+
     webserver::WebServer* m_webServer;
     std::string m_wwwpath;
+    base::UniquePtr<DocumentCache> m_cache;
+    base::UniquePtr<Metrics> m_metrics;
+
+    // Only files inside this directory can be used (any file if it's
+    // empty).
+    std::string m_root;
   };
 
 } // namespace app
@@ -106,7 +106,7 @@ Widget* WidgetLoader::loadWidgetFromXmlFile(const base::string& xmlFilename,
   Widget* widget = NULL;
   m_tooltipManager = NULL;
 
-  XmlDocumentRef doc(open_xml(xmlFilename));
+  XmlDocumentRef doc(open_cached_xml(xmlFilename));
   TiXmlHandle handle(doc);
 
   // Search the requested widget.
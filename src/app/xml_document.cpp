@@ -24,9 +24,14 @@
 
 #include "app/xml_exception.h"
 #include "base/file_handle.h"
+#include "base/fs.h"
+#include "base/mutex.h"
+#include "base/scoped_lock.h"
 
 #include "tinyxml.h"
 
+#include <map>
+
 namespace app {
 
 using namespace base;
@@ -46,4 +51,34 @@ XmlDocumentRef open_xml(const string& filename)
   return doc;
 }
 
+namespace {
+
+  struct CachedXml {
+    time_t mtime;
+    XmlDocumentRef doc;
+  };
+
+  typedef std::map<string, CachedXml> CachedXmlMap;
+
+  mutex cached_xml_mutex;
+  CachedXmlMap cached_xml;
+
+}
+
+XmlDocumentRef open_cached_xml(const string& filename)
+{
+  time_t mtime = get_file_mtime(filename);
+  scoped_lock lock(cached_xml_mutex);
+
+  CachedXmlMap::iterator it = cached_xml.find(filename);
+  if (it != cached_xml.end() && it->second.mtime == mtime)
+    return it->second.doc;
+
+  CachedXml entry;
+  entry.mtime = mtime;
+  entry.doc = open_xml(filename);
+  cached_xml[filename] = entry;
+  return entry.doc;
+}
+
 } // namespace app
@@ -31,6 +31,12 @@ namespace app {
 
   XmlDocumentRef open_xml(const base::string& filename);
 
+  // Like open_xml() but the parsed document is kept in memory, so the
+  // file is parsed again only when its modification time changes. The
+  // returned document is shared by all callers and must not be
+  // modified.
+  XmlDocumentRef open_cached_xml(const base::string& filename);
+
 } // namespace app
 
 #endif
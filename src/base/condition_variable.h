@@ -0,0 +1,45 @@
+// Aseprite Base Library
+// Copyright (c) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifndef BASE_CONDITION_VARIABLE_H_INCLUDED
+#define BASE_CONDITION_VARIABLE_H_INCLUDED
+
+#include "base/disable_copying.h"
+
+namespace base {
+
+  class scoped_lock;
+
+  // Based on C++0x std::condition_variable. It can be used with a
+  // scoped_lock of any base::mutex.
+  class condition_variable {
+  public:
+    condition_variable();
+    ~condition_variable();
+
+    // Unlocks the mutex of the given lock and blocks the current
+    // thread until notify_one() or notify_all() are called. The mutex
+    // is locked again before returning. Spurious wakeups can happen,
+    // so the waited condition must be checked in a loop.
+    void wait(scoped_lock& lock);
+
+    // Same as wait() but it blocks the thread "seconds" as maximum.
+    // Returns false if the timeout expired.
+    bool wait_for(scoped_lock& lock, double seconds);
+
+    void notify_one();
+    void notify_all();
+
+  private:
+    class condition_variable_impl;
+    condition_variable_impl* m_impl;
+
+    DISABLE_COPYING(condition_variable);
+  };
+
+} // namespace base
+
+#endif
@@ -0,0 +1,55 @@
+// Aseprite Base Library
+// Copyright (c) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifndef BASE_CONDITION_VARIABLE_PTHREAD_H_INCLUDED
+#define BASE_CONDITION_VARIABLE_PTHREAD_H_INCLUDED
+
+#include <pthread.h>
+#include <errno.h>
+#include <sys/time.h>
+
+class base::condition_variable::condition_variable_impl
+{
+public:
+
+  condition_variable_impl() {
+    pthread_cond_init(&m_handle, NULL);
+  }
+
+  ~condition_variable_impl() {
+    pthread_cond_destroy(&m_handle);
+  }
+
+  void wait(base::mutex::mutex_impl* mutex) {
+    pthread_cond_wait(&m_handle, mutex->native_handle());
+  }
+
+  bool wait_for(base::mutex::mutex_impl* mutex, double seconds) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    long long usecs = (long long)now.tv_usec + (long long)(seconds * 1000000.0);
+    struct timespec abstime;
+    abstime.tv_sec = now.tv_sec + (time_t)(usecs / 1000000);
+    abstime.tv_nsec = (long)(usecs % 1000000) * 1000;
+
+    return (pthread_cond_timedwait(&m_handle, mutex->native_handle(), &abstime) != ETIMEDOUT);
+  }
+
+  void notify_one() {
+    pthread_cond_signal(&m_handle);
+  }
+
+  void notify_all() {
+    pthread_cond_broadcast(&m_handle);
+  }
+
+private:
+  pthread_cond_t m_handle;
+
+};
+
+#endif
@@ -0,0 +1,77 @@
+// Aseprite Base Library
+// Copyright (c) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#include <gtest/gtest.h>
+
+#include "base/chrono.h"
+#include "base/condition_variable.h"
+#include "base/mutex.h"
+#include "base/scoped_lock.h"
+#include "base/thread.h"
+
+using namespace base;
+
+struct SharedState {
+  mutex m;
+  condition_variable cv;
+  bool ready;
+  int value;
+
+  SharedState() : ready(false), value(0) { }
+};
+
+static void producer(SharedState* state)
+{
+  this_thread::sleep_for(0.01);
+
+  scoped_lock lock(state->m);
+  state->value = 32;
+  state->ready = true;
+  state->cv.notify_one();
+}
+
+TEST(ConditionVariable, WaitNotify)
+{
+  SharedState state;
+  thread t(&producer, &state);
+  {
+    scoped_lock lock(state.m);
+    while (!state.ready)
+      state.cv.wait(lock);
+    EXPECT_EQ(32, state.value);
+  }
+  t.join();
+}
+
+TEST(ConditionVariable, WaitForTimeout)
+{
+  SharedState state;
+  scoped_lock lock(state.m);
+
+  Chrono chrono;
+  bool notified = state.cv.wait_for(lock, 0.05);
+  EXPECT_FALSE(notified);
+  EXPECT_LE(0.04, chrono.elapsed());
+}
+
+TEST(ConditionVariable, WaitForNotified)
+{
+  SharedState state;
+  thread t(&producer, &state);
+  {
+    scoped_lock lock(state.m);
+    while (!state.ready)
+      state.cv.wait_for(lock, 10.0);
+    EXPECT_TRUE(state.ready);
+  }
+  t.join();
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
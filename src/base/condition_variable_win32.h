@@ -0,0 +1,47 @@
+// Aseprite Base Library
+// Copyright (c) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifndef BASE_CONDITION_VARIABLE_WIN32_H_INCLUDED
+#define BASE_CONDITION_VARIABLE_WIN32_H_INCLUDED
+
+#include <windows.h>
+
+// Condition variables need Windows Vista or greater.
+class base::condition_variable::condition_variable_impl
+{
+public:
+
+  condition_variable_impl() {
+    InitializeConditionVariable(&m_handle);
+  }
+
+  ~condition_variable_impl() {
+    // Windows condition variables don't need to be destroyed.
+  }
+
+  void wait(base::mutex::mutex_impl* mutex) {
+    SleepConditionVariableCS(&m_handle, mutex->native_handle(), INFINITE);
+  }
+
+  bool wait_for(base::mutex::mutex_impl* mutex, double seconds) {
+    DWORD msecs = (seconds > 0.0 ? (DWORD)(seconds * 1000.0): 0);
+    return SleepConditionVariableCS(&m_handle, mutex->native_handle(), msecs) ? true: false;
+  }
+
+  void notify_one() {
+    WakeConditionVariable(&m_handle);
+  }
+
+  void notify_all() {
+    WakeAllConditionVariable(&m_handle);
+  }
+
+private:
+  CONDITION_VARIABLE m_handle;
+
+};
+
+#endif
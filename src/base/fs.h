@@ -9,11 +9,27 @@
 
 #include "base/string.h"
 
+#include <ctime>
+
 namespace base {
 
   bool file_exists(const string& path);
   bool directory_exists(const string& path);
 
+  // Returns the last modification time of the given file, or 0 if
+  // the file does not exist.
+  time_t get_file_mtime(const string& path);
+
+  // Returns the size in bytes of the given file, or 0 if the file
+  // does not exist.
+  size_t get_file_size(const string& path);
+
+  void delete_file(const string& path);
+
+  // Renames the file "src" as "dst" replacing "dst" if it already
+  // exists (the replacement is atomic on POSIX systems).
+  void move_file(const string& src, const string& dst);
+
   void make_directory(const string& path);
   void remove_directory(const string& path);
 
@@ -7,6 +7,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdexcept>
 
@@ -24,6 +25,36 @@ bool directory_exists(const string& path)
   return (stat(path.c_str(), &sts) == 0 && S_ISDIR(sts.st_mode)) ? true: false;
 }
 
+time_t get_file_mtime(const string& path)
+{
+  struct stat sts;
+  return (stat(path.c_str(), &sts) == 0) ? sts.st_mtime: 0;
+}
+
+size_t get_file_size(const string& path)
+{
+  struct stat sts;
+  return (stat(path.c_str(), &sts) == 0) ? (size_t)sts.st_size: 0;
+}
+
+void delete_file(const string& path)
+{
+  int result = unlink(path.c_str());
+  if (result != 0) {
+    // TODO add errno into the exception
+    throw std::runtime_error("Error deleting file");
+  }
+}
+
+void move_file(const string& src, const string& dst)
+{
+  int result = rename(src.c_str(), dst.c_str());
+  if (result != 0) {
+    // TODO add errno into the exception
+    throw std::runtime_error("Error moving file");
+  }
+}
+
 void make_directory(const string& path)
 {
   int result = mkdir(path.c_str(), 0777);
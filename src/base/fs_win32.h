@@ -5,6 +5,8 @@
 // please read LICENSE.txt for more information.
 
 #include <windows.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <stdexcept>
 
 #include "base/string.h"
@@ -29,6 +31,38 @@ bool directory_exists(const string& path)
           ((attr & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY));
 }
 
+time_t get_file_mtime(const string& path)
+{
+  struct _stat sts;
+  return (_wstat(from_utf8(path).c_str(), &sts) == 0) ? sts.st_mtime: 0;
+}
+
+size_t get_file_size(const string& path)
+{
+  struct _stat sts;
+  return (_wstat(from_utf8(path).c_str(), &sts) == 0) ? (size_t)sts.st_size: 0;
+}
+
+void delete_file(const string& path)
+{
+  BOOL result = ::DeleteFile(from_utf8(path).c_str());
+  if (result == 0) {
+    // TODO add GetLastError() value into the exception
+    throw std::runtime_error("Error deleting file");
+  }
+}
+
+void move_file(const string& src, const string& dst)
+{
+  BOOL result = ::MoveFileEx(from_utf8(src).c_str(),
+                             from_utf8(dst).c_str(),
+                             MOVEFILE_REPLACE_EXISTING);
+  if (result == 0) {
+    // TODO add GetLastError() value into the exception
+    throw std::runtime_error("Error moving file");
+  }
+}
+
 void make_directory(const string& path)
 {
   BOOL result = ::CreateDirectory(from_utf8(path).c_str(), NULL);
@@ -24,6 +24,8 @@ namespace base {
     class mutex_impl;
     mutex_impl* m_impl;
 
+    friend class condition_variable;
+
     DISABLE_COPYING(mutex);
   };
 
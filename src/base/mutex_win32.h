@@ -37,6 +37,10 @@ public:
     LeaveCriticalSection(&m_handle);
   }
 
+  CRITICAL_SECTION* native_handle() {
+    return &m_handle;
+  }
+
 private:
   CRITICAL_SECTION m_handle;
 };
@@ -0,0 +1,48 @@
+// Aseprite Base Library
+// Copyright (c) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifndef BASE_PARALLEL_FOR_H_INCLUDED
+#define BASE_PARALLEL_FOR_H_INCLUDED
+
+#include "base/task_scheduler.h"
+#include "base/thread.h"
+
+namespace base {
+
+  namespace details {
+
+    template<class Callable>
+    class parallel_for_each_index {
+    public:
+      parallel_for_each_index(const Callable& f) : m_f(f) { }
+
+      void operator()(int i1, int i2) const {
+        for (int i=i1; i<i2; ++i)
+          m_f(i);
+      }
+
+    private:
+      const Callable& m_f;
+    };
+
+  } // namespace details
+
+  // Calls f(i) for each i in [begin, end) distributing the calls
+  // between the threads of the default TaskScheduler (the current
+  // thread is used too). Indexes are taken in groups of "grain" items
+  // at least. It returns when all calls are done. "f" must be
+  // thread-safe and must not throw exceptions.
+  template<class Callable>
+  void parallel_for(int begin, int end, const Callable& f, int grain = 1)
+  {
+    TaskGroup group;
+    parallel_for_range(group, begin, end,
+                       details::parallel_for_each_index<Callable>(f), grain);
+  }
+
+} // namespace base
+
+#endif
@@ -0,0 +1,56 @@
+// Aseprite Base Library
+// Copyright (c) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "base/parallel_for.h"
+
+using namespace base;
+
+class Square {
+public:
+  Square(std::vector<int>& v) : m_v(v) { }
+  void operator()(int i) const { m_v[i] = i*i; }
+private:
+  std::vector<int>& m_v;
+};
+
+TEST(ParallelFor, HardwareConcurrency)
+{
+  EXPECT_LE(1u, thread::hardware_concurrency());
+}
+
+TEST(ParallelFor, EmptyRange)
+{
+  std::vector<int> v(1, -1);
+  parallel_for(0, 0, Square(v));
+  EXPECT_EQ(-1, v[0]);
+}
+
+TEST(ParallelFor, AllIndexesVisitedOnce)
+{
+  std::vector<int> v(1000, -1);
+  parallel_for(0, (int)v.size(), Square(v));
+  for (int i=0; i<(int)v.size(); ++i)
+    EXPECT_EQ(i*i, v[i]);
+}
+
+TEST(ParallelFor, Grain)
+{
+  std::vector<int> v(1001, -1);
+  parallel_for(1, (int)v.size(), Square(v), 64);
+  EXPECT_EQ(-1, v[0]);
+  for (int i=1; i<(int)v.size(); ++i)
+    EXPECT_EQ(i*i, v[i]);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
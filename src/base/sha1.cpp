@@ -63,4 +63,27 @@ bool Sha1::operator!=(const Sha1& other) const
   return m_digest != other.m_digest;
 }
 
+Sha1Builder::Sha1Builder()
+  : m_sha(new SHA1Context)
+{
+  SHA1Reset(m_sha);
+}
+
+Sha1Builder::~Sha1Builder()
+{
+  delete m_sha;
+}
+
+void Sha1Builder::add(const void* data, size_t size)
+{
+  SHA1Input(m_sha, (const uint8_t*)data, (unsigned int)size);
+}
+
+Sha1 Sha1Builder::getSha1()
+{
+  std::vector<uint8_t> digest(Sha1::HashSize);
+  SHA1Result(m_sha, &digest[0]);
+  return Sha1(digest);
+}
+
 } // namespace base
@@ -7,6 +7,8 @@
 #ifndef BASE_SHA1_H_INCLUDED
 #define BASE_SHA1_H_INCLUDED
 
+#include "base/disable_copying.h"
+
 #include <vector>
 #include <string>
 
@@ -35,6 +37,24 @@ namespace base {
     std::vector<uint8_t> m_digest;
   };
 
+  // Calculates the SHA1 of data added in several parts (e.g. the
+  // rows of an image).
+  class Sha1Builder {
+  public:
+    Sha1Builder();
+    ~Sha1Builder();
+
+    void add(const void* data, size_t size);
+
+    // Returns the SHA1 of all added data.
+    Sha1 getSha1();
+
+  private:
+    SHA1Context* m_sha;
+
+    DISABLE_COPYING(Sha1Builder);
+  };
+
 } // namespace base
 
 #endif  // BASE_SHA1_H_INCLUDED
@@ -0,0 +1,270 @@
+// Aseprite Base Library
+// Copyright (c) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "base/task_scheduler.h"
+
+#include "base/bind.h"
+#include "base/chrono.h"
+#include "base/scoped_lock.h"
+#include "base/thread.h"
+
+namespace base {
+
+void CancellationToken::cancel()
+{
+  scoped_lock hold(m_mutex);
+  m_canceled = true;
+}
+
+bool CancellationToken::isCanceled() const
+{
+  scoped_lock hold(m_mutex);
+  return m_canceled;
+}
+
+//////////////////////////////////////////////////////////////////////
+// TaskScheduler
+
+TaskScheduler::TaskScheduler(int threads)
+  : m_nextQueue(0)
+  , m_exit(false)
+{
+  if (threads <= 0)
+    threads = std::max<int>(1, thread::hardware_concurrency()-1);
+
+  for (int i=0; i<threads; ++i)
+    m_queues.push_back(new Queue);
+
+  for (int i=0; i<threads; ++i)
+    m_threads.push_back(new thread(Bind<void>(&TaskScheduler::threadProc, this, i)));
+}
+
+TaskScheduler::~TaskScheduler()
+{
+  {
+    scoped_lock hold(m_mutex);
+    m_exit = true;
+    m_changed.notify_all();
+  }
+
+  for (size_t i=0; i<m_threads.size(); ++i) {
+    m_threads[i]->join();
+    delete m_threads[i];
+  }
+
+  for (size_t i=0; i<m_queues.size(); ++i) {
+    std::deque<Entry>& entries = m_queues[i]->m_entries;
+    for (size_t j=0; j<entries.size(); ++j)
+      delete entries[j].task;
+    delete m_queues[i];
+  }
+}
+
+// static
+TaskScheduler& TaskScheduler::getDefault()
+{
+  static TaskScheduler scheduler;
+  return scheduler;
+}
+
+void TaskScheduler::schedule(TaskGroup* group, Task* task)
+{
+  Entry entry = { task, group };
+
+  scoped_lock hold(m_mutex);
+
+  // Distribute tasks between all queues, idle threads will steal
+  // tasks from busy ones.
+  Queue* queue = m_queues[m_nextQueue];
+  m_nextQueue = (m_nextQueue+1) % m_queues.size();
+  {
+    scoped_lock holdQueue(queue->m_mutex);
+    queue->m_entries.push_back(entry);
+  }
+
+  // Wake up all threads (not just one, as it could be a thread waiting
+  // a group that is already finished, so it wouldn't run the task).
+  m_changed.notify_all();
+}
+
+// Executes one task taking it from the given queue, or stealing it
+// from other queue. Returns false if there are no tasks.
+bool TaskScheduler::tryRunTask(int queueIndex)
+{
+  Entry entry = { NULL, NULL };
+  int n = (int)m_queues.size();
+
+  for (int i=0; i<n && !entry.task; ++i) {
+    Queue* queue = m_queues[(queueIndex+i) % n];
+    scoped_lock hold(queue->m_mutex);
+
+    if (!queue->m_entries.empty()) {
+      // Take the oldest task from our queue, and the newest one
+      // from other queues.
+      if (i == 0) {
+        entry = queue->m_entries.front();
+        queue->m_entries.pop_front();
+      }
+      else {
+        entry = queue->m_entries.back();
+        queue->m_entries.pop_back();
+      }
+    }
+  }
+
+  if (!entry.task)
+    return false;
+
+  if (!entry.group->isCanceled())
+    entry.task->run();
+
+  delete entry.task;
+  entry.group->onTaskDone();
+  return true;
+}
+
+// m_mutex must be locked.
+bool TaskScheduler::hasTasks()
+{
+  for (size_t i=0; i<m_queues.size(); ++i) {
+    scoped_lock hold(m_queues[i]->m_mutex);
+    if (!m_queues[i]->m_entries.empty())
+      return true;
+  }
+  return false;
+}
+
+void TaskScheduler::threadProc(int queueIndex)
+{
+  for (;;) {
+    if (tryRunTask(queueIndex))
+      continue;
+
+    scoped_lock hold(m_mutex);
+    while (!m_exit && !hasTasks())
+      m_changed.wait(hold);
+
+    if (m_exit)
+      return;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+// TaskGroup
+
+TaskGroup::TaskGroup(TaskScheduler& scheduler)
+  : m_scheduler(scheduler)
+  , m_pending(0)
+  , m_totalWork(0.0)
+  , m_doneWork(0.0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+  wait();
+}
+
+void TaskGroup::add(Task* task)
+{
+  {
+    scoped_lock hold(m_mutex);
+    ++m_pending;
+  }
+  m_scheduler.schedule(this, task);
+}
+
+void TaskGroup::wait()
+{
+  waitImpl(-1.0);
+}
+
+bool TaskGroup::wait_for(double seconds)
+{
+  return waitImpl(seconds);
+}
+
+void TaskGroup::addTotalWork(double units)
+{
+  scoped_lock hold(m_mutex);
+  m_totalWork += units;
+}
+
+void TaskGroup::addDoneWork(double units)
+{
+  scoped_lock hold(m_mutex);
+  m_doneWork += units;
+}
+
+double TaskGroup::getProgress() const
+{
+  scoped_lock hold(m_mutex);
+  if (m_totalWork > 0.0)
+    return std::min(1.0, m_doneWork / m_totalWork);
+  else
+    return (m_pending == 0 ? 1.0: 0.0);
+}
+
+// Waits "seconds" as maximum (or forever if it's negative).
+bool TaskGroup::waitImpl(double seconds)
+{
+  Chrono chrono;
+
+  for (;;) {
+    if (isDone())
+      return true;
+
+    // Help to execute tasks (of this or other group).
+    if (m_scheduler.tryRunTask(0))
+      continue;
+
+    scoped_lock hold(m_scheduler.m_mutex);
+    if (isDone())
+      return true;
+
+    if (m_scheduler.hasTasks())
+      continue;
+
+    if (seconds < 0.0)
+      m_scheduler.m_changed.wait(hold);
+    else {
+      double left = seconds - chrono.elapsed();
+      if (left <= 0.0)
+        return false;
+
+      m_scheduler.m_changed.wait_for(hold, left);
+    }
+  }
+}
+
+bool TaskGroup::isDone() const
+{
+  scoped_lock hold(m_mutex);
+  return (m_pending == 0);
+}
+
+void TaskGroup::onTaskDone()
+{
+  TaskScheduler& scheduler = m_scheduler;
+  bool done;
+  {
+    scoped_lock hold(m_mutex);
+    done = (--m_pending == 0);
+  }
+
+  // Wake up threads waiting this group (we cannot use "this"
+  // after unlocking m_mutex as the group could be destroyed).
+  if (done) {
+    scoped_lock hold(scheduler.m_mutex);
+    scheduler.m_changed.notify_all();
+  }
+}
+
+} // namespace base
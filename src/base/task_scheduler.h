@@ -0,0 +1,218 @@
+// Aseprite Base Library
+// Copyright (c) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifndef BASE_TASK_SCHEDULER_H_INCLUDED
+#define BASE_TASK_SCHEDULER_H_INCLUDED
+
+#include "base/condition_variable.h"
+#include "base/disable_copying.h"
+#include "base/mutex.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+namespace base {
+
+  class TaskGroup;
+  class thread;
+
+  // A unit of work to be executed by a TaskScheduler. Tasks must not
+  // throw exceptions.
+  class Task {
+  public:
+    virtual ~Task() { }
+    virtual void run() = 0;
+  };
+
+  // Flag shared between the code that wants to stop some work and the
+  // tasks doing that work (which should check isCanceled()
+  // periodically).
+  class CancellationToken {
+  public:
+    CancellationToken() : m_canceled(false) { }
+
+    void cancel();
+    bool isCanceled() const;
+
+  private:
+    mutable mutex m_mutex;
+    bool m_canceled;
+
+    DISABLE_COPYING(CancellationToken);
+  };
+
+  // Pool of threads to execute tasks. Each thread has its own queue of
+  // tasks, and when it is empty, the thread steals tasks from the
+  // queues of other threads. Tasks are added through a TaskGroup.
+  class TaskScheduler {
+  public:
+    // Creates a scheduler with the given number of threads. Zero means
+    // one thread less than the number of CPUs (the thread that waits
+    // a TaskGroup executes tasks too).
+    explicit TaskScheduler(int threads = 0);
+
+    // Pending tasks are discarded (all groups must be waited before).
+    ~TaskScheduler();
+
+    // Returns the scheduler shared by the whole program.
+    static TaskScheduler& getDefault();
+
+    int getThreadsCount() const { return (int)m_threads.size(); }
+
+  private:
+    friend class TaskGroup;
+
+    struct Entry {
+      Task* task;
+      TaskGroup* group;
+    };
+
+    struct Queue {
+      mutex m_mutex;
+      std::deque<Entry> m_entries;
+    };
+
+    void schedule(TaskGroup* group, Task* task);
+    bool tryRunTask(int queueIndex);
+    bool hasTasks();
+    void threadProc(int queueIndex);
+
+    std::vector<Queue*> m_queues;
+    std::vector<thread*> m_threads;
+    int m_nextQueue;
+
+    // Protects m_nextQueue/m_exit, and it is used with m_changed to
+    // wait new tasks or finished groups.
+    mutex m_mutex;
+    condition_variable m_changed;
+    bool m_exit;
+
+    DISABLE_COPYING(TaskScheduler);
+  };
+
+  // Set of tasks that can be waited/canceled together. It can be used
+  // to aggregate the progress of all its tasks too.
+  class TaskGroup {
+  public:
+    explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::getDefault());
+
+    // Waits all tasks.
+    ~TaskGroup();
+
+    TaskScheduler& getScheduler() { return m_scheduler; }
+
+    // Adds a task to the group (the group owns the task).
+    void add(Task* task);
+
+    // Adds a task to call a copy of "f" (f() is called from other
+    // thread).
+    template<class Callable>
+    void run(const Callable& f);
+
+    // Waits until all tasks of the group are finished. The calling
+    // thread executes pending tasks meanwhile (so a task can wait
+    // other groups without blocking a thread of the scheduler).
+    void wait();
+
+    // Like wait() but it returns false if the tasks aren't finished
+    // after the given number of seconds.
+    bool wait_for(double seconds);
+
+    // Tasks of a canceled group that weren't started are not
+    // executed.
+    void cancel() { m_token.cancel(); }
+    bool isCanceled() const { return m_token.isCanceled(); }
+    const CancellationToken& getToken() const { return m_token; }
+
+    // Progress of the group: tasks add the total work that they will
+    // do and then report the done work (in any unit).
+    void addTotalWork(double units);
+    void addDoneWork(double units);
+
+    // Returns the progress from 0.0 to 1.0.
+    double getProgress() const;
+
+  private:
+    friend class TaskScheduler;
+
+    bool waitImpl(double seconds);
+    bool isDone() const;
+    void onTaskDone();
+
+    TaskScheduler& m_scheduler;
+    mutable mutex m_mutex;
+    int m_pending;
+    double m_totalWork;
+    double m_doneWork;
+    CancellationToken m_token;
+
+    DISABLE_COPYING(TaskGroup);
+  };
+
+  namespace details {
+
+    template<class Callable>
+    class callable_task : public Task {
+    public:
+      callable_task(const Callable& f) : m_f(f) { }
+      void run() { m_f(); }
+    private:
+      Callable m_f;
+    };
+
+    template<class Callable>
+    class range_task : public Task {
+    public:
+      range_task(TaskGroup& group, const Callable& f, int i1, int i2)
+        : m_group(group), m_f(f), m_i1(i1), m_i2(i2) { }
+
+      void run() {
+        m_f(m_i1, m_i2);
+        m_group.addDoneWork(m_i2 - m_i1);
+      }
+
+    private:
+      TaskGroup& m_group;
+      const Callable& m_f;
+      int m_i1, m_i2;
+    };
+
+  } // namespace details
+
+  template<class Callable>
+  void TaskGroup::run(const Callable& f)
+  {
+    add(new details::callable_task<Callable>(f));
+  }
+
+  // Calls f(i1, i2) for consecutive ranges [i1, i2) of [begin, end)
+  // (e.g. bands of rows of an image) from the threads of the group's
+  // scheduler, and waits until all ranges are done. Each range has
+  // "grain" items at least. Finished ranges are reported as done work
+  // of the group. "f" must be thread-safe and must not throw
+  // exceptions.
+  template<class Callable>
+  void parallel_for_range(TaskGroup& group, int begin, int end, const Callable& f, int grain = 1)
+  {
+    if (begin >= end)
+      return;
+
+    // Some tasks per thread to balance the work
+    int count = end - begin;
+    int tasks = 4 * (group.getScheduler().getThreadsCount() + 1);
+    int chunk = std::max(std::max(grain, 1), (count + tasks - 1) / tasks);
+
+    group.addTotalWork(count);
+    for (int i=begin; i<end; i+=chunk)
+      group.add(new details::range_task<Callable>(group, f, i, std::min(i+chunk, end)));
+
+    group.wait();
+  }
+
+} // namespace base
+
+#endif
@@ -0,0 +1,159 @@
+// Aseprite Base Library
+// Copyright (c) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "base/mutex.h"
+#include "base/scoped_lock.h"
+#include "base/task_scheduler.h"
+
+using namespace base;
+
+class Counter {
+public:
+  Counter() : m_value(0) { }
+  void increment() { scoped_lock hold(m_mutex); ++m_value; }
+  int value() { scoped_lock hold(m_mutex); return m_value; }
+private:
+  mutex m_mutex;
+  int m_value;
+};
+
+class IncrementTask {
+public:
+  IncrementTask(Counter* counter) : m_counter(counter) { }
+  void operator()() const { m_counter->increment(); }
+private:
+  Counter* m_counter;
+};
+
+class MarkRange {
+public:
+  MarkRange(std::vector<int>& v) : m_v(v) { }
+  void operator()(int i1, int i2) const {
+    for (int i=i1; i<i2; ++i)
+      ++m_v[i];
+  }
+private:
+  std::vector<int>& m_v;
+};
+
+// Task that waits a nested group (it must not block a thread of the
+// scheduler forever).
+class NestedTask {
+public:
+  NestedTask(TaskScheduler* scheduler, Counter* counter)
+    : m_scheduler(scheduler), m_counter(counter) { }
+  void operator()() const {
+    TaskGroup group(*m_scheduler);
+    for (int i=0; i<10; ++i)
+      group.run(IncrementTask(m_counter));
+    group.wait();
+  }
+private:
+  TaskScheduler* m_scheduler;
+  Counter* m_counter;
+};
+
+TEST(TaskScheduler, ThreadsCount)
+{
+  TaskScheduler scheduler(3);
+  EXPECT_EQ(3, scheduler.getThreadsCount());
+  EXPECT_LE(1, TaskScheduler::getDefault().getThreadsCount());
+}
+
+TEST(TaskScheduler, RunAllTasks)
+{
+  TaskScheduler scheduler(4);
+  Counter counter;
+  {
+    TaskGroup group(scheduler);
+    for (int i=0; i<1000; ++i)
+      group.run(IncrementTask(&counter));
+    group.wait();
+    EXPECT_EQ(1000, counter.value());
+  }
+}
+
+TEST(TaskScheduler, DestructorWaitsTasks)
+{
+  Counter counter;
+  {
+    TaskGroup group;
+    for (int i=0; i<100; ++i)
+      group.run(IncrementTask(&counter));
+  }
+  EXPECT_EQ(100, counter.value());
+}
+
+TEST(TaskScheduler, NestedGroups)
+{
+  TaskScheduler scheduler(2);
+  Counter counter;
+  TaskGroup group(scheduler);
+  for (int i=0; i<20; ++i)
+    group.run(NestedTask(&scheduler, &counter));
+  group.wait();
+  EXPECT_EQ(200, counter.value());
+}
+
+TEST(TaskScheduler, ParallelForRange)
+{
+  std::vector<int> v(1001, 0);
+  TaskGroup group;
+  parallel_for_range(group, 1, (int)v.size(), MarkRange(v), 16);
+
+  EXPECT_EQ(0, v[0]);
+  for (int i=1; i<(int)v.size(); ++i)
+    EXPECT_EQ(1, v[i]);
+}
+
+TEST(TaskScheduler, Progress)
+{
+  std::vector<int> v(100, 0);
+  TaskGroup group;
+  EXPECT_EQ(1.0, group.getProgress());
+
+  group.addTotalWork(100);
+  EXPECT_EQ(0.0, group.getProgress());
+
+  group.addDoneWork(50);
+  EXPECT_EQ(0.5, group.getProgress());
+
+  group.addDoneWork(50);
+  parallel_for_range(group, 0, (int)v.size(), MarkRange(v));
+  EXPECT_EQ(1.0, group.getProgress());
+}
+
+TEST(TaskScheduler, Cancel)
+{
+  Counter counter;
+  TaskGroup group;
+  EXPECT_FALSE(group.isCanceled());
+
+  group.cancel();
+  EXPECT_TRUE(group.isCanceled());
+  EXPECT_TRUE(group.getToken().isCanceled());
+
+  for (int i=0; i<100; ++i)
+    group.run(IncrementTask(&counter));
+  EXPECT_TRUE(group.wait_for(10.0));
+  EXPECT_EQ(0, counter.value());
+}
+
+TEST(TaskScheduler, WaitForEmptyGroup)
+{
+  TaskGroup group;
+  EXPECT_TRUE(group.wait_for(0.0));
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
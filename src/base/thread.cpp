@@ -65,10 +65,12 @@ void base::thread::join()
   if (joinable()) {
 #ifdef WIN32
     ::WaitForSingleObject(m_native_handle, INFINITE);
+    detach();
 #else
+    // A joined thread cannot be detached (or joined again).
     ::pthread_join((pthread_t)m_native_handle, NULL);
+    m_native_handle = (native_handle_type)0;
 #endif
-    detach();
   }
 }
 
@@ -80,6 +82,7 @@ void base::thread::detach()
     m_native_handle = (native_handle_type)0;
 #else
     ::pthread_detach((pthread_t)m_native_handle);
+    m_native_handle = (native_handle_type)0;
 #endif
   }
 }
@@ -89,6 +92,27 @@ base::thread::native_handle_type base::thread::native_handle()
   return m_native_handle;
 }
 
+// static
+unsigned int base::thread::hardware_concurrency()
+{
+#ifdef WIN32
+
+  SYSTEM_INFO info;
+  ::GetSystemInfo(&info);
+  return (info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors: 1);
+
+#elif defined(_SC_NPROCESSORS_ONLN)
+
+  long n = ::sysconf(_SC_NPROCESSORS_ONLN);
+  return (n > 0 ? (unsigned int)n: 1);
+
+#else
+
+  return 1;
+
+#endif
+}
+
 void base::thread::launch_thread(func_wrapper* f)
 {
   m_native_handle = (native_handle_type)0;
@@ -42,6 +42,10 @@ namespace base {                // Based on C++0x threads lib
 
     native_handle_type native_handle();
 
+    // Returns the number of threads that can run concurrently in this
+    // machine (it is at least 1).
+    static unsigned int hardware_concurrency();
+
     class details {
     public:
       static void thread_proxy(void* data);
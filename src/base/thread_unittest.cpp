@@ -23,6 +23,17 @@ TEST(Thread, Joinable)
   thread t(&nothing);
   EXPECT_TRUE(t.joinable());
   t.join();
+  EXPECT_FALSE(t.joinable());
+
+  // Joining again does nothing.
+  t.join();
+}
+
+TEST(Thread, Detach)
+{
+  thread t(&nothing);
+  t.detach();
+  EXPECT_FALSE(t.joinable());
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -0,0 +1,220 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BENCHMARKS_BENCHMARK_H_INCLUDED
+#define BENCHMARKS_BENCHMARK_H_INCLUDED
+
+// Minimal benchmark harness. Include this file in only one .cpp file
+// per executable (it defines main(), like tests/test.h does).
+//
+// Each benchmark is a benchmarks::Case subclass registered with
+// BENCHMARK_CASE(). setUp() creates the (reproducible) input data,
+// run() is the measured part, and it is called several times. The
+// results are printed to stdout as CSV or JSON with min, median, p95
+// and mean timings in milliseconds.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "base/chrono.h"
+#include "base/convert_to.h"
+#include "base/program_options.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace benchmarks {
+
+  class Case {
+  public:
+    Case(const char* name) : m_name(name) { }
+    virtual ~Case() { }
+
+    const char* name() const { return m_name; }
+
+    // Creates the input data (it is not measured).
+    virtual void setUp() { }
+
+    // Measured code (called several times).
+    virtual void run() = 0;
+
+    // Destroys the data created in setUp().
+    virtual void tearDown() { }
+
+  private:
+    const char* m_name;
+  };
+
+  inline std::vector<Case*>& get_cases() {
+    static std::vector<Case*> cases;
+    return cases;
+  }
+
+  class CaseRegistrar {
+  public:
+    CaseRegistrar(Case* benchmarkCase) {
+      get_cases().push_back(benchmarkCase);
+    }
+  };
+
+  // Small linear congruential generator, so synthetic inputs are the
+  // same on every platform/build (std::rand() is not).
+  class Random {
+  public:
+    Random(unsigned int seed = 1) : m_state(seed) { }
+
+    unsigned int next() {
+      m_state = m_state * 1103515245 + 12345;
+      return (m_state >> 16) & 0x7fff;
+    }
+
+    int next(int max) {
+      return next() % max;
+    }
+
+  private:
+    unsigned int m_state;
+  };
+
+  struct Stats {
+    int iterations;
+    double min, median, p95, mean; // In milliseconds
+  };
+
+  inline Stats calc_stats(std::vector<double> times) {
+    Stats stats;
+    std::sort(times.begin(), times.end());
+
+    stats.iterations = (int)times.size();
+    stats.min = times.front();
+    stats.median = times[times.size() / 2];
+    stats.p95 = times[std::min(times.size()-1, (times.size()*95 + 99) / 100 - 1)];
+    stats.mean = 0.0;
+    for (size_t i=0; i<times.size(); ++i)
+      stats.mean += times[i];
+    stats.mean /= times.size();
+    return stats;
+  }
+
+  inline int run_all_cases(int argc, const char* argv[]) {
+    typedef base::ProgramOptions::Option Option;
+
+    base::ProgramOptions po;
+    Option& iterationsOpt = po.add("iterations").requiresValue("N").description("Number of measured runs of each benchmark (default 10)");
+    Option& formatOpt = po.add("format").requiresValue("csv|json").description("Output format (default csv)");
+    Option& filterOpt = po.add("filter").requiresValue("TEXT").description("Run only benchmarks which name contains TEXT");
+    Option& helpOpt = po.add("help").mnemonic('?').description("Display this help and exits");
+
+    try {
+      po.parse(argc, argv);
+    }
+    catch (const std::runtime_error& parseError) {
+      std::cerr << argv[0] << ": " << parseError.what() << '\n';
+      return 1;
+    }
+
+    if (helpOpt.enabled()) {
+      std::cout << "Usage:\n  " << argv[0] << " [OPTIONS]\n\nOptions:\n" << po;
+      return 0;
+    }
+
+    int iterations = 10;
+    if (!iterationsOpt.value().empty())
+      iterations = std::max(1, base::convert_to<int>(iterationsOpt.value()));
+
+    bool json = (formatOpt.value() == "json");
+    const std::string& filter = filterOpt.value();
+    std::vector<Case*>& cases = get_cases();
+    bool first = true;
+
+    if (json)
+      std::cout << "[\n";
+    else
+      std::cout << "name,iterations,min_ms,median_ms,p95_ms,mean_ms\n";
+
+    for (size_t i=0; i<cases.size(); ++i) {
+      Case* benchmarkCase = cases[i];
+      if (!filter.empty() && std::strstr(benchmarkCase->name(), filter.c_str()) == NULL)
+        continue;
+
+      std::vector<double> times;
+      benchmarkCase->setUp();
+
+      // Warm up caches (this run is not measured).
+      benchmarkCase->run();
+
+      for (int j=0; j<iterations; ++j) {
+        base::Chrono chrono;
+        benchmarkCase->run();
+        times.push_back(chrono.elapsed() * 1000.0);
+      }
+
+      benchmarkCase->tearDown();
+
+      Stats stats = calc_stats(times);
+      char buf[512];
+
+      if (json)
+        std::sprintf(buf, "%s  { \"name\": \"%s\", \"iterations\": %d, \"min_ms\": %.4f, \"median_ms\": %.4f, \"p95_ms\": %.4f, \"mean_ms\": %.4f }",
+                     (first ? "": ",\n"), benchmarkCase->name(), stats.iterations,
+                     stats.min, stats.median, stats.p95, stats.mean);
+      else
+        std::sprintf(buf, "%s,%d,%.4f,%.4f,%.4f,%.4f\n",
+                     benchmarkCase->name(), stats.iterations,
+                     stats.min, stats.median, stats.p95, stats.mean);
+
+      std::cout << buf << std::flush;
+      first = false;
+    }
+
+    if (json)
+      std::cout << "\n]\n";
+
+    return 0;
+  }
+
+} // namespace benchmarks
+
+#define BENCHMARK_CASE(ClassName)                       \
+  static benchmarks::CaseRegistrar ClassName##_registrar(new ClassName)
+
+#ifdef LINKED_WITH_SHE
+  #undef main
+  #ifdef WIN32
+    int main(int argc, char* argv[]) {
+      extern int app_main(int argc, char* argv[]);
+      return app_main(argc, argv);
+    }
+  #endif
+  #define main app_main
+#endif
+
+#ifndef BENCHMARK_CUSTOM_MAIN
+int main(int argc, char* argv[])
+{
+  return benchmarks::run_all_cases(argc, const_cast<const char**>(argv));
+}
+#endif
+
+#endif
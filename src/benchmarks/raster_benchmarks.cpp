@@ -0,0 +1,432 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define BENCHMARK_CUSTOM_MAIN
+#include "benchmarks/benchmark.h"
+
+#include "app/document.h"
+#include "app/ui_context.h"
+#include "app/util/render.h"
+#include "base/shared_ptr.h"
+#include "base/unique_ptr.h"
+#include "filters/convolution_matrix.h"
+#include "filters/convolution_matrix_filter.h"
+#include "filters/filter_indexed_data.h"
+#include "filters/filter_manager.h"
+#include "filters/median_filter.h"
+#include "raster/algo.h"
+#include "raster/algorithm/resize_image.h"
+#include "raster/primitives_fast.h"
+#include "raster/quantization.h"
+#include "raster/raster.h"
+#include "raster/rotate.h"
+#include "she/she.h"
+
+using namespace app;
+using namespace benchmarks;
+using namespace filters;
+using namespace raster;
+
+namespace {
+
+  const int kImageSize = 1024;
+
+  // Random RGBA pixels in blocks (so there are flat areas like in a
+  // real sprite) with some fully transparent blocks.
+  void fill_rgb_image(Image* image, unsigned int seed)
+  {
+    Random random(seed);
+    color_t c = 0;
+
+    for (int y=0; y<image->getHeight(); ++y) {
+      for (int x=0; x<image->getWidth(); ++x) {
+        if ((x % 8) == 0 || random.next(16) == 0) {
+          int a = random.next(4);
+          c = rgba(random.next(256), random.next(256), random.next(256),
+                   a == 0 ? 0: (a == 1 ? 128: 255));
+        }
+        put_pixel_fast<RgbTraits>(image, x, y, c);
+      }
+    }
+  }
+
+  // Indexed image with big regions of a few colors (useful for flood
+  // fill).
+  void fill_indexed_image(Image* image, unsigned int seed)
+  {
+    Random random(seed);
+
+    for (int y=0; y<image->getHeight(); ++y)
+      for (int x=0; x<image->getWidth(); ++x)
+        put_pixel_fast<IndexedTraits>(image, x, y,
+                                      (random.next(64) == 0 ? 1: 0));
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Simple FilterManager to apply a filter to a whole image
+
+  class ImageFilterManager : public FilterManager
+                           , public FilterIndexedData {
+  public:
+    ImageFilterManager(const Image* src, Image* dst, Palette* palette, RgbMap* rgbmap)
+      : m_src(src), m_dst(dst), m_palette(palette), m_rgbmap(rgbmap), m_row(0) {
+    }
+
+    void apply(Filter* filter) {
+      for (m_row=0; m_row<m_src->getHeight(); ++m_row) {
+        switch (m_src->getPixelFormat()) {
+          case IMAGE_RGB:       filter->applyToRgba(this); break;
+          case IMAGE_GRAYSCALE: filter->applyToGrayscale(this); break;
+          case IMAGE_INDEXED:   filter->applyToIndexed(this); break;
+        }
+      }
+    }
+
+    // FilterManager implementation
+    const void* getSourceAddress() { return m_src->getPixelAddress(0, m_row); }
+    void* getDestinationAddress() { return m_dst->getPixelAddress(0, m_row); }
+    int getWidth() { return m_src->getWidth(); }
+    Target getTarget() { return TARGET_ALL_CHANNELS; }
+    FilterIndexedData* getIndexedData() { return this; }
+    bool skipPixel() { return false; }
+    const Image* getSourceImage() { return m_src; }
+    int getX() { return 0; }
+    int getY() { return m_row; }
+
+    // FilterIndexedData implementation
+    Palette* getPalette() { return m_palette; }
+    RgbMap* getRgbMap() { return m_rgbmap; }
+
+  private:
+    const Image* m_src;
+    Image* m_dst;
+    Palette* m_palette;
+    RgbMap* m_rgbmap;
+    int m_row;
+  };
+
+  //////////////////////////////////////////////////////////////////////
+  // Benchmarks
+
+  class ImageMergeBenchmark : public Case {
+  public:
+    ImageMergeBenchmark() : Case("ImageImpl::merge/rgb_1024") { }
+
+    void setUp() {
+      m_src.reset(Image::create(IMAGE_RGB, kImageSize, kImageSize));
+      m_dst.reset(Image::create(IMAGE_RGB, kImageSize, kImageSize));
+      fill_rgb_image(m_src, 1);
+      fill_rgb_image(m_dst, 2);
+    }
+
+    void run() {
+      m_dst->merge(m_src, 0, 0, m_dst->getBounds(), 200, BLEND_MODE_NORMAL);
+    }
+
+    void tearDown() {
+      m_src.reset(NULL);
+      m_dst.reset(NULL);
+    }
+
+  private:
+    base::UniquePtr<Image> m_src, m_dst;
+  };
+
+  class ResizeImageBenchmark : public Case {
+  public:
+    ResizeImageBenchmark(const char* name, algorithm::ResizeMethod method)
+      : Case(name), m_method(method) { }
+
+    void setUp() {
+      m_src.reset(Image::create(IMAGE_RGB, kImageSize/2, kImageSize/2));
+      m_dst.reset(Image::create(IMAGE_RGB, kImageSize, kImageSize+kImageSize/4));
+      m_palette.reset(new Palette(FrameNumber(0), 256));
+      m_rgbmap.reset(new RgbMap);
+      m_rgbmap->regenerate(m_palette);
+      fill_rgb_image(m_src, 3);
+    }
+
+    void run() {
+      algorithm::resize_image(m_src, m_dst, m_method, m_palette, m_rgbmap);
+    }
+
+    void tearDown() {
+      m_src.reset(NULL);
+      m_dst.reset(NULL);
+      m_rgbmap.reset(NULL);
+      m_palette.reset(NULL);
+    }
+
+  private:
+    algorithm::ResizeMethod m_method;
+    base::UniquePtr<Image> m_src, m_dst;
+    base::UniquePtr<Palette> m_palette;
+    base::UniquePtr<RgbMap> m_rgbmap;
+  };
+
+  class ImageParallelogramBenchmark : public Case {
+  public:
+    ImageParallelogramBenchmark() : Case("image_parallelogram/rgb_512_rotated") { }
+
+    void setUp() {
+      m_src.reset(Image::create(IMAGE_RGB, kImageSize/2, kImageSize/2));
+      m_dst.reset(Image::create(IMAGE_RGB, kImageSize, kImageSize));
+      fill_rgb_image(m_src, 4);
+      clear_image(m_dst, 0);
+    }
+
+    void run() {
+      // 512x512 image rotated ~30 degrees and scaled 1.5x.
+      image_parallelogram(m_dst, m_src,
+                          200, 40, 865, 424,
+                          481, 1089, -184, 705);
+    }
+
+    void tearDown() {
+      m_src.reset(NULL);
+      m_dst.reset(NULL);
+    }
+
+  private:
+    base::UniquePtr<Image> m_src, m_dst;
+  };
+
+  class FloodFillBenchmark : public Case {
+  public:
+    FloodFillBenchmark() : Case("algo_floodfill/indexed_1024") { }
+
+    void setUp() {
+      m_src.reset(Image::create(IMAGE_INDEXED, kImageSize, kImageSize));
+      m_dst.reset(Image::create(IMAGE_INDEXED, kImageSize, kImageSize));
+      fill_indexed_image(m_src, 5);
+      put_pixel_fast<IndexedTraits>(m_src, kImageSize/2, kImageSize/2, 0);
+    }
+
+    void run() {
+      algo_floodfill(m_src, kImageSize/2, kImageSize/2, 0, m_dst, hline);
+    }
+
+    void tearDown() {
+      m_src.reset(NULL);
+      m_dst.reset(NULL);
+    }
+
+  private:
+    static void hline(int x1, int y, int x2, void* data) {
+      draw_hline(reinterpret_cast<Image*>(data), x1, y, x2, 2);
+    }
+
+    base::UniquePtr<Image> m_src, m_dst;
+  };
+
+  class CreatePaletteBenchmark : public Case {
+  public:
+    CreatePaletteBenchmark() : Case("quantization::create_palette_from_rgb/rgb_1024") { }
+
+    void setUp() {
+      m_doc.reset(Document::createBasicDocument(IMAGE_RGB, kImageSize, kImageSize, 256));
+      Sprite* sprite = m_doc->getSprite();
+      Layer* layer = sprite->getFolder()->getFirstLayer();
+      Cel* cel = static_cast<LayerImage*>(layer)->getCel(FrameNumber(0));
+      fill_rgb_image(sprite->getStock()->getImage(cel->getImage()), 6);
+    }
+
+    void run() {
+      delete quantization::create_palette_from_rgb(m_doc->getSprite(), FrameNumber(0));
+    }
+
+    void tearDown() {
+      m_doc.reset(NULL);
+    }
+
+  private:
+    base::UniquePtr<Document> m_doc;
+  };
+
+  class OrderedDitheringBenchmark : public Case {
+  public:
+    OrderedDitheringBenchmark() : Case("ordered_dithering/rgb_1024") { }
+
+    void setUp() {
+      m_src.reset(Image::create(IMAGE_RGB, kImageSize, kImageSize));
+      m_palette.reset(new Palette(FrameNumber(0), 256));
+      for (int i=0; i<256; ++i)
+        m_palette->setEntry(i, rgba((i & 7) * 255 / 7,
+                                    ((i >> 3) & 7) * 255 / 7,
+                                    ((i >> 6) & 3) * 255 / 3, 255));
+      m_rgbmap.reset(new RgbMap);
+      m_rgbmap->regenerate(m_palette);
+      fill_rgb_image(m_src, 7);
+    }
+
+    void run() {
+      delete quantization::convert_pixel_format(m_src, IMAGE_INDEXED,
+                                                DITHERING_ORDERED,
+                                                m_rgbmap, m_palette, false);
+    }
+
+    void tearDown() {
+      m_src.reset(NULL);
+      m_rgbmap.reset(NULL);
+      m_palette.reset(NULL);
+    }
+
+  private:
+    base::UniquePtr<Image> m_src;
+    base::UniquePtr<Palette> m_palette;
+    base::UniquePtr<RgbMap> m_rgbmap;
+  };
+
+  class FilterBenchmark : public Case {
+  public:
+    FilterBenchmark(const char* name) : Case(name) { }
+
+    void setUp() {
+      m_src.reset(Image::create(IMAGE_RGB, kImageSize/2, kImageSize/2));
+      m_dst.reset(Image::create(IMAGE_RGB, kImageSize/2, kImageSize/2));
+      m_palette.reset(new Palette(FrameNumber(0), 256));
+      m_rgbmap.reset(new RgbMap);
+      m_rgbmap->regenerate(m_palette);
+      fill_rgb_image(m_src, 8);
+      m_filter.reset(createFilter());
+    }
+
+    void run() {
+      ImageFilterManager filterMgr(m_src, m_dst, m_palette, m_rgbmap);
+      filterMgr.apply(m_filter);
+    }
+
+    void tearDown() {
+      m_filter.reset(NULL);
+      m_src.reset(NULL);
+      m_dst.reset(NULL);
+      m_rgbmap.reset(NULL);
+      m_palette.reset(NULL);
+    }
+
+  protected:
+    virtual Filter* createFilter() = 0;
+
+  private:
+    base::UniquePtr<Filter> m_filter;
+    base::UniquePtr<Image> m_src, m_dst;
+    base::UniquePtr<Palette> m_palette;
+    base::UniquePtr<RgbMap> m_rgbmap;
+  };
+
+  class MedianFilterBenchmark : public FilterBenchmark {
+  public:
+    MedianFilterBenchmark() : FilterBenchmark("MedianFilter/rgb_512_3x3") { }
+
+  protected:
+    Filter* createFilter() {
+      MedianFilter* filter = new MedianFilter;
+      filter->setSize(3, 3);
+      return filter;
+    }
+  };
+
+  class ConvolutionMatrixFilterBenchmark : public FilterBenchmark {
+  public:
+    ConvolutionMatrixFilterBenchmark() : FilterBenchmark("ConvolutionMatrixFilter/rgb_512_blur5x5") { }
+
+  protected:
+    Filter* createFilter() {
+      SharedPtr<ConvolutionMatrix> matrix(new ConvolutionMatrix(5, 5));
+      matrix->setName("blur-5x5");
+      matrix->setCenterX(2);
+      matrix->setCenterY(2);
+      matrix->setDiv(25 * ConvolutionMatrix::Precision);
+      matrix->setBias(0);
+      matrix->setDefaultTarget(TARGET_ALL_CHANNELS);
+      for (int y=0; y<5; ++y)
+        for (int x=0; x<5; ++x)
+          matrix->value(x, y) = ConvolutionMatrix::Precision;
+
+      ConvolutionMatrixFilter* filter = new ConvolutionMatrixFilter;
+      filter->setMatrix(matrix);
+      return filter;
+    }
+  };
+
+  class RenderSpriteBenchmark : public Case {
+  public:
+    RenderSpriteBenchmark(const char* name, PixelFormat format, int zoom)
+      : Case(name), m_format(format), m_zoom(zoom) { }
+
+    void setUp() {
+      m_doc.reset(Document::createBasicDocument(m_format, kImageSize/2, kImageSize/2, 256));
+      Sprite* sprite = m_doc->getSprite();
+
+      // Three layers of random pixels.
+      for (int i=0; i<3; ++i) {
+        Image* image = Image::create(m_format, sprite->getWidth(), sprite->getHeight());
+        if (m_format == IMAGE_RGB)
+          fill_rgb_image(image, 9+i);
+        else
+          fill_indexed_image(image, 9+i);
+
+        LayerImage* layer = new LayerImage(sprite);
+        layer->addCel(new Cel(FrameNumber(0), sprite->getStock()->addImage(image)));
+        sprite->getFolder()->addLayer(layer);
+      }
+    }
+
+    void run() {
+      Sprite* sprite = m_doc->getSprite();
+      RenderEngine render(m_doc, sprite, sprite->getFolder()->getFirstLayer(), FrameNumber(0));
+      delete render.renderSprite(0, 0,
+                                 sprite->getWidth() << m_zoom,
+                                 sprite->getHeight() << m_zoom,
+                                 FrameNumber(0), m_zoom, true);
+    }
+
+    void tearDown() {
+      m_doc.reset(NULL);
+    }
+
+  private:
+    PixelFormat m_format;
+    int m_zoom;
+    base::UniquePtr<Document> m_doc;
+  };
+
+  BENCHMARK_CASE(ImageMergeBenchmark);
+  static CaseRegistrar resize_nearest_registrar(new ResizeImageBenchmark("resize_image/rgb_512_nearest", algorithm::RESIZE_METHOD_NEAREST_NEIGHBOR));
+  static CaseRegistrar resize_bilinear_registrar(new ResizeImageBenchmark("resize_image/rgb_512_bilinear", algorithm::RESIZE_METHOD_BILINEAR));
+  BENCHMARK_CASE(ImageParallelogramBenchmark);
+  BENCHMARK_CASE(FloodFillBenchmark);
+  BENCHMARK_CASE(CreatePaletteBenchmark);
+  BENCHMARK_CASE(OrderedDitheringBenchmark);
+  BENCHMARK_CASE(MedianFilterBenchmark);
+  BENCHMARK_CASE(ConvolutionMatrixFilterBenchmark);
+  static CaseRegistrar render_rgb_registrar(new RenderSpriteBenchmark("RenderEngine::renderSprite/rgb_512_zoom1x", IMAGE_RGB, 0));
+  static CaseRegistrar render_rgb_zoom_registrar(new RenderSpriteBenchmark("RenderEngine::renderSprite/rgb_512_zoom4x", IMAGE_RGB, 2));
+  static CaseRegistrar render_indexed_registrar(new RenderSpriteBenchmark("RenderEngine::renderSprite/indexed_512_zoom1x", IMAGE_INDEXED, 0));
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  // RenderEngine needs the settings of the UI context (and the
+  // context needs a she::System to be initialized).
+  she::ScopedHandle<she::System> system(she::CreateSystem());
+  UIContext context;
+
+  return run_all_cases(argc, const_cast<const char**>(argv));
+}
@@ -0,0 +1,152 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "benchmarks/benchmark.h"
+
+#include "base/mutex.h"
+#include "base/scoped_lock.h"
+#include "base/task_scheduler.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace base;
+using namespace benchmarks;
+
+namespace {
+
+  // Some floating point work for each row.
+  void process_rows(std::vector<double>& rows, int i1, int i2)
+  {
+    for (int i=i1; i<i2; ++i) {
+      double v = i;
+      for (int j=0; j<256; ++j)
+        v = std::sqrt(v + j);
+      rows[i] = v;
+    }
+  }
+
+  class RowsFunctor {
+  public:
+    RowsFunctor(std::vector<double>& rows) : m_rows(rows) { }
+    void operator()(int i1, int i2) const { process_rows(m_rows, i1, i2); }
+  private:
+    std::vector<double>& m_rows;
+  };
+
+  // Task that does nothing (to measure the scheduling overhead).
+  class EmptyTask {
+  public:
+    void operator()() const { }
+  };
+
+  // Task that uses a shared mutex (the worst case for contention).
+  class SharedCounterTask {
+  public:
+    SharedCounterTask(mutex* mutex, int* counter) : m_mutex(mutex), m_counter(counter) { }
+    void operator()() const {
+      scoped_lock hold(*m_mutex);
+      ++(*m_counter);
+    }
+  private:
+    mutex* m_mutex;
+    int* m_counter;
+  };
+
+  // Task that waits a nested group.
+  class NestedTask {
+  public:
+    NestedTask(std::vector<double>* rows, int i1, int i2) : m_rows(rows), m_i1(i1), m_i2(i2) { }
+    void operator()() const {
+      TaskGroup group;
+      parallel_for_range(group, m_i1, m_i2, RowsFunctor(*m_rows), 8);
+    }
+  private:
+    std::vector<double>* m_rows;
+    int m_i1, m_i2;
+  };
+
+  const int kRows = 4096;
+
+  class SerialRowsBenchmark : public Case {
+  public:
+    SerialRowsBenchmark() : Case("rows/serial_4096") { }
+    void setUp() { m_rows.resize(kRows); }
+    void run() { process_rows(m_rows, 0, kRows); }
+  private:
+    std::vector<double> m_rows;
+  };
+
+  class ParallelRowsBenchmark : public Case {
+  public:
+    ParallelRowsBenchmark() : Case("rows/parallel_for_range_4096") { }
+    void setUp() { m_rows.resize(kRows); }
+    void run() {
+      TaskGroup group;
+      parallel_for_range(group, 0, kRows, RowsFunctor(m_rows));
+    }
+  private:
+    std::vector<double> m_rows;
+  };
+
+  class NestedRowsBenchmark : public Case {
+  public:
+    NestedRowsBenchmark() : Case("rows/nested_groups_64x64") { }
+    void setUp() { m_rows.resize(kRows); }
+    void run() {
+      TaskGroup group;
+      for (int i=0; i<kRows; i+=64)
+        group.run(NestedTask(&m_rows, i, i+64));
+      group.wait();
+    }
+  private:
+    std::vector<double> m_rows;
+  };
+
+  class EmptyTasksBenchmark : public Case {
+  public:
+    EmptyTasksBenchmark() : Case("scheduling/empty_tasks_10000") { }
+    void run() {
+      TaskGroup group;
+      for (int i=0; i<10000; ++i)
+        group.run(EmptyTask());
+      group.wait();
+    }
+  };
+
+  class SharedMutexBenchmark : public Case {
+  public:
+    SharedMutexBenchmark() : Case("scheduling/shared_mutex_tasks_10000") { }
+    void run() {
+      int counter = 0;
+      TaskGroup group;
+      for (int i=0; i<10000; ++i)
+        group.run(SharedCounterTask(&m_mutex, &counter));
+      group.wait();
+    }
+  private:
+    mutex m_mutex;
+  };
+
+  BENCHMARK_CASE(SerialRowsBenchmark);
+  BENCHMARK_CASE(ParallelRowsBenchmark);
+  BENCHMARK_CASE(NestedRowsBenchmark);
+  BENCHMARK_CASE(EmptyTasksBenchmark);
+  BENCHMARK_CASE(SharedMutexBenchmark);
+
+} // anonymous namespace
@@ -0,0 +1,135 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "benchmarks/benchmark.h"
+
+#include "undo/undo_history.h"
+#include "undo/undoer.h"
+
+#include <limits>
+
+using namespace benchmarks;
+using namespace undo;
+
+namespace {
+
+  // Undoer that doesn't modify anything (just to measure the cost of
+  // the undo history itself).
+  class FakeUndoer : public Undoer {
+  public:
+    enum Kind { Action, OpenGroup, CloseGroup };
+
+    FakeUndoer(Kind kind) : m_kind(kind) { }
+
+    void dispose() { delete this; }
+    size_t getMemSize() const { return sizeof(*this) + 64; }
+    Modification getModification() const { return ModifyDocument; }
+    bool isOpenGroup() const { return m_kind == OpenGroup; }
+    bool isCloseGroup() const { return m_kind == CloseGroup; }
+
+    void revert(ObjectsContainer* objects, UndoersCollector* redoers) {
+      redoers->pushUndoer(new FakeUndoer(m_kind == OpenGroup ? CloseGroup:
+                                         m_kind == CloseGroup ? OpenGroup: Action));
+    }
+
+  private:
+    Kind m_kind;
+  };
+
+  class FakeDelegate : public UndoHistoryDelegate {
+  public:
+    FakeDelegate(size_t sizeLimit) : m_sizeLimit(sizeLimit) { }
+    ObjectsContainer* getObjects() const { return NULL; }
+    size_t getUndoSizeLimit() const { return m_sizeLimit; }
+  private:
+    size_t m_sizeLimit;
+  };
+
+  const int kUndoers = 100000;
+
+  // Adds kUndoers undoers, in groups of "groupSize" undoers (like the
+  // small undoers of each stroke in a long painting session).
+  void push_undoers(UndoHistory& history, int groupSize)
+  {
+    for (int i=0; i<kUndoers; ) {
+      if (groupSize > 1) {
+        history.pushUndoer(new FakeUndoer(FakeUndoer::OpenGroup));
+        for (int j=0; j<groupSize-2; ++j)
+          history.pushUndoer(new FakeUndoer(FakeUndoer::Action));
+        history.pushUndoer(new FakeUndoer(FakeUndoer::CloseGroup));
+        i += groupSize;
+      }
+      else {
+        history.pushUndoer(new FakeUndoer(FakeUndoer::Action));
+        ++i;
+      }
+    }
+  }
+
+  class PushBenchmark : public Case {
+  public:
+    PushBenchmark() : Case("undo/push_100000") { }
+    void run() {
+      FakeDelegate delegate(std::numeric_limits<size_t>::max());
+      UndoHistory history(&delegate);
+      push_undoers(history, 1);
+    }
+  };
+
+  class PushGroupsBenchmark : public Case {
+  public:
+    PushGroupsBenchmark() : Case("undo/push_100000_in_groups_of_10") { }
+    void run() {
+      FakeDelegate delegate(std::numeric_limits<size_t>::max());
+      UndoHistory history(&delegate);
+      push_undoers(history, 10);
+    }
+  };
+
+  // The history is full, so old groups are discarded in each push.
+  class PushWithLimitBenchmark : public Case {
+  public:
+    PushWithLimitBenchmark() : Case("undo/push_100000_with_1mb_limit") { }
+    void run() {
+      FakeDelegate delegate(1024*1024);
+      UndoHistory history(&delegate);
+      push_undoers(history, 10);
+    }
+  };
+
+  class UndoRedoBenchmark : public Case {
+  public:
+    UndoRedoBenchmark() : Case("undo/undo_redo_100000_in_groups_of_10") { }
+    void run() {
+      FakeDelegate delegate(std::numeric_limits<size_t>::max());
+      UndoHistory history(&delegate);
+      push_undoers(history, 10);
+
+      while (history.canUndo())
+        history.doUndo();
+      while (history.canRedo())
+        history.doRedo();
+    }
+  };
+
+  BENCHMARK_CASE(PushBenchmark);
+  BENCHMARK_CASE(PushGroupsBenchmark);
+  BENCHMARK_CASE(PushWithLimitBenchmark);
+  BENCHMARK_CASE(UndoRedoBenchmark);
+
+} // anonymous namespace
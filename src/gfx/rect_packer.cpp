@@ -0,0 +1,172 @@
+// Aseprite Gfx Library
+// Copyright (C) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gfx/rect_packer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+MaxRectsBin::MaxRectsBin(int width, int height)
+{
+  m_freeRects.push_back(Rect(0, 0, width, height));
+}
+
+bool MaxRectsBin::insert(const Size& size, Rect& bounds)
+{
+  int best = -1;
+
+  for (int i=0; i<(int)m_freeRects.size(); ++i) {
+    const Rect& rc = m_freeRects[i];
+    if (rc.w < size.w || rc.h < size.h)
+      continue;
+
+    // Bottom-left rule: lowest bottom side, then the leftmost one.
+    if (best < 0 ||
+        rc.y+size.h < m_freeRects[best].y+size.h ||
+        (rc.y == m_freeRects[best].y && rc.x < m_freeRects[best].x))
+      best = i;
+  }
+
+  if (best < 0)
+    return false;
+
+  bounds = Rect(m_freeRects[best].x, m_freeRects[best].y, size.w, size.h);
+  m_usedBounds = m_usedBounds.createUnion(bounds);
+
+  splitFreeRects(bounds);
+  pruneFreeRects();
+  return true;
+}
+
+// Unlike Rect::intersects(), rectangles that share an edge don't
+// overlap.
+static bool overlaps(const Rect& a, const Rect& b)
+{
+  return (a.x < b.x2() && b.x < a.x2() &&
+          a.y < b.y2() && b.y < a.y2());
+}
+
+// Replaces each free rectangle that intersects "used" with the
+// maximal rectangles around "used".
+void MaxRectsBin::splitFreeRects(const Rect& used)
+{
+  std::vector<Rect> newRects;
+
+  for (int i=0; i<(int)m_freeRects.size(); ) {
+    Rect rc = m_freeRects[i];
+    if (!overlaps(rc, used)) {
+      ++i;
+      continue;
+    }
+
+    if (used.x > rc.x)
+      newRects.push_back(Rect(rc.x, rc.y, used.x-rc.x, rc.h));
+    if (used.x2() < rc.x2())
+      newRects.push_back(Rect(used.x2(), rc.y, rc.x2()-used.x2(), rc.h));
+    if (used.y > rc.y)
+      newRects.push_back(Rect(rc.x, rc.y, rc.w, used.y-rc.y));
+    if (used.y2() < rc.y2())
+      newRects.push_back(Rect(rc.x, used.y2(), rc.w, rc.y2()-used.y2()));
+
+    m_freeRects.erase(m_freeRects.begin()+i);
+  }
+
+  m_freeRects.insert(m_freeRects.end(), newRects.begin(), newRects.end());
+}
+
+// Removes free rectangles that are inside other free rectangles.
+void MaxRectsBin::pruneFreeRects()
+{
+  for (int i=0; i<(int)m_freeRects.size(); ++i) {
+    for (int j=i+1; j<(int)m_freeRects.size(); ) {
+      if (m_freeRects[j].contains(m_freeRects[i])) {
+        m_freeRects.erase(m_freeRects.begin()+i);
+        --i;
+        break;
+      }
+      else if (m_freeRects[i].contains(m_freeRects[j]))
+        m_freeRects.erase(m_freeRects.begin()+j);
+      else
+        ++j;
+    }
+  }
+}
+
+namespace {
+
+  // Sorts indexes of sizes by height (the tallest first) and then by
+  // width, which gives better results with the bottom-left rule.
+  class TallerFirst {
+  public:
+    TallerFirst(const std::vector<Size>& sizes) : m_sizes(sizes) { }
+    bool operator()(int a, int b) const {
+      if (m_sizes[a].h != m_sizes[b].h)
+        return m_sizes[a].h > m_sizes[b].h;
+      else
+        return m_sizes[a].w > m_sizes[b].w;
+    }
+  private:
+    const std::vector<Size>& m_sizes;
+  };
+
+}
+
+Size pack_rects(const std::vector<Size>& sizes, std::vector<Rect>& bounds)
+{
+  std::vector<int> order;
+  int maxWidth = 0;
+  int totalHeight = 0;
+  double totalArea = 0.0;
+
+  for (int i=0; i<(int)sizes.size(); ++i) {
+    if (sizes[i].w <= 0 || sizes[i].h <= 0)
+      continue;
+
+    order.push_back(i);
+    maxWidth = std::max(maxWidth, sizes[i].w);
+    totalHeight += sizes[i].h;
+    totalArea += double(sizes[i].w) * sizes[i].h;
+  }
+
+  std::sort(order.begin(), order.end(), TallerFirst(sizes));
+
+  // Try bins wider than a square of the total area, the bin height is
+  // never a limit.
+  static const double factors[] = { 1.0, 1.125, 1.25, 1.5, 2.0 };
+  int minWidth = std::max(maxWidth, (int)std::ceil(std::sqrt(totalArea)));
+  Size bestSize;
+  std::vector<Rect> bestBounds;
+
+  for (int f=0; f<int(sizeof(factors)/sizeof(factors[0])); ++f) {
+    int width = std::max(maxWidth, int(minWidth * factors[f]));
+    MaxRectsBin bin(width, totalHeight);
+    std::vector<Rect> rects(sizes.size());
+
+    // The bin is as tall as all rectangles together, so each one has
+    // a place.
+    for (int i=0; i<(int)order.size(); ++i)
+      bin.insert(sizes[order[i]], rects[order[i]]);
+
+    Size size(bin.getUsedBounds().x2(), bin.getUsedBounds().y2());
+    if (bestBounds.empty() ||
+        size.w*size.h < bestSize.w*bestSize.h) {
+      bestSize = size;
+      bestBounds = rects;
+    }
+  }
+
+  bounds = bestBounds;
+  bounds.resize(sizes.size());
+  return bestSize;
+}
+
+} // namespace gfx
@@ -0,0 +1,47 @@
+// Aseprite Gfx Library
+// Copyright (C) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifndef GFX_RECT_PACKER_H_INCLUDED
+#define GFX_RECT_PACKER_H_INCLUDED
+
+#include "gfx/point.h"
+#include "gfx/rect.h"
+#include "gfx/size.h"
+
+#include <vector>
+
+namespace gfx {
+
+  // Bin to place rectangles using the MaxRects algorithm: it keeps
+  // the list of maximal free rectangles, and each new rectangle is
+  // placed in the free position nearest to the top-left corner.
+  class MaxRectsBin {
+  public:
+    MaxRectsBin(int width, int height);
+
+    // Finds a place for a rectangle of the given size. Returns false
+    // if there is no space for it.
+    bool insert(const Size& size, Rect& bounds);
+
+    // Returns the area used by all inserted rectangles.
+    const Rect& getUsedBounds() const { return m_usedBounds; }
+
+  private:
+    void splitFreeRects(const Rect& used);
+    void pruneFreeRects();
+
+    std::vector<Rect> m_freeRects;
+    Rect m_usedBounds;
+  };
+
+  // Packs rectangles of the given sizes (empty ones are not packed)
+  // trying several bin widths, and returns the size of the smallest
+  // bin. "bounds" receives the position of each rectangle.
+  Size pack_rects(const std::vector<Size>& sizes, std::vector<Rect>& bounds);
+
+} // namespace gfx
+
+#endif
@@ -0,0 +1,105 @@
+// Aseprite Gfx Library
+// Copyright (C) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#include <gtest/gtest.h>
+
+#include "gfx/rect_packer.h"
+
+#include <cstdlib>
+
+using namespace gfx;
+
+static void expect_valid_packing(const std::vector<Size>& sizes,
+                                 const std::vector<Rect>& bounds,
+                                 const Size& binSize)
+{
+  ASSERT_EQ(sizes.size(), bounds.size());
+
+  for (size_t i=0; i<sizes.size(); ++i) {
+    if (sizes[i].w <= 0 || sizes[i].h <= 0) {
+      EXPECT_TRUE(bounds[i].isEmpty());
+      continue;
+    }
+
+    EXPECT_EQ(sizes[i].w, bounds[i].w);
+    EXPECT_EQ(sizes[i].h, bounds[i].h);
+    EXPECT_TRUE(Rect(0, 0, binSize.w, binSize.h).contains(bounds[i]));
+
+    for (size_t j=i+1; j<sizes.size(); ++j)
+      EXPECT_TRUE(bounds[i].createIntersect(bounds[j]).isEmpty());
+  }
+}
+
+TEST(RectPacker, Bin)
+{
+  MaxRectsBin bin(10, 10);
+  Rect a, b, c;
+
+  EXPECT_TRUE(bin.insert(Size(6, 10), a));
+  EXPECT_TRUE(bin.insert(Size(4, 5), b));
+  EXPECT_TRUE(bin.insert(Size(4, 5), c));
+  EXPECT_FALSE(bin.insert(Size(1, 1), c));
+
+  EXPECT_EQ(0, a.x); EXPECT_EQ(0, a.y);
+  EXPECT_EQ(6, b.x); EXPECT_EQ(0, b.y);
+  EXPECT_EQ(6, c.x); EXPECT_EQ(5, c.y);
+  EXPECT_EQ(10, bin.getUsedBounds().w);
+  EXPECT_EQ(10, bin.getUsedBounds().h);
+}
+
+TEST(RectPacker, EqualSquares)
+{
+  std::vector<Size> sizes(16, Size(8, 8));
+  std::vector<Rect> bounds;
+  Size size = pack_rects(sizes, bounds);
+
+  EXPECT_EQ(32, size.w);
+  EXPECT_EQ(32, size.h);
+  expect_valid_packing(sizes, bounds, size);
+}
+
+TEST(RectPacker, EmptySizes)
+{
+  std::vector<Size> sizes;
+  std::vector<Rect> bounds;
+  Size size = pack_rects(sizes, bounds);
+  EXPECT_EQ(0, size.w);
+  EXPECT_EQ(0, size.h);
+  EXPECT_TRUE(bounds.empty());
+
+  sizes.push_back(Size(0, 0));
+  sizes.push_back(Size(5, 3));
+  sizes.push_back(Size(0, 7));
+  size = pack_rects(sizes, bounds);
+  EXPECT_EQ(5, size.w);
+  EXPECT_EQ(3, size.h);
+  expect_valid_packing(sizes, bounds, size);
+}
+
+TEST(RectPacker, RandomSizes)
+{
+  std::srand(1);
+
+  std::vector<Size> sizes;
+  int area = 0;
+  for (int i=0; i<200; ++i) {
+    sizes.push_back(Size(1 + std::rand() % 40, 1 + std::rand() % 40));
+    area += sizes.back().w * sizes.back().h;
+  }
+
+  std::vector<Rect> bounds;
+  Size size = pack_rects(sizes, bounds);
+  expect_valid_packing(sizes, bounds, size);
+
+  // The packing should waste less than a third of the sheet.
+  EXPECT_LT(size.w * size.h, area * 3 / 2);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
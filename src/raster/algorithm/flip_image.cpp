@@ -25,19 +25,47 @@
 #include "base/unique_ptr.h"
 #include "gfx/rect.h"
 #include "raster/image.h"
+#include "raster/image_traits.h"
 #include "raster/mask.h"
 #include "raster/primitives.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace raster {
 namespace algorithm {
 
+namespace {
+
+template<typename ImageTraits>
+void flip_rows_horizontally(Image* image, const gfx::Rect& bounds)
+{
+  typedef typename ImageTraits::pixel_t pixel_t;
+
+  for (int y=bounds.y; y<bounds.y+bounds.h; ++y) {
+    pixel_t* address = (pixel_t*)image->getPixelAddress(bounds.x, y);
+    std::reverse(address, address+bounds.w);
+  }
+}
+
+} // anonymous namespace
+
 void flip_image(Image* image, const gfx::Rect& bounds, FlipType flipType)
 {
   switch (flipType) {
 
     case FlipHorizontal:
+      // Fast path: reverse each row in-place when the whole bounds
+      // is inside the image.
+      if (image->getBounds().contains(bounds)) {
+        switch (image->getPixelFormat()) {
+          case IMAGE_RGB:       flip_rows_horizontally<RgbTraits>(image, bounds); return;
+          case IMAGE_GRAYSCALE: flip_rows_horizontally<GrayscaleTraits>(image, bounds); return;
+          case IMAGE_INDEXED:   flip_rows_horizontally<IndexedTraits>(image, bounds); return;
+          default: break;
+        }
+      }
+
       for (int y=bounds.y; y<bounds.y+bounds.h; ++y) {
         int u = bounds.x+bounds.w-1;
         for (int x=bounds.x; x<bounds.x+bounds.w/2; ++x, --u) {
@@ -27,124 +27,219 @@
 #include "raster/palette.h"
 #include "raster/rgbmap.h"
 
+#include <vector>
+
 namespace raster {
 namespace algorithm {
 
+namespace {
+
+  // Source coordinate and 8-bit fractional weight of each destination
+  // column/row for bilinear interpolation.
+  struct BilinearSample {
+    int i1, i2;                 // Source pixels to interpolate
+    int f;                      // Weight of "i2" (0-256)
+  };
+
+  void calc_bilinear_samples(int srcSize, int dstSize, int i, BilinearSample& sample)
+  {
+    double d = (dstSize > 1 ? (srcSize-1) * 1.0 / (dstSize-1): 0.0);
+    double u = i * d;
+
+    sample.i1 = MID(0, (int)u, srcSize-1);
+    sample.i2 = MIN(sample.i1+1, srcSize-1);
+    sample.f = MID(0, (int)((u - sample.i1) * 256.0), 256);
+  }
+
+  // Nearest-neighbor for RGB/Grayscale/Indexed images (direct access
+  // to rows instead of getPixel/putPixel calls).
+  template<class Traits>
+  void resize_nearest_rows(const Image* src, Image* dst, int y1, int y2)
+  {
+    typedef typename Traits::pixel_t pixel_t;
+    int srcW = src->getWidth(), srcH = src->getHeight();
+    int dstW = dst->getWidth(), dstH = dst->getHeight();
+    std::vector<int> cols(dstW);
+
+    for (int x=0; x<dstW; ++x)
+      cols[x] = MIN((int)((double)x * srcW / dstW), srcW-1);
+
+    for (int y=y1; y<y2; ++y) {
+      int v = MIN((int)((double)y * srcH / dstH), srcH-1);
+      const pixel_t* srcRow = (const pixel_t*)src->getPixelAddress(0, v);
+      pixel_t* dstRow = (pixel_t*)dst->getPixelAddress(0, y);
+
+      for (int x=0; x<dstW; ++x)
+        dstRow[x] = srcRow[cols[x]];
+    }
+  }
+
+  // Fixed-point bilinear interpolation. The color of each sample is
+  // weighted by its alpha, so fully transparent pixels don't bleed
+  // their (meaningless) RGB values into the result. This replaces the
+  // fixup_image_transparent_colors() pass over the source image.
+  template<class Traits>
+  struct BilinearPixel;
+
+  template<>
+  struct BilinearPixel<RgbTraits> {
+    static inline uint32_t interpolate(const uint32_t c[4], const int w[4],
+                                       const Palette*, const RgbMap*) {
+      int r = 0, g = 0, b = 0, k = 0;
+
+      for (int i=0; i<4; ++i) {
+        int ka = w[i] * rgba_geta(c[i]);
+        r += ka * rgba_getr(c[i]);
+        g += ka * rgba_getg(c[i]);
+        b += ka * rgba_getb(c[i]);
+        k += ka;
+      }
+
+      if (k == 0)
+        return 0;
+
+      return rgba((r + k/2) / k,
+                  (g + k/2) / k,
+                  (b + k/2) / k, (k + 128) >> 8);
+    }
+  };
+
+  template<>
+  struct BilinearPixel<GrayscaleTraits> {
+    static inline uint16_t interpolate(const uint16_t c[4], const int w[4],
+                                       const Palette*, const RgbMap*) {
+      int v = 0, k = 0;
+
+      for (int i=0; i<4; ++i) {
+        int ka = w[i] * graya_geta(c[i]);
+        v += ka * graya_getv(c[i]);
+        k += ka;
+      }
+
+      if (k == 0)
+        return 0;
+
+      return graya((v + k/2) / k, (k + 128) >> 8);
+    }
+  };
+
+  template<>
+  struct BilinearPixel<IndexedTraits> {
+    static inline uint8_t interpolate(const uint8_t c[4], const int w[4],
+                                      const Palette* pal, const RgbMap* rgbmap) {
+      int r = 0, g = 0, b = 0, a = 0;
+
+      for (int i=0; i<4; ++i) {
+        uint32_t entry = pal->getEntry(c[i]);
+        r += w[i] * rgba_getr(entry);
+        g += w[i] * rgba_getg(entry);
+        b += w[i] * rgba_getb(entry);
+        a += w[i] * (c[i] == 0 ? 0: 255);
+      }
+
+      return ((a >> 8) > 127 ? rgbmap->mapColor(r >> 8, g >> 8, b >> 8): 0);
+    }
+  };
+
+  template<class Traits>
+  void resize_bilinear_rows(const Image* src, Image* dst,
+                            const Palette* pal, const RgbMap* rgbmap,
+                            int y1, int y2)
+  {
+    typedef typename Traits::pixel_t pixel_t;
+    int dstW = dst->getWidth();
+    std::vector<BilinearSample> cols(dstW);
+
+    for (int x=0; x<dstW; ++x)
+      calc_bilinear_samples(src->getWidth(), dstW, x, cols[x]);
+
+    for (int y=y1; y<y2; ++y) {
+      BilinearSample row;
+      calc_bilinear_samples(src->getHeight(), dst->getHeight(), y, row);
+
+      const pixel_t* srcRow1 = (const pixel_t*)src->getPixelAddress(0, row.i1);
+      const pixel_t* srcRow2 = (const pixel_t*)src->getPixelAddress(0, row.i2);
+      pixel_t* dstRow = (pixel_t*)dst->getPixelAddress(0, y);
+      pixel_t c[4];
+      int w[4];
+
+      for (int x=0; x<dstW; ++x) {
+        const BilinearSample& col = cols[x];
+
+        c[0] = srcRow1[col.i1];
+        c[1] = srcRow1[col.i2];
+        c[2] = srcRow2[col.i1];
+        c[3] = srcRow2[col.i2];
+
+        // Weights of the four pixels (they sum 256).
+        w[0] = ((256-col.f) * (256-row.f)) >> 8;
+        w[1] = (col.f * (256-row.f)) >> 8;
+        w[2] = ((256-col.f) * row.f) >> 8;
+        w[3] = 256 - w[0] - w[1] - w[2];
+
+        dstRow[x] = BilinearPixel<Traits>::interpolate(c, w, pal, rgbmap);
+      }
+    }
+  }
+
+  // Generic version (used for bitmaps).
+  void resize_generic_rows(const Image* src, Image* dst, ResizeMethod method, int y1, int y2)
+  {
+    for (int y=y1; y<y2; ++y) {
+      for (int x=0; x<dst->getWidth(); ++x) {
+        if (method == RESIZE_METHOD_BILINEAR) {
+          BilinearSample col, row;
+          calc_bilinear_samples(src->getWidth(), dst->getWidth(), x, col);
+          calc_bilinear_samples(src->getHeight(), dst->getHeight(), y, row);
+
+          int a = (((src->getPixel(col.i1, row.i1) ? 256-col.f: 0) +
+                    (src->getPixel(col.i2, row.i1) ? col.f: 0)) * (256-row.f) +
+                   ((src->getPixel(col.i1, row.i2) ? 256-col.f: 0) +
+                    (src->getPixel(col.i2, row.i2) ? col.f: 0)) * row.f);
+
+          dst->putPixel(x, y, (a >= 128*256 ? 1: 0));
+        }
+        else {
+          dst->putPixel(x, y, src->getPixel(MIN((int)((double)x * src->getWidth() / dst->getWidth()), src->getWidth()-1),
+                                            MIN((int)((double)y * src->getHeight() / dst->getHeight()), src->getHeight()-1)));
+        }
+      }
+    }
+  }
+
+} // anonymous namespace
+
 void resize_image(const Image* src, Image* dst, ResizeMethod method, const Palette* pal, const RgbMap* rgbmap)
 {
+  resize_image(src, dst, method, pal, rgbmap, 0, dst->getHeight());
+}
+
+void resize_image(const Image* src, Image* dst, ResizeMethod method, const Palette* pal, const RgbMap* rgbmap, int y1, int y2)
+{
+  ASSERT(src->getPixelFormat() == dst->getPixelFormat());
+
+  y1 = MAX(y1, 0);
+  y2 = MIN(y2, dst->getHeight());
+
   switch (method) {
 
-    // TODO optimize this
-    case RESIZE_METHOD_NEAREST_NEIGHBOR: {
-      uint32_t color;
-      double u, v, du, dv;
-      int x, y;
-
-      u = v = 0.0;
-      du = src->getWidth() * 1.0 / dst->getWidth();
-      dv = src->getHeight() * 1.0 / dst->getHeight();
-      for (y=0; y<dst->getHeight(); ++y) {
-        for (x=0; x<dst->getWidth(); ++x) {
-          color = src->getPixel(MID(0, u, src->getWidth()-1),
-                                MID(0, v, src->getHeight()-1));
-          dst->putPixel(x, y, color);
-          u += du;
-        }
-        u = 0.0;
-        v += dv;
+    case RESIZE_METHOD_NEAREST_NEIGHBOR:
+      switch (dst->getPixelFormat()) {
+        case IMAGE_RGB:       resize_nearest_rows<RgbTraits>(src, dst, y1, y2); break;
+        case IMAGE_GRAYSCALE: resize_nearest_rows<GrayscaleTraits>(src, dst, y1, y2); break;
+        case IMAGE_INDEXED:   resize_nearest_rows<IndexedTraits>(src, dst, y1, y2); break;
+        default:              resize_generic_rows(src, dst, method, y1, y2); break;
       }
       break;
-    }
 
-    // TODO optimize this
-    case RESIZE_METHOD_BILINEAR: {
-      uint32_t color[4], dst_color = 0;
-      double u, v, du, dv;
-      int u_floor, u_floor2;
-      int v_floor, v_floor2;
-      int x, y;
-
-      u = v = 0.0;
-      du = (src->getWidth()-1) * 1.0 / (dst->getWidth()-1);
-      dv = (src->getHeight()-1) * 1.0 / (dst->getHeight()-1);
-      for (y=0; y<dst->getHeight(); ++y) {
-        for (x=0; x<dst->getWidth(); ++x) {
-          u_floor = floor(u);
-          v_floor = floor(v);
-
-          if (u_floor > src->getWidth()-1) {
-            u_floor = src->getWidth()-1;
-            u_floor2 = src->getWidth()-1;
-          }
-          else if (u_floor == src->getWidth()-1)
-            u_floor2 = u_floor;
-          else
-            u_floor2 = u_floor+1;
-
-          if (v_floor > src->getHeight()-1) {
-            v_floor = src->getHeight()-1;
-            v_floor2 = src->getHeight()-1;
-          }
-          else if (v_floor == src->getHeight()-1)
-            v_floor2 = v_floor;
-          else
-            v_floor2 = v_floor+1;
-
-          // get the four colors
-          color[0] = src->getPixel(u_floor,  v_floor);
-          color[1] = src->getPixel(u_floor2, v_floor);
-          color[2] = src->getPixel(u_floor,  v_floor2);
-          color[3] = src->getPixel(u_floor2, v_floor2);
-
-          // calculate the interpolated color
-          double u1 = u - u_floor;
-          double v1 = v - v_floor;
-          double u2 = 1 - u1;
-          double v2 = 1 - v1;
-
-          switch (dst->getPixelFormat()) {
-            case IMAGE_RGB: {
-              int r = ((rgba_getr(color[0])*u2 + rgba_getr(color[1])*u1)*v2 +
-                       (rgba_getr(color[2])*u2 + rgba_getr(color[3])*u1)*v1);
-              int g = ((rgba_getg(color[0])*u2 + rgba_getg(color[1])*u1)*v2 +
-                       (rgba_getg(color[2])*u2 + rgba_getg(color[3])*u1)*v1);
-              int b = ((rgba_getb(color[0])*u2 + rgba_getb(color[1])*u1)*v2 +
-                       (rgba_getb(color[2])*u2 + rgba_getb(color[3])*u1)*v1);
-              int a = ((rgba_geta(color[0])*u2 + rgba_geta(color[1])*u1)*v2 +
-                       (rgba_geta(color[2])*u2 + rgba_geta(color[3])*u1)*v1);
-              dst_color = rgba(r, g, b, a);
-              break;
-            }
-            case IMAGE_GRAYSCALE: {
-              int v = ((graya_getv(color[0])*u2 + graya_getv(color[1])*u1)*v2 +
-                       (graya_getv(color[2])*u2 + graya_getv(color[3])*u1)*v1);
-              int a = ((graya_geta(color[0])*u2 + graya_geta(color[1])*u1)*v2 +
-                       (graya_geta(color[2])*u2 + graya_geta(color[3])*u1)*v1);
-              dst_color = graya(v, a);
-              break;
-            }
-            case IMAGE_INDEXED: {
-              int r = ((rgba_getr(pal->getEntry(color[0]))*u2 + rgba_getr(pal->getEntry(color[1]))*u1)*v2 +
-                       (rgba_getr(pal->getEntry(color[2]))*u2 + rgba_getr(pal->getEntry(color[3]))*u1)*v1);
-              int g = ((rgba_getg(pal->getEntry(color[0]))*u2 + rgba_getg(pal->getEntry(color[1]))*u1)*v2 +
-                       (rgba_getg(pal->getEntry(color[2]))*u2 + rgba_getg(pal->getEntry(color[3]))*u1)*v1);
-              int b = ((rgba_getb(pal->getEntry(color[0]))*u2 + rgba_getb(pal->getEntry(color[1]))*u1)*v2 +
-                       (rgba_getb(pal->getEntry(color[2]))*u2 + rgba_getb(pal->getEntry(color[3]))*u1)*v1);
-              int a = (((color[0] == 0 ? 0: 255)*u2 + (color[1] == 0 ? 0: 255)*u1)*v2 +
-                       ((color[2] == 0 ? 0: 255)*u2 + (color[3] == 0 ? 0: 255)*u1)*v1);
-              dst_color = a > 127 ? rgbmap->mapColor(r, g, b): 0;
-              break;
-            }
-          }
-
-          dst->putPixel(x, y, dst_color);
-          u += du;
-        }
-        u = 0.0;
-        v += dv;
+    case RESIZE_METHOD_BILINEAR:
+      switch (dst->getPixelFormat()) {
+        case IMAGE_RGB:       resize_bilinear_rows<RgbTraits>(src, dst, pal, rgbmap, y1, y2); break;
+        case IMAGE_GRAYSCALE: resize_bilinear_rows<GrayscaleTraits>(src, dst, pal, rgbmap, y1, y2); break;
+        case IMAGE_INDEXED:   resize_bilinear_rows<IndexedTraits>(src, dst, pal, rgbmap, y1, y2); break;
+        default:              resize_generic_rows(src, dst, method, y1, y2); break;
       }
       break;
-    }
 
   }
 }
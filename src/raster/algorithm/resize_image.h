@@ -35,11 +35,16 @@ namespace raster {
 
     // Resizes the source image 'src' to the destination image 'dst'.
     //
-    // Warning: If you are using the RESIZE_METHOD_BILINEAR, it is
-    // recommended to use 'fixup_image_transparent_colors' function
-    // over the source image 'src' BEFORE using this routine.
+    // The RESIZE_METHOD_BILINEAR weights colors by their alpha
+    // channel, so it is not necessary to use
+    // 'fixup_image_transparent_colors' over the source image 'src'.
     void resize_image(const Image* src, Image* dst, ResizeMethod method, const Palette* palette, const RgbMap* rgbmap);
 
+    // Same as above but it only generates rows [y1, y2) of 'dst'. It
+    // can be used to resize one image from several threads (each one
+    // generating a different range of rows).
+    void resize_image(const Image* src, Image* dst, ResizeMethod method, const Palette* palette, const RgbMap* rgbmap, int y1, int y2);
+
     // It does not modify the image to the human eye, but internally
     // tries to fixup all colors that are completelly transparent
     // (alpha = 0) with the average of its 4-neighbors.  Useful if you
@@ -22,6 +22,8 @@
 
 #include "raster/image.h"
 
+#include "base/mutex.h"
+#include "base/scoped_lock.h"
 #include "raster/algo.h"
 #include "raster/blend.h"
 #include "raster/image_impl.h"
@@ -32,6 +34,16 @@
 
 namespace raster {
 
+// Images are created from different threads.
+static base::mutex stamp_mutex;
+static uint32_t stamp_counter = 0;
+
+static uint32_t new_stamp()
+{
+  base::scoped_lock hold(stamp_mutex);
+  return ++stamp_counter;
+}
+
 Image::Image(PixelFormat format, int width, int height)
   : Object(OBJECT_IMAGE)
   , m_format(format)
@@ -39,6 +51,12 @@ Image::Image(PixelFormat format, int width, int height)
   m_width = width;
   m_height = height;
   m_maskColor = 0;
+  m_stamp = new_stamp();
+}
+
+void Image::markAsModified()
+{
+  m_stamp = new_stamp();
 }
 
 Image::~Image()
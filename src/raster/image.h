@@ -20,6 +20,7 @@
 #define RASTER_IMAGE_H_INCLUDED
 
 #include "base/compiler_specific.h"
+#include "gfx/point.h"
 #include "gfx/rect.h"
 #include "gfx/size.h"
 #include "raster/blend.h"
@@ -58,6 +59,14 @@ namespace raster {
     color_t getMaskColor() const { return m_maskColor; }
     void setMaskColor(color_t c) { m_maskColor = c; }
 
+    // Stamp of the current pixels: each new image has a unique stamp,
+    // and markAsModified() gives a new one. Code that modifies pixels
+    // of images of a document must call markAsModified() (undoers do
+    // it), so snapshots can share the pixels of unmodified images.
+    uint32_t getModificationStamp() const { return m_stamp; }
+    void setModificationStamp(uint32_t stamp) { m_stamp = stamp; }
+    void markAsModified();
+
     int getMemSize() const OVERRIDE;
     int getRowStrideSize() const;
     int getRowStrideSize(int pixels_per_row) const;
@@ -85,7 +94,8 @@ namespace raster {
     virtual void putPixel(int x, int y, color_t color) = 0;
     virtual void clear(color_t color) = 0;
     virtual void copy(const Image* src, int x, int y) = 0;
-    virtual void merge(const Image* src, int x, int y, int opacity, int blend_mode) = 0;
+    // Merges "src" at x,y changing only the pixels inside "clip".
+    virtual void merge(const Image* src, int x, int y, const gfx::Rect& clip, int opacity, int blend_mode) = 0;
     virtual void drawHLine(int x1, int y, int x2, color_t color) = 0;
     virtual void fillRect(int x1, int y1, int x2, int y2, color_t color) = 0;
     virtual void blendRect(int x1, int y1, int x2, int y2, color_t color, int opacity) = 0;
@@ -98,6 +108,7 @@ namespace raster {
     int m_width;
     int m_height;
     color_t m_maskColor;  // Skipped color in merge process.
+    uint32_t m_stamp;     // See getModificationStamp()
   };
 
 } // namespace raster
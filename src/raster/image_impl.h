@@ -165,7 +165,7 @@ namespace raster {
       }
     }
 
-    void merge(const Image* _src, int x, int y, int opacity, int blend_mode) OVERRIDE {
+    void merge(const Image* _src, int x, int y, const gfx::Rect& clip, int opacity, int blend_mode) OVERRIDE {
       BLEND_COLOR blender = Traits::get_blender(blend_mode);
       const ImageImpl<Traits>* src = (const ImageImpl<Traits>*)_src;
       ImageImpl<Traits>* dst = this;
@@ -181,6 +181,7 @@ namespace raster {
 
       // clipping
 
+      gfx::Rect bounds = clip.createIntersect(dst->getBounds());
       xsrc = 0;
       ysrc = 0;
 
@@ -189,25 +190,26 @@ namespace raster {
       xend = x+src->getWidth()-1;
       yend = y+src->getHeight()-1;
 
-      if ((xend < 0) || (xbeg >= dst->getWidth()) ||
-          (yend < 0) || (ybeg >= dst->getHeight()))
+      if (bounds.isEmpty() ||
+          (xend < bounds.x) || (xbeg >= bounds.x2()) ||
+          (yend < bounds.y) || (ybeg >= bounds.y2()))
         return;
 
-      if (xbeg < 0) {
-        xsrc -= xbeg;
-        xbeg = 0;
+      if (xbeg < bounds.x) {
+        xsrc += bounds.x - xbeg;
+        xbeg = bounds.x;
       }
 
-      if (ybeg < 0) {
-        ysrc -= ybeg;
-        ybeg = 0;
+      if (ybeg < bounds.y) {
+        ysrc += bounds.y - ybeg;
+        ybeg = bounds.y;
       }
 
-      if (xend >= dst->getWidth())
-        xend = dst->getWidth()-1;
+      if (xend >= bounds.x2())
+        xend = bounds.x2()-1;
 
-      if (yend >= dst->getHeight())
-        yend = dst->getHeight()-1;
+      if (yend >= bounds.y2())
+        yend = bounds.y2()-1;
 
       // Merge process
 
@@ -294,7 +296,7 @@ namespace raster {
   }
 
   template<>
-  inline void ImageImpl<IndexedTraits>::merge(const Image* src, int x, int y, int opacity, int blend_mode) {
+  inline void ImageImpl<IndexedTraits>::merge(const Image* src, int x, int y, const gfx::Rect& clip, int opacity, int blend_mode) {
     Image* dst = this;
     address_t src_address;
     address_t dst_address;
@@ -303,6 +305,7 @@ namespace raster {
 
     // clipping
 
+    gfx::Rect bounds = clip.createIntersect(dst->getBounds());
     xsrc = 0;
     ysrc = 0;
 
@@ -311,25 +314,26 @@ namespace raster {
     xend = x+src->getWidth()-1;
     yend = y+src->getHeight()-1;
 
-    if ((xend < 0) || (xbeg >= dst->getWidth()) ||
-        (yend < 0) || (ybeg >= dst->getHeight()))
+    if (bounds.isEmpty() ||
+        (xend < bounds.x) || (xbeg >= bounds.x2()) ||
+        (yend < bounds.y) || (ybeg >= bounds.y2()))
       return;
 
-    if (xbeg < 0) {
-      xsrc -= xbeg;
-      xbeg = 0;
+    if (xbeg < bounds.x) {
+      xsrc += bounds.x - xbeg;
+      xbeg = bounds.x;
     }
 
-    if (ybeg < 0) {
-      ysrc -= ybeg;
-      ybeg = 0;
+    if (ybeg < bounds.y) {
+      ysrc += bounds.y - ybeg;
+      ybeg = bounds.y;
     }
 
-    if (xend >= dst->getWidth())
-      xend = dst->getWidth()-1;
+    if (xend >= bounds.x2())
+      xend = bounds.x2()-1;
 
-    if (yend >= dst->getHeight())
-      yend = dst->getHeight()-1;
+    if (yend >= bounds.y2())
+      yend = bounds.y2()-1;
 
     // merge process
 
@@ -419,13 +423,14 @@ namespace raster {
   }
 
   template<>
-  inline void ImageImpl<BitmapTraits>::merge(const Image* src, int x, int y, int opacity, int blend_mode) {
+  inline void ImageImpl<BitmapTraits>::merge(const Image* src, int x, int y, const gfx::Rect& clip, int opacity, int blend_mode) {
     Image* dst = this;
     int xbeg, xend, xsrc, xdst;
     int ybeg, yend, ysrc, ydst;
 
     // clipping
 
+    gfx::Rect bounds = clip.createIntersect(dst->getBounds());
     xsrc = 0;
     ysrc = 0;
 
@@ -434,25 +439,26 @@ namespace raster {
     xend = x+src->getWidth()-1;
     yend = y+src->getHeight()-1;
 
-    if ((xend < 0) || (xbeg >= dst->getWidth()) ||
-        (yend < 0) || (ybeg >= dst->getHeight()))
+    if (bounds.isEmpty() ||
+        (xend < bounds.x) || (xbeg >= bounds.x2()) ||
+        (yend < bounds.y) || (ybeg >= bounds.y2()))
       return;
 
-    if (xbeg < 0) {
-      xsrc -= xbeg;
-      xbeg = 0;
+    if (xbeg < bounds.x) {
+      xsrc += bounds.x - xbeg;
+      xbeg = bounds.x;
     }
 
-    if (ybeg < 0) {
-      ysrc -= ybeg;
-      ybeg = 0;
+    if (ybeg < bounds.y) {
+      ysrc += bounds.y - ybeg;
+      ybeg = bounds.y;
     }
 
-    if (xend >= dst->getWidth())
-      xend = dst->getWidth()-1;
+    if (xend >= bounds.x2())
+      xend = bounds.x2()-1;
 
-    if (yend >= dst->getHeight())
-      yend = dst->getHeight()-1;
+    if (yend >= bounds.y2())
+      yend = bounds.y2()-1;
 
     // merge process
 
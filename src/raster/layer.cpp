@@ -301,6 +301,12 @@ void LayerFolder::stackLayer(Layer* layer, Layer* after)
 }
 
 void layer_render(const Layer* layer, Image* image, int x, int y, FrameNumber frame)
+{
+  layer_render(layer, image, x, y, frame, image->getBounds());
+}
+
+void layer_render(const Layer* layer, Image* image, int x, int y, FrameNumber frame,
+                  const gfx::Rect& clip)
 {
   if (!layer->isReadable())
     return;
@@ -318,13 +324,16 @@ void layer_render(const Layer* layer, Image* image, int x, int y, FrameNumber fr
         src_image = layer->getSprite()->getStock()->getImage(cel->getImage());
         ASSERT(src_image != NULL);
 
-        src_image->setMaskColor(layer->getSprite()->getTransparentColor());
+        gfx::Rect celBounds(cel->getX() + x, cel->getY() + y,
+                            src_image->getWidth(), src_image->getHeight());
+        if (!clip.createIntersect(celBounds).isEmpty()) {
+          src_image->setMaskColor(layer->getSprite()->getTransparentColor());
 
-        composite_image(image, src_image,
-                        cel->getX() + x,
-                        cel->getY() + y,
-                        MID (0, cel->getOpacity(), 255),
-                        static_cast<const LayerImage*>(layer)->getBlendMode());
+          composite_image(image, src_image,
+                          celBounds.x, celBounds.y, clip,
+                          MID (0, cel->getOpacity(), 255),
+                          static_cast<const LayerImage*>(layer)->getBlendMode());
+        }
       }
       break;
     }
@@ -334,7 +343,7 @@ void layer_render(const Layer* layer, Image* image, int x, int y, FrameNumber fr
       LayerConstIterator end = static_cast<const LayerFolder*>(layer)->getLayerEnd();
 
       for (; it != end; ++it)
-        layer_render(*it, image, x, y, frame);
+        layer_render(*it, image, x, y, frame, clip);
 
       break;
     }
@@ -19,6 +19,7 @@
 #ifndef RASTER_LAYER_H_INCLUDED
 #define RASTER_LAYER_H_INCLUDED
 
+#include "gfx/fwd.h"
 #include "raster/blend.h"
 #include "raster/frame_number.h"
 #include "raster/object.h"
@@ -160,6 +161,11 @@ namespace raster {
 
   void layer_render(const Layer* layer, Image *image, int x, int y, FrameNumber frame);
 
+  // Like layer_render() but only the pixels of the image inside "clip"
+  // are modified (cels outside "clip" are skipped).
+  void layer_render(const Layer* layer, Image *image, int x, int y, FrameNumber frame,
+                    const gfx::Rect& clip);
+
 } // namespace raster
 
 #endif
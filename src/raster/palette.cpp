@@ -479,6 +479,12 @@ static void bestfit_init()
   }
 }
 
+// The table is filled before main() so findBestfit() can be used
+// from several threads at the same time.
+static struct BestfitInit {
+  BestfitInit() { bestfit_init(); }
+} bestfit_init_on_startup;
+
 int Palette::findBestfit(int r, int g, int b) const
 {
 #ifdef __GNUC__
@@ -492,9 +498,6 @@ int Palette::findBestfit(int r, int g, int b) const
   ASSERT(g >= 0 && g <= 255);
   ASSERT(b >= 0 && b <= 255);
 
-  if (col_diff[1] == 0)
-    bestfit_init();
-
   bestfit = 0;
   lowest = INT_MAX;
 
@@ -30,6 +30,7 @@
 #include "raster/pen.h"
 #include "raster/rgbmap.h"
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace raster {
@@ -84,7 +85,12 @@ void copy_image(Image* dst, const Image* src, int x, int y)
 
 void composite_image(Image* dst, const Image* src, int x, int y, int opacity, int blend_mode)
 {
-  dst->merge(src, x, y, opacity, blend_mode);
+  dst->merge(src, x, y, dst->getBounds(), opacity, blend_mode);
+}
+
+void composite_image(Image* dst, const Image* src, int x, int y, const gfx::Rect& clip, int opacity, int blend_mode)
+{
+  dst->merge(src, x, y, clip, opacity, blend_mode);
 }
 
 Image* crop_image(const Image* image, int x, int y, int w, int h, color_t bg, const ImageBufferPtr& buffer)
@@ -101,16 +107,62 @@ Image* crop_image(const Image* image, int x, int y, int w, int h, color_t bg, co
   return trim;
 }
 
-void rotate_image(const Image* src, Image* dst, int angle)
+namespace {
+
+// Size (in pixels) of the square tiles used to rotate +/-90 degrees,
+// so the reads from "src" and the writes to "dst" stay in cache.
+const int kRotateTileSize = 32;
+
+template<typename ImageTraits>
+void rotate_image_templ(const Image* src, Image* dst, int angle)
+{
+  typedef typename ImageTraits::pixel_t pixel_t;
+
+  int w = src->getWidth();
+  int h = src->getHeight();
+
+  if (angle == 180) {
+    for (int y=0; y<h; ++y) {
+      const pixel_t* s = (const pixel_t*)src->getPixelAddress(0, y);
+      pixel_t* d = (pixel_t*)dst->getPixelAddress(0, h-y-1);
+      std::reverse_copy(s, s+w, d);
+    }
+    return;
+  }
+
+  // +/-90: Each source row is a destination column, so we copy tiles
+  // of kRotateTileSize x kRotateTileSize pixels. The destination row
+  // pointers of each tile are calculated just one time.
+  pixel_t* dstRows[kRotateTileSize];
+
+  for (int ty=0; ty<h; ty+=kRotateTileSize) {
+    int ty2 = std::min(ty+kRotateTileSize, h);
+
+    for (int tx=0; tx<w; tx+=kRotateTileSize) {
+      int tx2 = std::min(tx+kRotateTileSize, w);
+      int tw = tx2-tx;
+
+      for (int i=0; i<tw; ++i)
+        dstRows[i] = (pixel_t*)dst->getPixelAddress(0, (angle == 90 ? tx+i: w-tx-i-1));
+
+      for (int y=ty; y<ty2; ++y) {
+        const pixel_t* s = (const pixel_t*)src->getPixelAddress(tx, y);
+        int u = (angle == 90 ? h-y-1: y);
+
+        for (int i=0; i<tw; ++i)
+          dstRows[i][u] = s[i];
+      }
+    }
+  }
+}
+
+void rotate_image_generic(const Image* src, Image* dst, int angle)
 {
   int x, y;
 
   switch (angle) {
 
     case 180:
-      ASSERT(dst->getWidth() == src->getWidth());
-      ASSERT(dst->getHeight() == src->getHeight());
-
       for (y=0; y<src->getHeight(); ++y)
         for (x=0; x<src->getWidth(); ++x)
           dst->putPixel(src->getWidth() - x - 1,
@@ -118,27 +170,49 @@ void rotate_image(const Image* src, Image* dst, int angle)
       break;
 
     case 90:
-      ASSERT(dst->getWidth() == src->getHeight());
-      ASSERT(dst->getHeight() == src->getWidth());
-
       for (y=0; y<src->getHeight(); ++y)
         for (x=0; x<src->getWidth(); ++x)
           dst->putPixel(src->getHeight() - y - 1, x, src->getPixel(x, y));
       break;
 
     case -90:
-      ASSERT(dst->getWidth() == src->getHeight());
-      ASSERT(dst->getHeight() == src->getWidth());
-
       for (y=0; y<src->getHeight(); ++y)
         for (x=0; x<src->getWidth(); ++x)
           dst->putPixel(y, src->getWidth() - x - 1, src->getPixel(x, y));
       break;
+  }
+}
+
+} // anonymous namespace
+
+void rotate_image(const Image* src, Image* dst, int angle)
+{
+  switch (angle) {
+
+    case 180:
+      ASSERT(dst->getWidth() == src->getWidth());
+      ASSERT(dst->getHeight() == src->getHeight());
+      break;
+
+    case 90:
+    case -90:
+      ASSERT(dst->getWidth() == src->getHeight());
+      ASSERT(dst->getHeight() == src->getWidth());
+      break;
 
     // bad angle
     default:
       throw std::invalid_argument("Invalid angle specified to rotate the image");
   }
+
+  ASSERT(dst->getPixelFormat() == src->getPixelFormat());
+
+  switch (src->getPixelFormat()) {
+    case IMAGE_RGB:       rotate_image_templ<RgbTraits>(src, dst, angle); break;
+    case IMAGE_GRAYSCALE: rotate_image_templ<GrayscaleTraits>(src, dst, angle); break;
+    case IMAGE_INDEXED:   rotate_image_templ<IndexedTraits>(src, dst, angle); break;
+    default:              rotate_image_generic(src, dst, angle); break;
+  }
 }
 
 void draw_hline(Image* image, int x1, int y, int x2, color_t color)
@@ -19,6 +19,7 @@
 #ifndef RASTER_PRIMITIVES_H_INCLUDED
 #define RASTER_PRIMITIVES_H_INCLUDED
 
+#include "gfx/fwd.h"
 #include "raster/color.h"
 #include "raster/image_buffer.h"
 
@@ -35,6 +36,7 @@ namespace raster {
 
   void copy_image(Image* dst, const Image* src, int x, int y);
   void composite_image(Image* dst, const Image* src, int x, int y, int opacity, int blend_mode);
+  void composite_image(Image* dst, const Image* src, int x, int y, const gfx::Rect& clip, int opacity, int blend_mode);
 
   Image* crop_image(const Image* image, int x, int y, int w, int h, color_t bg, const ImageBufferPtr& buffer = ImageBufferPtr());
   void rotate_image(const Image* src, Image* dst, int angle);
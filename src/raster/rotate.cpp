@@ -11,6 +11,7 @@
 #include "config.h"
 #endif
 
+#include "base/parallel_for.h"
 #include "raster/blend.h"
 #include "raster/image.h"
 #include "raster/image_bits.h"
@@ -19,6 +20,8 @@
 #include <allegro.h>
 #include <allegro/internal/aintern.h>
 #include <math.h>
+#include <string.h>
+#include <vector>
 
 #ifndef _AL_SINCOS
 #if defined (__i386__) && defined (__GNUC__)
@@ -30,7 +33,11 @@
 
 namespace raster {
 
-static void ase_parallelogram_map_standard(Image *bmp, Image *sprite, fixed xs[4], fixed ys[4]);
+// Number of scanlines drawn by each task when the parallelogram is
+// drawn from several threads.
+static const int kScanlinesPerTask = 32;
+
+static void ase_parallelogram_map_standard(Image *bmp, Image *sprite, fixed xs[4], fixed ys[4], int step);
 static void ase_rotate_scale_flip_coordinates(fixed w, fixed h,
                                               fixed x, fixed y,
                                               fixed cx, fixed cy,
@@ -87,7 +94,7 @@ void image_rotate(Image *dst, Image *src, int x, int y, int w, int h,
                                     fixdiv(itofix(h), itofix(src->getHeight())),
                                     false, false, xs, ys);
 
-  ase_parallelogram_map_standard (dst, src, xs, ys);
+  ase_parallelogram_map_standard (dst, src, xs, ys, 1);
 }
 
 /*    1-----2
@@ -96,7 +103,8 @@ void image_rotate(Image *dst, Image *src, int x, int y, int w, int h,
  */
 void image_parallelogram (Image *bmp, Image *sprite,
                           int x1, int y1, int x2, int y2,
-                          int x3, int y3, int x4, int y4)
+                          int x3, int y3, int x4, int y4,
+                          int step)
 {
   fixed xs[4], ys[4];
 
@@ -109,31 +117,130 @@ void image_parallelogram (Image *bmp, Image *sprite,
   xs[3] = itofix (x4);
   ys[3] = itofix (y4);
 
-  ase_parallelogram_map_standard (bmp, sprite, xs, ys);
+  ase_parallelogram_map_standard (bmp, sprite, xs, ys, step);
 }
 
+// Sprite readers.
+
+// Reads pixels directly from the rows of a sprite with the same pixel
+// format of the destination bitmap (avoiding one virtual call for
+// each pixel).
+template<class Traits>
+class DirectSpriteReader {
+public:
+  typedef typename Traits::pixel_t pixel_t;
+
+  DirectSpriteReader(const Image* spr) : m_rows(spr->getHeight()) {
+    for (int y=0; y<spr->getHeight(); ++y)
+      m_rows[y] = (const pixel_t*)spr->getPixelAddress(0, y);
+  }
+
+  color_t getPixel(int x, int y) const {
+    return m_rows[y][x];
+  }
+
+private:
+  std::vector<const pixel_t*> m_rows;
+};
+
+// Reads pixels from any kind of sprite.
+class GenericSpriteReader {
+public:
+  GenericSpriteReader(const Image* spr) : m_spr(spr) {
+  }
+
+  color_t getPixel(int x, int y) const {
+    return m_spr->getPixel(x, y);
+  }
+
+private:
+  const Image* m_spr;
+};
+
 // Scanline drawers.
 
-template<class Traits, class Delegate>
-static void draw_scanline(Image *bmp, Image *spr,
-                          fixed l_bmp_x, int bmp_y_i,
-                          fixed r_bmp_x,
-                          fixed l_spr_x, fixed l_spr_y,
-                          fixed spr_dx, fixed spr_dy)
+// Scanline to be drawn. The first row (bmp_y) is sampled from the
+// sprite, and it is copied in the following rows (rows > 1 only in
+// decimated mode).
+struct Scanline {
+  fixed l_bmp_x, r_bmp_x;
+  fixed l_spr_x, l_spr_y;
+  int bmp_y;
+  int rows;
+};
+
+template<class Traits, class Delegate, class Reader>
+static void draw_scanline(Image *bmp, const Reader& spr,
+                          const Scanline& scanline,
+                          fixed spr_dx, fixed spr_dy, int step)
 {
-  r_bmp_x >>= 16;
-  l_bmp_x >>= 16;
+  int l_bmp_x = scanline.l_bmp_x >> 16;
+  int r_bmp_x = scanline.r_bmp_x >> 16;
+  fixed l_spr_x = scanline.l_spr_x;
+  fixed l_spr_y = scanline.l_spr_y;
+
+  {
+    Delegate delegate(bmp, gfx::Rect(l_bmp_x, scanline.bmp_y, r_bmp_x - l_bmp_x + 1, 1));
+
+    if (step == 1) {
+      for (int x=l_bmp_x; x<=r_bmp_x; ++x) {
+        delegate.putPixel(spr.getPixel(l_spr_x>>16, l_spr_y>>16));
 
-  Delegate delegate(bmp, gfx::Rect(l_bmp_x, bmp_y_i, r_bmp_x - l_bmp_x + 1, 1));
+        l_spr_x += spr_dx;
+        l_spr_y += spr_dy;
+      }
+    }
+    else {
+      // Sample one of each "step" pixels.
+      color_t c = 0;
+      for (int x=l_bmp_x, i=0; x<=r_bmp_x; ++x, --i) {
+        if (i == 0) {
+          c = spr.getPixel(l_spr_x>>16, l_spr_y>>16);
+          i = step;
+        }
+        delegate.putPixel(c);
+
+        l_spr_x += spr_dx;
+        l_spr_y += spr_dy;
+      }
+    }
+  }
 
-  for (int x=(int)l_bmp_x; x<=(int)r_bmp_x; ++x) {
-    delegate.feedLine(spr, l_spr_x>>16, l_spr_y>>16);
+  // Copy the sampled row in the following ones.
+  if (scanline.rows > 1) {
+    int bytes = bmp->getRowStrideSize(r_bmp_x - l_bmp_x + 1);
+    const uint8_t* src_address = bmp->getPixelAddress(l_bmp_x, scanline.bmp_y);
 
-    l_spr_x += spr_dx;
-    l_spr_y += spr_dy;
+    for (int v=1; v<scanline.rows; ++v)
+      memcpy(bmp->getPixelAddress(l_bmp_x, scanline.bmp_y+v), src_address, bytes);
   }
 }
 
+// Functor used in base::parallel_for() to draw scanlines from several
+// threads (each scanline modifies different rows of "bmp").
+template<class Traits, class Delegate, class Reader>
+class DrawScanlines {
+public:
+  DrawScanlines(Image* bmp, const Reader& spr,
+                const std::vector<Scanline>& scanlines,
+                fixed spr_dx, fixed spr_dy, int step)
+    : m_bmp(bmp), m_spr(spr), m_scanlines(scanlines)
+    , m_spr_dx(spr_dx), m_spr_dy(spr_dy), m_step(step) {
+  }
+
+  void operator()(int i) const {
+    draw_scanline<Traits, Delegate, Reader>(m_bmp, m_spr, m_scanlines[i],
+                                            m_spr_dx, m_spr_dy, m_step);
+  }
+
+private:
+  Image* m_bmp;
+  const Reader& m_spr;
+  const std::vector<Scanline>& m_scanlines;
+  fixed m_spr_dx, m_spr_dy;
+  int m_step;
+};
+
 template<class Traits>
 class GenericDelegate {
 public:
@@ -158,10 +265,15 @@ public:
     m_blender(rgba_blenders[BLEND_MODE_NORMAL]) {
   }
 
-  void feedLine(Image* spr, int spr_x, int spr_y) {
+  void putPixel(color_t c) {
     ASSERT(m_it != m_end);
 
-    *m_it = m_blender(*m_it, spr->getPixel(spr_x, spr_y), 255);
+    // Fast paths for transparent and opaque pixels over transparent
+    // ones (the most common case when the bitmap was cleared).
+    if (rgba_geta(*m_it) == 0)
+      *m_it = c;
+    else if (rgba_geta(c) != 0)
+      *m_it = m_blender(*m_it, c, 255);
     ++m_it;
   }
 };
@@ -174,10 +286,10 @@ public:
     m_blender(graya_blenders[BLEND_MODE_NORMAL]) {
   }
 
-  void feedLine(Image* spr, int spr_x, int spr_y) {
+  void putPixel(color_t c) {
     ASSERT(m_it != m_end);
 
-    *m_it = m_blender(*m_it, spr->getPixel(spr_x, spr_y), 255);
+    *m_it = m_blender(*m_it, c, 255);
     ++m_it;
   }
 };
@@ -188,10 +300,9 @@ public:
     GenericDelegate<IndexedTraits>(bmp, bounds) {
   }
 
-  void feedLine(Image* spr, int spr_x, int spr_y) {
+  void putPixel(color_t c) {
     ASSERT(m_it != m_end);
 
-    register int c = spr->getPixel(spr_x, spr_y);
     if (c != 0)                 // TODO
       *m_it = c;
     ++m_it;
@@ -204,10 +315,9 @@ public:
     GenericDelegate<BitmapTraits>(bmp, bounds) {
   }
 
-  void feedLine(Image* spr, int spr_x, int spr_y) {
+  void putPixel(color_t c) {
     ASSERT(m_it != m_end);
 
-    register int c = spr->getPixel(spr_x, spr_y);
     if (c != 0)                 // TODO
       *m_it = c;
     ++m_it;
@@ -238,9 +348,9 @@ public:
  *  at least partly covered by the sprite. This is useful for doing
  *  anti-aliased blending.
  */
-template<class Traits, class Delegate>
+template<class Traits, class Delegate, class Reader>
 static void ase_parallelogram_map(Image *bmp, Image *spr, fixed xs[4], fixed ys[4],
-                                  int sub_pixel_accuracy)
+                                  int sub_pixel_accuracy, int step)
 {
   /* Index in xs[] and ys[] to topmost point. */
   int top_index;
@@ -283,6 +393,10 @@ static void ase_parallelogram_map(Image *bmp, Image *spr, fixed xs[4], fixed ys[
   int bmp_y_i;
   /* Right edge of scanline. */
   int right_edge_test;
+  /* First scanline (to know which ones are sampled in decimated mode). */
+  int first_bmp_y_i;
+  /* Scanlines to be drawn after all of them are calculated. */
+  std::vector<Scanline> scanlines;
 
   /* Get index of topmost point. */
   top_index = 0;
@@ -379,6 +493,9 @@ static void ase_parallelogram_map(Image *bmp, Image *spr, fixed xs[4], fixed ys[
   if (bmp_y_i >= clip_bottom_i)
     return;
 
+  first_bmp_y_i = bmp_y_i;
+  scanlines.reserve((clip_bottom_i - bmp_y_i + step - 1) / step);
+
   /* Vertical gap between top corner and centre of topmost scanline. */
   extra_scanline_fraction = (bmp_y_i << 16) + 0x8000 - top_bmp_y;
   /* Calculate x coordinate of beginning of scanline in bmp. */
@@ -521,8 +638,10 @@ static void ase_parallelogram_map(Image *bmp, Image *spr, fixed xs[4], fixed ys[
     if (r_bmp_x_rounded > clip_right)
       r_bmp_x_rounded = clip_right;
 
-    /* Draw! */
-    if (l_bmp_x_rounded <= r_bmp_x_rounded) {
+    /* Draw! (In decimated mode only one of each "step" scanlines is
+       sampled.) */
+    if ((l_bmp_x_rounded <= r_bmp_x_rounded) &&
+        ((bmp_y_i - first_bmp_y_i) % step) == 0) {
       if (!sub_pixel_accuracy) {
         /* The bodies of these ifs are only reached extremely seldom,
            it's an ugly hack to avoid reading outside the sprite when
@@ -611,10 +730,14 @@ static void ase_parallelogram_map(Image *bmp, Image *spr, fixed xs[4], fixed ys[
           }
         }
       }
-      draw_scanline<Traits, Delegate>(bmp, spr,
-                                      l_bmp_x_rounded, bmp_y_i, r_bmp_x_rounded,
-                                      l_spr_x_rounded, l_spr_y_rounded,
-                                      spr_dx, spr_dy);
+      Scanline scanline;
+      scanline.l_bmp_x = l_bmp_x_rounded;
+      scanline.r_bmp_x = r_bmp_x_rounded;
+      scanline.l_spr_x = l_spr_x_rounded;
+      scanline.l_spr_y = l_spr_y_rounded;
+      scanline.bmp_y = bmp_y_i;
+      scanline.rows = MIN(step, clip_bottom_i - bmp_y_i);
+      scanlines.push_back(scanline);
 
     }
     /* I'm not going to apoligize for this label and its gotos: to get
@@ -634,6 +757,14 @@ static void ase_parallelogram_map(Image *bmp, Image *spr, fixed xs[4], fixed ys[
     r_spr_y += r_spr_dy;
 #endif
   }
+
+  /* Draw all scanlines (each one modifies different rows, so they can
+     be drawn in parallel). */
+  Reader reader(spr);
+  base::parallel_for(0, (int)scanlines.size(),
+                     DrawScanlines<Traits, Delegate, Reader>(bmp, reader, scanlines,
+                                                             spr_dx, spr_dy, step),
+                     kScanlinesPerTask);
 }
 
 /* _parallelogram_map_standard:
@@ -643,24 +774,40 @@ static void ase_parallelogram_map(Image *bmp, Image *spr, fixed xs[4], fixed ys[
  *  your own scanline drawer, eg. for anti-aliased rotations.
  */
 static void ase_parallelogram_map_standard(Image *bmp, Image *sprite,
-                                           fixed xs[4], fixed ys[4])
+                                           fixed xs[4], fixed ys[4], int step)
 {
+  bool direct = (bmp->getPixelFormat() == sprite->getPixelFormat());
+
+  if (step < 1)
+    step = 1;
+
   switch (bmp->getPixelFormat()) {
 
     case IMAGE_RGB:
-      ase_parallelogram_map<RgbTraits, RgbDelegate>(bmp, sprite, xs, ys, false);
+      if (direct)
+        ase_parallelogram_map<RgbTraits, RgbDelegate, DirectSpriteReader<RgbTraits> >(bmp, sprite, xs, ys, false, step);
+      else
+        ase_parallelogram_map<RgbTraits, RgbDelegate, GenericSpriteReader>(bmp, sprite, xs, ys, false, step);
       break;
 
     case IMAGE_GRAYSCALE:
-      ase_parallelogram_map<GrayscaleTraits, GrayscaleDelegate>(bmp, sprite, xs, ys, false);
+      if (direct)
+        ase_parallelogram_map<GrayscaleTraits, GrayscaleDelegate, DirectSpriteReader<GrayscaleTraits> >(bmp, sprite, xs, ys, false, step);
+      else
+        ase_parallelogram_map<GrayscaleTraits, GrayscaleDelegate, GenericSpriteReader>(bmp, sprite, xs, ys, false, step);
       break;
 
     case IMAGE_INDEXED:
-      ase_parallelogram_map<IndexedTraits, IndexedDelegate>(bmp, sprite, xs, ys, false);
+      if (direct)
+        ase_parallelogram_map<IndexedTraits, IndexedDelegate, DirectSpriteReader<IndexedTraits> >(bmp, sprite, xs, ys, false, step);
+      else
+        ase_parallelogram_map<IndexedTraits, IndexedDelegate, GenericSpriteReader>(bmp, sprite, xs, ys, false, step);
       break;
 
     case IMAGE_BITMAP:
-      ase_parallelogram_map<BitmapTraits, BitmapDelegate>(bmp, sprite, xs, ys, false);
+      // Bitmaps are always drawn with full quality (rows are bit-packed,
+      // so they cannot be copied from the sampled ones).
+      ase_parallelogram_map<BitmapTraits, BitmapDelegate, GenericSpriteReader>(bmp, sprite, xs, ys, false, 1);
       break;
   }
 }
@@ -30,9 +30,15 @@ namespace raster {
                     int x, int y, int w, int h,
                     int cx, int cy, double angle);
 
+  // Draws the "sprite" transformed to the given parallelogram in
+  // "bmp". Scanlines are drawn from several threads. If "step" is
+  // greater than 1, only one of each "step" pixels and scanlines is
+  // sampled (and replicated), which is useful to show a fast (and
+  // low quality) preview of big images.
   void image_parallelogram(Image* bmp, Image* sprite,
                            int x1, int y1, int x2, int y2,
-                           int x3, int y3, int x4, int y4);
+                           int x3, int y3, int x4, int y4,
+                           int step = 1);
 
 } // namespace raster
 
@@ -360,6 +360,8 @@ void Sprite::remapImages(FrameNumber frameFrom, FrameNumber frameTo, const std::
     if (cel->getFrame() >= frameFrom &&
         cel->getFrame() <= frameTo) {
       Image* image = getStock()->getImage(cel->getImage());
+      image->markAsModified();
+
       LockImageBits<IndexedTraits> bits(image);
       LockImageBits<IndexedTraits>::iterator
         it = bits.begin(),
@@ -376,10 +378,19 @@ void Sprite::remapImages(FrameNumber frameFrom, FrameNumber frameTo, const std::
 
 void Sprite::render(Image* image, int x, int y, FrameNumber frame) const
 {
-  fill_rect(image, x, y, x+m_width-1, y+m_height-1,
+  render(image, x, y, frame, image->getBounds());
+}
+
+void Sprite::render(Image* image, int x, int y, FrameNumber frame, const gfx::Rect& clip) const
+{
+  gfx::Rect bounds = clip.createIntersect(gfx::Rect(x, y, m_width, m_height));
+  if (bounds.isEmpty())
+    return;
+
+  fill_rect(image, bounds.x, bounds.y, bounds.x2()-1, bounds.y2()-1,
             (m_format == IMAGE_INDEXED ? getTransparentColor(): 0));
 
-  layer_render(getFolder(), image, x, y, frame);
+  layer_render(getFolder(), image, x, y, frame, clip);
 }
 
 int Sprite::getPixel(int x, int y, FrameNumber frame) const
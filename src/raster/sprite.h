@@ -20,6 +20,7 @@
 #define RASTER_SPRITE_H_INCLUDED
 
 #include "base/disable_copying.h"
+#include "gfx/fwd.h"
 #include "raster/frame_number.h"
 #include "raster/layer_index.h"
 #include "raster/object.h"
@@ -130,6 +131,12 @@ namespace raster {
     // sprite.
     void render(Image* image, int x, int y, FrameNumber frame) const;
 
+    // Renders the frame at x,y but modifies only the pixels of the
+    // image inside "clip" (i.e. the "clip" area moved by -x,-y of the
+    // sprite is rendered). It doesn't need a temporary image to render
+    // a frame in a cell of a bigger image (e.g. a sprite sheet).
+    void render(Image* image, int x, int y, FrameNumber frame, const gfx::Rect& clip) const;
+
     // Gets a pixel from the sprite in the specified position. If in the
     // specified coordinates there're background this routine will
     // return the 0 color (the mask-color).
@@ -0,0 +1,71 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "raster/raster.h"
+
+using namespace raster;
+
+// A cel bigger than the sprite must not be drawn outside the clipping
+// rectangle (e.g. in the neighbor cell of a sprite sheet).
+TEST(Sprite, RenderWithClip)
+{
+  Sprite sprite(IMAGE_RGB, 4, 4, 256);
+  LayerImage* layer = new LayerImage(&sprite);
+  sprite.getFolder()->addLayer(layer);
+
+  Image* image = Image::create(IMAGE_RGB, 6, 6);
+  clear_image(image, rgba(255, 0, 0, 255));
+  Cel* cel = new Cel(FrameNumber(0), sprite.getStock()->addImage(image));
+  cel->setPosition(-1, -1);
+  layer->addCel(cel);
+
+  color_t white = rgba(255, 255, 255, 255);
+  Image* sheet = Image::create(IMAGE_RGB, 12, 4);
+  clear_image(sheet, white);
+
+  gfx::Rect cell(4, 0, 4, 4);
+  sprite.render(sheet, cell.x, cell.y, FrameNumber(0), cell);
+
+  for (int y=0; y<4; ++y) {
+    for (int x=0; x<12; ++x) {
+      if (cell.contains(gfx::Point(x, y)))
+        EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(sheet, x, y));
+      else
+        EXPECT_EQ(white, get_pixel(sheet, x, y));
+    }
+  }
+
+  // An empty clipping rectangle doesn't change anything.
+  clear_image(sheet, white);
+  sprite.render(sheet, 0, 0, FrameNumber(0), gfx::Rect(2, 2, 0, 0));
+  EXPECT_EQ(white, get_pixel(sheet, 2, 2));
+
+  delete sheet;
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
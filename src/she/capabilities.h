@@ -12,7 +12,12 @@ namespace she {
   enum Capabilities {
     kMultipleDisplaysCapability = 1,
     kCanResizeDisplayCapability = 2,
-    kDisplayScaleCapability = 4
+    kDisplayScaleCapability = 4,
+
+    // There is no real display or input devices (e.g. headless
+    // system for tests), so the program must advance its clock and
+    // inject the input.
+    kHeadlessCapability = 8
   };
 
 } // namespace she
@@ -7,12 +7,34 @@
 #ifndef SHE_EVENT_LOOP_H_INCLUDED
 #define SHE_EVENT_LOOP_H_INCLUDED
 
+#include "gfx/point.h"
+
+#include <vector>
+
 namespace she {
 
+  // Waits for input events (keyboard, mouse, display changes) without
+  // polling, so the UI thread doesn't use CPU while it's idle.
   class EventLoop {
   public:
     virtual ~EventLoop() { }
     virtual void dispose() = 0;
+
+    // Blocks the current thread until a new input event is received,
+    // wakeUp() is called, or "timeout" seconds elapse (a negative
+    // timeout waits forever). Returns immediately if some event was
+    // received after the previous call.
+    virtual void waitForEvents(double timeout) = 0;
+
+    // Wakes up the thread blocked in waitForEvents(). It can be called
+    // from any thread (e.g. from a background job).
+    virtual void wakeUp() = 0;
+
+    // Moves to "positions" all the mouse positions (in display
+    // coordinates) received since the previous call, the oldest
+    // first. Useful to get each intermediate point of fast mouse
+    // movements.
+    virtual void popMousePositions(std::vector<gfx::Point>& positions) = 0;
   };
 
 } // namespace she
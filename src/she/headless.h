@@ -0,0 +1,65 @@
+// SHE library
+// Copyright (C) 2012-2013  David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifndef SHE_HEADLESS_H_INCLUDED
+#define SHE_HEADLESS_H_INCLUDED
+
+#include "she/system.h"
+
+namespace she {
+
+  // Synthetic input event for the headless system.
+  struct HeadlessEvent {
+    enum Type {
+      MouseMove,                // Moves the mouse to (x, y)
+      MouseButtons,             // Changes pressed buttons (1=left, 2=right, 4=middle)
+      MouseWheel,               // Moves the wheel "z" steps
+      KeyDown,                  // Presses "scancode" (KEY_* constant) generating "unicodeChar"
+      KeyUp                     // Releases "scancode"
+    };
+
+    Type type;
+    int x, y;
+    int buttons;
+    int z;
+    int scancode;
+    int unicodeChar;
+
+    static HeadlessEvent mouseMove(int x, int y);
+    static HeadlessEvent mouseButtons(int buttons);
+    static HeadlessEvent mouseWheel(int z);
+    static HeadlessEvent keyDown(int scancode, int unicodeChar = 0);
+    static HeadlessEvent keyUp(int scancode);
+  };
+
+  // System without a real display or input devices, to run the UI
+  // in tests, benchmarks, or servers. Displays and surfaces are
+  // memory bitmaps, and the input is a queue of synthetic events: the
+  // EventLoop::waitForEvents() function applies the next event to the
+  // input state each time it's called (so the UI processes the events
+  // one by one, as if they came from the user).
+  //
+  // The UI clock (ui::ji_clock) isn't incremented automatically, the
+  // program can advance it to get deterministic timers.
+  class HeadlessSystem : public System {
+  public:
+    // Adds an event at the end of the queue. It can be called from
+    // any thread.
+    virtual void queueEvent(const HeadlessEvent& ev) = 0;
+
+    // Returns the number of events that weren't processed yet.
+    virtual int pendingEvents() const = 0;
+
+    // Returns the number of times that Display::flip() was called
+    // (useful to count repaints).
+    virtual int flipCount() const = 0;
+  };
+
+  HeadlessSystem* CreateHeadlessSystem();
+
+} // namespace she
+
+#endif
@@ -10,6 +10,10 @@
 
 #include "she.h"
 
+#include "base/condition_variable.h"
+#include "base/mutex.h"
+#include "base/scoped_lock.h"
+
 #include <allegro.h>
 #include <allegro/internal/aintern.h>
 #ifdef ALLEGRO_WINDOWS
@@ -26,10 +30,13 @@ static volatile int display_flags = 0;
 static volatile int original_width = 0;
 static volatile int original_height = 0;
 
+static void wake_up_event_loop();
+
 // Used by set_display_switch_callback(SWITCH_IN, ...).
 static void display_switch_in_callback()
 {
   display_flags |= DISPLAY_FLAG_FULL_REFRESH;
+  wake_up_event_loop();
 }
 
 END_OF_STATIC_FUNCTION(display_switch_in_callback);
@@ -43,6 +50,7 @@ static void resize_callback(RESIZE_DISPLAY_EVENT* ev)
     original_height = ev->old_h;
   }
   display_flags |= DISPLAY_FLAG_WINDOW_RESIZE;
+  wake_up_event_loop();
 }
 #endif // ALLEGRO4_WITH_RESIZE_PATCH
 
@@ -261,14 +269,88 @@ private:
 
 class Alleg4EventLoop : public EventLoop {
 public:
-  Alleg4EventLoop() {
+  Alleg4EventLoop() : m_events(false) {
+    ASSERT(g_event_loop == NULL);
+    g_event_loop = this;
+
+    // Allegro calls these hooks from its input thread each time a
+    // key is pressed/released or the mouse changes.
+    LOCK_FUNCTION(keyboard_hook);
+    LOCK_FUNCTION(mouse_hook);
+    keyboard_lowlevel_callback = keyboard_hook;
+    mouse_callback = mouse_hook;
+  }
+
+  ~Alleg4EventLoop() {
+    keyboard_lowlevel_callback = NULL;
+    mouse_callback = NULL;
+    g_event_loop = NULL;
   }
 
   void dispose() {
     delete this;
   }
+
+  void waitForEvents(double timeout) {
+    base::scoped_lock hold(m_mutex);
+
+    if (!m_events) {
+      if (timeout < 0.0)
+        m_cond.wait(hold);
+      else if (timeout > 0.0)
+        m_cond.wait_for(hold, timeout);
+    }
+
+    m_events = false;
+  }
+
+  void wakeUp() {
+    base::scoped_lock hold(m_mutex);
+    m_events = true;
+    m_cond.notify_one();
+  }
+
+  void popMousePositions(std::vector<gfx::Point>& positions) {
+    base::scoped_lock hold(m_mutex);
+    positions.insert(positions.end(), m_mousePositions.begin(), m_mousePositions.end());
+    m_mousePositions.clear();
+  }
+
+  static Alleg4EventLoop* g_event_loop;
+
+private:
+  static void keyboard_hook(int scancode) {
+    wake_up_event_loop();
+  }
+
+  static void mouse_hook(int flags) {
+    if ((flags & MOUSE_FLAG_MOVE) && g_event_loop)
+      g_event_loop->addMousePosition(gfx::Point((int)mouse_x, (int)mouse_y));
+
+    wake_up_event_loop();
+  }
+
+  void addMousePosition(const gfx::Point& pos) {
+    base::scoped_lock hold(m_mutex);
+
+    // Keep only the latest positions (e.g. if nobody calls
+    // popMousePositions()).
+    if (m_mousePositions.size() >= kMaxMousePositions)
+      m_mousePositions.erase(m_mousePositions.begin());
+
+    m_mousePositions.push_back(pos);
+  }
+
+  static const size_t kMaxMousePositions = 256;
+
+  base::mutex m_mutex;
+  base::condition_variable m_cond;
+  bool m_events;
+  std::vector<gfx::Point> m_mousePositions;
 };
 
+Alleg4EventLoop* Alleg4EventLoop::g_event_loop = NULL;
+
 class Alleg4System : public System {
 public:
   Alleg4System() {
@@ -326,6 +408,12 @@ System* Instance()
 
 }
 
+static void wake_up_event_loop()
+{
+  if (she::Alleg4EventLoop::g_event_loop)
+    she::Alleg4EventLoop::g_event_loop->wakeUp();
+}
+
 // It must be defined by the user program code.
 extern int app_main(int argc, char* argv[]);
 
@@ -0,0 +1,447 @@
+// SHE library
+// Copyright (C) 2012-2013  David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "she.h"
+#include "she/headless.h"
+
+#include "base/condition_variable.h"
+#include "base/mutex.h"
+#include "base/scoped_lock.h"
+
+#include <allegro.h>
+#include "loadpng.h"
+
+#include <cassert>
+#include <deque>
+
+// Without a keyboard driver, Allegro's keypressed()/ureadkey() need
+// these hooks to read the key buffer (where simulated keys are
+// added). They are called only when the buffer is empty.
+static int keypressed_hook()
+{
+  return FALSE;
+}
+
+static int readkey_hook()
+{
+  return 0;
+}
+
+namespace she {
+
+HeadlessEvent HeadlessEvent::mouseMove(int x, int y)
+{
+  HeadlessEvent ev = { MouseMove, x, y, 0, 0, 0, 0 };
+  return ev;
+}
+
+HeadlessEvent HeadlessEvent::mouseButtons(int buttons)
+{
+  HeadlessEvent ev = { MouseButtons, 0, 0, buttons, 0, 0, 0 };
+  return ev;
+}
+
+HeadlessEvent HeadlessEvent::mouseWheel(int z)
+{
+  HeadlessEvent ev = { MouseWheel, 0, 0, 0, z, 0, 0 };
+  return ev;
+}
+
+HeadlessEvent HeadlessEvent::keyDown(int scancode, int unicodeChar)
+{
+  HeadlessEvent ev = { KeyDown, 0, 0, 0, 0, scancode, unicodeChar };
+  return ev;
+}
+
+HeadlessEvent HeadlessEvent::keyUp(int scancode)
+{
+  HeadlessEvent ev = { KeyUp, 0, 0, 0, 0, scancode, 0 };
+  return ev;
+}
+
+class HeadlessSurface : public Surface
+                      , public LockedSurface {
+public:
+  enum DestroyFlag { NoDestroy, AutoDestroy };
+
+  HeadlessSurface(BITMAP* bmp, DestroyFlag destroy)
+    : m_bmp(bmp)
+    , m_destroy(destroy)
+  {
+  }
+
+  HeadlessSurface(int width, int height)
+    : m_bmp(create_bitmap(width, height))
+    , m_destroy(AutoDestroy)
+  {
+  }
+
+  ~HeadlessSurface() {
+    if (m_destroy == AutoDestroy)
+      destroy_bitmap(m_bmp);
+  }
+
+  // Surface implementation
+
+  void dispose() {
+    delete this;
+  }
+
+  int width() const {
+    return m_bmp->w;
+  }
+
+  int height() const {
+    return m_bmp->h;
+  }
+
+  LockedSurface* lock() {
+    return this;
+  }
+
+  void* nativeHandle() {
+    return reinterpret_cast<void*>(m_bmp);
+  }
+
+  // LockedSurface implementation
+
+  void unlock() {
+  }
+
+  void clear() {
+    clear_to_color(m_bmp, 0);
+  }
+
+  void blitTo(LockedSurface* dest, int srcx, int srcy, int dstx, int dsty, int width, int height) const {
+    ASSERT(m_bmp);
+    ASSERT(dest);
+    ASSERT(static_cast<HeadlessSurface*>(dest)->m_bmp);
+
+    blit(m_bmp,
+         static_cast<HeadlessSurface*>(dest)->m_bmp,
+         srcx, srcy,
+         dstx, dsty,
+         width, height);
+  }
+
+  void drawAlphaSurface(const LockedSurface* src, int dstx, int dsty) {
+    set_alpha_blender();
+    draw_trans_sprite(m_bmp, static_cast<const HeadlessSurface*>(src)->m_bmp, dstx, dsty);
+  }
+
+private:
+  BITMAP* m_bmp;
+  DestroyFlag m_destroy;
+};
+
+class HeadlessSystemImpl;
+
+class HeadlessDisplay : public Display {
+public:
+  HeadlessDisplay(HeadlessSystemImpl* system, int width, int height, int scale)
+    : m_system(system)
+    , m_surface(NULL)
+    , m_width(width)
+    , m_height(height)
+    , m_scale(0) {
+    setScale(scale);
+  }
+
+  ~HeadlessDisplay() {
+    m_surface->dispose();
+  }
+
+  void dispose() {
+    delete this;
+  }
+
+  int width() const {
+    return m_width;
+  }
+
+  int height() const {
+    return m_height;
+  }
+
+  int originalWidth() const {
+    return m_width;
+  }
+
+  int originalHeight() const {
+    return m_height;
+  }
+
+  void setScale(int scale) {
+    ASSERT(scale >= 1);
+
+    if (m_scale == scale)
+      return;
+
+    m_scale = scale;
+    Surface* newSurface = new HeadlessSurface(m_width/m_scale,
+                                              m_height/m_scale);
+    if (m_surface)
+      m_surface->dispose();
+    m_surface = newSurface;
+  }
+
+  NotDisposableSurface* getSurface() {
+    return static_cast<NotDisposableSurface*>(m_surface);
+  }
+
+  // The surface is the final image (there is no real screen).
+  bool flip();
+
+  void maximize() {
+  }
+
+  bool isMaximized() const {
+    return false;
+  }
+
+  void* nativeHandle() {
+    return NULL;
+  }
+
+private:
+  HeadlessSystemImpl* m_system;
+  Surface* m_surface;
+  int m_width;
+  int m_height;
+  int m_scale;
+};
+
+class HeadlessEventLoop : public EventLoop {
+public:
+  HeadlessEventLoop(HeadlessSystemImpl* system) : m_system(system) {
+  }
+
+  void dispose() {
+    delete this;
+  }
+
+  void waitForEvents(double timeout);
+  void wakeUp();
+  void popMousePositions(std::vector<gfx::Point>& positions);
+
+private:
+  HeadlessSystemImpl* m_system;
+};
+
+class HeadlessSystemImpl : public HeadlessSystem {
+public:
+  HeadlessSystemImpl()
+    : m_wakeUp(false)
+    , m_flips(0) {
+    // Without a system driver, Allegro doesn't need a display,
+    // keyboard, mouse, or timer (memory bitmaps work anyway).
+    install_allegro(SYSTEM_NONE, &errno, atexit);
+    set_uformat(U_UTF8);
+    set_color_depth(32);
+    install_keyboard_hooks(keypressed_hook, readkey_hook);
+
+    // Register PNG as a supported bitmap type
+    register_bitmap_file_type("png", load_png, save_png);
+  }
+
+  ~HeadlessSystemImpl() {
+    install_keyboard_hooks(NULL, NULL);
+    allegro_exit();
+  }
+
+  void dispose() {
+    delete this;
+  }
+
+  Capabilities capabilities() const {
+    return (Capabilities)(kCanResizeDisplayCapability |
+                          kHeadlessCapability);
+  }
+
+  Display* createDisplay(int width, int height, int scale) {
+    return new HeadlessDisplay(this, width, height, scale);
+  }
+
+  Surface* createSurface(int width, int height) {
+    return new HeadlessSurface(width, height);
+  }
+
+  Surface* createSurfaceFromNativeHandle(void* nativeHandle) {
+    return new HeadlessSurface(reinterpret_cast<BITMAP*>(nativeHandle),
+                               HeadlessSurface::AutoDestroy);
+  }
+
+  EventLoop* createEventLoop() {
+    return new HeadlessEventLoop(this);
+  }
+
+  // HeadlessSystem implementation
+
+  void queueEvent(const HeadlessEvent& ev) {
+    base::scoped_lock hold(m_mutex);
+    m_events.push_back(ev);
+    m_cond.notify_one();
+  }
+
+  int pendingEvents() const {
+    base::scoped_lock hold(m_mutex);
+    return (int)m_events.size();
+  }
+
+  int flipCount() const {
+    base::scoped_lock hold(m_mutex);
+    return m_flips;
+  }
+
+  void onFlip() {
+    base::scoped_lock hold(m_mutex);
+    ++m_flips;
+  }
+
+  // Event loop
+
+  void waitForEvents(double timeout) {
+    base::scoped_lock hold(m_mutex);
+
+    if (m_events.empty() && !m_wakeUp) {
+      if (timeout < 0.0)
+        m_cond.wait(hold);
+      else if (timeout > 0.0)
+        m_cond.wait_for(hold, timeout);
+    }
+
+    // Only one event each time, so the UI can see each change of the
+    // input state.
+    if (!m_events.empty()) {
+      processEvent(m_events.front());
+      m_events.pop_front();
+    }
+
+    m_wakeUp = false;
+  }
+
+  void wakeUp() {
+    base::scoped_lock hold(m_mutex);
+    m_wakeUp = true;
+    m_cond.notify_one();
+  }
+
+  void popMousePositions(std::vector<gfx::Point>& positions) {
+    base::scoped_lock hold(m_mutex);
+    positions.insert(positions.end(), m_mousePositions.begin(), m_mousePositions.end());
+    m_mousePositions.clear();
+  }
+
+private:
+  // Changes the Allegro input state that the UI polls. m_mutex must
+  // be locked.
+  void processEvent(const HeadlessEvent& ev) {
+    switch (ev.type) {
+
+      case HeadlessEvent::MouseMove:
+        mouse_x = ev.x;
+        mouse_y = ev.y;
+        mouse_pos = (ev.x << 16) | (ev.y & 0xffff);
+
+        if (m_mousePositions.size() >= kMaxMousePositions)
+          m_mousePositions.erase(m_mousePositions.begin());
+        m_mousePositions.push_back(gfx::Point(ev.x, ev.y));
+        break;
+
+      case HeadlessEvent::MouseButtons:
+        mouse_b = ev.buttons;
+        break;
+
+      case HeadlessEvent::MouseWheel:
+        mouse_z += ev.z;
+        break;
+
+      case HeadlessEvent::KeyDown:
+        key[ev.scancode] = -1;
+        updateKeyShifts();
+
+        // Modifiers aren't added to the key buffer
+        if (ev.scancode < KEY_MODIFIERS)
+          simulate_ukeypress(ev.unicodeChar, ev.scancode);
+        break;
+
+      case HeadlessEvent::KeyUp:
+        key[ev.scancode] = 0;
+        updateKeyShifts();
+        break;
+    }
+  }
+
+  void updateKeyShifts() {
+    int shifts = 0;
+    if (key[KEY_LSHIFT] || key[KEY_RSHIFT]) shifts |= KB_SHIFT_FLAG;
+    if (key[KEY_LCONTROL] || key[KEY_RCONTROL]) shifts |= KB_CTRL_FLAG;
+    if (key[KEY_ALT] || key[KEY_ALTGR]) shifts |= KB_ALT_FLAG;
+    key_shifts = shifts;
+  }
+
+  static const size_t kMaxMousePositions = 256;
+
+  mutable base::mutex m_mutex;
+  base::condition_variable m_cond;
+  std::deque<HeadlessEvent> m_events;
+  std::vector<gfx::Point> m_mousePositions;
+  bool m_wakeUp;
+  int m_flips;
+};
+
+bool HeadlessDisplay::flip()
+{
+  m_system->onFlip();
+  return true;
+}
+
+void HeadlessEventLoop::waitForEvents(double timeout)
+{
+  m_system->waitForEvents(timeout);
+}
+
+void HeadlessEventLoop::wakeUp()
+{
+  m_system->wakeUp();
+}
+
+void HeadlessEventLoop::popMousePositions(std::vector<gfx::Point>& positions)
+{
+  m_system->popMousePositions(positions);
+}
+
+static System* g_instance;
+
+HeadlessSystem* CreateHeadlessSystem() {
+  HeadlessSystem* system = new HeadlessSystemImpl();
+  g_instance = system;
+  return system;
+}
+
+System* CreateSystem() {
+  return CreateHeadlessSystem();
+}
+
+System* Instance()
+{
+  return g_instance;
+}
+
+}
+
+// It must be defined by the user program code.
+extern int app_main(int argc, char* argv[]);
+
+int main(int argc, char* argv[]) {
+  return app_main(argc, argv);
+}
+
+END_OF_MAIN();
@@ -132,15 +132,12 @@ void jdraw_text(BITMAP* bmp, FONT* font, const char *s, int x, int y,
 
   SETUP_ANTIALISING(font, bg_color, fill_bg);
 
-  textout_ex(bmp, font, tmp, x, y, to_system(fg_color), (fill_bg ? to_system(bg_color): -1));
+  ji_font_render_text(bmp, font, tmp, x, y, to_system(fg_color), (fill_bg ? to_system(bg_color): -1));
 
   if (hline_pos >= 0) {
-    c = ugetat(tmp, hline_pos);
-    usetat(tmp, hline_pos, 0);
-    hline_pos = text_length(font, tmp);
-    c = usetc(tmp, c);
-    usetc(tmp+c, 0);
-    c = text_length(font, tmp);
+    c = ji_font_char_pos(font, tmp, hline_pos+1);
+    hline_pos = ji_font_char_pos(font, tmp, hline_pos);
+    c -= hline_pos;
 
     rectfill(bmp, x+hline_pos,
              y+text_height(font),
@@ -15,13 +15,21 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
 #include "base/memory.h"
+#include "gfx/rect.h"
 #include "ui/font.h"
 #include "ui/intern.h"
 #include "ui/theme.h"
 
 namespace ui {
 
+static void font_cache_exit();
+
 FONT* ji_font_load(const char* filepathname)
 {
   FONT* f = ji_font_load_bmp(filepathname);
@@ -50,6 +58,302 @@ FONT* ji_font_load_bmp(const char* filepathname)
   return f;
 }
 
+void ji_font_destroy(FONT* f)
+{
+  ji_font_flush_cache(f);
+  destroy_font(f);
+}
+
+/**********************************************************************/
+/* Glyph atlas and text-run cache */
+/**********************************************************************/
+
+// Bitmap fonts (the ones imported by bitmapToFont()) are drawn from a
+// glyph atlas: all glyphs of the font packed in one 8-bit bitmap. A
+// text run is composed one time from the atlas into a 8-bit mask and
+// kept in a LRU cache (with its glyph positions), so drawing it again
+// is just one draw_character_ex() call, and measuring it is a lookup.
+
+namespace {
+
+const int kAtlasWidth = 256;
+const size_t kMaxTextRuns = 1024;
+
+class GlyphAtlas {
+public:
+  GlyphAtlas() : m_bmp(NULL), m_uniformHeight(true) { }
+
+  ~GlyphAtlas() {
+    if (m_bmp)
+      destroy_bitmap(m_bmp);
+  }
+
+  // Returns false if the font glyphs can't be packed in an atlas
+  // (e.g. color fonts with true-color glyphs).
+  bool build(FONT* f) {
+    std::vector<const void*> glyphs;
+    std::vector<gfx::Rect> rects;
+
+    if (f->vtable == font_vtable_color) {
+      for (FONT_COLOR_DATA* cf = (FONT_COLOR_DATA*)f->data; cf; cf = cf->next) {
+        for (int c=cf->begin; c<cf->end; ++c) {
+          BITMAP* g = cf->bitmaps[c - cf->begin];
+          if (bitmap_color_depth(g) != 8)
+            return false;
+
+          glyphs.push_back(g);
+          rects.push_back(gfx::Rect(0, 0, g->w, g->h));
+        }
+      }
+    }
+    else if (f->vtable == font_vtable_mono) {
+      for (FONT_MONO_DATA* mf = (FONT_MONO_DATA*)f->data; mf; mf = mf->next) {
+        for (int c=mf->begin; c<mf->end; ++c) {
+          FONT_GLYPH* g = mf->glyphs[c - mf->begin];
+          glyphs.push_back(g);
+          rects.push_back(gfx::Rect(0, 0, g->w, g->h));
+        }
+      }
+    }
+    else
+      return false;
+
+    // Shelf packing
+    int x = 0, y = 0, rowHeight = 0;
+    for (size_t i=0; i<rects.size(); ++i) {
+      gfx::Rect& rc = rects[i];
+      if (x > 0 && x+rc.w > kAtlasWidth) {
+        x = 0;
+        y += rowHeight;
+        rowHeight = 0;
+      }
+      rc.x = x;
+      rc.y = y;
+      x += rc.w;
+      rowHeight = MAX(rowHeight, rc.h);
+
+      if (rc.h != f->height)
+        m_uniformHeight = false;
+    }
+
+    m_bmp = create_bitmap_ex(8, kAtlasWidth, MAX(1, y+rowHeight));
+    if (!m_bmp)
+      return false;
+
+    clear_to_color(m_bmp, 0);
+
+    for (size_t i=0; i<glyphs.size(); ++i) {
+      const gfx::Rect& rc = rects[i];
+
+      if (f->vtable == font_vtable_color) {
+        blit((BITMAP*)glyphs[i], m_bmp, 0, 0, rc.x, rc.y, rc.w, rc.h);
+      }
+      else {
+        const FONT_GLYPH* g = (const FONT_GLYPH*)glyphs[i];
+        int stride = (g->w+7) / 8;
+        for (int v=0; v<g->h; ++v)
+          for (int u=0; u<g->w; ++u)
+            if (g->dat[v*stride + u/8] & (0x80 >> (u & 7)))
+              m_bmp->line[rc.y+v][rc.x+u] = 1;
+      }
+
+      m_rects[glyphs[i]] = rc;
+    }
+
+    return true;
+  }
+
+  // Copies the glyph of the given character to "dst" (vertically
+  // centered like Allegro's color/mono fonts do).
+  void drawGlyph(FONT* f, int ch, BITMAP* dst, int x) const {
+    const void* g;
+    if (f->vtable == font_vtable_color)
+      g = _color_find_glyph(f, ch);
+    else
+      g = _mono_find_glyph(f, ch);
+
+    std::map<const void*, gfx::Rect>::const_iterator it = m_rects.find(g);
+    if (it == m_rects.end())
+      return;
+
+    const gfx::Rect& rc = it->second;
+    blit(m_bmp, dst, rc.x, rc.y, x, (f->height - rc.h) / 2, rc.w, rc.h);
+  }
+
+  bool uniformHeight() const { return m_uniformHeight; }
+
+private:
+  BITMAP* m_bmp;
+  std::map<const void*, gfx::Rect> m_rects;
+  bool m_uniformHeight;   // True if all glyphs have the font height
+};
+
+struct TextRun {
+  std::vector<int> positions;   // X position of each char (and the total width at the end)
+  BITMAP* mask;                 // 8-bit mask of the whole run (NULL if it wasn't drawn yet)
+
+  int width() const { return positions.back(); }
+};
+
+class FontCache {
+public:
+  ~FontCache() {
+    while (!m_atlases.empty())
+      flush(m_atlases.begin()->first);
+
+    while (!m_lru.empty())
+      removeRun(m_lru.back());
+  }
+
+  // Returns the run of the given plain text (without mnemonics).
+  TextRun* getRun(FONT* f, const char* text) {
+    Key key(f, text);
+    Runs::iterator it = m_runs.find(key);
+    if (it != m_runs.end()) {
+      // Move to the front of the LRU list
+      m_lru.splice(m_lru.begin(), m_lru, it->second.second);
+      return &it->second.first;
+    }
+
+    if (m_runs.size() >= kMaxTextRuns)
+      removeRun(m_lru.back());
+
+    m_lru.push_front(key);
+    std::pair<TextRun, LruList::iterator>& entry = m_runs[key];
+    entry.second = m_lru.begin();
+
+    TextRun& run = entry.first;
+
+    AL_CONST char* p = text;
+    int ch, x = 0;
+    run.mask = NULL;
+    while ((ch = ugetxc(&p))) {
+      run.positions.push_back(x);
+      x += f->vtable->char_length(f, ch);
+    }
+    run.positions.push_back(x);
+    return &run;
+  }
+
+  // Returns the 8-bit mask to draw the run, or NULL if the font
+  // doesn't support atlases.
+  BITMAP* getRunMask(FONT* f, const char* text, TextRun* run, bool opaque) {
+    GlyphAtlas* atlas = getAtlas(f);
+    if (!atlas || (opaque && !atlas->uniformHeight()) || run->width() <= 0)
+      return NULL;
+
+    if (!run->mask) {
+      run->mask = create_bitmap_ex(8, run->width(), MAX(1, f->height));
+      if (!run->mask)
+        return NULL;
+
+      clear_to_color(run->mask, 0);
+
+      AL_CONST char* p = text;
+      int ch, i = 0;
+      while ((ch = ugetxc(&p)))
+        atlas->drawGlyph(f, ch, run->mask, run->positions[i++]);
+    }
+    return run->mask;
+  }
+
+  void flush(FONT* f) {
+    Atlases::iterator it = m_atlases.find(f);
+    if (it != m_atlases.end()) {
+      delete it->second;
+      m_atlases.erase(it);
+    }
+
+    for (LruList::iterator it=m_lru.begin(); it != m_lru.end(); ) {
+      LruList::iterator next = it;
+      ++next;
+      if (it->first == f)
+        removeRun(*it);
+      it = next;
+    }
+  }
+
+private:
+  typedef std::pair<FONT*, std::string> Key;
+  typedef std::list<Key> LruList;
+  typedef std::map<Key, std::pair<TextRun, LruList::iterator> > Runs;
+  typedef std::map<FONT*, GlyphAtlas*> Atlases;
+
+  GlyphAtlas* getAtlas(FONT* f) {
+    Atlases::iterator it = m_atlases.find(f);
+    if (it != m_atlases.end())
+      return it->second;
+
+    GlyphAtlas* atlas = new GlyphAtlas;
+    if (!atlas->build(f)) {
+      delete atlas;
+      atlas = NULL;
+    }
+    m_atlases[f] = atlas;
+    return atlas;
+  }
+
+  void removeRun(Key key) {
+    Runs::iterator it = m_runs.find(key);
+    if (it == m_runs.end())
+      return;
+
+    if (it->second.first.mask)
+      destroy_bitmap(it->second.first.mask);
+
+    m_lru.erase(it->second.second);
+    m_runs.erase(it);
+  }
+
+  Runs m_runs;
+  LruList m_lru;
+  Atlases m_atlases;
+};
+
+FontCache* font_cache = NULL;
+
+FontCache* get_font_cache()
+{
+  if (!font_cache)
+    font_cache = new FontCache;
+  return font_cache;
+}
+
+} // anonymous namespace
+
+static void font_cache_exit()
+{
+  delete font_cache;
+  font_cache = NULL;
+}
+
+void ji_font_flush_cache(FONT* f)
+{
+  if (font_cache)
+    font_cache->flush(f);
+}
+
+void ji_font_render_text(BITMAP* bmp, FONT* f, const char* text, int x, int y, int fg, int bg)
+{
+  if (fg >= 0 && *text) {
+    FontCache* cache = get_font_cache();
+    TextRun* run = cache->getRun(f, text);
+    BITMAP* mask = cache->getRunMask(f, text, run, bg >= 0);
+    if (mask) {
+      draw_character_ex(bmp, mask, x, y, fg, bg);
+      return;
+    }
+  }
+
+  textout_ex(bmp, f, text, x, y, fg, bg);
+}
+
+int ji_font_char_pos(FONT* f, const char* text, int index)
+{
+  TextRun* run = get_font_cache()->getRun(f, text);
+  return run->positions[MID(0, index, (int)run->positions.size()-1)];
+}
+
 /**********************************************************************/
 #if 0 /* with FreeType */
 /**********************************************************************/
@@ -329,6 +633,8 @@ int _ji_font_init()
 
 void _ji_font_exit()
 {
+  font_cache_exit();
+
   if (ji_font_inited) {
     FT_Done_FreeType(ft_library);
 
@@ -473,6 +779,7 @@ int ji_font_set_size(FONT* f, int h)
 
   if (!error) {
     _font_uncache_glyphs(f);
+    ji_font_flush_cache(f);
     af->face_h = h;
     af->real_face_h = test_h;
     af->face_ascender = af->face->size->metrics.ascender >> 6;
@@ -922,6 +1229,7 @@ int _ji_font_init()
 
 void _ji_font_exit()
 {
+  font_cache_exit();
 }
 
 FONT* ji_font_load_ttf(const char* filepathname)
@@ -983,6 +1291,10 @@ int ji_font_char_len(FONT* f, int chr)
 // see jdraw_text
 int ji_font_text_len(struct FONT* f, const char* s)
 {
+  // Text without mnemonics is measured from the text-run cache
+  if (!strchr(s, '&'))
+    return get_font_cache()->getRun(f, s)->width();
+
   int in_pos = 0;
   int pix_len = 0;
   int c;
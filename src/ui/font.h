@@ -9,6 +9,7 @@
 
 #include "ui/base.h"
 
+struct BITMAP;
 struct FONT;
 
 namespace ui {
@@ -16,6 +17,7 @@ namespace ui {
   FONT* ji_font_load(const char* filepathname);
   FONT* ji_font_load_bmp(const char* filepathname);
   FONT* ji_font_load_ttf(const char* filepathname);
+  void ji_font_destroy(FONT* f);
 
   int ji_font_get_size(FONT* f);
   int ji_font_set_size(FONT* f, int height);
@@ -34,6 +36,16 @@ namespace ui {
   int ji_font_char_len(FONT* f, int chr);
   int ji_font_text_len(FONT* f, const char* text);
 
+  // Draws/measures plain text (without mnemonics) using the glyph
+  // atlas and the text-run cache of the font. ji_font_render_text()
+  // is like textout_ex().
+  void ji_font_render_text(BITMAP* bmp, FONT* f, const char* text, int x, int y, int fg, int bg);
+  int ji_font_char_pos(FONT* f, const char* text, int index);
+
+  // Removes the cached atlas/text-runs of the font (it must be called
+  // when a font is destroyed or changed).
+  void ji_font_flush_cache(FONT* f);
+
 } // namespace ui
 
 #endif
@@ -207,7 +207,7 @@ gfx::Size Graphics::drawStringAlgorithm(const std::string& str, Color fg, Color
         xout = pt.x;
 
       ji_font_set_aa_mode(m_currentFont, to_system(bg));
-      textout_ex(m_bmp, m_currentFont, line.c_str(), m_dx+xout, m_dy+pt.y, to_system(fg), to_system(bg));
+      ji_font_render_text(m_bmp, m_currentFont, line.c_str(), m_dx+xout, m_dy+pt.y, to_system(fg), to_system(bg));
 
       jrectexclude(m_bmp,
                    m_dx+rc.x, m_dy+pt.y, m_dx+rc.x+rc.w-1, m_dy+pt.y+lineSize.h-1,
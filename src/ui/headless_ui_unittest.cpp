@@ -0,0 +1,94 @@
+/* Aseprite
+ * Copyright (C) 2001-2013  David Capello
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define TEST_GUI
+#include "tests/test.h"
+#include "she/headless.h"
+
+#include <allegro.h>
+
+using namespace ui;
+
+static she::HeadlessSystem* headless()
+{
+  return static_cast<she::HeadlessSystem*>(she::Instance());
+}
+
+TEST(HeadlessSystem, MouseEvents)
+{
+  she::ScopedHandle<she::EventLoop> loop(she::Instance()->createEventLoop());
+
+  headless()->queueEvent(she::HeadlessEvent::mouseMove(10, 20));
+  headless()->queueEvent(she::HeadlessEvent::mouseButtons(kButtonLeft));
+  EXPECT_EQ(2, headless()->pendingEvents());
+
+  // Each call processes only one event.
+  loop->waitForEvents(0.0);
+  EXPECT_TRUE(jmouse_poll());
+  EXPECT_EQ(10, jmouse_x(0));
+  EXPECT_EQ(20, jmouse_y(0));
+  EXPECT_EQ(kButtonNone, jmouse_b(0));
+
+  loop->waitForEvents(0.0);
+  jmouse_poll();
+  EXPECT_EQ(kButtonLeft, jmouse_b(0));
+  EXPECT_EQ(0, headless()->pendingEvents());
+
+  std::vector<gfx::Point> positions;
+  loop->popMousePositions(positions);
+  ASSERT_EQ(1, (int)positions.size());
+  EXPECT_EQ(10, positions[0].x);
+  EXPECT_EQ(20, positions[0].y);
+}
+
+TEST(HeadlessSystem, KeyEvents)
+{
+  she::ScopedHandle<she::EventLoop> loop(she::Instance()->createEventLoop());
+  clear_keybuf();
+
+  headless()->queueEvent(she::HeadlessEvent::keyDown(KEY_LCONTROL));
+  headless()->queueEvent(she::HeadlessEvent::keyDown(KEY_A, 'a'));
+  loop->waitForEvents(0.0);
+  loop->waitForEvents(0.0);
+
+  EXPECT_TRUE(key[KEY_A] != 0);
+  EXPECT_TRUE((key_shifts & KB_CTRL_FLAG) != 0);
+  ASSERT_TRUE(keypressed() != 0);
+
+  int scancode;
+  EXPECT_EQ('a', ureadkey(&scancode));
+  EXPECT_EQ(KEY_A, scancode);
+
+  headless()->queueEvent(she::HeadlessEvent::keyUp(KEY_A));
+  headless()->queueEvent(she::HeadlessEvent::keyUp(KEY_LCONTROL));
+  loop->waitForEvents(0.0);
+  loop->waitForEvents(0.0);
+  EXPECT_EQ(0, key[KEY_A]);
+  EXPECT_EQ(0, key_shifts & KB_CTRL_FLAG);
+}
+
+TEST(HeadlessSystem, DisplayFlip)
+{
+  she::ScopedHandle<she::Display> display(she::Instance()->createDisplay(320, 240, 2));
+  EXPECT_EQ(160, display->getSurface()->width());
+  EXPECT_EQ(120, display->getSurface()->height());
+
+  int flips = headless()->flipCount();
+  EXPECT_TRUE(display->flip());
+  EXPECT_EQ(flips+1, headless()->flipCount());
+}
@@ -13,6 +13,9 @@
 
 #include "ui/manager.h"
 
+#include "base/thread.h"
+#include "she/event_loop.h"
+#include "she/system.h"
 #include "ui/intern.h"
 #include "ui/ui.h"
 
@@ -69,6 +72,13 @@ static int want_close_stage;       /* variable to handle the external
                                       close button in some Windows
                                       enviroments */
 
+// Maximum time (in seconds) that the UI thread is blocked waiting for
+// events, just in case that some platform doesn't notify some kind of
+// input.
+static const double kMaxWaitTime = 0.5;
+
+static she::EventLoop* event_loop = NULL; // Used to wait for input events
+
 Manager* Manager::m_defaultManager = NULL;
 
 static WidgetsList new_windows; // Windows that we should show
@@ -102,6 +112,9 @@ static void allegro_window_close_hook()
 {
   if (want_close_stage == STAGE_NORMAL)
     want_close_stage = STAGE_WANT_CLOSE;
+
+  if (event_loop)
+    event_loop->wakeUp();
 }
 
 // static
@@ -118,6 +131,10 @@ Manager::Manager()
     want_close_stage = STAGE_NORMAL;
     set_close_button_callback(allegro_window_close_hook);
 
+    // Create the event loop to wait for input events
+    if (she::Instance())
+      event_loop = she::Instance()->createEventLoop();
+
     // Empty lists
     ASSERT(msg_queue.empty());
     ASSERT(new_windows.empty());
@@ -172,6 +189,12 @@ Manager::~Manager()
     // No more default manager
     m_defaultManager = NULL;
 
+    // Destroy the event loop
+    if (event_loop) {
+      event_loop->dispose();
+      event_loop = NULL;
+    }
+
     // Shutdown system
     ASSERT(msg_queue.empty());
     ASSERT(new_windows.empty());
@@ -269,6 +292,25 @@ bool Manager::generateMessages()
       else
         dst = mouse_widget;
 
+      // Send one message for each intermediate position of the
+      // mouse since the last poll (they will be coalesced in just
+      // one message with the whole trail of points).
+      if (event_loop) {
+        std::vector<gfx::Point> positions;
+        event_loop->popMousePositions(positions);
+
+        for (size_t i=0; i+1<positions.size(); ++i) {
+          gfx::Point pos(JI_SCREEN_W * positions[i].x / SCREEN_W,
+                         JI_SCREEN_H * positions[i].y / SCREEN_H);
+
+          Message* msg = new MouseMessage(kMouseMoveMessage,
+                                          currentMouseButtons(0), pos);
+          if (dst)
+            msg->addRecipient(dst);
+          enqueueMessage(msg);
+        }
+      }
+
       // Send the mouse movement message
       enqueueMessage(newMouseMessage(kMouseMoveMessage, dst,
                                      currentMouseButtons(0)));
@@ -460,6 +502,27 @@ bool Manager::generateMessages()
     return false;
 }
 
+void Manager::waitForEvents()
+{
+  double timeout = kMaxWaitTime;
+
+  // Wake up for the next timer tick
+  int msecs = Timer::getTimeToNextTick();
+  if (msecs >= 0)
+    timeout = MIN(timeout, msecs / 1000.0);
+
+  if (event_loop)
+    event_loop->waitForEvents(timeout);
+  else
+    base::this_thread::sleep_for(MIN(timeout, 0.01));
+}
+
+void Manager::wakeUp()
+{
+  if (event_loop)
+    event_loop->wakeUp();
+}
+
 void Manager::dispatchMessages()
 {
   // Add the "Queue Processing" message for the manager.
@@ -500,10 +563,30 @@ void Manager::enqueueMessage(Message* msg)
     }
   }
 
-  if (msg->hasRecipients())
-    msg_queue.push_back(msg);
-  else
+  if (!msg->hasRecipients()) {
     delete msg;
+    return;
+  }
+
+  // Coalesce consecutive mouse movements for the same recipients, so
+  // a slow widget doesn't process stale positions (the positions are
+  // kept in MouseMessage::coalescedPositions()).
+  if (msg->type() == kMouseMoveMessage && !msg_queue.empty()) {
+    Message* last = msg_queue.back();
+
+    if (!last->isUsed() &&
+        last->type() == kMouseMoveMessage &&
+        last->recipients() == msg->recipients() &&
+        last->keyModifiers() == msg->keyModifiers() &&
+        static_cast<MouseMessage*>(last)->buttons() == static_cast<MouseMessage*>(msg)->buttons()) {
+      static_cast<MouseMessage*>(msg)->coalesceWith(static_cast<MouseMessage*>(last));
+
+      msg_queue.pop_back();
+      delete last;
+    }
+  }
+
+  msg_queue.push_back(msg);
 }
 
 Window* Manager::getTopWindow()
@@ -749,6 +832,25 @@ void Manager::removeMessagesFor(Widget* widget)
     removeWidgetFromRecipients(widget, *it);
 }
 
+void Manager::removePaintMessagesFor(Widget* widget, gfx::Region& region)
+{
+  for (Messages::iterator it=msg_queue.begin(); it != msg_queue.end(); ) {
+    Message* msg = *it;
+
+    if (!msg->isUsed() &&
+        msg->type() == kPaintMessage &&
+        msg->recipients().size() == 1 &&
+        msg->recipients().front() == widget) {
+      region.createUnion(region, gfx::Region(static_cast<PaintMessage*>(msg)->rect()));
+
+      delete msg;
+      it = msg_queue.erase(it);
+    }
+    else
+      ++it;
+  }
+}
+
 void Manager::removeMessagesForTimer(Timer* timer)
 {
   for (Messages::iterator it=msg_queue.begin(); it != msg_queue.end(); ) {
@@ -877,7 +979,7 @@ void Manager::_closeWindow(Window* window, bool redraw_background)
   removeChild(window);
 
   // Redraw background.
-  invalidateRegion(reg1);
+  exposeRegion(reg1);
 
   // Maybe the window is in the "new_windows" list.
   WidgetsList::iterator it =
@@ -1120,7 +1222,7 @@ void Manager::invalidateDisplayRegion(const gfx::Region& region)
     Window* window = static_cast<Window*>(*it);
 
     // Invalidate regions of this window
-    window->invalidateRegion(reg1);
+    window->exposeRegion(reg1);
 
     // There is desktop?
     if (window->isDesktop()) {
@@ -1137,7 +1239,7 @@ void Manager::invalidateDisplayRegion(const gfx::Region& region)
   // Invalidate areas outside windows (only when there are not a
   // desktop window).
   if (!withDesktop)
-    Widget::invalidateRegion(reg1);
+    Widget::exposeRegion(reg1);
 }
 
 LayoutIO* Manager::getLayoutIO()
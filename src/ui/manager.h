@@ -39,6 +39,14 @@ namespace ui {
     void dispatchMessages();
     void enqueueMessage(Message* msg);
 
+    // Blocks the UI thread until a new input event is received, the
+    // next timer must tick, or wakeUp() is called.
+    void waitForEvents();
+
+    // Wakes up the UI thread if it's blocked in waitForEvents(). It
+    // can be called from any thread.
+    void wakeUp();
+
     void addToGarbage(Widget* widget);
     void collectGarbage();
 
@@ -62,6 +70,10 @@ namespace ui {
     void removeMessagesFor(Widget* widget);
     void removeMessagesForTimer(Timer* timer);
 
+    // Removes the paint messages (not yet dispatched) of the given
+    // widget, adding their rectangles to "region".
+    void removePaintMessagesFor(Widget* widget, gfx::Region& region);
+
     void addMessageFilter(int message, Widget* widget);
     void removeMessageFilter(int message, Widget* widget);
     void removeMessageFilterFor(Widget* widget);
@@ -19,6 +19,63 @@
 
 namespace ui {
 
+namespace {
+
+// Size of each block of the pool of messages (bigger messages are
+// allocated with the global operator new).
+const std::size_t kMessageBlockSize = 128;
+
+// Number of blocks allocated each time the pool is empty.
+const std::size_t kMessageBlocksPerChunk = 64;
+
+union MessageBlock {
+  MessageBlock* next;
+  char data[kMessageBlockSize];
+  double align;
+};
+
+MessageBlock* free_blocks = NULL;
+
+} // anonymous namespace
+
+// static
+void* Message::operator new(std::size_t size)
+{
+  if (size > kMessageBlockSize)
+    return ::operator new(size);
+
+  if (!free_blocks) {
+    // The chunks are never freed, they are reused for new messages.
+    MessageBlock* chunk = static_cast<MessageBlock*>(
+      ::operator new(sizeof(MessageBlock) * kMessageBlocksPerChunk));
+
+    for (std::size_t i=0; i<kMessageBlocksPerChunk; ++i) {
+      chunk[i].next = free_blocks;
+      free_blocks = &chunk[i];
+    }
+  }
+
+  MessageBlock* block = free_blocks;
+  free_blocks = block->next;
+  return block;
+}
+
+// static
+void Message::operator delete(void* ptr, std::size_t size)
+{
+  if (!ptr)
+    return;
+
+  if (size > kMessageBlockSize) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  MessageBlock* block = static_cast<MessageBlock*>(ptr);
+  block->next = free_blocks;
+  free_blocks = block;
+}
+
 Message::Message(MessageType type)
   : m_type(type)
   , m_used(false)
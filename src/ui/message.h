@@ -16,6 +16,9 @@
 #include "ui/mouse_buttons.h"
 #include "ui/widgets_list.h"
 
+#include <cstddef>
+#include <vector>
+
 namespace ui {
 
   class Timer;
@@ -29,6 +32,11 @@ namespace ui {
     Message(MessageType type);
     virtual ~Message();
 
+    // Messages are allocated from a pool of fixed-size blocks (they
+    // are created and destroyed all the time from the UI thread).
+    static void* operator new(std::size_t size);
+    static void operator delete(void* ptr, std::size_t size);
+
     MessageType type() const { return m_type; }
     const WidgetsList& recipients() const { return m_recipients; }
     bool hasRecipients() const { return !m_recipients.empty(); }
@@ -108,9 +116,24 @@ namespace ui {
 
     const gfx::Point& position() const { return m_pos; }
 
+    // Previous positions of consecutive kMouseMoveMessage that were
+    // coalesced in this message (the oldest first, position() is not
+    // included).
+    const std::vector<gfx::Point>& coalescedPositions() const { return m_coalescedPositions; }
+
+    // Takes all positions of "older" message as coalesced positions
+    // of this message.
+    void coalesceWith(const MouseMessage* older) {
+      m_coalescedPositions.insert(m_coalescedPositions.begin(), older->position());
+      m_coalescedPositions.insert(m_coalescedPositions.begin(),
+                                  older->m_coalescedPositions.begin(),
+                                  older->m_coalescedPositions.end());
+    }
+
   private:
     MouseButtons m_buttons;     // Pressed buttons
     gfx::Point m_pos;           // Mouse position
+    std::vector<gfx::Point> m_coalescedPositions;
   };
 
   class TimerMessage : public Message
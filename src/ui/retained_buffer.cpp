@@ -0,0 +1,105 @@
+// Aseprite UI Library
+// Copyright (C) 2001-2013  David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ui/retained_buffer.h"
+
+#include "ui/system.h"
+
+#include <allegro.h>
+
+namespace ui {
+
+RetainedBuffer::RetainedBuffer()
+  : m_bmp(NULL)
+{
+}
+
+RetainedBuffer::~RetainedBuffer()
+{
+  if (m_bmp)
+    destroy_bitmap(m_bmp);
+}
+
+void RetainedBuffer::discard()
+{
+  m_valid.clear();
+}
+
+void RetainedBuffer::discard(const gfx::Region& region)
+{
+  m_valid.createSubtraction(m_valid, region);
+}
+
+bool RetainedBuffer::restore(const gfx::Point& origin, const gfx::Rect& rc)
+{
+  if (!m_bmp ||
+      bitmap_color_depth(m_bmp) != bitmap_color_depth(ji_screen) ||
+      m_valid.contains(rc) != gfx::Region::In)
+    return false;
+
+  blit(m_bmp, ji_screen,
+       rc.x - m_area.x, rc.y - m_area.y,
+       origin.x + rc.x, origin.y + rc.y, rc.w, rc.h);
+  return true;
+}
+
+void RetainedBuffer::retain(const gfx::Point& origin, const gfx::Region& region, const gfx::Rect& area)
+{
+  if (area.isEmpty()) {
+    discard();
+    return;
+  }
+
+  if (!m_bmp ||
+      bitmap_color_depth(m_bmp) != bitmap_color_depth(ji_screen) ||
+      !m_area.contains(area)) {
+    resize(area);
+    if (!m_bmp)
+      return;
+  }
+
+  gfx::Region rgn;
+  rgn.createIntersection(region, gfx::Region(m_area));
+
+  for (gfx::Region::const_iterator it=rgn.begin(), end=rgn.end(); it != end; ++it) {
+    const gfx::Rect& rc = *it;
+    blit(ji_screen, m_bmp,
+         origin.x + rc.x, origin.y + rc.y,
+         rc.x - m_area.x, rc.y - m_area.y, rc.w, rc.h);
+  }
+
+  m_valid.createUnion(m_valid, rgn);
+}
+
+void RetainedBuffer::resize(const gfx::Rect& area)
+{
+  BITMAP* bmp = create_bitmap_ex(bitmap_color_depth(ji_screen), area.w, area.h);
+
+  // Keep the valid content that is still inside the new area.
+  if (bmp && m_bmp && bitmap_color_depth(m_bmp) == bitmap_color_depth(bmp)) {
+    gfx::Rect overlap = m_area.createIntersect(area);
+    if (!overlap.isEmpty())
+      blit(m_bmp, bmp,
+           overlap.x - m_area.x, overlap.y - m_area.y,
+           overlap.x - area.x, overlap.y - area.y, overlap.w, overlap.h);
+
+    m_valid.createIntersection(m_valid, gfx::Region(overlap));
+  }
+  else
+    m_valid.clear();
+
+  if (m_bmp)
+    destroy_bitmap(m_bmp);
+
+  m_bmp = bmp;
+  m_area = area;
+}
+
+} // namespace ui
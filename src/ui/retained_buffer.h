@@ -0,0 +1,57 @@
+// Aseprite UI Library
+// Copyright (C) 2001-2013  David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#ifndef UI_RETAINED_BUFFER_H_INCLUDED
+#define UI_RETAINED_BUFFER_H_INCLUDED
+
+#include "base/disable_copying.h"
+#include "gfx/point.h"
+#include "gfx/rect.h"
+#include "gfx/region.h"
+
+struct BITMAP;
+
+namespace ui {
+
+  // Off-screen copy of the pixels that a widget painted on
+  // ji_screen. It's used to repaint exposed areas (e.g. when a menu
+  // is closed) with a blit instead of a kPaintMessage.
+  //
+  // All rectangles/regions are relative to the widget origin, so the
+  // content is still valid when the widget is moved (e.g. a window is
+  // moved, or the sprite editor is scrolled inside its view).
+  class RetainedBuffer {
+  public:
+    RetainedBuffer();
+    ~RetainedBuffer();
+
+    // Discards the whole content or the given region of the buffer.
+    void discard();
+    void discard(const gfx::Region& region);
+
+    // Copies the given rectangle from the buffer to ji_screen
+    // ("origin" is the widget position in the screen). Returns false
+    // (and does nothing) if some part of "rc" isn't in the buffer.
+    bool restore(const gfx::Point& origin, const gfx::Rect& rc);
+
+    // Copies the given region from ji_screen to the buffer. "area" is
+    // the part of the widget that can be visible, the buffer is
+    // re-created to cover it if it's needed.
+    void retain(const gfx::Point& origin, const gfx::Region& region, const gfx::Rect& area);
+
+  private:
+    void resize(const gfx::Rect& area);
+
+    BITMAP* m_bmp;
+    gfx::Rect m_area;           // Area of the widget covered by m_bmp
+    gfx::Region m_valid;        // Valid content of m_bmp
+
+    DISABLE_COPYING(RetainedBuffer);
+  };
+
+} // namespace ui
+
+#endif
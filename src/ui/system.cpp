@@ -13,6 +13,7 @@
 #include "gfx/point.h"
 #include "she/display.h"
 #include "she/surface.h"
+#include "she/system.h"
 #include "ui/cursor.h"
 #include "ui/intern.h"
 #include "ui/manager.h"
@@ -56,6 +57,7 @@ static int m_y[2];
 static int m_z[2];
 
 static bool moved;
+static bool headless = false;
 static int mouse_scares = 0;
 
 /* Local routines.  */
@@ -95,12 +97,17 @@ static void set_mouse_cursor(Cursor* cursor)
 
 int _ji_system_init()
 {
+  // Without a real display, the program advances ji_clock.
+  headless = (she::Instance() &&
+              (she::Instance()->capabilities() & she::kHeadlessCapability));
+
   /* Install timer related stuff.  */
   LOCK_VARIABLE(ji_clock);
   LOCK_VARIABLE(m_b);
   LOCK_FUNCTION(clock_inc);
 
-  if (install_int_ex(clock_inc, BPS_TO_TIMER(1000)) < 0)
+  if (!headless &&
+      install_int_ex(clock_inc, BPS_TO_TIMER(1000)) < 0)
     return -1;
 
   if (screen)
@@ -117,7 +124,8 @@ void _ji_system_exit()
   SetDisplay(NULL);
   set_mouse_cursor(NULL);
 
-  remove_int(clock_inc);
+  if (!headless)
+    remove_int(clock_inc);
 }
 
 void SetDisplay(she::Display* display)
@@ -247,14 +255,22 @@ void jmouse_set_position(int x, int y)
   m_x[0] = m_x[1] = x;
   m_y[0] = m_y[1] = y;
 
-  position_mouse(SCREEN_W * x / JI_SCREEN_W,
-                 SCREEN_H * y / JI_SCREEN_H);
+  if (headless) {
+    mouse_x = x;
+    mouse_y = y;
+  }
+  else
+    position_mouse(SCREEN_W * x / JI_SCREEN_W,
+                   SCREEN_H * y / JI_SCREEN_H);
 }
 
 void jmouse_capture()
 {
 #if defined(ALLEGRO_UNIX)
 
+  if (headless)
+    return;
+
   XGrabPointer(_xwin.display, _xwin.window, False,
                PointerMotionMask | ButtonPressMask | ButtonReleaseMask,
                GrabModeAsync, GrabModeAsync,
@@ -267,6 +283,9 @@ void jmouse_release()
 {
 #if defined(ALLEGRO_UNIX)
 
+  if (headless)
+    return;
+
   XUngrabPointer(_xwin.display, CurrentTime);
 
 #endif
@@ -312,6 +331,14 @@ bool jmouse_control_infinite_scroll(const gfx::Rect& rect)
 
 static void update_mouse_position()
 {
+  // The headless system gives the mouse position in display
+  // coordinates.
+  if (headless) {
+    m_x[0] = mouse_x;
+    m_y[0] = mouse_y;
+    return;
+  }
+
   m_x[0] = JI_SCREEN_W * mouse_x / SCREEN_W;
   m_y[0] = JI_SCREEN_H * mouse_y / SCREEN_H;
 
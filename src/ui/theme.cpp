@@ -40,7 +40,7 @@ Theme::Theme()
 Theme::~Theme()
 {
   if (default_font && default_font != font)
-    destroy_font(default_font);
+    ji_font_destroy(default_font);
 
   if (current_theme == this)
     CurrentTheme::set(NULL);
@@ -259,7 +259,7 @@ static void draw_text(BITMAP *bmp, FONT *f, const char *text, int x, int y,
 {
   // TODO Optional anti-aliased textout
   ji_font_set_aa_mode(f, to_system(bg_color));
-  textout_ex(bmp, f, text, x, y, to_system(fg_color), (fill_bg ? to_system(bg_color): -1));
+  ji_font_render_text(bmp, f, text, x, y, to_system(fg_color), (fill_bg ? to_system(bg_color): -1));
 }
 
 } // namespace ui
@@ -28,6 +28,7 @@ Timer::Timer(int interval, Widget* owner)
   : m_owner(owner ? owner: Manager::getDefault())
   , m_interval(interval)
   , m_lastTime(-1)
+  , m_tickRequested(false)
 {
   ASSERT(m_owner != NULL);
 
@@ -64,6 +65,12 @@ void Timer::tick()
   onTick();
 }
 
+void Timer::tickFromThread()
+{
+  m_tickRequested = true;
+  Manager::getDefault()->wakeUp();
+}
+
 void Timer::setInterval(int interval)
 {
   m_interval = interval;
@@ -97,6 +104,12 @@ void Timer::pollTimers()
           }
         }
 
+        if (timer->m_tickRequested) {
+          timer->m_tickRequested = false;
+          if (count == 0)
+            count = 1;
+        }
+
         if (count > 0) {
           ASSERT(timer->m_owner != NULL);
 
@@ -114,4 +127,22 @@ void Timer::checkNoTimers()
   ASSERT(timers.empty());
 }
 
+int Timer::getTimeToNextTick()
+{
+  int t = ji_clock;
+  int next = -1;
+
+  for (Timers::iterator it=timers.begin(), end=timers.end(); it != end; ++it) {
+    Timer* timer = *it;
+    if (timer && timer->m_lastTime >= 0) {
+      // pollTimers() generates a tick when "t - m_lastTime > m_interval"
+      int msecs = MAX(0, timer->m_lastTime + timer->m_interval + 1 - t);
+      if (next < 0 || msecs < next)
+        next = msecs;
+    }
+  }
+
+  return next;
+}
+
 } // namespace ui
@@ -30,11 +30,20 @@ namespace ui {
 
     void tick();
 
+    // Makes the timer tick in the next pollTimers() call (if it is
+    // running), and wakes up the UI thread. It can be called from a
+    // background thread.
+    void tickFromThread();
+
     Signal0<void> Tick;
 
     static void pollTimers();
     static void checkNoTimers();
 
+    // Returns the milliseconds until the next running timer ticks, or
+    // -1 if there is no running timer.
+    static int getTimeToNextTick();
+
   protected:
     virtual void onTick();
 
@@ -42,6 +51,7 @@ namespace ui {
     Widget* m_owner;
     int m_interval;
     int m_lastTime;
+    volatile bool m_tickRequested;
 
     DISABLE_COPYING(Timer);
   };
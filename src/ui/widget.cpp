@@ -12,6 +12,7 @@
 
 #include "base/memory.h"
 #include "ui/intern.h"
+#include "ui/retained_buffer.h"
 #include "ui/ui.h"
 
 #include <allegro.h>
@@ -27,6 +28,10 @@ namespace ui {
 
 using namespace gfx;
 
+// True when exposeRegion() is invalidating widgets (the content of
+// retained buffers is still valid).
+static bool exposing_region = false;
+
 static inline void mark_dirty_flag(Widget* widget)
 {
   while (widget) {
@@ -76,6 +81,7 @@ Widget::Widget(WidgetType type)
   this->user_data[3] = NULL;
 
   m_preferredSize = NULL;
+  m_retainedBuffer = NULL;
   m_doubleBuffered = false;
 }
 
@@ -101,6 +107,8 @@ Widget::~Widget()
   // Delete the preferred size
   delete m_preferredSize;
 
+  delete m_retainedBuffer;
+
   // Low level free
   removeWidget(this);
 }
@@ -192,6 +200,10 @@ void Widget::setVisible(bool state)
       getManager()->freeWidget(this); // Free from manager
 
       this->flags |= JI_HIDDEN;
+
+      // Content changes are not tracked while the widget is hidden
+      if (m_retainedBuffer)
+        m_retainedBuffer->discard();
     }
   }
 }
@@ -586,6 +598,9 @@ void Widget::setBounds(const Rect& rc)
 
 void Widget::setBoundsQuietly(const gfx::Rect& rc)
 {
+  if (m_retainedBuffer && m_bounds.getSize() != rc.getSize())
+    m_retainedBuffer->discard();
+
   m_bounds = rc;
 }
 
@@ -905,6 +920,10 @@ void Widget::flushRedraw()
     }
 
     if (!widget->m_updateRegion.isEmpty()) {
+      // Merge the areas of pending paint messages, so the widget is
+      // painted just one time for each region.
+      getManager()->removePaintMessagesFor(widget, widget->m_updateRegion);
+
       // Intersect m_updateRegion with drawable area.
       {
         Region region;
@@ -941,8 +960,83 @@ void Widget::setDoubleBuffered(bool doubleBuffered)
   m_doubleBuffered = doubleBuffered;
 }
 
+bool Widget::hasRetainedBuffer() const
+{
+  return (m_retainedBuffer != NULL);
+}
+
+void Widget::setRetainedBuffer(bool state)
+{
+  if (state) {
+    if (!m_retainedBuffer)
+      m_retainedBuffer = new RetainedBuffer;
+  }
+  else {
+    delete m_retainedBuffer;
+    m_retainedBuffer = NULL;
+  }
+}
+
+bool Widget::restoreRetainedArea(const gfx::Rect& rc)
+{
+  if (!m_retainedBuffer)
+    return false;
+
+  Point origin = getBounds().getOrigin();
+  Rect localRc = rc.createIntersect(getBounds());
+  localRc.offset(-origin.x, -origin.y);
+
+  return m_retainedBuffer->restore(origin, localRc);
+}
+
+void Widget::retainArea(const gfx::Region& region)
+{
+  if (!m_retainedBuffer)
+    return;
+
+  // Only the pixels that the widget could paint are retained: the
+  // drawable region inside the current clipping rectangle.
+  Region drawable;
+  getDrawableRegion(drawable, kCutTopWindows);
+  drawable.createIntersection(drawable,
+                              Region(Rect(ji_screen->cl, ji_screen->ct,
+                                          ji_screen->cr - ji_screen->cl,
+                                          ji_screen->cb - ji_screen->ct)));
+
+  Region retained, discarded;
+  retained.createIntersection(region, drawable);
+  discarded.createSubtraction(region, retained);
+
+  // The area of the widget that can be visible (without top windows)
+  Region visible;
+  getDrawableRegion(visible, kUseChildArea);
+
+  Point origin = getBounds().getOrigin();
+  retained.offset(-origin.x, -origin.y);
+  discarded.offset(-origin.x, -origin.y);
+
+  Rect area = visible.getBounds();
+  area.offset(-origin.x, -origin.y);
+
+  m_retainedBuffer->discard(discarded);
+  m_retainedBuffer->retain(origin, retained, area);
+}
+
+void Widget::discardRetainedArea(const gfx::Region& region)
+{
+  if (!m_retainedBuffer)
+    return;
+
+  Region rgn(region);
+  rgn.offset(-getBounds().x, -getBounds().y);
+  m_retainedBuffer->discard(rgn);
+}
+
 void Widget::invalidate()
 {
+  if (m_retainedBuffer && !exposing_region)
+    m_retainedBuffer->discard();
+
   if (isVisible()) {
     m_updateRegion.clear();
     getDrawableRegion(m_updateRegion, kCutTopWindows);
@@ -965,6 +1059,14 @@ void Widget::invalidateRegion(const Region& region)
   onInvalidateRegion(region);
 }
 
+void Widget::exposeRegion(const Region& region)
+{
+  bool old = exposing_region;
+  exposing_region = true;
+  invalidateRegion(region);
+  exposing_region = old;
+}
+
 void Widget::scrollRegion(const Region& region, int dx, int dy)
 {
   if (dx != 0 || dy != 0) {
@@ -980,6 +1082,15 @@ void Widget::scrollRegion(const Region& region, int dx, int dy)
 
     reg2.offset(dx, dy);
 
+    // The moved pixels are the new content of the widget, and the
+    // rest of the region is repainted.
+    if (m_retainedBuffer) {
+      Region reg3;
+      reg3.createSubtraction(region, reg2);
+      discardRetainedArea(reg3);
+      retainArea(reg2);
+    }
+
     m_updateRegion.createUnion(m_updateRegion, region);
     m_updateRegion.createSubtraction(m_updateRegion, reg2);
 
@@ -1188,6 +1299,12 @@ bool Widget::onProcessMessage(Message* msg)
       break;
 
     case kPaintMessage:
+      if (m_retainedBuffer) {
+        const PaintMessage* ptmsg = static_cast<const PaintMessage*>(msg);
+        if (restoreRetainedArea(ptmsg->rect()))
+          return true;
+      }
+
       // With double-buffering we create a temporary bitmap to draw
       // the widget on it and then we blit the final result to the
       // real screen. Anyway, if ji_screen is not the real hardware
@@ -1212,8 +1329,10 @@ bool Widget::onProcessMessage(Message* msg)
         onPaint(ev); // Fire onPaint event
 
         // Blit the temporary bitmap to the real screen
-        if (ev.isPainted())
+        if (ev.isPainted()) {
           blit(bmp, ji_screen, 0, 0, ptmsg->rect().x, ptmsg->rect().y, bmp->w, bmp->h);
+          retainArea(Region(ptmsg->rect()));
+        }
 
         destroy_bitmap(bmp);
         return ev.isPainted();
@@ -1226,6 +1345,9 @@ bool Widget::onProcessMessage(Message* msg)
 
         PaintEvent ev(this, &graphics);
         onPaint(ev); // Fire onPaint event
+
+        if (ev.isPainted())
+          retainArea(Region(static_cast<const PaintMessage*>(msg)->rect()));
         return ev.isPainted();
       }
 
@@ -1274,6 +1396,9 @@ bool Widget::onProcessMessage(Message* msg)
 
 void Widget::onInvalidateRegion(const Region& region)
 {
+  if (m_retainedBuffer && !exposing_region)
+    discardRetainedArea(region);
+
   if (isVisible() && region.contains(getBounds()) != Region::Out) {
     Region reg1;
     reg1.createUnion(m_updateRegion, region);
@@ -35,6 +35,7 @@ namespace ui {
   class PaintEvent;
   class PreferredSizeEvent;
   class ResizeEvent;
+  class RetainedBuffer;
   class SaveLayoutEvent;
   class Theme;
   class Window;
@@ -287,10 +288,29 @@ namespace ui {
     bool isDoubleBuffered();
     void setDoubleBuffered(bool doubleBuffered);
 
+    // A widget with a retained buffer keeps a copy of the pixels it
+    // painted, so when some area of it is exposed (e.g. a menu on top
+    // of it is closed) the area is restored with a blit. Only
+    // invalidate*() calls (content changes) discard the copy.
+    bool hasRetainedBuffer() const;
+    void setRetainedBuffer(bool state);
+
+    // Used by widgets that handle kPaintMessage (or draw on ji_screen
+    // directly) to copy/restore screen areas to/from the retained
+    // buffer. All rectangles/regions are in screen coordinates.
+    bool restoreRetainedArea(const gfx::Rect& rc);
+    void retainArea(const gfx::Region& region);
+    void discardRetainedArea(const gfx::Region& region);
+
     void invalidate();
     void invalidateRect(const gfx::Rect& rect);
     void invalidateRegion(const gfx::Region& region);
 
+    // Like invalidateRegion() but the content of the widgets didn't
+    // change (the region was just covered by other window), so
+    // retained buffers are used to repaint it.
+    void exposeRegion(const gfx::Region& region);
+
     void flushRedraw();
 
     void scrollRegion(const gfx::Region& region, int dx, int dy);
@@ -372,6 +392,7 @@ namespace ui {
     WidgetsList m_children;       // Sub-widgets
     Widget* m_parent;             // Who is the parent?
     gfx::Size* m_preferredSize;
+    RetainedBuffer* m_retainedBuffer;
     bool m_doubleBuffered : 1;
   };
 
@@ -602,7 +602,7 @@ void Window::moveWindow(const gfx::Rect& rect, bool use_blit)
   }
 
   manager->invalidateDisplayRegion(manager_refresh_region);
-  invalidateRegion(window_refresh_region);
+  exposeRegion(window_refresh_region);
 }
 
 } // namespace ui
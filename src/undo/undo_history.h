@@ -48,6 +48,12 @@ namespace undo {
     bool isSavedState() const;
     void markSavedState();
 
+    // Remembers the current state as the one that is being saved (e.g.
+    // from a background thread while the user continues editing), so
+    // it can be marked as the saved state when the save finishes.
+    void markSavingState();
+    void markSavingStateAsSaved();
+
     ObjectsContainer* getObjects() const { return m_delegate->getObjects(); }
 
     // UndoersCollector interface
@@ -72,6 +78,7 @@ namespace undo {
     int m_groupLevel;
     int m_diffCount;
     int m_diffSaved;
+    int m_diffSaving;
   };
 
 } // namespace undo
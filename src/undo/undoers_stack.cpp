@@ -19,6 +19,9 @@ UndoersStack::UndoersStack(UndoHistory* undoHistory)
 {
   m_undoHistory = undoHistory;
   m_size = 0;
+  m_groups = 0;
+  m_headLevel = 0;
+  m_tailLevel = 0;
 }
 
 UndoersStack::~UndoersStack()
@@ -32,6 +35,9 @@ void UndoersStack::clear()
     (*it)->dispose();           // Delete the Undoer.
 
   m_size = 0;
+  m_groups = 0;
+  m_headLevel = 0;
+  m_tailLevel = 0;
   m_items.clear();              // Clear the list of items.
 }
 
@@ -50,7 +56,7 @@ void UndoersStack::pushUndoer(Undoer* undoer)
   ASSERT(undoer != NULL);
 
   try {
-    m_items.insert(begin(), undoer);
+    m_items.push_front(undoer);
   }
   catch (...) {
     undoer->dispose();
@@ -58,53 +64,77 @@ void UndoersStack::pushUndoer(Undoer* undoer)
   }
 
   m_size += undoer->getMemSize();
+  addedToHead(undoer);
 }
 
 Undoer* UndoersStack::popUndoer(PopFrom popFrom)
 {
+  if (empty())
+    return NULL;
+
   Undoer* undoer;
-  iterator it;
 
-  if (!empty()) {
-    if (popFrom == PopFromHead)
-      it = begin();
-    else
-      it = --end();
+  if (popFrom == PopFromHead) {
+    undoer = m_items.front();
+    m_items.pop_front();
+    removedFromHead(undoer);
+  }
+  else {
+    undoer = m_items.back();
+    m_items.pop_back();
+    removedFromTail(undoer);
+  }
+
+  m_size -= undoer->getMemSize(); // Reduce the stack size.
 
-    undoer = (*it);                 // Set the undoer to return.
-    m_items.erase(it);              // Erase the item from the stack.
-    m_size -= undoer->getMemSize(); // Reduce the stack size.
+  if (empty()) {
+    m_groups = 0;
+    m_headLevel = 0;
+    m_tailLevel = 0;
   }
-  else
-    undoer = NULL;
 
   return undoer;
 }
 
-size_t UndoersStack::countUndoGroups() const
+// A group is completed when its CloseGroup is added to the head (or
+// a single undoer is added outside groups).
+void UndoersStack::addedToHead(const Undoer* undoer)
 {
-  size_t groups = 0;
-  int level;
-
-  const_iterator it = begin();
-  while (it != end()) {
-    level = 0;
-
-    do {
-      const Undoer* undoer = (*it);
-      ++it;
-
-      if (undoer->isOpenGroup())
-        level++;
-      else if (undoer->isCloseGroup())
-        level--;
-    } while (level && (it != end()));
+  if (undoer->isOpenGroup())
+    ++m_headLevel;
+  else if (undoer->isCloseGroup()) {
+    if (--m_headLevel == 0)
+      ++m_groups;
+  }
+  else if (m_headLevel == 0)
+    ++m_groups;
+}
 
-    if (level == 0)
-      groups++;
+// Removing the CloseGroup from the head "opens" the group again.
+void UndoersStack::removedFromHead(const Undoer* undoer)
+{
+  if (undoer->isOpenGroup())
+    --m_headLevel;
+  else if (undoer->isCloseGroup()) {
+    if (m_headLevel++ == 0)
+      --m_groups;
   }
+  else if (m_headLevel == 0)
+    --m_groups;
+}
 
-  return groups;
+// The tail has the oldest undoers, so groups are removed from their
+// OpenGroup to their CloseGroup.
+void UndoersStack::removedFromTail(const Undoer* undoer)
+{
+  if (undoer->isOpenGroup())
+    ++m_tailLevel;
+  else if (undoer->isCloseGroup()) {
+    if (--m_tailLevel == 0)
+      --m_groups;
+  }
+  else if (m_tailLevel == 0)
+    --m_groups;
 }
 
 } // namespace undo
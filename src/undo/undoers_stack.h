@@ -9,7 +9,8 @@
 
 #include "undo/undoers_collector.h"
 
-#include <vector>
+#include <cstddef>
+#include <deque>
 
 namespace undo {
 
@@ -20,6 +21,10 @@ namespace undo {
   // the UndoHistory class): One stack to hold actions to be undone (the
   // "undoers stack"), and another stack were actions are held to redo
   // reverted actions (the "redoers stack").
+  //
+  // The head of the stack is the last added undoer. Undoers are
+  // added/removed in constant time from both ends, and the memory
+  // size and the number of groups are updated in each operation.
   class UndoersStack : public UndoersCollector {
   public:
     enum PopFrom {
@@ -27,7 +32,7 @@ namespace undo {
       PopFromTail
     };
 
-    typedef std::vector<Undoer*> Items;
+    typedef std::deque<Undoer*> Items;
     typedef Items::iterator iterator;
     typedef Items::const_iterator const_iterator;
 
@@ -57,14 +62,30 @@ namespace undo {
     // deleted by the caller using Undoer::dispose().
     Undoer* popUndoer(PopFrom popFrom);
 
-    size_t countUndoGroups() const;
+    // Returns the number of complete groups in the stack (an undoer
+    // outside a group counts as a group too). Undoers of a group
+    // that is not closed yet are not counted.
+    size_t countUndoGroups() const { return m_groups; }
 
   private:
+    void addedToHead(const Undoer* undoer);
+    void removedFromHead(const Undoer* undoer);
+    void removedFromTail(const Undoer* undoer);
+
     UndoHistory* m_undoHistory;
     Items m_items;
 
     // Bytes occupied by all undoers in the stack.
     size_t m_size;
+
+    // Number of complete groups.
+    size_t m_groups;
+
+    // Number of groups opened (and not closed) at the head of the
+    // stack, and number of groups opened by undoers removed from the
+    // tail (the rest of the group is still in the stack).
+    int m_headLevel;
+    int m_tailLevel;
   };
 
 } // namespace undo
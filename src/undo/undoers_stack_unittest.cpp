@@ -0,0 +1,284 @@
+// Aseprite Undo Library
+// Copyright (C) 2001-2013 David Capello
+//
+// This source file is distributed under MIT license,
+// please read LICENSE.txt for more information.
+
+#include <gtest/gtest.h>
+
+#include "undo/undoer.h"
+#include "undo/undoers_stack.h"
+
+#include <cstdlib>
+
+using namespace undo;
+
+namespace {
+
+  class FakeUndoer : public Undoer {
+  public:
+    enum Kind { Action, OpenGroup, CloseGroup };
+
+    FakeUndoer(Kind kind) : m_kind(kind) { }
+
+    void dispose() { delete this; }
+    size_t getMemSize() const { return sizeof(*this); }
+    Modification getModification() const { return ModifyDocument; }
+    bool isOpenGroup() const { return m_kind == OpenGroup; }
+    bool isCloseGroup() const { return m_kind == CloseGroup; }
+
+    // Reverting a group adds the group again in the other stack (its
+    // CloseGroup is reverted first).
+    void revert(ObjectsContainer* objects, UndoersCollector* redoers) {
+      redoers->pushUndoer(new FakeUndoer(m_kind == OpenGroup ? CloseGroup:
+                                         m_kind == CloseGroup ? OpenGroup: Action));
+    }
+
+  private:
+    Kind m_kind;
+  };
+
+  // Counts the complete groups walking the whole stack from the tail
+  // (the oldest undoer) to the head.
+  size_t count_groups_walking(const UndoersStack& stack)
+  {
+    size_t groups = 0;
+    int level = 0;
+
+    for (UndoersStack::const_iterator it = stack.end(); it != stack.begin(); ) {
+      const Undoer* undoer = *(--it);
+
+      if (undoer->isOpenGroup())
+        ++level;
+      else if (undoer->isCloseGroup()) {
+        if (--level == 0)
+          ++groups;
+      }
+      else if (level == 0)
+        ++groups;
+    }
+
+    return groups;
+  }
+
+  void push(UndoersStack& stack, FakeUndoer::Kind kind)
+  {
+    stack.pushUndoer(new FakeUndoer(kind));
+  }
+
+  void push_group(UndoersStack& stack, int actions)
+  {
+    push(stack, FakeUndoer::OpenGroup);
+    for (int i=0; i<actions; ++i)
+      push(stack, FakeUndoer::Action);
+    push(stack, FakeUndoer::CloseGroup);
+  }
+
+  // Moves the group (or single undoer) at the head of "undoers" to
+  // "redoers" like UndoHistory::runUndo() does.
+  void run_undo(UndoersStack& undoers, UndoersStack& redoers)
+  {
+    int level = 0;
+    do {
+      Undoer* undoer = undoers.popUndoer(UndoersStack::PopFromHead);
+      if (!undoer)
+        break;
+
+      undoer->revert(NULL, &redoers);
+
+      if (undoer->isOpenGroup())
+        ++level;
+      else if (undoer->isCloseGroup())
+        --level;
+
+      undoer->dispose();
+    } while (level);
+  }
+
+  // Removes the oldest group like UndoHistory::discardTail() does.
+  void discard_tail(UndoersStack& undoers)
+  {
+    int level = 0;
+    do {
+      Undoer* undoer = undoers.popUndoer(UndoersStack::PopFromTail);
+      if (!undoer)
+        break;
+
+      if (undoer->isOpenGroup())
+        ++level;
+      else if (undoer->isCloseGroup())
+        --level;
+
+      undoer->dispose();
+    } while (level);
+  }
+
+} // anonymous namespace
+
+#define EXPECT_GROUPS(n, stack)                                 \
+  EXPECT_EQ(n, (stack).countUndoGroups());                      \
+  EXPECT_EQ(count_groups_walking(stack), (stack).countUndoGroups());
+
+TEST(UndoersStack, Push)
+{
+  UndoersStack undoers(NULL);
+  EXPECT_GROUPS(0, undoers);
+
+  push(undoers, FakeUndoer::Action);
+  EXPECT_GROUPS(1, undoers);
+
+  push_group(undoers, 3);
+  EXPECT_GROUPS(2, undoers);
+
+  push_group(undoers, 0);
+  EXPECT_GROUPS(3, undoers);
+
+  // Nested groups count as one group
+  push(undoers, FakeUndoer::OpenGroup);
+  push(undoers, FakeUndoer::Action);
+  push_group(undoers, 2);
+  push_group(undoers, 1);
+  push(undoers, FakeUndoer::CloseGroup);
+  EXPECT_GROUPS(4, undoers);
+
+  undoers.clear();
+  EXPECT_GROUPS(0, undoers);
+}
+
+TEST(UndoersStack, OpenGroupAtHead)
+{
+  UndoersStack undoers(NULL);
+
+  push_group(undoers, 1);
+  push(undoers, FakeUndoer::OpenGroup);
+  EXPECT_GROUPS(1, undoers);
+
+  push(undoers, FakeUndoer::Action);
+  push_group(undoers, 2);
+  EXPECT_GROUPS(1, undoers);
+
+  push(undoers, FakeUndoer::CloseGroup);
+  EXPECT_GROUPS(2, undoers);
+
+  // Removing the CloseGroup from the head opens the group again.
+  Undoer* undoer = undoers.popUndoer(UndoersStack::PopFromHead);
+  EXPECT_TRUE(undoer->isCloseGroup());
+  undoer->dispose();
+  EXPECT_GROUPS(1, undoers);
+
+  undoer = undoers.popUndoer(UndoersStack::PopFromHead);
+  EXPECT_TRUE(undoer->isCloseGroup());
+  undoer->dispose();
+  EXPECT_GROUPS(1, undoers);
+}
+
+TEST(UndoersStack, UndoRedo)
+{
+  UndoersStack undoers(NULL);
+  UndoersStack redoers(NULL);
+
+  push(undoers, FakeUndoer::Action);
+  push_group(undoers, 2);
+  push(undoers, FakeUndoer::OpenGroup);
+  push_group(undoers, 1);
+  push(undoers, FakeUndoer::CloseGroup);
+  EXPECT_GROUPS(3, undoers);
+
+  run_undo(undoers, redoers);
+  EXPECT_GROUPS(2, undoers);
+  EXPECT_GROUPS(1, redoers);
+
+  run_undo(undoers, redoers);
+  run_undo(undoers, redoers);
+  EXPECT_GROUPS(0, undoers);
+  EXPECT_GROUPS(3, redoers);
+  EXPECT_TRUE(undoers.empty());
+
+  run_undo(redoers, undoers);
+  run_undo(redoers, undoers);
+  EXPECT_GROUPS(2, undoers);
+  EXPECT_GROUPS(1, redoers);
+
+  run_undo(redoers, undoers);
+  EXPECT_GROUPS(3, undoers);
+  EXPECT_GROUPS(0, redoers);
+}
+
+TEST(UndoersStack, DiscardTail)
+{
+  UndoersStack undoers(NULL);
+
+  push_group(undoers, 1);
+  push(undoers, FakeUndoer::Action);
+  push(undoers, FakeUndoer::OpenGroup);
+  push_group(undoers, 2);
+  push(undoers, FakeUndoer::CloseGroup);
+  push(undoers, FakeUndoer::OpenGroup);
+  EXPECT_GROUPS(3, undoers);
+
+  // Discard the oldest groups while the stack is over a size limit
+  // (like UndoHistory::checkSizeLimit() does).
+  const size_t sizeLimit = 6*sizeof(FakeUndoer);
+  while (undoers.getMemSize() > sizeLimit && undoers.countUndoGroups() > 1) {
+    size_t groups = undoers.countUndoGroups();
+    discard_tail(undoers);
+    EXPECT_GROUPS(groups-1, undoers);
+  }
+  EXPECT_GROUPS(1, undoers);
+
+  // The open group at the head is closed after discarding the tail.
+  push(undoers, FakeUndoer::CloseGroup);
+  EXPECT_GROUPS(2, undoers);
+
+  discard_tail(undoers);
+  discard_tail(undoers);
+  EXPECT_GROUPS(0, undoers);
+  EXPECT_TRUE(undoers.empty());
+}
+
+TEST(UndoersStack, RandomOperations)
+{
+  UndoersStack undoers(NULL);
+  UndoersStack redoers(NULL);
+  int level = 0;
+
+  std::srand(1);
+  for (int i=0; i<10000; ++i) {
+    switch (std::rand() % 6) {
+      case 0:
+        push(undoers, FakeUndoer::Action);
+        break;
+      case 1:
+        push(undoers, FakeUndoer::OpenGroup);
+        ++level;
+        break;
+      case 2:
+        if (level > 0) {
+          push(undoers, FakeUndoer::CloseGroup);
+          --level;
+        }
+        break;
+      case 3:
+        if (level == 0)
+          run_undo(undoers, redoers);
+        break;
+      case 4:
+        if (level == 0)
+          run_undo(redoers, undoers);
+        break;
+      case 5:
+        if (undoers.countUndoGroups() > 1)
+          discard_tail(undoers);
+        break;
+    }
+
+    ASSERT_EQ(count_groups_walking(undoers), undoers.countUndoGroups());
+    ASSERT_EQ(count_groups_walking(redoers), redoers.countUndoGroups());
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -24,9 +24,12 @@
 
 #include "base/bind.h"
 #include "base/compiler_specific.h"
+#include "base/convert_to.h"
 #include "mongoose.h"
 
+#include <cstring>
 #include <sstream>
+#include <vector>
 
 namespace webserver {
 
@@ -64,6 +67,23 @@ public:
     return m_requestInfo->query_string;
   }
 
+  virtual bool getQueryVar(const char* name, std::string& value) OVERRIDE {
+    const char* query = m_requestInfo->query_string;
+    if (!query)
+      return false;
+
+    std::vector<char> buf(std::strlen(query)+1);
+    if (mg_get_var(query, std::strlen(query), name, &buf[0], buf.size()) < 0)
+      return false;
+
+    value = &buf[0];
+    return true;
+  }
+
+  virtual const char* getHeader(const char* name) OVERRIDE {
+    return mg_get_header(m_conn, name);
+  }
+
   // IResponse implementation
 
   virtual void setStatusCode(int code) OVERRIDE {
@@ -107,10 +127,13 @@ private:
 class WebServer::WebServerImpl
 {
 public:
-  WebServerImpl(IDelegate* delegate)
+  WebServerImpl(IDelegate* delegate, int threads)
     : m_delegate(delegate) {
+    std::string threadsStr = base::convert_to<std::string>(threads);
+    std::string portStr = "127.0.0.1:" + base::convert_to<std::string>(WebServer::getPort());
     const char* options[] = {
-      "listening_ports", "10453",
+      "listening_ports", portStr.c_str(),
+      "num_threads", threadsStr.c_str(),
       NULL
     };
 
@@ -241,8 +264,8 @@ static int begin_request_handler(mg_connection* conn)
   return webServer->onBeginRequest(conn);
 }
 
-WebServer::WebServer(IDelegate* delegate)
-  : m_impl(new WebServerImpl(delegate))
+WebServer::WebServer(IDelegate* delegate, int threads)
+  : m_impl(new WebServerImpl(delegate, threads))
 {
 }
 
@@ -256,4 +279,9 @@ std::string WebServer::getName() const
   return m_impl->getName();
 }
 
+int WebServer::getPort()
+{
+  return 10453;
+}
+
 }
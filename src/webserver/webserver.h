@@ -32,6 +32,14 @@ namespace webserver {
     virtual const char* getUri() = 0;
     virtual const char* getHttpVersion() = 0;
     virtual const char* getQueryString() = 0;
+
+    // Gets the value of a variable of the query string (already
+    // decoded). Returns false if the variable is not present.
+    virtual bool getQueryVar(const char* name, std::string& value) = 0;
+
+    // Returns the value of a header of the request, or NULL if it is
+    // not present.
+    virtual const char* getHeader(const char* name) = 0;
   };
 
   class IResponse {
@@ -43,6 +51,8 @@ namespace webserver {
     virtual void sendFile(const char* path) = 0;
   };
 
+  // The delegate is called from several threads at the same time (one
+  // for each request that is being processed).
   class IDelegate {
   public:
     virtual ~IDelegate() { }
@@ -53,11 +63,16 @@ namespace webserver {
   public:
     class WebServerImpl;
 
-    WebServer(IDelegate* delegate);
+    // The server listens in the localhost only, "threads" is the
+    // number of requests that can be processed at the same time.
+    WebServer(IDelegate* delegate, int threads = 4);
     ~WebServer();
 
     std::string getName() const;
 
+    // Port where the server listens.
+    static int getPort();
+
   private:
     WebServerImpl* m_impl;
 